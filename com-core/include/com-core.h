@@ -22,6 +22,8 @@
 extern "C" {
 #endif
 
+struct iovec;
+
 enum com_core_event_type {
 	CONNECTOR_CONNECTED,
 	CONNECTOR_DISCONNECTED
@@ -152,6 +154,21 @@ extern int com_core_send(int handle, const char *buffer, int size, double timeou
  */
 extern int com_core_send_with_fd(int handle, const char *buffer, int size, double timeout, int fd);
 
+/**
+ * @brief Send scattered data, it is sent with sendmsg without merging buffers.
+ * @details
+ * @remarks The iov array is updated while sending.
+ * @param[in] handle
+ * @param[in] iov
+ * @param[in] iovcnt
+ * @param[in] timeout
+ * @param[in] fd
+ * @return int
+ * @retval Sent bytes
+ * @sa com_core_send_with_fd
+ */
+extern int com_core_sendv_with_fd(int handle, struct iovec *iov, int iovcnt, double timeout, int fd);
+
 /**
  * @brief
  * @details
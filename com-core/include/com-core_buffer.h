@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2000 - 2013 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef _COM_CORE_BUFFER_H
+#define _COM_CORE_BUFFER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * \brief
+ * Layout of buffers which are shared by the data-provider-master, libwidget-provider and libwidget-viewer.
+ * Macros refer the struct widget_fb and the enum widget_fb_type of the widget-service,
+ * include the widget_buffer.h of it before using them.
+ */
+
+#define SCHEMA_MEMFD	"memfd://"
+
+/*!
+ * \note
+ * The widget_fb_type of the widget-service has no type for the memfd buffer.
+ */
+#define WIDGET_FB_TYPE_MEMFD	((enum widget_fb_type)(WIDGET_FB_TYPE_ERROR + 1))
+
+/*!
+ * \note
+ * The provider and viewers request the fd of a MEMFD buffer using this, with its id.
+ */
+#define CMD_STR_BUFFER_FD	"buffer_fd"
+
+/*!
+ * \note
+ * Layout of the MEMFD buffer, version is identified by the WIDGET_FB_TYPE_MEMFD.
+ * If the layout is changed, a new type should be defined for it, viewers which don't know it will refuse the buffer.
+ *
+ * [widget_fb][frame]
+ *
+ * The "refcnt" of the widget_fb is not a reference count, the mappings of the memfd are not counted.
+ * It has the sequence number of the last published frame, 0 if nothing is published yet.
+ * The provider increases it after the frame is written, viewers load it before reading the frame.
+ * The "info" has the size of the frame.
+ */
+#define WIDGET_FB_MEMFD_SEQ(buffer)	(__atomic_load_n(&(buffer)->refcnt, __ATOMIC_ACQUIRE))
+#define WIDGET_FB_MEMFD_PUBLISH(buffer)	(__atomic_add_fetch(&(buffer)->refcnt, 1, __ATOMIC_RELEASE))
+#define WIDGET_FB_MEMFD_SIZE(buffer)	((int)((long)(buffer)->info))
+
+/*!
+ * \note
+ * Layout of the N-buffered SHM.
+ * The id of it has the count of slots, "shm://SHMID#SERIAL@SLOTS"
+ *
+ * [widget_fb][draw frame][shm_ring][widget_fb of slot 0][frame] ... [widget_fb of slot N-1][frame]
+ *
+ * The provider draws on the draw frame, copies it to a slot which is not being read and publishes the slot.
+ * Viewers take the latest published slot without the lock.
+ * The widget_fb of a slot has the index of the slot in the "refcnt" and the negative offset to the segment in the "info".
+ * Viewers pin slots under their pid, so the master can give back the pins of a viewer which is gone.
+ */
+#define SHM_RING_MAX_PINS	16
+#define SHM_RING_MAX_SLOTS	3
+#define SHM_RING_DELIM	'@'
+#define SHM_RING_ALIGN(size)	(((size) + 63) & ~63)
+#define SHM_RING_LATEST(seq, idx)	((((seq) & 0x3FFFFFFF) << 2) | (idx)) /*!< seq never be 0, 0 means nothing is published */
+#define SHM_RING_LATEST_SEQ(latest)	((latest) >> 2)
+#define SHM_RING_LATEST_IDX(latest)	((latest) & 0x3)
+
+/*!
+ * \note
+ * A viewer increases the readers of a slot first and then its own count, and decreases them in reverse order.
+ * So the count of a pin never exceeds the readers which are taken by it.
+ */
+struct shm_ring_pin {
+	int pid; /*!< Viewer which owns this, 0 if it is free */
+	unsigned int count[SHM_RING_MAX_SLOTS]; /*!< Slots which are pinned by the viewer */
+};
+
+struct shm_ring {
+	unsigned int count; /*!< Count of slots */
+	unsigned int frame_size;
+	unsigned int latest; /*!< SHM_RING_LATEST() of the latest published slot */
+	unsigned int consumed; /*!< Sequence of the frame which is taken by a viewer lastly */
+	unsigned int dropped; /*!< Published frames which are replaced before a viewer takes them */
+	unsigned int skipped; /*!< Drawn frames which are not published */
+	unsigned int readers[SHM_RING_MAX_SLOTS]; /*!< Count of viewers who are reading the slot */
+	struct shm_ring_pin pins[SHM_RING_MAX_PINS];
+};
+
+#define SHM_RING_SLOT_SIZE(frame_size)	(SHM_RING_ALIGN(sizeof(struct widget_fb) + (frame_size)))
+#define SHM_RING_SIZE(frame_size, count)	(SHM_RING_ALIGN(frame_size) + SHM_RING_ALIGN(sizeof(struct shm_ring)) + (count) * SHM_RING_SLOT_SIZE(frame_size))
+#define SHM_RING(buffer)	((struct shm_ring *)((char *)(buffer)->data + SHM_RING_ALIGN((long)(buffer)->info)))
+#define SHM_RING_SLOT(ring, idx)	((widget_fb_t)((char *)(ring) + SHM_RING_ALIGN(sizeof(struct shm_ring)) + (idx) * SHM_RING_SLOT_SIZE((ring)->frame_size)))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+/* End of a file */
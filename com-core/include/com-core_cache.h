@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2000 - 2013 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef _COM_CORE_CACHE_H
+#define _COM_CORE_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * \brief
+ * Bounded LRU cache of data blocks indexed by a string key, e.g. decoded pixels of images.
+ * Data is copied into the cache, the least recently used ones are evicted if the usage exceeds the limit.
+ * This is not thread safe, use it from one thread.
+ */
+struct com_core_cache;
+
+/*!
+ * \brief Create a cache.
+ * \param[in] limit Maximum size of data in bytes
+ * \return struct com_core_cache *
+ * \retval NULL if it fails to allocate memory
+ */
+extern struct com_core_cache *com_core_cache_create(unsigned long limit);
+
+/*!
+ * \brief Destroy a cache with its data.
+ * \param[in] cache Cache
+ * \return void
+ */
+extern void com_core_cache_destroy(struct com_core_cache *cache);
+
+/*!
+ * \brief Find data and make it the most recently used one.
+ * \param[in] cache Cache
+ * \param[in] key Key
+ * \param[out] size Size of data, can be NULL
+ * \return const void *
+ * \retval NULL if there is no data for the key
+ * \note The data is valid until the next com_core_cache_put or com_core_cache_trim.
+ */
+extern const void *com_core_cache_get(struct com_core_cache *cache, const char *key, int *size);
+
+/*!
+ * \brief Add (or replace) data of a key.
+ * \param[in] cache Cache
+ * \param[in] key Key
+ * \param[in] data Data, it is copied
+ * \param[in] size Size of data
+ * \return int
+ * \retval 0 if succeed
+ * \retval -EINVAL Invalid argument
+ * \retval -E2BIG Data is too big to be cached
+ * \retval -ENOMEM Out of memory
+ */
+extern int com_core_cache_put(struct com_core_cache *cache, const char *key, const void *data, int size);
+
+/*!
+ * \brief Evict the least recently used data until the usage is not greater than the given size.
+ * \param[in] cache Cache
+ * \param[in] size 0 to evict all
+ * \return unsigned long Released bytes
+ */
+extern unsigned long com_core_cache_trim(struct com_core_cache *cache, unsigned long size);
+
+/*!
+ * \brief Get the size of data in the cache.
+ * \param[in] cache Cache
+ * \return unsigned long Bytes
+ */
+extern unsigned long com_core_cache_usage(struct com_core_cache *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+/* End of a file */
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2000 - 2013 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef _COM_CORE_DESC_H
+#define _COM_CORE_DESC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * \brief
+ * Binary encoding of the content description file, it can be used instead of the text one.
+ *
+ * file   := "WDSC" version(1) reserved(3) block*
+ * block  := count(1) field{count}
+ * field  := tag(1) length(4, little endian) value(length) '\0'
+ *
+ * Every value is terminated by '\0', readers give the values in place, without copying them.
+ * Readers skip the fields which have unknown tags.
+ * Values dominate the size, so a binary desc is about as large as the text one, it saves the tokenizing.
+ */
+#define COM_CORE_DESC_MAGIC "WDSC"
+#define COM_CORE_DESC_VERSION 1
+#define COM_CORE_DESC_HEADER_SIZE 8
+
+enum com_core_desc_field {
+	COM_CORE_DESC_FIELD_TYPE = 0x01,
+	COM_CORE_DESC_FIELD_PART = 0x02,
+	COM_CORE_DESC_FIELD_DATA = 0x03,
+	COM_CORE_DESC_FIELD_OPTION = 0x04,
+	COM_CORE_DESC_FIELD_ID = 0x05,
+	COM_CORE_DESC_FIELD_TARGET = 0x06,
+	COM_CORE_DESC_FIELD_FILE = 0x07
+};
+
+/*!
+ * \note
+ * NULL if the block has no such field.
+ */
+struct com_core_desc_block {
+	const char *type;
+	const char *part;
+	const char *data;
+	const char *option;
+	const char *id;
+	const char *target;
+	const char *file;
+};
+
+struct com_core_desc_reader {
+	const char *buffer;
+	int size;
+	int offset;
+};
+
+/*!
+ * \brief Check whether the buffer has the binary desc or not.
+ * \param[in] buffer Contents of a desc file
+ * \param[in] size Size of the buffer
+ * \return int
+ * \retval 1 Binary desc
+ * \retval 0 Text desc (or something else)
+ */
+extern int com_core_desc_is_binary(const void *buffer, int size);
+
+/*!
+ * \brief Prepare to read blocks of the binary desc.
+ * \param[out] reader Reader
+ * \param[in] buffer Contents of a desc file, it should be kept while using the blocks
+ * \param[in] size Size of the buffer
+ * \return int
+ * \retval 0 if succeed
+ * \retval -EINVAL Not a binary desc
+ * \retval -ENOTSUP Unsupported version
+ */
+extern int com_core_desc_reader_init(struct com_core_desc_reader *reader, const void *buffer, int size);
+
+/*!
+ * \brief Get the next block, its fields are pointing the buffer of the reader.
+ * \param[in] reader Reader
+ * \param[out] block Block
+ * \return int
+ * \retval 1 A block is given
+ * \retval 0 No more blocks
+ * \retval -EFAULT Broken desc
+ */
+extern int com_core_desc_reader_next(struct com_core_desc_reader *reader, struct com_core_desc_block *block);
+
+/*!
+ * \brief Read every block of the binary desc.
+ * \details Fields of a block are pointing the buffer, the callback maps them to the block of its own.
+ *          If the callback returns a negative value, reading is stopped and the value is returned.
+ * \param[in] buffer Contents of a desc file, it should be kept while using the blocks
+ * \param[in] size Size of the buffer
+ * \param[in] block_cb Called for each block, blockno starts from 1
+ * \param[in] data Callback data
+ * \return int
+ * \retval >=0 Count of blocks
+ * \retval -EINVAL Not a binary desc
+ * \retval -ENOTSUP Unsupported version
+ * \retval -EFAULT Broken desc
+ * \sa com_core_desc_reader_next
+ */
+extern int com_core_desc_foreach_block(const void *buffer, int size, int (*block_cb)(const struct com_core_desc_block *block, int blockno, void *data), void *data);
+
+/*!
+ * \brief Write the header of the binary desc.
+ * \param[out] buffer Buffer, if it is NULL, only the size is returned
+ * \param[in] size Size of the buffer
+ * \return int
+ * \retval >0 Written bytes
+ * \retval -ENOSPC Buffer is too small
+ */
+extern int com_core_desc_write_header(void *buffer, int size);
+
+/*!
+ * \brief Write a block of the binary desc.
+ * \param[out] buffer Buffer, if it is NULL, only the size is returned
+ * \param[in] size Size of the buffer
+ * \param[in] block Block, NULL fields are not written
+ * \return int
+ * \retval >0 Written bytes
+ * \retval -ENOSPC Buffer is too small
+ * \retval -EINVAL Invalid block
+ */
+extern int com_core_desc_write_block(void *buffer, int size, const struct com_core_desc_block *block);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+/* End of a file */
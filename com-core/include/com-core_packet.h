@@ -54,6 +54,49 @@ extern int com_core_packet_async_send(int handle, struct packet *packet, double
  */
 extern int com_core_packet_send_only(int handle, struct packet *packet);
 
+/*!
+ * \brief Queue a packet, then send it with other queued packets of the same connection at once
+ * \details Queued packets are sent via one sendmsg call at the end of the current main loop iteration,
+ *          or after the window which is set by com_core_packet_set_batch_window().
+ *          A packet which has fd is sent via its own message after flushing queued packets.
+ * \remarks Only PACKET_REQ_NOACK packets can be queued.
+ *          result_cb is called once for the queued packet, with 0 if it is sent or a negative errno,
+ *          -ECONNRESET if the connection is lost before sending it.
+ *          If the packet is sent right away (it has fd) or this returns an error, result_cb is not called.
+ * \param[in] handle
+ * \param[in] packet
+ * \param[in] result_cb Can be NULL
+ * \param[in] data
+ * \return int
+ * \retval 0 if succeed
+ * \retval -EINVAL Invalid packet
+ * \sa com_core_packet_batch_flush
+ * \sa com_core_packet_send_only
+ */
+extern int com_core_packet_batch_send(int handle, struct packet *packet, void (*result_cb)(int handle, const struct packet *packet, int status, void *data), void *data);
+
+/*!
+ * \brief Send queued packets of a connection right now
+ * \details N/A
+ * \remarks N/A
+ * \param[in] handle
+ * \return int
+ * \retval 0 if succeed
+ * \retval -EIO Failed to send whole packets
+ * \sa com_core_packet_batch_send
+ */
+extern int com_core_packet_batch_flush(int handle);
+
+/*!
+ * \brief Set the time window to gather packets of com_core_packet_batch_send()
+ * \details N/A
+ * \remarks The main loop timer is used, so it is rounded up to milliseconds.
+ * \param[in] usec 0 to send them at the end of the current main loop iteration (default)
+ * \return void
+ * \sa com_core_packet_batch_send
+ */
+extern void com_core_packet_set_batch_window(unsigned int usec);
+
 /*!
  * \brief
  * \details N/A
@@ -148,6 +191,50 @@ extern void com_core_packet_server_disconnect_handle(int handle);
  */
 extern void com_core_packet_use_thread(int flag);
 
+/*!
+ * \brief Use shared memory rings for packets between processes on the same host
+ * \details A client offers a ring when it is connected, and a server replies with its own ring.
+ *          Each ring is a memfd which is passed via the socket with an eventfd for signalling.
+ *          Peers which don't support this keep using the socket.
+ *          Packets which have fd or which are large are still sent via the socket.
+ *          If this is not called, the COM_CORE_RING environment variable decides it.
+ * \remarks Must be called before initializing the com-core packet.
+ * \param[in] flag 1 to use rings
+ * \return void
+ * \sa com_core_packet_use_thread
+ */
+extern void com_core_packet_use_ring(int flag);
+
+/*!
+ * \brief Find the index of a command in the method table.
+ * \details Every command is converted to the int tagged one first, using com_core_packet_method_tag,
+ *          so the dispatcher handles the string commands of legacy peers same as the tagged ones.
+ * \remarks N/A
+ * \param[in] table
+ * \param[in] cmd
+ * \return int
+ * \retval >=0 index of the method
+ * \retval -ENOENT command is not in the table
+ * \sa com_core_packet_method_tag
+ */
+extern int com_core_packet_method_index(struct method *table, const char *cmd);
+
+/*!
+ * \brief Convert a string command to the int tagged command of the table.
+ * \details String commands are resolved via a hash index which is built once per table,
+ *          int tagged commands are validated against the size of the table.
+ *          Indexes are destroyed when the com-core packet is finalized.
+ * \remarks N/A
+ * \param[in] table
+ * \param[in] cmd
+ * \param[out] tagged buffer, its size should be PACKET_MAX_CMD
+ * \return int
+ * \retval 0 if succeed
+ * \retval -ENOENT command is not in the table
+ * \sa com_core_packet_method_index
+ */
+extern int com_core_packet_method_tag(struct method *table, const char *cmd, char *tagged);
+
 #ifdef __cplusplus
 }
 #endif
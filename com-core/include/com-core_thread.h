@@ -22,6 +22,8 @@
 extern "C" {
 #endif
 
+struct iovec;
+
 extern int com_core_thread_client_create(const char *addr, int is_sync, int (*service_cb)(int fd, void *data), void *data);
 extern int com_core_thread_server_create(const char *addr, int is_sync, const char *label, int (*service_cb)(int fd, void *data), void *data);
 extern int com_core_thread_client_create_by_fd(int client_fd, int is_sync, int (*service_cb)(int fd, void *data), void *data);
@@ -34,6 +36,45 @@ extern int com_core_thread_send(int handle, const char *buffer, int size, double
 
 extern int com_core_thread_recv_with_fd(int handle, char *buffer, int size, int *sender_pid, double timeout, int *fd);
 extern int com_core_thread_send_with_fd(int handle, const char *buffer, int size, double timeout, int fd);
+extern int com_core_thread_sendv_with_fd(int handle, struct iovec *iov, int iovcnt, double timeout, int fd);
+
+/*!
+ * \brief Get the received data in place, without copying it out of the receive ring.
+ * \details The returned region is contiguous, so a packet which wraps the ring is given in two pieces.
+ * \remarks The region is valid until com_core_thread_recv_consume() is called.
+ * \param[in] handle Connection handle
+ * \param[out] ptr Address of the received data
+ * \param[out] sender_pid Pid of the sender, can be NULL
+ * \param[in] timeout Seconds to wait for data
+ * \param[out] fd Received file descriptor or -1, it is delivered only once. if NULL, it is closed
+ * \return int
+ * \retval >0 Size of available data
+ * \retval 0 Disconnected
+ * \retval <0 Error
+ */
+extern int com_core_thread_recv_peek(int handle, const char **ptr, int *sender_pid, double timeout, int *fd);
+
+/*!
+ * \brief Release the data which is taken by com_core_thread_recv_peek()
+ * \param[in] handle Connection handle
+ * \param[in] size Size of consumed data, cannot exceed the size given by the peek
+ * \return int
+ * \retval 0 if succeed
+ * \retval -EINVAL Invalid handle or size
+ */
+extern int com_core_thread_recv_consume(int handle, int size);
+
+/*!
+ * \brief Serve connections from a fixed pool of epoll reactors instead of creating a thread per connection.
+ * \details If this is not called, the COM_CORE_REACTOR_WORKERS environment variable gives the count of workers.
+ * \remarks Must be called before creating any connection.
+ * \param[in] workers Count of reactor threads, 0 to use a thread per connection
+ * \return int
+ * \retval 0 if succeed
+ * \retval -EBUSY connections are already created
+ * \retval -EINVAL invalid count of workers
+ */
+extern int com_core_thread_set_reactor(int workers);
 
 #ifdef __cplusplus
 }
@@ -22,6 +22,8 @@
 extern "C" {
 #endif
 
+struct iovec;
+
 struct packet;
 
 enum packet_type {
@@ -49,6 +51,24 @@ enum packet_flag {
 #define PACKET_MAX_CMD	24
 #define PACKET_CMD_INT_TAG	0x01
 
+/*!
+ * \brief Maximum count of iovec entries of a packet
+ */
+#define PACKET_MAX_IOV	9
+
+/*!
+ * \brief Statistics of the packet pool
+ * \details Packet objects and data buffers are counted together.
+ */
+struct packet_pool_stat {
+	unsigned long alloc; /*!< Count of requested allocations */
+	unsigned long hit; /*!< Served from the pool */
+	unsigned long heap; /*!< Allocated from the heap */
+	unsigned long grow; /*!< Data buffer is moved to the larger one */
+	unsigned long recycle; /*!< Released to the pool */
+	unsigned long release; /*!< Released to the heap */
+};
+
 /*!
  * \brief Create a packet
  * \details N/A
@@ -65,6 +85,23 @@ enum packet_flag {
  */
 extern struct packet *packet_create(const char *command, const char *fmt, ...);
 
+/*!
+ * \brief Create a packet which doesn't need reply, long strings are referenced instead of copying
+ * \details Strings which are longer than 512 bytes are not copied into the packet,
+ *          they are sent from the caller's memory by com_core_packet_send_only().
+ * \remarks Referenced strings should be kept until the sending function returns.
+ *           If the packet gets another owner (packet_ref) or someone needs the contiguous packet (packet_data, packet_get),
+ *           they are copied into the packet at that time, so queued, batched and parked packets do not refer the caller's memory.
+ * \param[in] command
+ * \param[in] fmt
+ * \param[in] ...
+ * \return struct packet *
+ * \retval
+ * \sa packet_create_noack
+ * \sa packet_flatten
+ */
+extern struct packet *packet_create_noack_ref(const char *command, const char *fmt, ...);
+
 /*!
  * \brief Create a packet which doesn't need reply
  * \details N/A
@@ -133,10 +170,10 @@ extern int packet_destroy(struct packet *packet);
  *   com_core_packet_send series functions will destroy the packet after it sends them
  *   If you want reuse the sent packet again, increase the reference count of a packet
  *   Then the packet will not be destroyed even though returns from the com_core_packet_send series functions
- * \remarks N/A
+ * \remarks Referenced strings of the packet are copied into it, if it already has an owner.
  * \param[in] packet
  * \return struct packet *
- * \retval
+ * \retval NULL Invalid packet or failed to copy referenced strings
  * \sa packet_unref
  */
 extern struct packet *packet_ref(struct packet *packet);
@@ -377,10 +414,112 @@ extern const int const packet_size(const struct packet *packet);
  */
 extern struct packet *packet_build(struct packet *packet, int offset, void *data, int size);
 
+/*!
+ * \brief Parse fields of a packet once, then they can be accessed via packet_view_* without scanning
+ * \details Offsets of fields are cached in the packet, packet_get() uses the same cache.
+ *          Types and bounds of fields are verified while parsing.
+ * \remarks Only the last format is cached. Format should not have more than 32 fields.
+ * \param[in] packet
+ * \param[in] fmt
+ * \return int
+ * \retval >=0 Count of valid fields
+ * \retval -EINVAL Invalid argument or invalid type in the format
+ * \retval -E2BIG Format is too long to be cached
+ * \sa packet_view_str
+ * \sa packet_view_int
+ * \sa packet_view_double
+ */
+extern int packet_view(const struct packet *packet, const char *fmt);
+
+/*!
+ * \brief Get a string field of the parsed packet
+ * \details N/A
+ * \remarks packet_view() should be called first.
+ * \param[in] packet
+ * \param[in] idx Index of the field in the format
+ * \return const char *
+ * \retval NULL Index is out of range or the field is not a string
+ * \sa packet_view
+ */
+extern const char *packet_view_str(const struct packet *packet, int idx);
+
+/*!
+ * \brief Get an integer field of the parsed packet
+ * \details N/A
+ * \remarks packet_view() should be called first.
+ * \param[in] packet
+ * \param[in] idx Index of the field in the format
+ * \return int
+ * \retval 0 Index is out of range or the field is not an integer
+ * \sa packet_view
+ */
+extern int packet_view_int(const struct packet *packet, int idx);
+
+/*!
+ * \brief Get a double field of the parsed packet
+ * \details N/A
+ * \remarks packet_view() should be called first.
+ * \param[in] packet
+ * \param[in] idx Index of the field in the format
+ * \return double
+ * \retval 0.0f Index is out of range or the field is not a double
+ * \sa packet_view
+ */
+extern double packet_view_double(const struct packet *packet, int idx);
+
+/*!
+ * \brief Get the scattered data of a packet, to send it without merging buffers
+ * \details N/A
+ * \remarks Returned buffers are valid until the packet is changed or destroyed.
+ * \param[in] packet
+ * \param[out] iov
+ * \param[in] count Size of iov array, PACKET_MAX_IOV is enough
+ * \return int
+ * \retval >0 Count of iov entries
+ * \retval -EINVAL Invalid argument
+ * \sa packet_create_noack_ref
+ */
+extern int packet_iovec(const struct packet *packet, struct iovec *iov, int count);
+
+/*!
+ * \brief Copy the referenced strings into the packet
+ * \details A packet which is kept after the sending function returns should not refer the caller's memory.
+ * \remarks N/A
+ * \param[in] packet
+ * \return int
+ * \retval 0 The packet is contiguous
+ * \retval -EINVAL Invalid argument
+ * \retval -ENOMEM Not enough memory
+ * \sa packet_create_noack_ref
+ */
+extern int packet_flatten(struct packet *packet);
+
 extern int packet_fd(const struct packet *packet);
 extern int packet_set_fd(struct packet *packet, int fd);
 extern int packet_set_fd_close_handler_on_destroy(struct packet *packet, void (*close_cb)(int fd, void *data), void *data);
 
+/*!
+ * \brief Get the statistics of the packet pool
+ * \details Packets and their data buffers are recycled via per-thread pools,
+ *          this can be used to see how many heap allocations are saved.
+ * \remarks N/A
+ * \param[out] stat
+ * \return int
+ * \retval 0 if succeed
+ * \retval -EINVAL Invalid argument
+ * \sa packet_pool_reset_stat
+ */
+extern int packet_pool_get_stat(struct packet_pool_stat *stat);
+
+/*!
+ * \brief Reset the statistics of the packet pool
+ * \details N/A
+ * \remarks N/A
+ * \return void
+ * \sa packet_pool_get_stat
+ */
+extern void packet_pool_reset_stat(void);
+
 #ifdef __cplusplus
 }
 #endif
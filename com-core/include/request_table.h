@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2000 - 2013 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/*!
+ * \brief
+ * Outstanding requests, indexed by (handle, sequence).
+ * The node has to be embedded in the request context.
+ */
+struct request_node {
+	int handle;
+	unsigned long long seq; /*!< Bit pattern of the sequence of a packet */
+	struct request_node *next; /*!< Requests which have the same sequence on the same handle */
+};
+
+struct request_table;
+
+extern struct request_table *request_table_create(void);
+extern void request_table_destroy(struct request_table *table);
+
+extern int request_table_add(struct request_table *table, struct request_node *node, int handle, double seq);
+extern void request_table_del(struct request_table *table, struct request_node *node);
+extern struct request_node *request_table_find(struct request_table *table, int handle, double seq);
+
+/*!
+ * \note
+ * Returns a new dlist of nodes of a handle, the caller has to free the list.
+ * Nodes can be deleted from the table while walking the list.
+ */
+extern struct dlist *request_table_list(struct request_table *table, int handle);
+
+/* End of a file */
@@ -22,6 +22,8 @@
 extern "C" {
 #endif
 
+struct iovec;
+
 /*!
  * local:///tmp/.socket.file => /tmp/.socket.file
  */
@@ -101,6 +103,21 @@ extern int secure_socket_get_connection_handle(int server_handle);
 extern int secure_socket_send(int conn, const char *buffer, int size);
 extern int secure_socket_send_with_fd(int handle, const char *buffer, int size, int fd);
 
+/*!
+ * \brief Send scattered data to the connected peer with one sendmsg call.
+ * \details N/A
+ * \remarks It can be sent partially, the caller should handle the rest of data.
+ * \param[in] handle
+ * \param[in] iov
+ * \param[in] iovcnt
+ * \param[in] fd Shared fd which will be used from receiver process.
+ * \return int
+ * \retval >0 Sent bytes
+ * \retval -EAGAIN Try again
+ * \sa secure_socket_send_with_fd
+ */
+extern int secure_socket_sendv_with_fd(int handle, const struct iovec *iov, int iovcnt, int fd);
+
 /*!
  * \brief Recv data from the connected peer. and its PID value
  * \details N/A
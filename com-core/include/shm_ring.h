@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2000 - 2013 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/*!
+ * \brief
+ * Single producer, single consumer ring on a memfd which is shared between two processes.
+ * The producer creates the ring and passes its memfd and eventfds to the consumer.
+ * The memfd is sealed, so its size cannot be changed by either of them.
+ * A record never wraps around the end of the ring, so the consumer can parse it in place.
+ */
+struct shm_ring;
+struct iovec;
+
+enum shm_ring_record_type {
+	SHM_RING_DATA = 0x01, /*!< A packet */
+	SHM_RING_BARRIER = 0x02, /*!< Following packets are sent via the socket, its size is the count of them */
+	SHM_RING_PAD = 0x03 /*!< Skip to the end of the ring */
+};
+
+extern struct shm_ring *shm_ring_create(unsigned int size);
+extern struct shm_ring *shm_ring_attach(int mem_fd, int evt_fd, int space_fd);
+extern void shm_ring_destroy(struct shm_ring *ring);
+
+extern int shm_ring_mem_fd(struct shm_ring *ring);
+extern int shm_ring_evt_fd(struct shm_ring *ring);
+extern int shm_ring_space_fd(struct shm_ring *ring);
+
+/*!
+ * \note
+ * Producer side.
+ * shm_ring_put() always leaves a room for a barrier, so a barrier can be put at any time.
+ * \return 0 if succeed, -ENOSPC if there is no room for the data.
+ */
+extern int shm_ring_put(struct shm_ring *ring, const struct iovec *iov, int iovcnt, int size);
+extern int shm_ring_put_barrier(struct shm_ring *ring, int count);
+
+/*!
+ * \note
+ * Producer side. Ask the consumer to write the space eventfd when it releases records.
+ * The ring has to be checked again after this, the room could be made already.
+ */
+extern void shm_ring_wait_space(struct shm_ring *ring);
+
+/*!
+ * \note
+ * Consumer side.
+ * shm_ring_peek() gives the type of the first record and its data in the ring,
+ * shm_ring_consume() releases it. The data is valid until it is consumed.
+ * \return type of the record, -ENOENT if the ring is empty, -EFAULT if the ring is broken.
+ */
+extern int shm_ring_peek(struct shm_ring *ring, const void **data, int *size);
+extern void shm_ring_consume(struct shm_ring *ring);
+
+/*!
+ * \note
+ * Consumer side. Read the eventfd and let the producer signal again.
+ * The ring has to be checked again after this.
+ */
+extern void shm_ring_rearm(struct shm_ring *ring);
+
+/* End of a file */
@@ -66,6 +66,10 @@ mkdir -p %{buildroot}/%{_datarootdir}/license
 %{_includedir}/com-core/com-core_packet.h
 %{_includedir}/com-core/com-core_thread.h
 %{_includedir}/com-core/secure_socket.h
+%{_includedir}/com-core/com-core_desc.h
+%{_includedir}/com-core/com-core_cache.h
+%{_includedir}/com-core/com-core_buffer.h
+%{_bindir}/com-core-desc-conv
 %{_libdir}/pkgconfig/*.pc
 
 # End of a file
@@ -24,6 +24,7 @@
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 
 #include <glib.h>
 
@@ -648,7 +649,25 @@ EAPI int com_core_recv(int handle, char *buffer, int size, int *sender_pid, doub
 	return com_core_recv_with_fd(handle, buffer, size, sender_pid, timeout, NULL);
 }
 
-EAPI int com_core_send_with_fd(int handle, const char *buffer, int size, double timeout, int fd)
+/*!
+ * \brief
+ * Skip "size" bytes of the iovec array, the array is updated in place.
+ */
+static void iov_consume(struct iovec **iov, int *iovcnt, int size)
+{
+	while (*iovcnt > 0 && size >= (*iov)->iov_len) {
+		size -= (*iov)->iov_len;
+		(*iov)++;
+		(*iovcnt)--;
+	}
+
+	if (*iovcnt > 0 && size > 0) {
+		(*iov)->iov_base = (char *)(*iov)->iov_base + size;
+		(*iov)->iov_len -= size;
+	}
+}
+
+EAPI int com_core_sendv_with_fd(int handle, struct iovec *iov, int iovcnt, double timeout, int fd)
 {
 	int writesize;
 	int ret;
@@ -656,7 +675,7 @@ EAPI int com_core_send_with_fd(int handle, const char *buffer, int size, double
 	fd_set set;
 
 	writesize = 0;
-	while (size > 0) {
+	while (iovcnt > 0) {
 
 		FD_ZERO(&set);
 		FD_SET(handle, &set);
@@ -693,10 +712,10 @@ EAPI int com_core_send_with_fd(int handle, const char *buffer, int size, double
 			return -EINVAL;
 		}
 
-		ret = secure_socket_send_with_fd(handle, buffer + writesize, size, fd);
+		ret = secure_socket_sendv_with_fd(handle, iov, iovcnt, fd);
 		if (ret < 0) {
 			if (ret == -EAGAIN) {
-				DbgPrint("Retry to send data (%d:%d)\n", writesize, size);
+				DbgPrint("Retry to send data (%d:%d)\n", writesize, iovcnt);
 				continue;
 			}
 			DbgPrint("Failed to send: %d\n", ret);
@@ -707,13 +726,27 @@ EAPI int com_core_send_with_fd(int handle, const char *buffer, int size, double
 		}
 
 		fd = -1; /** Send only once if it is fd */
-		size -= ret;
+		iov_consume(&iov, &iovcnt, ret);
 		writesize += ret;
 	}
 
 	return writesize;
 }
 
+EAPI int com_core_send_with_fd(int handle, const char *buffer, int size, double timeout, int fd)
+{
+	struct iovec iov;
+
+	if (!buffer || size <= 0) {
+		ErrPrint("Reject: 0 byte data sending\n");
+		return -EINVAL;
+	}
+
+	iov.iov_base = (char *)buffer;
+	iov.iov_len = size;
+	return com_core_sendv_with_fd(handle, &iov, 1, timeout, fd);
+}
+
 EAPI int com_core_send(int handle, const char *buffer, int size, double timeout)
 {
 	return com_core_send_with_fd(handle, buffer, size, timeout, -1);
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2000 - 2013 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <glib.h>
+#include <dlog.h>
+
+#include "debug.h"
+#include "com-core_cache.h"
+
+/*!
+ * \brief
+ * key -> entry, entries are linked in the order of use, head is the most recently used one.
+ */
+struct entry {
+	struct entry *prev;
+	struct entry *next;
+	char *key; /* Stored after the data */
+	int size;
+	unsigned char data[];
+};
+
+struct com_core_cache {
+	GHashTable *table;
+	struct entry *head;
+	struct entry *tail;
+	unsigned long usage;
+	unsigned long limit;
+};
+
+static inline void unlink_entry(struct com_core_cache *cache, struct entry *entry)
+{
+	if (entry->prev) {
+		entry->prev->next = entry->next;
+	} else {
+		cache->head = entry->next;
+	}
+
+	if (entry->next) {
+		entry->next->prev = entry->prev;
+	} else {
+		cache->tail = entry->prev;
+	}
+
+	entry->prev = NULL;
+	entry->next = NULL;
+}
+
+static inline void link_entry(struct com_core_cache *cache, struct entry *entry)
+{
+	entry->prev = NULL;
+	entry->next = cache->head;
+	if (cache->head) {
+		cache->head->prev = entry;
+	} else {
+		cache->tail = entry;
+	}
+	cache->head = entry;
+}
+
+static inline void delete_entry(struct com_core_cache *cache, struct entry *entry)
+{
+	unlink_entry(cache, entry);
+	g_hash_table_remove(cache->table, entry->key);
+	cache->usage -= entry->size;
+	free(entry);
+}
+
+EAPI struct com_core_cache *com_core_cache_create(unsigned long limit)
+{
+	struct com_core_cache *cache;
+
+	cache = calloc(1, sizeof(*cache));
+	if (!cache) {
+		ErrPrint("Heap: %s\n", strerror(errno));
+		return NULL;
+	}
+
+	cache->table = g_hash_table_new(g_str_hash, g_str_equal);
+	if (!cache->table) {
+		ErrPrint("Failed to create a table\n");
+		free(cache);
+		return NULL;
+	}
+
+	cache->limit = limit;
+	return cache;
+}
+
+EAPI void com_core_cache_destroy(struct com_core_cache *cache)
+{
+	if (!cache) {
+		return;
+	}
+
+	(void)com_core_cache_trim(cache, 0);
+	g_hash_table_destroy(cache->table);
+	free(cache);
+}
+
+EAPI const void *com_core_cache_get(struct com_core_cache *cache, const char *key, int *size)
+{
+	struct entry *entry;
+
+	if (!cache || !key) {
+		return NULL;
+	}
+
+	entry = g_hash_table_lookup(cache->table, key);
+	if (!entry) {
+		return NULL;
+	}
+
+	if (entry != cache->head) {
+		unlink_entry(cache, entry);
+		link_entry(cache, entry);
+	}
+
+	if (size) {
+		*size = entry->size;
+	}
+
+	return entry->data;
+}
+
+EAPI int com_core_cache_put(struct com_core_cache *cache, const char *key, const void *data, int size)
+{
+	struct entry *entry;
+	int len;
+
+	if (!cache || !key || !data || size <= 0) {
+		return -EINVAL;
+	}
+
+	if ((unsigned long)size > cache->limit) {
+		return -E2BIG;
+	}
+
+	entry = g_hash_table_lookup(cache->table, key);
+	if (entry) {
+		delete_entry(cache, entry);
+	}
+
+	(void)com_core_cache_trim(cache, cache->limit - size);
+
+	len = strlen(key) + 1;
+	entry = malloc(sizeof(*entry) + size + len);
+	if (!entry) {
+		ErrPrint("Heap: %s\n", strerror(errno));
+		return -ENOMEM;
+	}
+
+	memcpy(entry->data, data, size);
+	entry->key = (char *)entry->data + size;
+	memcpy(entry->key, key, len);
+	entry->size = size;
+
+	g_hash_table_insert(cache->table, entry->key, entry);
+	link_entry(cache, entry);
+	cache->usage += size;
+	return 0;
+}
+
+EAPI unsigned long com_core_cache_trim(struct com_core_cache *cache, unsigned long size)
+{
+	unsigned long released = 0;
+
+	if (!cache) {
+		return 0;
+	}
+
+	while (cache->tail && cache->usage > size) {
+		released += cache->tail->size;
+		delete_entry(cache, cache->tail);
+	}
+
+	return released;
+}
+
+EAPI unsigned long com_core_cache_usage(struct com_core_cache *cache)
+{
+	return cache ? cache->usage : 0;
+}
+
+/* End of a file */
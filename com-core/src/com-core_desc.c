@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2000 - 2013 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <dlog.h>
+
+#include "debug.h"
+#include "com-core_desc.h"
+
+#define FIELD_HEADER_SIZE 5 /* tag(1) + length(4) */
+#define FIELD_MAX 7
+
+static inline unsigned int get_length(const unsigned char *ptr)
+{
+	return ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | ((unsigned int)ptr[3] << 24);
+}
+
+static inline void put_length(unsigned char *ptr, unsigned int length)
+{
+	ptr[0] = length & 0xFF;
+	ptr[1] = (length >> 8) & 0xFF;
+	ptr[2] = (length >> 16) & 0xFF;
+	ptr[3] = (length >> 24) & 0xFF;
+}
+
+EAPI int com_core_desc_is_binary(const void *buffer, int size)
+{
+	return buffer && size >= COM_CORE_DESC_HEADER_SIZE && !memcmp(buffer, COM_CORE_DESC_MAGIC, strlen(COM_CORE_DESC_MAGIC));
+}
+
+EAPI int com_core_desc_reader_init(struct com_core_desc_reader *reader, const void *buffer, int size)
+{
+	if (!reader || !com_core_desc_is_binary(buffer, size)) {
+		return -EINVAL;
+	}
+
+	if (((const unsigned char *)buffer)[strlen(COM_CORE_DESC_MAGIC)] > COM_CORE_DESC_VERSION) {
+		ErrPrint("Unsupported version: %d\n", ((const unsigned char *)buffer)[strlen(COM_CORE_DESC_MAGIC)]);
+		return -ENOTSUP;
+	}
+
+	reader->buffer = buffer;
+	reader->size = size;
+	reader->offset = COM_CORE_DESC_HEADER_SIZE;
+	return 0;
+}
+
+EAPI int com_core_desc_reader_next(struct com_core_desc_reader *reader, struct com_core_desc_block *block)
+{
+	const unsigned char *ptr;
+	const char *value;
+	unsigned int length;
+	int offset;
+	int count;
+
+	if (!reader || !block) {
+		return -EINVAL;
+	}
+
+	if (reader->offset >= reader->size) {
+		return 0;
+	}
+
+	memset(block, 0, sizeof(*block));
+
+	offset = reader->offset;
+	ptr = (const unsigned char *)reader->buffer;
+	count = ptr[offset++];
+
+	while (count-- > 0) {
+		if (reader->size - offset < FIELD_HEADER_SIZE) {
+			ErrPrint("Field is truncated at %d\n", offset);
+			return -EFAULT;
+		}
+
+		length = get_length(ptr + offset + 1);
+		if (length >= (unsigned int)(reader->size - offset - FIELD_HEADER_SIZE)) {
+			ErrPrint("Value is truncated at %d (%u)\n", offset, length);
+			return -EFAULT;
+		}
+
+		value = reader->buffer + offset + FIELD_HEADER_SIZE;
+		if (value[length] != '\0') {
+			ErrPrint("Value is not terminated at %d\n", offset);
+			return -EFAULT;
+		}
+
+		switch (ptr[offset]) {
+		case COM_CORE_DESC_FIELD_TYPE:
+			block->type = value;
+			break;
+		case COM_CORE_DESC_FIELD_PART:
+			block->part = value;
+			break;
+		case COM_CORE_DESC_FIELD_DATA:
+			block->data = value;
+			break;
+		case COM_CORE_DESC_FIELD_OPTION:
+			block->option = value;
+			break;
+		case COM_CORE_DESC_FIELD_ID:
+			block->id = value;
+			break;
+		case COM_CORE_DESC_FIELD_TARGET:
+			block->target = value;
+			break;
+		case COM_CORE_DESC_FIELD_FILE:
+			block->file = value;
+			break;
+		default:
+			/* Fields of the newer version */
+			break;
+		}
+
+		offset += FIELD_HEADER_SIZE + length + 1;
+	}
+
+	reader->offset = offset;
+	return 1;
+}
+
+EAPI int com_core_desc_foreach_block(const void *buffer, int size, int (*block_cb)(const struct com_core_desc_block *block, int blockno, void *data), void *data)
+{
+	struct com_core_desc_reader reader;
+	struct com_core_desc_block block;
+	int blockno;
+	int ret;
+
+	if (!block_cb) {
+		return -EINVAL;
+	}
+
+	ret = com_core_desc_reader_init(&reader, buffer, size);
+	if (ret < 0) {
+		return ret;
+	}
+
+	blockno = 0;
+	while ((ret = com_core_desc_reader_next(&reader, &block)) > 0) {
+		blockno++;
+		ret = block_cb(&block, blockno, data);
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
+	if (ret < 0) {
+		ErrPrint("Block %d is broken\n", blockno + 1);
+		return ret;
+	}
+
+	return blockno;
+}
+
+EAPI int com_core_desc_write_header(void *buffer, int size)
+{
+	unsigned char *ptr = buffer;
+
+	if (!buffer) {
+		return COM_CORE_DESC_HEADER_SIZE;
+	}
+
+	if (size < COM_CORE_DESC_HEADER_SIZE) {
+		return -ENOSPC;
+	}
+
+	memcpy(ptr, COM_CORE_DESC_MAGIC, strlen(COM_CORE_DESC_MAGIC));
+	ptr[strlen(COM_CORE_DESC_MAGIC)] = COM_CORE_DESC_VERSION;
+	memset(ptr + strlen(COM_CORE_DESC_MAGIC) + 1, 0, COM_CORE_DESC_HEADER_SIZE - strlen(COM_CORE_DESC_MAGIC) - 1);
+	return COM_CORE_DESC_HEADER_SIZE;
+}
+
+EAPI int com_core_desc_write_block(void *buffer, int size, const struct com_core_desc_block *block)
+{
+	const struct {
+		enum com_core_desc_field tag;
+		const char *value;
+	} fields[FIELD_MAX] = {
+		{ COM_CORE_DESC_FIELD_TYPE, block ? block->type : NULL },
+		{ COM_CORE_DESC_FIELD_PART, block ? block->part : NULL },
+		{ COM_CORE_DESC_FIELD_DATA, block ? block->data : NULL },
+		{ COM_CORE_DESC_FIELD_OPTION, block ? block->option : NULL },
+		{ COM_CORE_DESC_FIELD_ID, block ? block->id : NULL },
+		{ COM_CORE_DESC_FIELD_TARGET, block ? block->target : NULL },
+		{ COM_CORE_DESC_FIELD_FILE, block ? block->file : NULL },
+	};
+	unsigned char *ptr = buffer;
+	unsigned int length;
+	int required;
+	int offset;
+	int count;
+	int i;
+
+	if (!block || !block->type) {
+		return -EINVAL;
+	}
+
+	required = 1;
+	count = 0;
+	for (i = 0; i < FIELD_MAX; i++) {
+		if (fields[i].value) {
+			required += FIELD_HEADER_SIZE + strlen(fields[i].value) + 1;
+			count++;
+		}
+	}
+
+	if (!buffer) {
+		return required;
+	}
+
+	if (size < required) {
+		return -ENOSPC;
+	}
+
+	ptr[0] = count;
+	offset = 1;
+
+	for (i = 0; i < FIELD_MAX; i++) {
+		if (!fields[i].value) {
+			continue;
+		}
+
+		length = strlen(fields[i].value);
+		ptr[offset] = fields[i].tag;
+		put_length(ptr + offset + 1, length);
+		memcpy(ptr + offset + FIELD_HEADER_SIZE, fields[i].value, length + 1);
+		offset += FIELD_HEADER_SIZE + length + 1;
+	}
+
+	return offset;
+}
+
+/* End of a file */
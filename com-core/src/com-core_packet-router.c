@@ -20,16 +20,20 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <stdint.h>
 #include <pthread.h>
 #include <fcntl.h> /* Obtain O_* constant definitions */
 #include <unistd.h>
+#include <sched.h>
 #include <sys/select.h>
+#include <sys/eventfd.h>
 
 #include <glib.h>
 #include <dlog.h>
 
 #include "secure_socket.h"
 #include "dlist.h"
+#include "request_table.h"
 #include "packet.h"
 #include "com-core.h"
 #include "com-core_packet.h"
@@ -37,11 +41,57 @@
 #include "util.h"
 #include "com-core_packet-router.h"
 
+#define PACKET_QUEUE_SIZE	512	/*!< Must be a power of 2 */
+#define PACKET_QUEUE_BACKOFF	1000	/*!< usec, waiting time of the reader for a free slot of the full recv queue */
+#define PACKET_PARKED_MAX	PACKET_QUEUE_SIZE	/*!< Senders get -EAGAIN if this many packets are parked already */
+
+/*!
+ * \brief Slot of the packet queue
+ * \note
+ * seq is used to synchronize the producer and the consumer without a lock.
+ * seq == position : slot is free, producer can fill it.
+ * seq == position + 1 : slot is filled, consumer can take it.
+ */
 struct packet_item {
+	unsigned long seq;
+	int handle;
 	pid_t pid;
 	struct packet *packet;
 };
 
+/*!
+ * \brief Bounded lock-free queue, multiple producers and a single consumer.
+ * \note
+ * The consumer is woken up via evt_fd (eventfd) only if it is not signalled yet,
+ * so a burst of packets costs only one wakeup and the consumer drains them all at once.
+ * If the consumer has many queues on the same evt_fd, the signalled queue is pushed to its ready stack,
+ * so the consumer drains only the queues which have packets.
+ */
+struct packet_queue {
+	struct packet_item *item;
+	unsigned long mask;
+	unsigned long head; /*!< Only used by the consumer */
+	unsigned long tail; /*!< Shared by producers */
+	int signalled;
+	int evt_fd; /*!< Not owned by the queue */
+
+	struct packet_queue **ready; /*!< Ready stack of the consumer, NULL if the queue has its own evt_fd */
+	struct packet_queue *next; /*!< Link of the ready stack, valid while the queue is signalled */
+};
+
+/*!
+ * \brief Packet which is not queued because the send queue was full
+ * \note
+ * pos is the tail of the send queue when it is parked,
+ * packets queued before it have to be sent first.
+ */
+struct parked_packet {
+	struct parked_packet *next;
+	int handle;
+	struct packet *packet;
+	unsigned long pos;
+};
+
 struct route {
 	unsigned long address;
 	int handle;
@@ -53,6 +103,8 @@ struct client {
 	int handle;
 
 	pthread_t thid;
+
+	struct packet_queue recv_queue; /*!< Leaf thread -> Main */
 };
 
 struct recv_ctx {
@@ -71,6 +123,8 @@ struct recv_ctx {
 };
 
 struct request_ctx {
+	struct request_node node; /*!< Must be the first member */
+
 	pid_t pid;
 	int handle;
 
@@ -88,23 +142,24 @@ struct router {
 
 	double timeout;
 
-	pthread_mutex_t recv_packet_list_lock;
-	struct dlist *recv_packet_list;
-
 	pthread_mutex_t route_list_lock;
 	struct dlist *route_list;
 
-	pthread_mutex_t send_packet_list_lock;
-	struct dlist *send_packet_list;
+	struct packet_queue recv_queue; /*!< Client thread -> Main, only used by the client */
+	struct packet_queue send_queue; /*!< Main, Client, Server -> Send thread */
+	struct packet_queue *ready_queue; /*!< Stack of signalled recv queues */
+	struct parked_packet *parked; /*!< Stack of packets waiting for the send thread, latest first */
+	int parked_count; /*!< Count of parked packets, including the ones taken by the send thread */
 
-	int recv_pipe[PIPE_MAX];
-	int send_pipe[PIPE_MAX];
+	int recv_evt_fd;
+	int send_evt_fd;
 
 	pthread_t send_thid;
 
 	guint id;
 
 	unsigned long count_of_dropped_packet;
+	unsigned long count_of_full_queue;
 
 	int is_server;
 	union {
@@ -126,26 +181,191 @@ struct event_item {
 
 static struct info {
 	struct dlist *router_list;
-	struct dlist *request_list;
+	struct request_table *request_table;
 
 	struct dlist *disconnected_list;
 	struct dlist *connected_list;
 	struct dlist *error_list;
 } s_info = {
 	.router_list = NULL,
-	.request_list = NULL,
+	.request_table = NULL,
 
 	.disconnected_list = NULL,
 	.connected_list = NULL,
 	.error_list = NULL,
 };
 
-static struct packet *get_recv_packet(struct router *router, int *handle, pid_t *pid);
-static int put_recv_packet(struct router *router, int handle, struct packet *packet, pid_t pid);
-
-static struct packet *get_send_packet(struct router *router, int *handle);
+static int put_recv_packet(struct router *router, struct packet_queue *queue, int handle, struct packet *packet, pid_t pid);
 static int put_send_packet(struct router *router, int handle, struct packet *packet);
 
+/*!
+ * \NOTE
+ * Running thread: Main
+ */
+static int queue_init(struct packet_queue *queue, int evt_fd, struct packet_queue **ready)
+{
+	unsigned long i;
+
+	queue->item = malloc(sizeof(*queue->item) * PACKET_QUEUE_SIZE);
+	if (!queue->item) {
+		ErrPrint("Heap: %s\n", strerror(errno));
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < PACKET_QUEUE_SIZE; i++) {
+		queue->item[i].seq = i;
+		queue->item[i].packet = NULL;
+	}
+
+	queue->mask = PACKET_QUEUE_SIZE - 1;
+	queue->head = 0lu;
+	queue->tail = 0lu;
+	queue->signalled = 0;
+	queue->evt_fd = evt_fd;
+	queue->ready = ready;
+	queue->next = NULL;
+	return 0;
+}
+
+/*!
+ * \NOTE
+ * Running threads: Producer of the queue
+ *
+ * Only the producer which signals the queue pushes it, so a queue is never pushed twice.
+ * The consumer takes the whole stack at once, so there is no ABA problem.
+ */
+static inline void ready_push(struct packet_queue *queue)
+{
+	struct packet_queue *head;
+
+	head = __atomic_load_n(queue->ready, __ATOMIC_RELAXED);
+	do {
+		queue->next = head;
+	} while (!__atomic_compare_exchange_n(queue->ready, &head, queue, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/*!
+ * \NOTE
+ * Running threads: Main / Client / Server
+ *
+ * Returns -EAGAIN if the queue is full.
+ */
+static int queue_push(struct packet_queue *queue, int handle, struct packet *packet, pid_t pid)
+{
+	struct packet_item *item;
+	unsigned long pos;
+	unsigned long seq;
+	long diff;
+
+	pos = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+	while (1) {
+		item = queue->item + (pos & queue->mask);
+		seq = __atomic_load_n(&item->seq, __ATOMIC_ACQUIRE);
+		diff = (long)seq - (long)pos;
+		if (diff == 0) {
+			if (__atomic_compare_exchange_n(&queue->tail, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+				break;
+			}
+		} else if (diff < 0) {
+			return -EAGAIN;
+		} else {
+			pos = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+		}
+	}
+
+	item->handle = handle;
+	item->pid = pid;
+	item->packet = packet;
+	__atomic_store_n(&item->seq, pos + 1, __ATOMIC_RELEASE);
+
+	/*!
+	 * \note
+	 * Producing an event only if the consumer is not signalled yet.
+	 */
+	if (!__atomic_exchange_n(&queue->signalled, 1, __ATOMIC_SEQ_CST)) {
+		uint64_t count = 1llu;
+
+		if (queue->ready) {
+			ready_push(queue);
+		}
+
+		if (write(queue->evt_fd, &count, sizeof(count)) != sizeof(count)) {
+			ErrPrint("Failed to put an event: %s\n", strerror(errno));
+		}
+	}
+
+	return 0;
+}
+
+/*!
+ * \NOTE
+ * Running thread: Consumer of the queue (Main or Send thread)
+ *
+ * Returns -ENOENT if the queue is empty.
+ */
+static int queue_pop(struct packet_queue *queue, int *handle, struct packet **packet, pid_t *pid)
+{
+	struct packet_item *item;
+	unsigned long pos;
+	unsigned long seq;
+
+	pos = queue->head;
+	item = queue->item + (pos & queue->mask);
+	seq = __atomic_load_n(&item->seq, __ATOMIC_ACQUIRE);
+	if ((long)seq - (long)(pos + 1) < 0) {
+		return -ENOENT;
+	}
+
+	*handle = item->handle;
+	*packet = item->packet;
+	if (pid) {
+		*pid = item->pid;
+	}
+
+	item->packet = NULL;
+	queue->head = pos + 1;
+	__atomic_store_n(&item->seq, pos + queue->mask + 1, __ATOMIC_RELEASE);
+	return 0;
+}
+
+/*!
+ * \NOTE
+ * Running thread: Consumer of the queue (Main or Send thread)
+ *
+ * Must be called before draining the queue.
+ * If a producer puts a packet after this, the consumer will be signalled again.
+ */
+static inline void queue_rearm(struct packet_queue *queue)
+{
+	__atomic_store_n(&queue->signalled, 0, __ATOMIC_SEQ_CST);
+}
+
+/*!
+ * \NOTE
+ * Running thread: Main
+ *
+ * Every producer and the consumer must be terminated before call this.
+ */
+static void queue_fini(struct packet_queue *queue)
+{
+	struct packet *packet;
+	int handle;
+
+	if (!queue->item) {
+		return;
+	}
+
+	while (queue_pop(queue, &handle, &packet, NULL) == 0) {
+		if (packet) {
+			DbgPrint("Discarding a packet (%d)\n", handle);
+			packet_destroy(packet);
+		}
+	}
+
+	free(queue->item);
+	queue->item = NULL;
+}
+
 /*!
  * \note
  * Running thread: Main
@@ -242,16 +462,11 @@ static inline int invoke_error_cb(struct router *router, int handle)
  */
 static inline struct request_ctx *find_request_ctx(int handle, double seq)
 {
-	struct request_ctx *ctx;
-	struct dlist *l;
-
-	dlist_foreach(s_info.request_list, l, ctx) {
-		if (ctx->handle == handle && packet_seq(ctx->packet) == seq) {
-			return ctx;
-		}
+	if (!s_info.request_table) {
+		return NULL;
 	}
 
-	return NULL;
+	return (struct request_ctx *)request_table_find(s_info.request_table, handle, seq);
 }
 
 /*!
@@ -261,7 +476,7 @@ static inline struct request_ctx *find_request_ctx(int handle, double seq)
 static inline void destroy_request_ctx(struct request_ctx *ctx)
 {
 	packet_unref(ctx->packet);
-	dlist_remove_data(s_info.request_list, ctx);
+	request_table_del(s_info.request_table, &ctx->node);
 	free(ctx);
 }
 
@@ -272,13 +487,17 @@ static inline void destroy_request_ctx(struct request_ctx *ctx)
 static inline void clear_request_ctx(int handle)
 {
 	struct request_ctx *ctx;
+	struct dlist *list;
 	struct dlist *l;
 	struct dlist *n;
 
-	dlist_foreach_safe(s_info.request_list, l, n, ctx) {
-		if (ctx->handle != handle) {
-			continue;
-		}
+	if (!s_info.request_table) {
+		return;
+	}
+
+	list = request_table_list(s_info.request_table, handle);
+	dlist_foreach_safe(list, l, n, ctx) {
+		list = dlist_remove(list, l);
 
 		if (ctx->recv_cb) {
 			ctx->recv_cb(-1, handle, NULL, ctx->data);
@@ -292,10 +511,17 @@ static inline void clear_request_ctx(int handle)
  * \NOTE
  * Running thread: Main
  */
-static inline struct request_ctx *create_request_ctx(int handle)
+static inline struct request_ctx *create_request_ctx(int handle, struct packet *packet)
 {
 	struct request_ctx *ctx;
 
+	if (!s_info.request_table) {
+		s_info.request_table = request_table_create();
+		if (!s_info.request_table) {
+			return NULL;
+		}
+	}
+
 	ctx = malloc(sizeof(*ctx));
 	if (!ctx) {
 		ErrPrint("Heap: %s\n", strerror(errno));
@@ -304,11 +530,16 @@ static inline struct request_ctx *create_request_ctx(int handle)
 
 	ctx->handle = handle;
 	ctx->pid = (pid_t)-1;
-	ctx->packet = NULL;
+	ctx->packet = packet_ref(packet);
 	ctx->recv_cb = NULL;
 	ctx->data = NULL;
 
-	s_info.request_list = dlist_append(s_info.request_list, ctx);
+	if (request_table_add(s_info.request_table, &ctx->node, handle, packet_seq(packet)) < 0) {
+		packet_unref(ctx->packet);
+		free(ctx);
+		return NULL;
+	}
+
 	return ctx;
 }
 
@@ -346,33 +577,11 @@ static struct router *find_router_by_handle(int handle)
  * \NOTE
  * Running thread: Main
  */
-static gboolean packet_cb(GIOChannel *src, GIOCondition cond, gpointer data)
+static void dispatch_packet(struct router *router, int handle, pid_t pid, struct packet *packet)
 {
-	struct router *router = data;
-	struct packet *packet;
 	struct packet *result_packet;
 	struct request_ctx *request;
-	int evt_handle;
-	int handle = -1;
-	pid_t pid = (pid_t)-1;
-
-	evt_handle = g_io_channel_unix_get_fd(src);
-	if (evt_handle != router->recv_pipe[PIPE_READ]) {
-		ErrPrint("Invalid FD\n");
-		goto errout;
-	}
 
-	if (!(cond & G_IO_IN)) {
-		DbgPrint("PIPE is not valid\n");
-		goto errout;
-	}
-
-	if ((cond & G_IO_ERR) || (cond & G_IO_HUP) || (cond & G_IO_NVAL)) {
-		DbgPrint("PIPE is not valid\n");
-		goto errout;
-	}
-
-	packet = get_recv_packet(router, &handle, &pid);
 	if (!packet) {
 		(void)invoke_disconnected_cb(router, handle);
 		clear_request_ctx(handle);
@@ -436,6 +645,70 @@ static gboolean packet_cb(GIOChannel *src, GIOCondition cond, gpointer data)
 	 * How could we disconnect from the client?
 	 */
 	packet_destroy(packet);
+}
+
+/*!
+ * \NOTE
+ * Running thread: Main
+ */
+static inline void drain_recv_queue(struct router *router, struct packet_queue *queue)
+{
+	struct packet *packet;
+	int handle;
+	pid_t pid;
+
+	queue_rearm(queue);
+	while (queue_pop(queue, &handle, &packet, &pid) == 0) {
+		dispatch_packet(router, handle, pid, packet);
+	}
+}
+
+/*!
+ * \NOTE
+ * Running thread: Main
+ */
+static gboolean packet_cb(GIOChannel *src, GIOCondition cond, gpointer data)
+{
+	struct router *router = data;
+	struct packet_queue *queue;
+	struct packet_queue *next;
+	int evt_handle;
+	uint64_t count;
+	int handle = -1;
+	pid_t pid = (pid_t)-1;
+
+	evt_handle = g_io_channel_unix_get_fd(src);
+	if (evt_handle != router->recv_evt_fd) {
+		ErrPrint("Invalid FD\n");
+		goto errout;
+	}
+
+	if (!(cond & G_IO_IN)) {
+		DbgPrint("EventFD is not valid\n");
+		goto errout;
+	}
+
+	if ((cond & G_IO_ERR) || (cond & G_IO_HUP) || (cond & G_IO_NVAL)) {
+		DbgPrint("EventFD is not valid\n");
+		goto errout;
+	}
+
+	/*!
+	 * \note
+	 * Consuming the event, every signalled queue will be drained at once
+	 */
+	if (read(router->recv_evt_fd, &count, sizeof(count)) != sizeof(count) && errno != EAGAIN) {
+		ErrPrint("Failed to get an event: %s\n", strerror(errno));
+	}
+
+	queue = __atomic_exchange_n(&router->ready_queue, NULL, __ATOMIC_ACQUIRE);
+	while (queue) {
+		/* Once it is rearmed, a producer can push it again */
+		next = queue->next;
+		drain_recv_queue(router, queue);
+		queue = next;
+	}
+
 	return TRUE;
 
 errout:
@@ -451,7 +724,7 @@ static struct packet *service_handler(int handle, pid_t pid, const struct packet
 {
 	struct method *table = data;
 	struct packet *result;
-	register int i;
+	int cmd_idx;
 
 	if (!packet) {
 		DbgPrint("Connection is lost [%d] [%d]\n", handle, pid);
@@ -460,17 +733,9 @@ static struct packet *service_handler(int handle, pid_t pid, const struct packet
 
 	result = NULL;
 
-	const char *cmd = packet_command(packet);
-	if (cmd) {
-		for (i = 0; table[i].cmd; i++) {
-
-			if (strcmp(table[i].cmd, cmd)) {
-				continue;
-			}
-
-			result = table[i].handler(pid, handle, packet);
-			break;
-		}
+	cmd_idx = com_core_packet_method_index(table, packet_command(packet));
+	if (cmd_idx >= 0) {
+		result = table[cmd_idx].handler(pid, handle, packet);
 	}
 
 	return result;
@@ -546,6 +811,122 @@ static inline int select_event(int handle, double timeout)
 	return 0;
 }
 
+/*!
+ * \NOTE
+ * Running thread: Send thread
+ */
+static inline int send_packet(struct router *router, int handle, struct packet *packet)
+{
+	int ret;
+
+	switch (packet_type(packet)) {
+	case PACKET_REQ:
+	case PACKET_REQ_NOACK:
+		ret = com_core_send(handle, (void *)packet_data(packet), packet_size(packet), router->timeout);
+		break;
+	default:
+		ret = -EINVAL;
+		break;
+	}
+
+	packet_destroy(packet);
+	return ret;
+}
+
+/*!
+ * \NOTE
+ * Running thread: Send thread / Main
+ */
+static void destroy_parked_packets(struct router *router, struct parked_packet *parked)
+{
+	struct parked_packet *item;
+
+	while (parked) {
+		item = parked;
+		parked = item->next;
+
+		if (item->packet) {
+			DbgPrint("Discarding a parked packet (%d)\n", item->handle);
+			packet_destroy(item->packet);
+		}
+		free(item);
+		__atomic_sub_fetch(&router->parked_count, 1, __ATOMIC_RELEASE);
+	}
+}
+
+/*!
+ * \NOTE
+ * Running thread: Send thread
+ *
+ * Takes every parked packet, in the order of parking.
+ */
+static inline struct parked_packet *take_parked_packets(struct router *router)
+{
+	struct parked_packet *parked;
+	struct parked_packet *item;
+	struct parked_packet *list = NULL;
+
+	parked = __atomic_exchange_n(&router->parked, NULL, __ATOMIC_ACQUIRE);
+	while (parked) {
+		item = parked;
+		parked = item->next;
+		item->next = list;
+		list = item;
+	}
+
+	return list;
+}
+
+/*!
+ * \NOTE
+ * Running thread: Send thread
+ *
+ * Sends the parked packets, after the packets which were queued before them.
+ * Returns 1 if the NULL packet is found.
+ */
+static int send_parked_packets(struct router *router)
+{
+	struct parked_packet *parked;
+	struct parked_packet *item;
+	struct packet *packet;
+	int handle;
+
+	parked = take_parked_packets(router);
+	while (parked) {
+		item = parked;
+
+		while ((long)(item->pos - router->send_queue.head) > 0) {
+			if (queue_pop(&router->send_queue, &handle, &packet, NULL) < 0) {
+				/* A producer took the slot but it is not filled yet */
+				sched_yield();
+				continue;
+			}
+
+			if (!packet) {
+				destroy_parked_packets(router, parked);
+				return 1;
+			}
+
+			(void)send_packet(router, handle, packet);
+		}
+
+		parked = item->next;
+		packet = item->packet;
+		handle = item->handle;
+		free(item);
+		__atomic_sub_fetch(&router->parked_count, 1, __ATOMIC_RELEASE);
+
+		if (!packet) {
+			destroy_parked_packets(router, parked);
+			return 1;
+		}
+
+		(void)send_packet(router, handle, packet);
+	}
+
+	return 0;
+}
+
 /*!
  * \NOTE
  * Running thread: Send thread
@@ -554,43 +935,73 @@ static void *send_main(void *data)
 {
 	struct router *router = data;
 	struct packet *packet;
+	uint64_t count;
 	int handle;
-	int ret;
+	int ret = 0;
 
 	while (1) {
+		if (read(router->send_evt_fd, &count, sizeof(count)) != sizeof(count)) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			ret = -errno;
+			ErrPrint("Failed to get an event: %s\n", strerror(errno));
+			break;
+		}
+
 		/*!
 		 * \note
-		 * select event has cancel point
+		 * Send all queued packets in a batch
 		 */
-		ret = select_event(router->send_pipe[PIPE_READ], 0.0f);
-		if (ret == -EAGAIN) {
-			continue;
-		}
+		queue_rearm(&router->send_queue);
+		while (queue_pop(&router->send_queue, &handle, &packet, NULL) == 0) {
+			if (!packet) {
+				DbgPrint("NULL Packet. Terminate thread\n");
+				return (void *)(unsigned long)ret;
+			}
 
-		if (ret < 0) {
-			break;
+			ret = send_packet(router, handle, packet);
 		}
 
-		packet = get_send_packet(router, &handle);
-		if (!packet) {
+		if (__atomic_load_n(&router->parked, __ATOMIC_ACQUIRE) && send_parked_packets(router)) {
 			DbgPrint("NULL Packet. Terminate thread\n");
-			break;
+			return (void *)(unsigned long)ret;
 		}
+	}
 
-		switch (packet_type(packet)) {
-		case PACKET_REQ:
-		case PACKET_REQ_NOACK:
-			ret = com_core_send(handle, (void *)packet_data(packet), packet_size(packet), router->timeout);
-			break;
-		default:
-			ret = -EINVAL;
-			break;
-		}
+	return (void *)(unsigned long)ret;
+}
+
+/*!
+ * \NOTE
+ * Running thread: Main
+ */
+static inline void release_router(struct router *router)
+{
+	int ret;
+
+	queue_fini(&router->send_queue);
+	queue_fini(&router->recv_queue);
+	destroy_parked_packets(router, router->parked);
+	router->parked = NULL;
 
-		packet_destroy(packet);
+	if (close(router->recv_evt_fd) < 0) {
+		ErrPrint("close: %s\n", strerror(errno));
 	}
 
-	return (void *)(unsigned long)ret;
+	if (close(router->send_evt_fd) < 0) {
+		ErrPrint("close: %s\n", strerror(errno));
+	}
+
+	free(router->sock);
+
+	ret = pthread_mutex_destroy(&router->route_list_lock);
+	if (ret != 0) {
+		ErrPrint("Mutex destroy failed: %s\n", strerror(ret));
+	}
+
+	free(router);
 }
 
 /*!
@@ -609,39 +1020,9 @@ static struct router *create_router(const char *sock, int handle, struct method
 		return NULL;
 	}
 
-	ret = pthread_mutex_init(&router->recv_packet_list_lock, NULL);
-	if (ret != 0) {
-		ErrPrint("Mutex creation failed: %s\n", strerror(ret));
-		free(router);
-		return NULL;
-	}
-
 	ret = pthread_mutex_init(&router->route_list_lock, NULL);
 	if (ret != 0) {
 		ErrPrint("Mutex craetion failed: %s\n", strerror(ret));
-		ret = pthread_mutex_destroy(&router->recv_packet_list_lock);
-		if (ret != 0) {
-			ErrPrint("Mutex destroy failed: %s\n", strerror(ret));
-		}
-
-		free(router);
-		return NULL;
-	}
-
-	ret = pthread_mutex_init(&router->send_packet_list_lock, NULL);
-	if (ret != 0) {
-		ErrPrint("Mutex creation failed: %s\n", strerror(ret));
-
-		ret = pthread_mutex_destroy(&router->recv_packet_list_lock);
-		if (ret != 0) {
-			ErrPrint("Mutex destroy failed: %s\n", strerror(ret));
-		}
-
-		ret = pthread_mutex_destroy(&router->route_list_lock);
-		if (ret != 0) {
-			ErrPrint("Mutex destroy failed: %s\n", strerror(ret));
-		}
-
 		free(router);
 		return NULL;
 	}
@@ -649,16 +1030,6 @@ static struct router *create_router(const char *sock, int handle, struct method
 	router->sock = strdup(sock);
 	if (!router->sock) {
 		ErrPrint("Heap: %s\n", strerror(errno));
-		ret = pthread_mutex_destroy(&router->send_packet_list_lock);
-		if (ret != 0) {
-			ErrPrint("Mutex destroy failed: %s\n", strerror(ret));
-		}
-
-		ret = pthread_mutex_destroy(&router->recv_packet_list_lock);
-		if (ret != 0) {
-			ErrPrint("Mutex destroy failed: %s\n", strerror(ret));
-		}
-
 		ret = pthread_mutex_destroy(&router->route_list_lock);
 		if (ret != 0) {
 			ErrPrint("Mutex destroy failed: %s\n", strerror(ret));
@@ -668,21 +1039,11 @@ static struct router *create_router(const char *sock, int handle, struct method
 		return NULL;
 	}
 
-	ret = pipe2(router->recv_pipe, O_NONBLOCK | O_CLOEXEC);
-	if (ret < 0) {
-		ErrPrint("pipe2: %s\n", strerror(errno));
+	router->recv_evt_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (router->recv_evt_fd < 0) {
+		ErrPrint("eventfd: %s\n", strerror(errno));
 		free(router->sock);
 
-		ret = pthread_mutex_destroy(&router->send_packet_list_lock);
-		if (ret != 0) {
-			ErrPrint("Mutex destroy failed: %s\n", strerror(ret));
-		}
-
-		ret = pthread_mutex_destroy(&router->recv_packet_list_lock);
-		if (ret != 0) {
-			ErrPrint("Mutex destroy failed: %s\n", strerror(ret));
-		}
-
 		ret = pthread_mutex_destroy(&router->route_list_lock);
 		if (ret != 0) {
 			ErrPrint("Mutex destroy failed: %s\n", strerror(ret));
@@ -692,22 +1053,18 @@ static struct router *create_router(const char *sock, int handle, struct method
 		return NULL;
 	}
 
-	ret = pipe2(router->send_pipe, O_NONBLOCK | O_CLOEXEC);
-	if (ret < 0) {
-		ErrPrint("pipe2: %s\n", strerror(errno));
-		free(router->sock);
-
-		CLOSE_PIPE(router->recv_pipe);
-
-		ret = pthread_mutex_destroy(&router->send_packet_list_lock);
-		if (ret != 0) {
-			ErrPrint("Mutex destroy failed: %s\n", strerror(ret));
+	/*!
+	 * \note
+	 * The send thread blocks on this until the packet is queued.
+	 */
+	router->send_evt_fd = eventfd(0, EFD_CLOEXEC);
+	if (router->send_evt_fd < 0) {
+		ErrPrint("eventfd: %s\n", strerror(errno));
+		if (close(router->recv_evt_fd) < 0) {
+			ErrPrint("close: %s\n", strerror(errno));
 		}
 
-		ret = pthread_mutex_destroy(&router->recv_packet_list_lock);
-		if (ret != 0) {
-			ErrPrint("Mutex destroy failed: %s\n", strerror(ret));
-		}
+		free(router->sock);
 
 		ret = pthread_mutex_destroy(&router->route_list_lock);
 		if (ret != 0) {
@@ -718,33 +1075,22 @@ static struct router *create_router(const char *sock, int handle, struct method
 		return NULL;
 	}
 
+	/*!
+	 * \note
+	 * release_router() can be used from here, queue_fini() handles the queue which is not initialized.
+	 */
+	if (queue_init(&router->send_queue, router->send_evt_fd, NULL) < 0 || queue_init(&router->recv_queue, router->recv_evt_fd, &router->ready_queue) < 0) {
+		release_router(router);
+		return NULL;
+	}
+
 	router->handle = handle;
 	router->service = service_handler;
 	router->data = table;
 
-	gio = g_io_channel_unix_new(router->recv_pipe[PIPE_READ]);
+	gio = g_io_channel_unix_new(router->recv_evt_fd);
 	if (!gio) {
-		CLOSE_PIPE(router->recv_pipe);
-		CLOSE_PIPE(router->send_pipe);
-
-		free(router->sock);
-
-		ret = pthread_mutex_destroy(&router->send_packet_list_lock);
-		if (ret != 0) {
-			ErrPrint("Mutex destroy failed: %s\n", strerror(ret));
-		}
-
-		ret = pthread_mutex_destroy(&router->recv_packet_list_lock);
-		if (ret != 0) {
-			ErrPrint("Mutex destroy failed: %s\n", strerror(ret));
-		}
-
-		ret = pthread_mutex_destroy(&router->route_list_lock);
-		if (ret != 0) {
-			ErrPrint("Mutex destroy failed: %s\n", strerror(ret));
-		}
-
-		free(router);
+		release_router(router);
 		return NULL;
 	}
 	g_io_channel_set_close_on_unref(gio, FALSE);
@@ -759,27 +1105,7 @@ static struct router *create_router(const char *sock, int handle, struct method
 		}
 		g_io_channel_unref(gio);
 
-		CLOSE_PIPE(router->recv_pipe);
-		CLOSE_PIPE(router->send_pipe);
-
-		free(router->sock);
-
-		ret = pthread_mutex_destroy(&router->send_packet_list_lock);
-		if (ret != 0) {
-			ErrPrint("Mutex destroy failed: %s\n", strerror(ret));
-		}
-
-		ret = pthread_mutex_destroy(&router->recv_packet_list_lock);
-		if (ret != 0) {
-			ErrPrint("Mutex destroy failed: %s\n", strerror(ret));
-		}
-
-		ret = pthread_mutex_destroy(&router->route_list_lock);
-		if (ret != 0) {
-			ErrPrint("Mutex destroy failed: %s\n", strerror(ret));
-		}
-
-		free(router);
+		release_router(router);
 		return NULL;
 	}
 
@@ -794,27 +1120,7 @@ static struct router *create_router(const char *sock, int handle, struct method
 
 		g_source_remove(router->id);
 
-		CLOSE_PIPE(router->recv_pipe);
-		CLOSE_PIPE(router->send_pipe);
-
-		free(router->sock);
-
-		ret = pthread_mutex_destroy(&router->send_packet_list_lock);
-		if (ret != 0) {
-			ErrPrint("Mutex destroy failed: %s\n", strerror(ret));
-		}
-
-		ret = pthread_mutex_destroy(&router->recv_packet_list_lock);
-		if (ret != 0) {
-			ErrPrint("Mutex destroy failed: %s\n", strerror(ret));
-		}
-
-		ret = pthread_mutex_destroy(&router->route_list_lock);
-		if (ret != 0) {
-			ErrPrint("Mutex destroy failed: %s\n", strerror(ret));
-		}
-
-		free(router);
+		release_router(router);
 		return NULL;
 	}
 
@@ -846,28 +1152,8 @@ static inline __attribute__((always_inline)) int destroy_router(struct router *r
 		g_source_remove(router->id);
 	}
 
-	CLOSE_PIPE(router->recv_pipe);
-	CLOSE_PIPE(router->send_pipe);
-
-	free(router->sock);
-
-	ret = pthread_mutex_destroy(&router->send_packet_list_lock);
-	if (ret != 0) {
-		ErrPrint("Mutex destroy failed: %s\n", strerror(ret));
-	}
-
-	ret = pthread_mutex_destroy(&router->recv_packet_list_lock);
-	if (ret != 0) {
-		ErrPrint("Mutex destroy failed: %s\n", strerror(ret));
-	}
-
-	ret = pthread_mutex_destroy(&router->route_list_lock);
-	if (ret != 0) {
-		ErrPrint("Mutex destroy failed: %s\n", strerror(ret));
-	}
-
 	handle = router->handle;
-	free(router);
+	release_router(router);
 
 	return handle;
 }
@@ -932,145 +1218,96 @@ static inline int route_packet(struct router *router, int handle, struct packet
 /*!
  * \NOTE
  * Running Threads: Main / Client / Server
+ *
+ * If the queue is full, the packet is parked and the send thread sends it after the queued ones.
+ * While any packet is parked, the next ones are parked too, to keep the order.
+ * If PACKET_PARKED_MAX packets are parked already, -EAGAIN is returned and the caller still owns the packet.
+ * NULL packet terminates the send thread, it is always parked.
  */
 static int put_send_packet(struct router *router, int handle, struct packet *packet)
 {
-	if (packet) {
-		struct packet_item *item;
-
-		item = malloc(sizeof(*item));
-		if (!item) {
-			packet_destroy(packet);
-			return -ENOMEM;
-		}
-
-		item->packet = packet;
-		item->pid = (pid_t)-1;
-
-		CRITICAL_SECTION_BEGIN(&router->send_packet_list_lock);
-
-		router->send_packet_list = dlist_append(router->send_packet_list, item);
-
-		CRITICAL_SECTION_END(&router->send_packet_list_lock);
-	}
+	struct parked_packet *item;
+	struct parked_packet *head;
+	uint64_t count = 1llu;
 
 	/*!
 	 * \note
-	 * Producing an event on event pipe
+	 * The send thread takes the packet over, the caller's strings can be gone before it is sent.
 	 */
-	if (write(router->send_pipe[PIPE_WRITE], &handle, sizeof(handle)) != sizeof(handle)) {
-		ErrPrint("Failed to put an event: %s\n", strerror(errno));
+	if (packet && packet_flatten(packet) < 0) {
+		return -ENOMEM;
 	}
 
-	return 0;
-}
-
-/*!
- * \NOTE
- * Running thread: Client / Server leaf thread
- */
-static int put_recv_packet(struct router *router, int handle, struct packet *packet, pid_t pid)
-{
-	/*!
-	 * If a packet is NULL, the connection is terminated
-	 */
-	if (packet) {
-		struct packet_item *item;
-
-		item = malloc(sizeof(*item));
-		if (!item) {
-			packet_destroy(packet);
-			return -ENOMEM;
+	if (!__atomic_load_n(&router->parked, __ATOMIC_ACQUIRE)) {
+		if (queue_push(&router->send_queue, handle, packet, (pid_t)-1) == 0) {
+			return 0;
 		}
 
-		item->packet = packet;
-		item->pid = pid;
-
-		CRITICAL_SECTION_BEGIN(&router->recv_packet_list_lock);
-
-		router->recv_packet_list = dlist_append(router->recv_packet_list, item);
-
-		CRITICAL_SECTION_END(&router->recv_packet_list_lock);
+		__atomic_add_fetch(&router->count_of_full_queue, 1lu, __ATOMIC_RELAXED);
 	}
 
-	/*!
-	 * \note
-	 * Producing an event on event pipe
-	 */
-	if (write(router->recv_pipe[PIPE_WRITE], &handle, sizeof(handle)) != sizeof(handle)) {
-		ErrPrint("Failed to put an event: %s\n", strerror(errno));
+	if (__atomic_add_fetch(&router->parked_count, 1, __ATOMIC_ACQUIRE) > PACKET_PARKED_MAX && packet) {
+		__atomic_sub_fetch(&router->parked_count, 1, __ATOMIC_RELEASE);
+		ErrPrint("Too many packets are parked (%d)\n", handle);
+		return -EAGAIN;
 	}
 
-	return 0;
-}
-
-/*!
- * \NOTE
- * Running thread: Send thread
- */
-static struct packet *get_send_packet(struct router *router, int *handle)
-{
-	struct packet *packet = NULL;
-	struct dlist *l;
-	struct packet_item *item;
-
-	CRITICAL_SECTION_BEGIN(&router->send_packet_list_lock);
-
-	l = dlist_nth(router->send_packet_list, 0);
-	if (l) {
-		item = dlist_data(l);
-		router->send_packet_list = dlist_remove(router->send_packet_list, l);
-		packet = item->packet;
-		free(item);
+	item = malloc(sizeof(*item));
+	if (!item) {
+		ErrPrint("Heap: %s\n", strerror(errno));
+		__atomic_sub_fetch(&router->parked_count, 1, __ATOMIC_RELEASE);
+		return -ENOMEM;
 	}
 
-	CRITICAL_SECTION_END(&router->send_packet_list_lock);
+	item->handle = handle;
+	item->packet = packet;
+	item->pos = __atomic_load_n(&router->send_queue.tail, __ATOMIC_ACQUIRE);
 
-	if (read(router->send_pipe[PIPE_READ], handle, sizeof(*handle)) != sizeof(*handle)) {
-		ErrPrint("Failed to get an event: %s\n", strerror(errno));
+	head = __atomic_load_n(&router->parked, __ATOMIC_RELAXED);
+	do {
+		item->next = head;
+	} while (!__atomic_compare_exchange_n(&router->parked, &head, item, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+	if (write(router->send_evt_fd, &count, sizeof(count)) != sizeof(count)) {
+		ErrPrint("Failed to put an event: %s\n", strerror(errno));
 	}
 
-	return packet;
+	return 0;
 }
 
 /*!
  * \NOTE
- * Running thread: Main thread
+ * Running thread: Client / Server leaf thread
+ *
+ * If the queue is full, stop reading from the socket until the main thread makes a room.
+ * Then the sender will be blocked by the socket buffer, instead of growing the queue.
+ * If a packet is NULL, the connection is terminated.
  */
-static struct packet *get_recv_packet(struct router *router, int *handle, pid_t *pid)
+static int put_recv_packet(struct router *router, struct packet_queue *queue, int handle, struct packet *packet, pid_t pid)
 {
-	struct packet *packet = NULL;
-	struct dlist *l;
-	struct packet_item *item;
-
-	CRITICAL_SECTION_BEGIN(&router->recv_packet_list_lock);
+	int status;
 
-	l = dlist_nth(router->recv_packet_list, 0);
-	if (l) {
-		item = dlist_data(l);
-		router->recv_packet_list = dlist_remove(router->recv_packet_list, l);
+	while (queue_push(queue, handle, packet, pid) == -EAGAIN) {
+		__atomic_add_fetch(&router->count_of_full_queue, 1lu, __ATOMIC_RELAXED);
 
-		packet = item->packet;
-		if (pid) {
-			*pid = item->pid;
+		/*!
+		 * \note
+		 * The main thread can cancel this thread instead of draining the queue.
+		 */
+		status = pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+		if (status != 0) {
+			ErrPrint("Failed to set cancelstate: %s\n", strerror(status));
 		}
 
-		free(item);
-	}
-
-	CRITICAL_SECTION_END(&router->recv_packet_list_lock);
+		usleep(PACKET_QUEUE_BACKOFF);
 
-	/*!
-	 * \note
-	 * Consuming an event from event pipe
-	 * Even if we cannot get the packet(NULL), we should consuming event
-	 * Because the NULL packet means disconnected
-	 */
-	if (read(router->recv_pipe[PIPE_READ], handle, sizeof(*handle)) != sizeof(*handle)) {
-		ErrPrint("Failed to get an event: %s\n", strerror(errno));
+		status = pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+		if (status != 0) {
+			ErrPrint("Failed to set cancelstate: %s\n", strerror(status));
+		}
 	}
 
-	return packet;
+	return 0;
 }
 
 static inline int build_packet(int handle, struct recv_ctx *ctx)
@@ -1160,7 +1397,7 @@ static inline int build_packet(int handle, struct recv_ctx *ctx)
 	return 0;
 }
 
-static int router_common_main(struct router *router, int handle, struct recv_ctx *ctx)
+static int router_common_main(struct router *router, struct packet_queue *queue, int handle, struct recv_ctx *ctx)
 {
 	int ret;
 	while (1) {
@@ -1197,14 +1434,14 @@ static int router_common_main(struct router *router, int handle, struct recv_ctx
 			if (packet_destination(ctx->packet)) {
 				route_packet(router, handle, ctx->packet);
 			} else {
-				put_recv_packet(router, handle, ctx->packet, ctx->pid);
+				put_recv_packet(router, queue, handle, ctx->packet, ctx->pid);
 			}
 
 			ctx->state = RECV_STATE_INIT;
 		}
 	}
 
-	put_recv_packet(router, handle, NULL, ctx->pid);
+	put_recv_packet(router, queue, handle, NULL, ctx->pid);
 	return ret;
 }
 
@@ -1224,7 +1461,7 @@ static void *server_main(void *data)
 	ctx.timeout = router->timeout;
 	ctx.pid = (pid_t)-1;
 
-	ret = router_common_main(router, client->handle, &ctx);
+	ret = router_common_main(router, &client->recv_queue, client->handle, &ctx);
 	return (void *)(unsigned long)ret;
 }
 
@@ -1244,7 +1481,7 @@ static void *client_main(void *data)
 	ctx.offset = 0;
 	ctx.pid = (pid_t)-1;
 
-	ret = router_common_main(router, router->handle, &ctx);
+	ret = router_common_main(router, &router->recv_queue, router->handle, &ctx);
 	return (void *)(unsigned long)ret;
 }
 
@@ -1303,12 +1540,24 @@ static gboolean accept_cb(GIOChannel *src, GIOCondition cond, gpointer data)
 
 	client->handle = fd;
 	client->router = router;
+
+	if (queue_init(&client->recv_queue, router->recv_evt_fd, &router->ready_queue) < 0) {
+		secure_socket_destroy_handle(client->handle);
+		free(client);
+		/*!
+		 * \NOTE
+		 * Just return TRUE to keep this accept handler
+		 */
+		return TRUE;
+	}
+
 	router->info.server.client_list = dlist_append(router->info.server.client_list, client);
 
 	status = pthread_create(&client->thid, NULL, server_main, client);
 	if (status != 0) {
 		ErrPrint("Thread creation failed: %s\n", strerror(status));
 		dlist_remove_data(router->info.server.client_list, client);
+		queue_fini(&client->recv_queue);
 		secure_socket_destroy_handle(client->handle);
 		free(client);
 		/*!
@@ -1398,15 +1647,6 @@ EAPI int com_core_packet_router_client_init(const char *sock, double timeout, st
 	router->timeout = timeout;
 	router->is_server = 0;
 
-	status = pthread_mutex_init(&router->recv_packet_list_lock, NULL);
-	if (status != 0) {
-		ErrPrint("Mutex creation failed: %s\n", strerror(status));
-
-		handle = destroy_router(router);
-		secure_socket_destroy_handle(handle);
-		return -EFAULT;
-	}
-
 	status = pthread_mutex_init(&router->route_list_lock, NULL);
 	if (status != 0) {
 		ErrPrint("Mutex creation failed: %s\n", strerror(status));
@@ -1473,6 +1713,7 @@ EAPI void *com_core_packet_router_server_fini(int handle)
 			clear_request_ctx(client->handle);
 		}
 
+		queue_fini(&client->recv_queue);
 		secure_socket_destroy_handle(client->handle);
 		free(client);
 	}
@@ -1570,14 +1811,13 @@ EAPI int com_core_packet_router_async_send(int handle, struct packet *packet, do
 		return -EINVAL;
 	}
 
-	ctx = create_request_ctx(handle);
+	ctx = create_request_ctx(handle, packet);
 	if (!ctx) {
 		return -ENOMEM;
 	}
 
 	ctx->recv_cb = recv_cb;
 	ctx->data = data;
-	ctx->packet = packet_ref(packet);
 
 	ret = put_send_packet(router, handle, packet);
 	if (ret < 0) {
@@ -23,6 +23,7 @@
 #include <fcntl.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 #include <glib.h>
 #include <dlog.h>
@@ -33,10 +34,30 @@
 #include "packet.h"
 #include "secure_socket.h"
 #include "dlist.h"
+#include "request_table.h"
+#include "shm_ring.h"
 #include "com-core_packet.h"
 #include "util.h"
 
 #define DEFAULT_TIMEOUT 2.0f
+#define PACKET_BATCH_MAX 64 /*!< Maximum count of packets which are sent at once */
+
+#define RING_ENV "COM_CORE_RING"
+#define RING_SIZE (64 * 1024)
+
+/*!
+ * \note
+ * Commands to negotiate the shared memory ring, they are sent via the socket.
+ * Peers which don't know them just ignore them, then the socket is used as before.
+ * Commands with fd are sent only after the peer replies to the hello, so they never leak fds on such peers.
+ */
+#define RING_CMD_HELLO "::ring_hello" /*!< Ask the peer whether it knows rings */
+#define RING_CMD_READY "::ring_ready" /*!< Reply of the hello */
+#define RING_CMD_MEM "::ring_mem" /*!< memfd of the ring */
+#define RING_CMD_SPACE "::ring_space" /*!< eventfd which is written by the consumer when it makes a room */
+#define RING_CMD_EVT "::ring_evt" /*!< eventfd of the ring, the ring is attached when this arrives */
+#define RING_CMD_ACCEPT "::ring_accept" /*!< The ring is mapped */
+#define RING_CMD_START "::ring_start" /*!< Packets after this can be sent via the ring */
 /**
  * @brief
  * If the first character is started with 0x01,
@@ -45,7 +66,12 @@
 
 static struct info {
 	struct dlist *recv_list;
-	struct dlist *request_list;
+	struct request_table *request_table;
+	GHashTable *method_index_table; /*!< struct method * -> struct method_index * */
+	GHashTable *batch_table; /*!< handle -> struct send_batch * */
+	unsigned int batch_window; /*!< usec, 0 to flush at the end of a main loop iteration */
+	GHashTable *ring_table; /*!< handle -> struct ring_ctx * */
+	int ring; /*!< -1 if it is not decided yet */
 	char *addr;
 
 	struct {
@@ -60,12 +86,22 @@ static struct info {
 
 		int (*recv_with_fd)(int handle, char *buffer, int size, int *sender_pid, double timeout, int *fd);
 		int (*send_with_fd)(int handle, const char *buffer, int size, double timeout, int fd);
+		int (*sendv_with_fd)(int handle, struct iovec *iov, int iovcnt, double timeout, int fd);
+
+		/* NULL if received data cannot be accessed in place */
+		int (*recv_peek)(int handle, const char **ptr, int *sender_pid, double timeout, int *fd);
+		int (*recv_consume)(int handle, int size);
 	} vtable;
 
 	int initialized;
 } s_info = {
 	.recv_list = NULL,
-	.request_list = NULL,
+	.request_table = NULL,
+	.method_index_table = NULL,
+	.batch_table = NULL,
+	.batch_window = 0u,
+	.ring_table = NULL,
+	.ring = -1,
 	.addr = NULL,
 	.vtable = {
 		.server_create = com_core_server_create,
@@ -77,11 +113,82 @@ static struct info {
 		.send = com_core_send,
 		.recv_with_fd = com_core_recv_with_fd,
 		.send_with_fd = com_core_send_with_fd,
+		.sendv_with_fd = com_core_sendv_with_fd,
+		.recv_peek = NULL,
+		.recv_consume = NULL,
 	},
 	.initialized = 0,
 };
 
+/*!
+ * \brief
+ * Index of string commands of a method table, built once per table.
+ */
+struct method_index {
+	GHashTable *cmd_table; /*!< command string -> int tagged command */
+	unsigned int count; /*!< Count of methods */
+};
+
+/*!
+ * \brief
+ * Packets which are waiting to be sent together via one sendmsg call.
+ */
+struct send_batch {
+	int handle;
+	guint source;
+	int count;
+	struct batch_item {
+		struct packet *packet;
+		void (*result_cb)(int handle, const struct packet *packet, int status, void *data);
+		void *data;
+	} item[PACKET_BATCH_MAX];
+};
+
+/*!
+ * \brief
+ * Shared memory rings of a connection, one for each direction.
+ * If a packet has to be sent via the socket while the ring is active,
+ * a barrier is put into the ring first, so the receiver can keep the order of packets.
+ */
+struct ring_ctx {
+	int handle;
+	int peer; /*!< The peer replied to the hello */
+
+	struct shm_ring *tx;
+	int tx_active;
+	struct dlist *tx_pending; /*!< struct ring_pending, packets which are waiting for a room of the ring */
+	guint tx_watch;
+	guint tx_timer;
+	unsigned int tx_sent; /*!< Count of pending packets which are sent, to detect a stalled peer */
+	unsigned int tx_checked;
+
+	struct shm_ring *rx;
+	int rx_active;
+	int rx_mem_fd; /*!< memfd which is waiting for its eventfd */
+	int rx_space_fd; /*!< space eventfd which is waiting for the eventfd */
+	guint rx_watch;
+	int credit; /*!< Count of packets which should be received from the socket before the ring */
+	struct method *table;
+	pid_t pid;
+
+	int client; /*!< The handle is created by com_core_packet_client_init */
+	int draining;
+	int destroyed;
+};
+
+/*!
+ * \brief
+ * A packet which cannot be put into the full ring.
+ * The fd is duplicated, the caller can close its own one after sending.
+ */
+struct ring_pending {
+	struct packet *packet;
+	int fd;
+};
+
 struct request_ctx {
+	struct request_node node; /*!< Must be the first member */
+
 	pid_t pid;
 	int handle;
 
@@ -108,43 +215,93 @@ struct recv_ctx {
 	int inuse;
 };
 
-static inline struct request_ctx *find_request_ctx(int handle, double seq)
+static void method_index_destroy(gpointer data)
 {
-	struct request_ctx *ctx;
-	struct dlist *l;
+	struct method_index *index = data;
 
-	dlist_foreach(s_info.request_list, l, ctx) {
-		if (ctx->handle == handle && packet_seq(ctx->packet) == seq) {
-			return ctx;
+	g_hash_table_destroy(index->cmd_table);
+	free(index);
+}
+
+static struct method_index *method_index_build(struct method *table)
+{
+	struct method_index *index;
+	unsigned int i;
+
+	if (!s_info.method_index_table) {
+		s_info.method_index_table = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, method_index_destroy);
+		if (!s_info.method_index_table) {
+			ErrPrint("Failed to create a hash table\n");
+			return NULL;
 		}
 	}
 
-	return NULL;
+	index = g_hash_table_lookup(s_info.method_index_table, table);
+	if (index) {
+		return index;
+	}
+
+	index = malloc(sizeof(*index));
+	if (!index) {
+		ErrPrint("Heap: %s\n", strerror(errno));
+		return NULL;
+	}
+
+	index->cmd_table = g_hash_table_new(g_str_hash, g_str_equal);
+	if (!index->cmd_table) {
+		ErrPrint("Failed to create a hash table\n");
+		free(index);
+		return NULL;
+	}
+
+	for (i = 0; table[i].cmd; i++) {
+		/*!
+		 * \note
+		 * If a command is duplicated, the first one is used as the linear search did.
+		 */
+		if (!g_hash_table_lookup(index->cmd_table, table[i].cmd)) {
+			g_hash_table_insert(index->cmd_table, (gpointer)table[i].cmd, GUINT_TO_POINTER((i << 8) | PACKET_CMD_INT_TAG));
+		}
+	}
+	index->count = i;
+
+	g_hash_table_insert(s_info.method_index_table, table, index);
+	DbgPrint("Method index is built: %u commands\n", index->count);
+	return index;
 }
 
-static inline void destroy_request_ctx(struct request_ctx *ctx)
+static inline struct request_ctx *find_request_ctx(int handle, double seq)
 {
-	struct dlist *l;
-
-	if (ctx->inuse) {
-		return;
+	if (!s_info.request_table) {
+		return NULL;
 	}
 
-	l = dlist_find_data(s_info.request_list, ctx);
-	if (!l) {
+	return (struct request_ctx *)request_table_find(s_info.request_table, handle, seq);
+}
+
+static inline void destroy_request_ctx(struct request_ctx *ctx)
+{
+	if (ctx->inuse) {
 		return;
 	}
 
-	s_info.request_list = dlist_remove(s_info.request_list, l);
+	request_table_del(s_info.request_table, &ctx->node);
 
 	packet_unref(ctx->packet);
 	free(ctx);
 }
 
-static inline struct request_ctx *create_request_ctx(int handle)
+static inline struct request_ctx *create_request_ctx(int handle, struct packet *packet)
 {
 	struct request_ctx *ctx;
 
+	if (!s_info.request_table) {
+		s_info.request_table = request_table_create();
+		if (!s_info.request_table) {
+			return NULL;
+		}
+	}
+
 	ctx = malloc(sizeof(*ctx));
 	if (!ctx) {
 		ErrPrint("Heap: %s\n", strerror(errno));
@@ -153,12 +310,17 @@ static inline struct request_ctx *create_request_ctx(int handle)
 
 	ctx->handle = handle;
 	ctx->pid = (pid_t)-1;
-	ctx->packet = NULL;
+	ctx->packet = packet_ref(packet);
 	ctx->recv_cb = NULL;
 	ctx->data = NULL;
 	ctx->inuse = 0;
 
-	s_info.request_list = dlist_append(s_info.request_list, ctx);
+	if (request_table_add(s_info.request_table, &ctx->node, handle, packet_seq(packet)) < 0) {
+		packet_unref(ctx->packet);
+		free(ctx);
+		return NULL;
+	}
+
 	return ctx;
 }
 
@@ -231,15 +393,31 @@ static inline struct recv_ctx *create_recv_ctx(int handle, double timeout)
 	return ctx;
 }
 
-static inline int packet_ready(int handle, struct recv_ctx *receive, struct method *table)
+static int packet_send(int handle, struct packet *packet);
+
+/*!
+ * \note
+ * Nobody takes the fd of an unknown command, close it not to leak it.
+ */
+static inline void close_unknown_fd(struct packet *packet)
+{
+	if (packet_fd(packet) < 0) {
+		return;
+	}
+
+	DbgPrint("Close fd(%d) of an unknown command (%s)\n", packet_fd(packet), packet_command(packet));
+	if (close(packet_fd(packet)) < 0) {
+		ErrPrint("close: %s\n", strerror(errno));
+	}
+}
+
+static int packet_ready(int handle, struct recv_ctx *receive, struct method *table)
 {
 	struct request_ctx *request;
 	double sequence;
 	struct packet *result;
-	register int i;
 	int ret;
-	const char *cmd;
-	unsigned int cmd_idx;
+	int cmd_idx;
 
 	ret = 0;
 
@@ -260,94 +438,995 @@ static inline int packet_ready(int handle, struct recv_ctx *receive, struct meth
 			request->inuse = 0;
 		}
 
-		destroy_request_ctx(request);
-		break;
-	case PACKET_REQ:
-		cmd_idx = 0xFFFFFFFF;
-		cmd = packet_command(receive->packet);
-		if (cmd) {
-			if (cmd[0] == PACKET_CMD_INT_TAG) {
-				unsigned int *p_cmd_idx = (unsigned int *)cmd;
-
-				/* Get rid of LSB 8 bits */
-				cmd_idx = *p_cmd_idx >> 8;
-			} else {
-				for (i = 0; table[i].cmd; i++) {
-					if (strcmp(table[i].cmd, cmd)) {
-						continue;
-					}
+		destroy_request_ctx(request);
+		break;
+	case PACKET_REQ:
+		cmd_idx = com_core_packet_method_index(table, packet_command(receive->packet));
+		if (cmd_idx >= 0) {
+			receive->inuse = 1;
+			result = table[cmd_idx].handler(receive->pid, handle, receive->packet);
+			receive->inuse = 0;
+			if (result) {
+				ret = packet_send(handle, result);
+				if (ret < 0) {
+					ErrPrint("Failed to send an ack packet\n");
+				} else {
+					ret = 0;
+				}
+				packet_destroy(result);
+			}
+		} else {
+			close_unknown_fd(receive->packet);
+		}
+
+		break;
+	case PACKET_REQ_NOACK:
+		cmd_idx = com_core_packet_method_index(table, packet_command(receive->packet));
+		if (cmd_idx >= 0) {
+			receive->inuse = 1;
+			result = table[cmd_idx].handler(receive->pid, handle, receive->packet);
+			receive->inuse = 0;
+			if (result) {
+				packet_destroy(result);
+			}
+		} else {
+			close_unknown_fd(receive->packet);
+		}
+		break;
+	default:
+		break;
+	}
+
+	/*!
+	 * Return negative value will make call the disconnected_cb
+	 */
+	return ret;
+}
+
+static inline int ring_enabled(void)
+{
+	const char *env;
+
+	if (s_info.ring < 0) {
+		env = getenv(RING_ENV);
+		s_info.ring = env ? !!atoi(env) : 0;
+	}
+
+	return s_info.ring;
+}
+
+static inline struct ring_ctx *find_ring_ctx(int handle)
+{
+	if (!s_info.ring_table) {
+		return NULL;
+	}
+
+	return g_hash_table_lookup(s_info.ring_table, GINT_TO_POINTER(handle));
+}
+
+static void destroy_ring_pending(struct ring_pending *item)
+{
+	if (item->fd >= 0 && close(item->fd) < 0) {
+		ErrPrint("close: %s\n", strerror(errno));
+	}
+
+	packet_unref(item->packet);
+	free(item);
+}
+
+static void clear_ring_pending(struct ring_ctx *ctx)
+{
+	struct ring_pending *item;
+	struct dlist *l;
+	struct dlist *n;
+
+	dlist_foreach_safe(ctx->tx_pending, l, n, item) {
+		ctx->tx_pending = dlist_remove(ctx->tx_pending, l);
+		destroy_ring_pending(item);
+	}
+
+	if (ctx->tx_watch) {
+		g_source_remove(ctx->tx_watch);
+		ctx->tx_watch = 0;
+	}
+
+	if (ctx->tx_timer) {
+		g_source_remove(ctx->tx_timer);
+		ctx->tx_timer = 0;
+	}
+}
+
+static void free_ring_ctx(struct ring_ctx *ctx)
+{
+	if (ctx->rx_watch) {
+		g_source_remove(ctx->rx_watch);
+	}
+
+	if (ctx->rx) {
+		shm_ring_destroy(ctx->rx);
+	}
+
+	if (ctx->rx_mem_fd >= 0 && close(ctx->rx_mem_fd) < 0) {
+		ErrPrint("close: %s\n", strerror(errno));
+	}
+
+	if (ctx->rx_space_fd >= 0 && close(ctx->rx_space_fd) < 0) {
+		ErrPrint("close: %s\n", strerror(errno));
+	}
+
+	if (ctx->tx_pending) {
+		ErrPrint("%d packets are dropped (handle: %d)\n", dlist_count(ctx->tx_pending), ctx->handle);
+	}
+	clear_ring_pending(ctx);
+
+	if (ctx->tx) {
+		shm_ring_destroy(ctx->tx);
+	}
+
+	free(ctx);
+}
+
+static struct ring_ctx *create_ring_ctx(int handle)
+{
+	struct ring_ctx *ctx;
+
+	if (!s_info.ring_table) {
+		s_info.ring_table = g_hash_table_new(g_direct_hash, g_direct_equal);
+		if (!s_info.ring_table) {
+			ErrPrint("Failed to create a hash table\n");
+			return NULL;
+		}
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		ErrPrint("Heap: %s\n", strerror(errno));
+		return NULL;
+	}
+
+	ctx->handle = handle;
+	ctx->rx_mem_fd = -1;
+	ctx->rx_space_fd = -1;
+	ctx->pid = (pid_t)-1;
+	g_hash_table_insert(s_info.ring_table, GINT_TO_POINTER(handle), ctx);
+	return ctx;
+}
+
+static void destroy_ring_ctx(int handle)
+{
+	struct ring_ctx *ctx;
+
+	ctx = find_ring_ctx(handle);
+	if (!ctx) {
+		return;
+	}
+
+	g_hash_table_remove(s_info.ring_table, GINT_TO_POINTER(handle));
+
+	/*!
+	 * \note
+	 * If a handler of a packet from the ring disconnects the handle,
+	 * the context will be freed after draining.
+	 */
+	if (ctx->draining) {
+		ctx->destroyed = 1;
+		return;
+	}
+
+	free_ring_ctx(ctx);
+}
+
+/*!
+ * \brief
+ * Dispatch packets in the ring.
+ * If "barrier" is set, the first barrier is consumed, then stop.
+ * Otherwise, stop at the first barrier without consuming it.
+ * Returns the negative value of a handler, then the handle should be closed same as the socket does.
+ */
+static int ring_drain(struct ring_ctx *ctx, int barrier)
+{
+	struct recv_ctx receive;
+	struct packet *packet;
+	const void *data;
+	int ret = 0;
+	int size;
+	int type;
+
+	ctx->draining++;
+
+	while (!ctx->destroyed && ctx->rx_active) {
+		type = shm_ring_peek(ctx->rx, &data, &size);
+		if (type == -ENOENT) {
+			break;
+		} else if (type < 0) {
+			ErrPrint("Ring is broken, handle(%d)\n", ctx->handle);
+			ctx->rx_active = 0;
+			break;
+		} else if (type == SHM_RING_BARRIER) {
+			if (barrier) {
+				ctx->credit += size;
+				shm_ring_consume(ctx->rx);
+			}
+			break;
+		}
+
+		packet = NULL;
+		if (size >= packet_header_size()) {
+			packet = packet_build(NULL, 0, (void *)data, size);
+		}
+		shm_ring_consume(ctx->rx);
+
+		if (!packet || packet_size(packet) != size) {
+			ErrPrint("Invalid packet in the ring, handle(%d), size(%d)\n", ctx->handle, size);
+			packet_destroy(packet);
+			continue;
+		}
+
+		memset(&receive, 0, sizeof(receive));
+		receive.state = RECV_STATE_READY;
+		receive.handle = ctx->handle;
+		receive.offset = size;
+		receive.pid = ctx->pid;
+		receive.packet = packet;
+		receive.timeout = DEFAULT_TIMEOUT;
+
+		ret = packet_ready(ctx->handle, &receive, ctx->table);
+		packet_destroy(packet);
+		if (ret < 0) {
+			ErrPrint("Stop draining the ring, handle(%d): %d\n", ctx->handle, ret);
+			break;
+		}
+	}
+
+	ctx->draining--;
+	if (ctx->destroyed && !ctx->draining) {
+		free_ring_ctx(ctx);
+	}
+
+	return ret;
+}
+
+/*!
+ * \brief
+ * Close the handle from the out of the socket callback, disconnected callbacks are invoked.
+ */
+static void ring_close_handle(int handle)
+{
+	struct ring_ctx *ctx;
+
+	ctx = find_ring_ctx(handle);
+	if (!ctx) {
+		/* Already disconnected by a handler */
+		return;
+	}
+
+	if (ctx->client) {
+		s_info.vtable.client_destroy(handle);
+	} else {
+		s_info.vtable.server_destroy(handle);
+	}
+}
+
+static gboolean ring_event_cb(GIOChannel *src, GIOCondition cond, gpointer data)
+{
+	struct ring_ctx *ctx = data;
+
+	if (cond & (G_IO_HUP | G_IO_ERR | G_IO_NVAL)) {
+		ErrPrint("Ring event is broken, handle(%d)\n", ctx->handle);
+		ctx->rx_watch = 0;
+		ctx->rx_active = 0;
+		return FALSE;
+	}
+
+	shm_ring_rearm(ctx->rx);
+
+	/*!
+	 * \note
+	 * If packets are expected from the socket, they should be handled first.
+	 */
+	if (!ctx->credit) {
+		int handle = ctx->handle;
+
+		if (ring_drain(ctx, 0) < 0) {
+			ring_close_handle(handle);
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+static int ring_send_control(int handle, const char *cmd, int fd)
+{
+	struct packet *packet;
+	int ret;
+
+	packet = packet_create_noack(cmd, "");
+	if (!packet) {
+		return -ENOMEM;
+	}
+
+	if (fd >= 0) {
+		ret = s_info.vtable.send_with_fd(handle, (void *)packet_data(packet), packet_size(packet), DEFAULT_TIMEOUT, fd);
+	} else {
+		ret = s_info.vtable.send(handle, (void *)packet_data(packet), packet_size(packet), DEFAULT_TIMEOUT);
+	}
+
+	ret = (ret == packet_size(packet)) ? 0 : -EIO;
+	packet_destroy(packet);
+	return ret;
+}
+
+/*!
+ * \brief
+ * Offer a ring for sending packets to the peer.
+ * If the peer is not known yet, ask it first, the ring is offered when it replies.
+ */
+static void ring_offer(int handle)
+{
+	struct ring_ctx *ctx;
+
+	if (!ring_enabled()) {
+		return;
+	}
+
+	ctx = find_ring_ctx(handle);
+	if (!ctx) {
+		ctx = create_ring_ctx(handle);
+		if (!ctx) {
+			return;
+		}
+	}
+
+	if (ctx->tx) {
+		return;
+	}
+
+	if (!ctx->peer) {
+		if (ring_send_control(handle, RING_CMD_HELLO, -1) < 0) {
+			ErrPrint("Failed to send a hello, handle(%d)\n", handle);
+		}
+		return;
+	}
+
+	ctx->tx = shm_ring_create(RING_SIZE);
+	if (!ctx->tx) {
+		return;
+	}
+
+	if (ring_send_control(handle, RING_CMD_MEM, shm_ring_mem_fd(ctx->tx)) < 0
+		|| ring_send_control(handle, RING_CMD_SPACE, shm_ring_space_fd(ctx->tx)) < 0
+		|| ring_send_control(handle, RING_CMD_EVT, shm_ring_evt_fd(ctx->tx)) < 0)
+	{
+		ErrPrint("Failed to offer a ring, handle(%d)\n", handle);
+		shm_ring_destroy(ctx->tx);
+		ctx->tx = NULL;
+	}
+}
+
+static inline void ring_set_client(int handle)
+{
+	struct ring_ctx *ctx;
+
+	ctx = find_ring_ctx(handle);
+	if (ctx) {
+		ctx->client = 1;
+	}
+}
+
+static int ring_start_rx(struct ring_ctx *ctx, struct recv_ctx *receive, struct method *table)
+{
+	GIOChannel *gio;
+
+	gio = g_io_channel_unix_new(shm_ring_evt_fd(ctx->rx));
+	if (!gio) {
+		ErrPrint("Failed to create a channel\n");
+		return 0;
+	}
+
+	g_io_channel_set_close_on_unref(gio, FALSE);
+	ctx->rx_watch = g_io_add_watch(gio, G_IO_IN | G_IO_HUP | G_IO_ERR | G_IO_NVAL, ring_event_cb, ctx);
+	g_io_channel_unref(gio);
+	if (!ctx->rx_watch) {
+		ErrPrint("Failed to add a watch\n");
+		return 0;
+	}
+
+	ctx->table = table;
+	ctx->pid = receive->pid;
+	ctx->rx_active = 1;
+	DbgPrint("Ring is started, handle(%d), pid(%d)\n", ctx->handle, ctx->pid);
+
+	return ring_drain(ctx, 0);
+}
+
+/*!
+ * \brief
+ * Keep an fd of the ring which is being offered by the peer.
+ */
+static inline void ring_keep_fd(int *slot, int fd)
+{
+	if (*slot >= 0 && close(*slot) < 0) {
+		ErrPrint("close: %s\n", strerror(errno));
+	}
+
+	*slot = fd;
+}
+
+/*!
+ * \brief
+ * Handle commands to negotiate rings.
+ * \return 1 if the packet is consumed, negative value if a packet from the ring fails.
+ */
+static int ring_control(int handle, struct recv_ctx *receive, struct method *table)
+{
+	struct ring_ctx *ctx;
+	struct shm_ring *ring;
+	const char *cmd;
+	int ret;
+	int fd;
+
+	cmd = packet_command(receive->packet);
+	if (!cmd || cmd[0] != ':' || cmd[1] != ':' || packet_type(receive->packet) != PACKET_REQ_NOACK) {
+		return 0;
+	}
+
+	ctx = find_ring_ctx(handle);
+	fd = packet_fd(receive->packet);
+
+	if (!strcmp(cmd, RING_CMD_HELLO)) {
+		if (!ctx) {
+			ctx = create_ring_ctx(handle);
+			if (!ctx) {
+				return 1;
+			}
+		}
+
+		ctx->peer = 1;
+		if (ring_send_control(handle, RING_CMD_READY, -1) < 0) {
+			ErrPrint("Failed to reply to a hello, handle(%d)\n", handle);
+		}
+	} else if (!strcmp(cmd, RING_CMD_READY)) {
+		if (!ctx || ctx->peer) {
+			return 1;
+		}
+
+		ctx->peer = 1;
+		ring_offer(handle);
+	} else if (!strcmp(cmd, RING_CMD_MEM) || !strcmp(cmd, RING_CMD_SPACE) || !strcmp(cmd, RING_CMD_EVT)) {
+		if (fd < 0) {
+			ErrPrint("%s has no fd\n", cmd);
+			return 1;
+		}
+
+		if (!ctx || ctx->rx) {
+			ErrPrint("Unable to accept %s, handle(%d)\n", cmd, handle);
+			if (close(fd) < 0) {
+				ErrPrint("close: %s\n", strerror(errno));
+			}
+			return 1;
+		}
+
+		if (!strcmp(cmd, RING_CMD_MEM)) {
+			ring_keep_fd(&ctx->rx_mem_fd, fd);
+			return 1;
+		} else if (!strcmp(cmd, RING_CMD_SPACE)) {
+			ring_keep_fd(&ctx->rx_space_fd, fd);
+			return 1;
+		}
+
+		ring = NULL;
+		if (ctx->rx_mem_fd >= 0 && ctx->rx_space_fd >= 0) {
+			ring = shm_ring_attach(ctx->rx_mem_fd, fd, ctx->rx_space_fd);
+		}
+
+		if (!ring) {
+			ErrPrint("Failed to attach a ring, handle(%d)\n", handle);
+			ring_keep_fd(&ctx->rx_mem_fd, -1);
+			ring_keep_fd(&ctx->rx_space_fd, -1);
+			if (close(fd) < 0) {
+				ErrPrint("close: %s\n", strerror(errno));
+			}
+			return 1;
+		}
+
+		ctx->rx = ring;
+		ctx->rx_mem_fd = -1; /*!< Owned by the ring */
+		ctx->rx_space_fd = -1;
+
+		if (ring_send_control(handle, RING_CMD_ACCEPT, -1) < 0) {
+			ErrPrint("Failed to accept a ring, handle(%d)\n", handle);
+			return 1;
+		}
+
+		ring_offer(handle);
+	} else if (!strcmp(cmd, RING_CMD_ACCEPT)) {
+		if (!ctx || !ctx->tx || ctx->tx_active) {
+			return 1;
+		}
+
+		if (ring_send_control(handle, RING_CMD_START, -1) == 0) {
+			ctx->tx_active = 1;
+		}
+	} else if (!strcmp(cmd, RING_CMD_START)) {
+		if (!ctx || !ctx->rx || ctx->rx_active) {
+			return 1;
+		}
+
+		ret = ring_start_rx(ctx, receive, table);
+		return ret < 0 ? ret : 1;
+	} else {
+		return 0;
+	}
+
+	return 1;
+}
+
+/*!
+ * \brief
+ * A packet is received from the socket, dispatch packets which were sent before it via the ring.
+ */
+static inline int ring_before_socket_packet(int handle)
+{
+	struct ring_ctx *ctx;
+	int ret;
+
+	ctx = find_ring_ctx(handle);
+	if (!ctx || !ctx->rx_active) {
+		return 0;
+	}
+
+	if (!ctx->credit) {
+		ret = ring_drain(ctx, 1);
+		if (ret < 0) {
+			return ret;
+		}
+
+		ctx = find_ring_ctx(handle);
+		if (!ctx) {
+			return 0;
+		}
+	}
+
+	if (ctx->credit > 0) {
+		ctx->credit--;
+	} else {
+		ErrPrint("Barrier is not found, handle(%d)\n", handle);
+	}
+
+	return 0;
+}
+
+static inline int ring_after_socket_packet(int handle)
+{
+	struct ring_ctx *ctx;
+
+	ctx = find_ring_ctx(handle);
+	if (ctx && ctx->rx_active && !ctx->credit) {
+		return ring_drain(ctx, 0);
+	}
+
+	return 0;
+}
+
+/*!
+ * \brief
+ * Put a packet into the ring, or send it via the socket after a barrier.
+ * \return 0 if the packet is sent, -ENOSPC if the ring is full.
+ */
+static int ring_put_packet(struct ring_ctx *ctx, struct packet *packet, int fd)
+{
+	struct iovec iov[PACKET_MAX_IOV];
+	int iovcnt;
+	int ret;
+
+	iovcnt = packet_iovec(packet, iov, PACKET_MAX_IOV);
+	if (iovcnt < 0) {
+		return iovcnt;
+	}
+
+	if (!ctx->tx_active) {
+		/* Pending packets of the stopped ring */
+		ret = s_info.vtable.sendv_with_fd(ctx->handle, iov, iovcnt, DEFAULT_TIMEOUT, fd);
+		return ret == packet_size(packet) ? 0 : -EIO;
+	}
+
+	/*!
+	 * \note
+	 * The fd can be delivered only via the socket,
+	 * and a large packet should not occupy the ring.
+	 */
+	if (fd < 0 && packet_size(packet) <= RING_SIZE / 4) {
+		return shm_ring_put(ctx->tx, iov, iovcnt, packet_size(packet));
+	}
+
+	/*!
+	 * \note
+	 * The peer should see the barrier before the packet from the socket, so it is published first.
+	 */
+	ret = shm_ring_put_barrier(ctx->tx, 1);
+	if (ret < 0) {
+		return ret;
+	}
+
+	ret = s_info.vtable.sendv_with_fd(ctx->handle, iov, iovcnt, DEFAULT_TIMEOUT, fd);
+	if (ret != packet_size(packet)) {
+		/*!
+		 * \note
+		 * The barrier cannot be taken back once the peer can see it.
+		 * Stop using the ring, then the next packet from the socket releases the barrier,
+		 * instead of holding every packet put after it.
+		 */
+		ErrPrint("Failed to send a packet after a barrier, stop the ring, handle(%d)\n", ctx->handle);
+		ctx->tx_active = 0;
+		return -EIO;
+	}
+
+	return 0;
+}
+
+/*!
+ * \brief
+ * Send pending packets in order, until the ring is full again.
+ */
+static void ring_flush_pending(struct ring_ctx *ctx)
+{
+	struct ring_pending *item;
+	struct dlist *l;
+	int ret;
+
+	while ((l = ctx->tx_pending)) {
+		item = dlist_data(l);
+
+		ret = ring_put_packet(ctx, item->packet, item->fd);
+		if (ret == -ENOSPC) {
+			/*!
+			 * \note
+			 * The consumer could make a room before it sees the waiting flag, so try once more.
+			 */
+			shm_ring_wait_space(ctx->tx);
+			ret = ring_put_packet(ctx, item->packet, item->fd);
+			if (ret == -ENOSPC) {
+				return;
+			}
+		}
+
+		if (ret < 0) {
+			ErrPrint("Failed to send a pending packet (%d), handle(%d)\n", ret, ctx->handle);
+		}
+
+		ctx->tx_sent++;
+		ctx->tx_pending = dlist_remove(ctx->tx_pending, l);
+		destroy_ring_pending(item);
+	}
+
+	clear_ring_pending(ctx);
+}
+
+static gboolean ring_space_cb(GIOChannel *src, GIOCondition cond, gpointer data)
+{
+	struct ring_ctx *ctx = data;
+
+	if (cond & (G_IO_HUP | G_IO_ERR | G_IO_NVAL)) {
+		ErrPrint("Ring space event is broken, handle(%d)\n", ctx->handle);
+		ctx->tx_watch = 0;
+		clear_ring_pending(ctx);
+		return FALSE;
+	}
+
+	ring_flush_pending(ctx);
+	return ctx->tx_watch ? TRUE : FALSE;
+}
+
+/*!
+ * \brief
+ * The peer doesn't consume the ring during DEFAULT_TIMEOUT, give up pending packets.
+ */
+static gboolean ring_stall_cb(gpointer data)
+{
+	struct ring_ctx *ctx = data;
+
+	if (ctx->tx_sent != ctx->tx_checked) {
+		ctx->tx_checked = ctx->tx_sent;
+		return TRUE;
+	}
+
+	ErrPrint("Ring is full, %d packets are dropped (handle: %d)\n", dlist_count(ctx->tx_pending), ctx->handle);
+	ctx->tx_timer = 0;
+	clear_ring_pending(ctx);
+	return FALSE;
+}
+
+/*!
+ * \brief
+ * Keep a packet until the peer makes a room of the ring.
+ * The main loop keeps running, the space eventfd wakes this up.
+ */
+static int ring_park(struct ring_ctx *ctx, struct packet *packet)
+{
+	struct ring_pending *item;
+	GIOChannel *gio;
+
+	item = malloc(sizeof(*item));
+	if (!item) {
+		ErrPrint("Heap: %s\n", strerror(errno));
+		return -ENOMEM;
+	}
+
+	item->fd = -1;
+	if (packet_fd(packet) >= 0) {
+		item->fd = dup(packet_fd(packet));
+		if (item->fd < 0) {
+			ErrPrint("dup: %s\n", strerror(errno));
+			free(item);
+			return -EIO;
+		}
+	}
+
+	item->packet = packet_ref(packet);
+	if (!item->packet) {
+		if (item->fd >= 0 && close(item->fd) < 0) {
+			ErrPrint("close: %s\n", strerror(errno));
+		}
+		free(item);
+		return -ENOMEM;
+	}
+
+	ctx->tx_pending = dlist_append(ctx->tx_pending, item);
+
+	if (!ctx->tx_watch) {
+		gio = g_io_channel_unix_new(shm_ring_space_fd(ctx->tx));
+		if (gio) {
+			g_io_channel_set_close_on_unref(gio, FALSE);
+			ctx->tx_watch = g_io_add_watch(gio, G_IO_IN | G_IO_HUP | G_IO_ERR | G_IO_NVAL, ring_space_cb, ctx);
+			g_io_channel_unref(gio);
+		}
+
+		if (!ctx->tx_watch) {
+			ErrPrint("Failed to add a watch, handle(%d)\n", ctx->handle);
+			clear_ring_pending(ctx);
+			return -EIO;
+		}
+	}
+
+	if (!ctx->tx_timer) {
+		ctx->tx_checked = ctx->tx_sent;
+		ctx->tx_timer = g_timeout_add((guint)(DEFAULT_TIMEOUT * 1000), ring_stall_cb, ctx);
+	}
+
+	ring_flush_pending(ctx);
+	return 0;
+}
+
+/*!
+ * \brief
+ * Send a packet via the ring if it is available, or via the socket.
+ * If the ring is full, the packet is kept in order and sent later from the main loop.
+ * \return Sent bytes
+ */
+static int packet_send(int handle, struct packet *packet)
+{
+	struct iovec iov[PACKET_MAX_IOV];
+	struct ring_ctx *ctx;
+	int iovcnt;
+	int ret;
+
+	ctx = find_ring_ctx(handle);
+	if (ctx && ctx->tx_active) {
+		ret = ctx->tx_pending ? -ENOSPC : ring_put_packet(ctx, packet, packet_fd(packet));
+		if (ret == -ENOSPC) {
+			ret = ring_park(ctx, packet);
+		}
+
+		return ret < 0 ? ret : packet_size(packet);
+	}
+
+	iovcnt = packet_iovec(packet, iov, PACKET_MAX_IOV);
+	if (iovcnt < 0) {
+		return iovcnt;
+	}
+
+	return s_info.vtable.sendv_with_fd(handle, iov, iovcnt, DEFAULT_TIMEOUT, packet_fd(packet));
+}
+
+static inline int ring_tx_active(int handle)
+{
+	struct ring_ctx *ctx;
+
+	ctx = find_ring_ctx(handle);
+	return ctx && ctx->tx_active;
+}
+
+/*!
+ * \note
+ * Items are taken out of the batch first,
+ * so result callbacks can queue new packets to the same connection.
+ */
+static inline int batch_take(struct send_batch *batch, struct batch_item *item)
+{
+	int count;
+
+	count = batch->count;
+	memcpy(item, batch->item, sizeof(*item) * count);
+	batch->count = 0;
+	return count;
+}
+
+static inline void batch_complete(int handle, struct batch_item *item, int status)
+{
+	if (item->result_cb) {
+		item->result_cb(handle, item->packet, status, item->data);
+	}
+
+	packet_unref(item->packet);
+}
+
+static int batch_flush(struct send_batch *batch)
+{
+	struct batch_item item[PACKET_BATCH_MAX];
+	struct iovec iov[PACKET_BATCH_MAX * PACKET_MAX_IOV];
+	int handle = batch->handle;
+	int iovcnt;
+	int count;
+	int size;
+	int ret;
+	int i;
+
+	if (batch->source) {
+		g_source_remove(batch->source);
+		batch->source = 0;
+	}
+
+	count = batch_take(batch, item);
+	if (!count) {
+		return 0;
+	}
+
+	if (ring_tx_active(handle)) {
+		size = 0;
+		ret = 0;
+		for (i = 0; i < count; i++) {
+			if (packet_send(handle, item[i].packet) != packet_size(item[i].packet)) {
+				ret = -EIO;
+				batch_complete(handle, item + i, -EIO);
+			} else {
+				size += packet_size(item[i].packet);
+				batch_complete(handle, item + i, 0);
+			}
+		}
+
+		DbgPrint("Batch: %d packets, %d bytes via ring (handle: %d)\n", count, size, handle);
+		return ret;
+	}
+
+	iovcnt = 0;
+	size = 0;
+	for (i = 0; i < count; i++) {
+		ret = packet_iovec(item[i].packet, iov + iovcnt, PACKET_MAX_IOV);
+		if (ret < 0) {
+			ErrPrint("Failed to get iovec: %d\n", ret);
+			batch_complete(handle, item + i, ret);
+			item[i].packet = NULL;
+			continue;
+		}
+
+		iovcnt += ret;
+		size += packet_size(item[i].packet);
+	}
+
+	ret = s_info.vtable.sendv_with_fd(handle, iov, iovcnt, DEFAULT_TIMEOUT, -1);
+	DbgPrint("Batch: %d packets, %d bytes (handle: %d)\n", count, size, handle);
+	if (ret != size) {
+		ErrPrint("Failed to send whole packets %d <> %d (handle: %d)\n", ret, size, handle);
+		ret = -EIO;
+	} else {
+		ret = 0;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (item[i].packet) {
+			batch_complete(handle, item + i, ret);
+		}
+	}
+
+	return ret;
+}
+
+static gboolean batch_flush_cb(gpointer data)
+{
+	struct send_batch *batch = data;
+
+	batch->source = 0;
+	(void)batch_flush(batch);
+	return FALSE;
+}
+
+/*!
+ * \note
+ * Queued packets are failed with -ECONNRESET, the batch should be out of the table already.
+ */
+static void batch_destroy(gpointer data)
+{
+	struct send_batch *batch = data;
+	struct batch_item item[PACKET_BATCH_MAX];
+	int count;
+	int i;
+
+	if (batch->source) {
+		g_source_remove(batch->source);
+	}
+
+	count = batch_take(batch, item);
+	if (count) {
+		ErrPrint("%d packets are dropped (handle: %d)\n", count, batch->handle);
+	}
+
+	for (i = 0; i < count; i++) {
+		batch_complete(batch->handle, item + i, -ECONNRESET);
+	}
+
+	free(batch);
+}
+
+static struct send_batch *find_batch(int handle)
+{
+	if (!s_info.batch_table) {
+		return NULL;
+	}
+
+	return g_hash_table_lookup(s_info.batch_table, GINT_TO_POINTER(handle));
+}
+
+static struct send_batch *create_batch(int handle)
+{
+	struct send_batch *batch;
 
-					cmd_idx = (unsigned int)i;
-					break;
-				}
-			}
+	if (!s_info.batch_table) {
+		s_info.batch_table = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, batch_destroy);
+		if (!s_info.batch_table) {
+			ErrPrint("Failed to create a hash table\n");
+			return NULL;
 		}
+	}
 
-		if (cmd_idx != 0xFFFFFFFF) {
-			receive->inuse = 1;
-			result = table[cmd_idx].handler(receive->pid, handle, receive->packet);
-			receive->inuse = 0;
-			if (result) {
-				if (packet_fd(result) >= 0) {
-					ret = s_info.vtable.send_with_fd(handle, (void *)packet_data(result), packet_size(result), DEFAULT_TIMEOUT, packet_fd(result));
-				} else {
-					ret = s_info.vtable.send(handle, (void *)packet_data(result), packet_size(result), DEFAULT_TIMEOUT);
-				}
+	batch = calloc(1, sizeof(*batch));
+	if (!batch) {
+		ErrPrint("Heap: %s\n", strerror(errno));
+		return NULL;
+	}
 
-				if (ret < 0) {
-					ErrPrint("Failed to send an ack packet\n");
-				} else {
-					ret = 0;
-				}
-				packet_destroy(result);
-			}
-		}
+	batch->handle = handle;
+	g_hash_table_insert(s_info.batch_table, GINT_TO_POINTER(handle), batch);
+	return batch;
+}
 
-		break;
-	case PACKET_REQ_NOACK:
-		cmd_idx = 0xFFFFFFFF;
-		cmd = packet_command(receive->packet);
-		if (cmd) {
-			if (cmd[0] == PACKET_CMD_INT_TAG) {
-				unsigned int *p_cmd_idx = (unsigned int *)cmd;
-
-				/* Get rid of LSB 8 bits */
-				cmd_idx = *p_cmd_idx >> 8;
-			} else {
-				for (i = 0; table[i].cmd; i++) {
-					if (strcmp(table[i].cmd, cmd)) {
-						continue;
-					}
+/*!
+ * \note
+ * If flush is true, queued packets are sent first, otherwise they are failed.
+ */
+static void destroy_batch(int handle, int flush)
+{
+	struct send_batch *batch;
 
-					cmd_idx = (unsigned int)i;
-					break;
-				}
-			}
-		}
+	batch = find_batch(handle);
+	if (!batch) {
+		return;
+	}
 
-		if (cmd_idx != 0xFFFFFFFF) {
-			receive->inuse = 1;
-			result = table[cmd_idx].handler(receive->pid, handle, receive->packet);
-			receive->inuse = 0;
-			if (result) {
-				packet_destroy(result);
-			}
-		}
-		break;
-	default:
-		break;
+	if (flush) {
+		(void)batch_flush(batch);
 	}
 
-	/*!
-	 * Return negative value will make call the disconnected_cb
-	 */
-	return ret;
+	/* Callbacks can touch the table, take it out before failing its packets */
+	g_hash_table_steal(s_info.batch_table, GINT_TO_POINTER(handle));
+	batch_destroy(batch);
 }
 
 static int client_disconnected_cb(int handle, void *data)
 {
 	struct recv_ctx *receive;
 	struct request_ctx *request;
+	struct dlist *list;
 	struct dlist *l;
 	struct dlist *n;
 	int inuse_found = 0;
@@ -360,10 +1439,9 @@ static int client_disconnected_cb(int handle, void *data)
 
 	DbgPrint("Clean up all requests and a receive context for handle(%d) for pid(%d)\n", handle, pid);
 
-	dlist_foreach_safe(s_info.request_list, l, n, request) {
-		if (request->handle != handle) {
-			continue;
-		}
+	list = s_info.request_table ? request_table_list(s_info.request_table, handle) : NULL;
+	dlist_foreach_safe(list, l, n, request) {
+		list = dlist_remove(list, l);
 
 		if (request->inuse) {
 			inuse_found = 1;
@@ -381,17 +1459,127 @@ static int client_disconnected_cb(int handle, void *data)
 		destroy_recv_ctx(receive);
 	}
 
+	destroy_batch(handle, 0);
+	destroy_ring_ctx(handle);
+	return 0;
+}
+
+/*!
+ * \brief
+ * Append received data to the packet which is being built.
+ */
+static int recv_feed(struct recv_ctx *receive, const char *ptr, int size, pid_t pid, int fd)
+{
+	if (receive->pid != -1 && receive->pid != pid) {
+		ErrPrint("Recv[%d], pid[%d :: %d]\n", size, receive->pid, pid);
+		if (fd >= 0 && close(fd) < 0) {
+			ErrPrint("close: %s\n", strerror(errno));
+		}
+		return -EIO; /*!< Return negative value will invoke the client_disconnected_cb */
+	}
+
+	receive->pid = pid;
+	receive->packet = packet_build(receive->packet, receive->offset, (void *)ptr, size);
+	if (!receive->packet) {
+		ErrPrint("Built packet is not valid\n");
+		if (fd >= 0 && close(fd) < 0) {
+			ErrPrint("close: %s\n", strerror(errno));
+		}
+		return -EFAULT; /*!< Return negative value will invoke the client_disconnected_cb */
+	}
+
+	if (fd >= 0) {
+		if (packet_fd(receive->packet) >= 0) {
+			DbgPrint("Packet already has FD: %d (new: %d)\n", packet_fd(receive->packet), fd);
+		}
+
+		packet_set_fd(receive->packet, fd);
+	}
+
+	receive->offset += size;
+
+	if (receive->state == RECV_STATE_HEADER) {
+		if (receive->offset == packet_header_size()) {
+			if (packet_size(receive->packet) == receive->offset) {
+				receive->state = RECV_STATE_READY;
+			} else {
+				receive->state = RECV_STATE_BODY;
+			}
+		}
+	} else if (receive->offset == packet_size(receive->packet)) {
+		receive->state = RECV_STATE_READY;
+	}
+
 	return 0;
 }
 
+/*!
+ * \brief
+ * Receive at most "size" bytes of the packet.
+ * If the transport keeps received data in its own buffer, the packet is built from it in place,
+ * otherwise the data is copied to a temporary buffer first.
+ */
+static int recv_data(int handle, struct recv_ctx *receive, int size)
+{
+	const char *ptr;
+	char *buffer;
+	pid_t pid = (pid_t)-1;
+	int fd = -1;
+	int ret;
+
+	if (s_info.vtable.recv_peek) {
+		ret = s_info.vtable.recv_peek(handle, &ptr, &pid, receive->timeout, &fd);
+		if (ret < 0) {
+			ErrPrint("Recv[%d], pid[%d :: %d]\n", ret, receive->pid, pid);
+			return -EIO; /*!< Return negative value will invoke the client_disconnected_cb */
+		} else if (ret == 0) {
+			DbgPrint("ZERO bytes receives\n");
+			return -ECONNRESET;
+		}
+
+		if (ret > size) {
+			ret = size;
+		}
+
+		/*!
+		 * \note
+		 * The packet outlives this callback, so this is the only copy of the data.
+		 */
+		size = ret;
+		ret = recv_feed(receive, ptr, size, pid, fd);
+		if (ret < 0) {
+			return ret;
+		}
+
+		return s_info.vtable.recv_consume(handle, size) < 0 ? -EIO : 0;
+	}
+
+	buffer = malloc(size);
+	if (!buffer) {
+		ErrPrint("Heap: %s (%d)\n", strerror(errno), size);
+		return -ENOMEM;
+	}
+
+	ret = s_info.vtable.recv_with_fd(handle, buffer, size, &pid, receive->timeout, &fd);
+	if (ret < 0) {
+		ErrPrint("Recv[%d], pid[%d :: %d]\n", ret, receive->pid, pid);
+		ret = -EIO; /*!< Return negative value will invoke the client_disconnected_cb */
+	} else if (ret > 0) {
+		ret = recv_feed(receive, buffer, ret, pid, fd);
+	} else {
+		DbgPrint("ZERO bytes receives(%d)\n", pid);
+		ret = -ECONNRESET;
+	}
+
+	free(buffer);
+	return ret;
+}
+
 static int service_cb(int handle, void *data)
 {
 	struct recv_ctx *receive;
-	pid_t pid;
 	int ret;
 	int size;
-	char *ptr;
-	int fd = -1;
 
 	receive = find_recv_ctx(handle);
 	if (!receive) {
@@ -407,59 +1595,14 @@ static int service_cb(int handle, void *data)
 		receive->state = RECV_STATE_HEADER;
 		receive->offset = 0;
 	case RECV_STATE_HEADER:
-		size = packet_header_size() - receive->offset;
 		/*!
 		 * \note
 		 * Getting header
 		 */
-		ptr = malloc(size);
-		if (!ptr) {
-			ErrPrint("Heap: %s (%d)\n", strerror(errno), size);
-			return -ENOMEM;
-		}
-
-		ret = s_info.vtable.recv_with_fd(handle, ptr, size, &pid, receive->timeout, &fd);
+		size = packet_header_size() - receive->offset;
+		ret = recv_data(handle, receive, size);
 		if (ret < 0) {
-			ErrPrint("Recv[%d], pid[%d :: %d]\n", ret, receive->pid, pid);
-			free(ptr);
-			return -EIO; /*!< Return negative value will invoke the client_disconnected_cb */
-		} else if (ret > 0) {
-			if (receive->pid != -1 && receive->pid != pid) {
-				ErrPrint("Recv[%d], pid[%d :: %d]\n", ret, receive->pid, pid);
-				free(ptr);
-				return -EIO; /*!< Return negative value will invoke the client_disconnected_cb */
-			}
-
-			receive->pid = pid;
-			receive->packet = packet_build(receive->packet, receive->offset, ptr, ret);
-			free(ptr);
-
-			if (!receive->packet) {
-				ErrPrint("Built packet is not valid\n");
-				return -EFAULT; /*!< Return negative value will invoke the client_disconnected_cb */
-			}
-
-			if (fd >= 0) {
-				if (packet_fd(receive->packet) >= 0) {
-					DbgPrint("Packet already has FD: %d (new: %d)\n", packet_fd(receive->packet), fd);
-				}
-
-				packet_set_fd(receive->packet, fd);
-			}
-
-			receive->offset += ret;
-
-			if (receive->offset == packet_header_size()) {
-				if (packet_size(receive->packet) == receive->offset) {
-					receive->state = RECV_STATE_READY;
-				} else {
-					receive->state = RECV_STATE_BODY;
-				}
-			}
-		} else {
-			DbgPrint("ZERO bytes receives(%d)\n", pid);
-			free(ptr);
-			return -ECONNRESET;
+			return ret;
 		}
 		break;
 	case RECV_STATE_BODY:
@@ -472,51 +1615,10 @@ static int service_cb(int handle, void *data)
 		 * \note
 		 * Getting body
 		 */
-		ptr = malloc(size);
-		if (!ptr) {
-			ErrPrint("Heap: %s (%d)\n", strerror(errno), size);
-			return -ENOMEM;
-		}
-
-		ret = s_info.vtable.recv_with_fd(handle, ptr, size, &pid, receive->timeout, &fd);
+		ret = recv_data(handle, receive, size);
 		if (ret < 0) {
-			ErrPrint("Recv[%d], pid[%d :: %d]\n", ret, receive->pid, pid);
-			free(ptr);
-			return -EIO;
-		} else if (ret > 0) {
-			if (receive->pid != pid) {
-				ErrPrint("Recv[%d], pid[%d :: %d]\n", ret, receive->pid, pid);
-				free(ptr);
-				return -EIO;
-			}
-
-			receive->packet = packet_build(receive->packet, receive->offset, ptr, ret);
-			free(ptr);
-
-			if (!receive->packet) {
-				ErrPrint("Built packet is not valid\n");
-				return -EFAULT;
-			}
-
-			if (fd >= 0) {
-				if (packet_fd(receive->packet) >= 0) {
-					DbgPrint("Packet already has FD: %d (new: %d)\n", packet_fd(receive->packet), fd);
-				}
-
-				packet_set_fd(receive->packet, fd);
-			}
-
-			receive->offset += ret;
-
-			if (receive->offset == packet_size(receive->packet)) {
-				receive->state = RECV_STATE_READY;
-			}
-		} else {
-			DbgPrint("ZERO bytes receives(%d)\n", pid);
-			free(ptr);
-			return -ECONNRESET;
+			return ret;
 		}
-
 		break;
 	case RECV_STATE_READY:
 	default:
@@ -524,7 +1626,24 @@ static int service_cb(int handle, void *data)
 	}
 
 	if (receive->state == RECV_STATE_READY) {
-		ret = packet_ready(handle, receive, data);
+		ret = ring_control(handle, receive, data);
+		if (ret > 0) {
+			ret = 0;
+		} else if (ret == 0) {
+			/*!
+			 * \note
+			 * If a packet from the ring fails, the handle is closed same as the failure of the socket packet.
+			 */
+			ret = ring_before_socket_packet(handle);
+			if (ret == 0) {
+				ret = packet_ready(handle, receive, data);
+			}
+
+			if (ret == 0) {
+				ret = ring_after_socket_packet(handle);
+			}
+		}
+
 		if (ret == 0) {
 			/*!
 			 * If ret is negative value, the receive context will be destroyed from disconnected callback
@@ -556,20 +1675,15 @@ EAPI int com_core_packet_async_send(int handle, struct packet *packet, double ti
 		return -EINVAL;
 	}
 
-	ctx = create_request_ctx(handle);
+	ctx = create_request_ctx(handle, packet);
 	if (!ctx) {
 		return -ENOMEM;
 	}
 
 	ctx->recv_cb = recv_cb;
 	ctx->data = data;
-	ctx->packet = packet_ref(packet);
 
-	if (packet_fd(packet) >= 0) {
-		ret = s_info.vtable.send_with_fd(handle, (void *)packet_data(packet), packet_size(packet), DEFAULT_TIMEOUT, packet_fd(packet));
-	} else {
-		ret = s_info.vtable.send(handle, (void *)packet_data(packet), packet_size(packet), DEFAULT_TIMEOUT);
-	}
+	ret = packet_send(handle, packet);
 	if (ret != packet_size(packet)) {
 		ErrPrint("Send failed. %d <> %d (handle: %d)\n", ret, packet_size(packet), handle);
 		destroy_request_ctx(ctx);
@@ -588,11 +1702,12 @@ EAPI int com_core_packet_send_only(int handle, struct packet *packet)
 		return -EINVAL;
 	}
 
-	if (packet_fd(packet) >= 0) {
-		ret = s_info.vtable.send_with_fd(handle, (void *)packet_data(packet), packet_size(packet), DEFAULT_TIMEOUT, packet_fd(packet));
-	} else {
-		ret = s_info.vtable.send(handle, (void *)packet_data(packet), packet_size(packet), DEFAULT_TIMEOUT);
-	}
+	/*!
+	 * \note
+	 * Referenced strings of the packet are sent as they are, without merging.
+	 * If the packet has to be kept after this, it is copied by packet_ref().
+	 */
+	ret = packet_send(handle, packet);
 	if (ret != packet_size(packet)) {
 		ErrPrint("Failed to send whole packet\n");
 		return -EIO;
@@ -601,6 +1716,90 @@ EAPI int com_core_packet_send_only(int handle, struct packet *packet)
 	return 0;
 }
 
+EAPI int com_core_packet_batch_send(int handle, struct packet *packet, void (*result_cb)(int handle, const struct packet *packet, int status, void *data), void *data)
+{
+	struct send_batch *batch;
+
+	if (packet_type(packet) != PACKET_REQ_NOACK) {
+		ErrPrint("Invalid type - should be PACKET_REQ_NOACK (%p)\n", packet);
+		return -EINVAL;
+	}
+
+	batch = find_batch(handle);
+
+	/*!
+	 * \note
+	 * A packet which has fd should be sent via its own message,
+	 * but it should not be sent before the packets which are already queued.
+	 */
+	if (packet_fd(packet) >= 0) {
+		if (batch) {
+			(void)batch_flush(batch);
+		}
+
+		return com_core_packet_send_only(handle, packet);
+	}
+
+	if (!batch) {
+		batch = create_batch(handle);
+		if (!batch) {
+			return com_core_packet_send_only(handle, packet);
+		}
+	}
+
+	batch->item[batch->count].packet = packet_ref(packet);
+	if (!batch->item[batch->count].packet) {
+		return -ENOMEM;
+	}
+
+	batch->item[batch->count].result_cb = result_cb;
+	batch->item[batch->count].data = data;
+	batch->count++;
+
+	/* The packet is queued, the result is delivered via result_cb from here */
+	if (batch->count == PACKET_BATCH_MAX) {
+		(void)batch_flush(batch);
+		return 0;
+	}
+
+	if (!batch->source) {
+		/*!
+		 * \note
+		 * DEFAULT_IDLE runs after every other source is dispatched,
+		 * a busy main loop could hold the batch, so the default priority is used.
+		 */
+		if (s_info.batch_window) {
+			batch->source = g_timeout_add((s_info.batch_window + 999u) / 1000u, batch_flush_cb, batch);
+		} else {
+			batch->source = g_idle_add_full(G_PRIORITY_DEFAULT, batch_flush_cb, batch, NULL);
+		}
+
+		if (!batch->source) {
+			ErrPrint("Failed to add a flush callback\n");
+			(void)batch_flush(batch);
+		}
+	}
+
+	return 0;
+}
+
+EAPI int com_core_packet_batch_flush(int handle)
+{
+	struct send_batch *batch;
+
+	batch = find_batch(handle);
+	if (!batch) {
+		return 0;
+	}
+
+	return batch_flush(batch);
+}
+
+EAPI void com_core_packet_set_batch_window(unsigned int usec)
+{
+	s_info.batch_window = usec;
+}
+
 EAPI struct packet *com_core_packet_oneshot_send(const char *addr, struct packet *packet, double timeout)
 {
 	int ret;
@@ -739,6 +1938,13 @@ static inline int com_core_packet_fini(void)
 
 	s_info.initialized = 0;
 	com_core_del_event_callback(CONNECTOR_DISCONNECTED, client_disconnected_cb, NULL);
+
+	/* Indexes are built again by the next lookup */
+	if (s_info.method_index_table) {
+		g_hash_table_destroy(s_info.method_index_table);
+		s_info.method_index_table = NULL;
+	}
+
 	return 0;
 }
 
@@ -751,9 +1957,14 @@ EAPI int com_core_packet_client_init(const char *addr, int is_sync, struct metho
 		return ret;
 	}
 
+	(void)method_index_build(table);
+
 	ret = s_info.vtable.client_create(addr, is_sync, service_cb, table);
 	if (ret < 0) {
 		com_core_packet_fini();
+	} else {
+		ring_offer(ret);
+		ring_set_client(ret);
 	}
 
 	return ret;
@@ -768,9 +1979,14 @@ EAPI int com_core_packet_client_init_by_fd(int fd, int is_sync, struct method *t
 		return ret;
 	}
 
+	(void)method_index_build(table);
+
 	ret = s_info.vtable.client_create_by_fd(fd, is_sync, service_cb, table);
 	if (ret < 0) {
 		com_core_packet_fini();
+	} else {
+		ring_offer(ret);
+		ring_set_client(ret);
 	}
 
 	return ret;
@@ -778,6 +1994,8 @@ EAPI int com_core_packet_client_init_by_fd(int fd, int is_sync, struct method *t
 
 EAPI int com_core_packet_client_fini(int handle)
 {
+	destroy_batch(handle, 1);
+	destroy_ring_ctx(handle);
 	s_info.vtable.client_destroy(handle);
 	com_core_packet_fini();
 	return 0;
@@ -792,6 +2010,8 @@ EAPI int com_core_packet_server_init(const char *addr, struct method *table)
 		return ret;
 	}
 
+	(void)method_index_build(table);
+
 	ret = s_info.vtable.server_create(addr, 0, NULL, service_cb, table);
 	if (ret < 0) {
 		com_core_packet_fini();
@@ -809,6 +2029,8 @@ EAPI int com_core_packet_server_init_with_permission(const char *addr, struct me
 		return ret;
 	}
 
+	(void)method_index_build(table);
+
 	ret = s_info.vtable.server_create(addr, 0, label, service_cb, table);
 	if (ret < 0) {
 		com_core_packet_fini();
@@ -829,6 +2051,65 @@ EAPI int com_core_packet_server_fini(int handle)
 	return 0;
 }
 
+EAPI int com_core_packet_method_index(struct method *table, const char *cmd)
+{
+	char tagged[PACKET_MAX_CMD];
+	unsigned int tag;
+	int ret;
+
+	/* A peer which uses string commands takes the same path as the tagged one */
+	ret = com_core_packet_method_tag(table, cmd, tagged);
+	if (ret < 0) {
+		return ret;
+	}
+
+	/* Get rid of LSB 8 bits */
+	memcpy(&tag, tagged, sizeof(tag));
+	return (int)(tag >> 8);
+}
+
+EAPI int com_core_packet_method_tag(struct method *table, const char *cmd, char *tagged)
+{
+	struct method_index *index;
+	unsigned int tag;
+
+	if (!table || !cmd || !tagged) {
+		return -EINVAL;
+	}
+
+	index = method_index_build(table);
+	if (!index) {
+		return -ENOMEM;
+	}
+
+	if (cmd[0] == PACKET_CMD_INT_TAG) {
+		memcpy(&tag, cmd, sizeof(tag));
+		if ((tag >> 8) >= index->count) {
+			ErrPrint("Invalid command index: %u (%u)\n", tag >> 8, index->count);
+			return -ENOENT;
+		}
+	} else {
+		tag = GPOINTER_TO_UINT(g_hash_table_lookup(index->cmd_table, cmd));
+		if (!tag) {
+			return -ENOENT;
+		}
+	}
+
+	memset(tagged, 0, PACKET_MAX_CMD);
+	memcpy(tagged, &tag, sizeof(tag));
+	return 0;
+}
+
+EAPI void com_core_packet_use_ring(int flag)
+{
+	if (s_info.initialized) {
+		ErrPrint("com-core method is in use\n");
+		return;
+	}
+
+	s_info.ring = !!flag;
+}
+
 EAPI void com_core_packet_use_thread(int flag)
 {
 	if (s_info.initialized) {
@@ -846,6 +2127,9 @@ EAPI void com_core_packet_use_thread(int flag)
 		s_info.vtable.send = com_core_thread_send;
 		s_info.vtable.recv_with_fd = com_core_thread_recv_with_fd;
 		s_info.vtable.send_with_fd = com_core_thread_send_with_fd;
+		s_info.vtable.sendv_with_fd = com_core_thread_sendv_with_fd;
+		s_info.vtable.recv_peek = com_core_thread_recv_peek;
+		s_info.vtable.recv_consume = com_core_thread_recv_consume;
 	} else {
 		s_info.vtable.server_create = com_core_server_create;
 		s_info.vtable.client_create = com_core_client_create;
@@ -856,6 +2140,9 @@ EAPI void com_core_packet_use_thread(int flag)
 		s_info.vtable.send = com_core_send;
 		s_info.vtable.recv_with_fd = com_core_recv_with_fd;
 		s_info.vtable.send_with_fd = com_core_send_with_fd;
+		s_info.vtable.sendv_with_fd = com_core_sendv_with_fd;
+		s_info.vtable.recv_peek = NULL;
+		s_info.vtable.recv_consume = NULL;
 	}
 }
 
@@ -26,6 +26,7 @@
 #include <pthread.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
 
 #include <glib.h>
 
@@ -42,12 +43,41 @@ int errno;
 #define EVENT_READY 'a'
 #define EVENT_TERM 'e'
 
+#define REACTOR_ENV		"COM_CORE_REACTOR_WORKERS"
+#define REACTOR_MAX_WORKERS	16
+#define REACTOR_MAX_EVENTS	32
+
+#define RX_RING_SIZE		(32 * 1024)
+#define RX_SEG_MAX		64
+
+/*!
+ * \brief Shared reader thread, serves many connections from one epoll set
+ */
+struct reactor {
+	pthread_t thid;
+	int epoll_fd;
+	pthread_mutex_t lock;
+	pthread_cond_t idle_cond; /*!< Signaled when the reactor finishes reading a TCB */
+	unsigned long epoch; /*!< Increased whenever a TCB is detached, protected by lock */
+	struct tcb *current; /*!< TCB being read without the lock, protected by lock */
+	struct dlist *tcb_list; /*!< Attached TCBs which are not notified as terminated, protected by lock */
+	int broken; /*!< epoll_wait() failed, the reactor is gone, protected by lock */
+	int count; /*!< Count of attached TCBs, Main thread only */
+};
+
 static struct {
 	struct dlist *tcb_list;
 	struct dlist *server_list;
+
+	int reactor_workers; /*!< 0 means a thread per connection, -1 means not decided yet */
+	int reactor_count; /*!< Count of launched reactors */
+	struct reactor reactor[REACTOR_MAX_WORKERS];
 } s_info = {
 	.tcb_list = NULL,
 	.server_list = NULL,
+
+	.reactor_workers = -1,
+	.reactor_count = 0,
 };
 
 /*!
@@ -62,34 +92,59 @@ struct server {
 };
 
 /*!
- * \brief This is used to holds a packet
+ * \brief Bytes taken by one read from the socket
+ * \note
+ * A segment never wraps the ring, the reader stops at the end of the buffer.
  */
-struct chunk {
-	char *data;
-	int offset;
+struct segment {
 	int size;
+	int offset; /*!< Consumed bytes */
 	pid_t pid;
 	int fd;
 };
 
+/*!
+ * \brief Receive ring, filled by the reader and drained by the main thread
+ * \note
+ * The reader writes into the free region without holding the lock,
+ * the main thread reads the used region without holding the lock.
+ * Only the indexes are updated in the critical section.
+ */
+struct rx_ring {
+	char *data;
+	int head; /*!< Offset of the first unconsumed byte */
+	int used;
+
+	struct segment segment[RX_SEG_MAX];
+	int seg_head;
+	int seg_count;
+
+	int stalled; /*!< Reader is waiting for free space */
+	int closing; /*!< Reader should not wait anymore */
+};
+
 /*!
  * \brief Thread Control Block
  */
 struct tcb {
 	pthread_t thid;
 	int handle;
-	struct dlist *chunk_list;
+	struct rx_ring rx;
 	int evt_pipe[PIPE_MAX];
 	int ctrl_pipe[PIPE_MAX];
-	pthread_mutex_t chunk_lock;
+	pthread_mutex_t rx_lock;
+	pthread_cond_t rx_cond; /*!< Signaled when the stalled reader can go on */
 	guint id; /*!< g_io_watch */
 
 	int server_handle;
+	struct reactor *reactor; /*!< NULL if this TCB has its own thread */
 
 	int (*service_cb)(int fd, void *data);
 	void *data;
 };
 
+static void reactor_detach(struct tcb *tcb);
+
 static ssize_t write_safe(int fd, const void *data, size_t bufsz)
 {
 	int ret;
@@ -160,93 +215,164 @@ static inline struct server *server_create(int handle, int (*service_cb)(int fd,
 /*!
  * \NOTE
  * Running thread: Main
+ *
+ * Close descriptors which are received but never delivered.
  */
-static inline void destroy_chunk(struct chunk *chunk)
+static void rx_discard(struct tcb *tcb)
 {
-	free(chunk->data);
-	free(chunk);
+	struct segment *seg;
+
+	while (tcb->rx.seg_count > 0) {
+		DbgPrint("Discarding segments\n");
+		seg = tcb->rx.segment + tcb->rx.seg_head;
+		if (seg->fd >= 0 && close(seg->fd) < 0) {
+			ErrPrint("close: %s\n", strerror(errno));
+		}
+
+		tcb->rx.seg_head = (tcb->rx.seg_head + 1) % RX_SEG_MAX;
+		tcb->rx.seg_count--;
+	}
+
+	tcb->rx.head = 0;
+	tcb->rx.used = 0;
 }
 
 /*!
  * \NOTE
  * Running thread: Main
  */
-static inline void terminate_thread(struct tcb *tcb)
+static void terminate_thread(struct tcb *tcb)
 {
 	int status;
-	struct dlist *l;
-	struct dlist *n;
 	void *res = NULL;
-	struct chunk *chunk;
-
-	if (write_safe(tcb->ctrl_pipe[PIPE_WRITE], &tcb, sizeof(tcb)) != sizeof(tcb)) {
-		ErrPrint("Unable to write CTRL pipe (%d)\n", sizeof(tcb));
-	}
 
-	secure_socket_destroy_handle(tcb->handle);
-
-	status = pthread_join(tcb->thid, &res);
-	if (status != 0) {
-		ErrPrint("Join: %s\n", strerror(status));
+	if (tcb->reactor) {
+		reactor_detach(tcb);
+		secure_socket_destroy_handle(tcb->handle);
 	} else {
-		ErrPrint("Thread returns: %d\n", (int)((long)res));
-	}
+		if (write_safe(tcb->ctrl_pipe[PIPE_WRITE], &tcb, sizeof(tcb)) != sizeof(tcb)) {
+			ErrPrint("Unable to write CTRL pipe (%d)\n", sizeof(tcb));
+		}
 
-	dlist_foreach_safe(tcb->chunk_list, l, n, chunk) {
 		/*!
-		 * Discarding all packets
+		 * \note
+		 * The reader could be waiting for free space of the ring, instead of the CTRL pipe.
 		 */
-		DbgPrint("Discarding chunks\n");
-		tcb->chunk_list = dlist_remove(tcb->chunk_list, l);
-		destroy_chunk(chunk);
+		CRITICAL_SECTION_BEGIN(&tcb->rx_lock);
+		tcb->rx.closing = 1;
+		pthread_cond_signal(&tcb->rx_cond);
+		CRITICAL_SECTION_END(&tcb->rx_lock);
+
+		secure_socket_destroy_handle(tcb->handle);
+
+		status = pthread_join(tcb->thid, &res);
+		if (status != 0) {
+			ErrPrint("Join: %s\n", strerror(status));
+		} else {
+			ErrPrint("Thread returns: %d\n", (int)((long)res));
+		}
 	}
+
+	/*!
+	 * Discarding all packets
+	 */
+	rx_discard(tcb);
 }
 
 /*!
  * \NOTE
  * Running thread: Main
+ *
+ * Release the consumed bytes of the head segment.
+ * Once the segment is drained, its event is consumed as well,
+ * so the count of segments is always same with the PIPE'd data.
  */
-static inline void chunk_remove(struct tcb *tcb, struct chunk *chunk)
+static void rx_consume(struct tcb *tcb, int size)
 {
+	struct segment *seg;
 	char event_ch;
+	int wakeup = 0;
+
+	seg = tcb->rx.segment + tcb->rx.seg_head;
+	seg->offset += size;
 
-	/* Consuming the event */
-	if (read(tcb->evt_pipe[PIPE_READ], &event_ch, sizeof(event_ch)) != sizeof(event_ch)) {
-		ErrPrint("Failed to get readsize\n");
-		return;
+	if (seg->offset == seg->size) {
+		/* Consuming the event */
+		if (read(tcb->evt_pipe[PIPE_READ], &event_ch, sizeof(event_ch)) != sizeof(event_ch)) {
+			ErrPrint("Failed to get readsize\n");
+		}
 	}
 
-	CRITICAL_SECTION_BEGIN(&tcb->chunk_lock);
+	CRITICAL_SECTION_BEGIN(&tcb->rx_lock);
 
-	dlist_remove_data(tcb->chunk_list, chunk);
+	tcb->rx.head = (tcb->rx.head + size) % RX_RING_SIZE;
+	tcb->rx.used -= size;
 
-	CRITICAL_SECTION_END(&tcb->chunk_lock);
+	if (seg->offset == seg->size) {
+		tcb->rx.seg_head = (tcb->rx.seg_head + 1) % RX_SEG_MAX;
+		tcb->rx.seg_count--;
+	}
 
-	destroy_chunk(chunk);
+	if (tcb->rx.stalled) {
+		tcb->rx.stalled = 0;
+		if (tcb->reactor) {
+			wakeup = 1;
+		} else {
+			pthread_cond_signal(&tcb->rx_cond);
+		}
+	}
+
+	CRITICAL_SECTION_END(&tcb->rx_lock);
+
+	if (wakeup) {
+		struct epoll_event ev;
+
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN;
+		ev.data.ptr = tcb;
+
+		/*!
+		 * \note
+		 * The reactor removed this connection from its epoll set when the ring was full,
+		 * before the stalled flag was set, so this never runs ahead of the removal.
+		 * Level triggered, so the pending data will be notified again.
+		 */
+		if (epoll_ctl(tcb->reactor->epoll_fd, EPOLL_CTL_ADD, tcb->handle, &ev) < 0) {
+			ErrPrint("epoll_ctl: %s\n", strerror(errno));
+		}
+	}
 }
 
 /*!
  * \NOTE
  * Running thread: Other
  */
-static inline int chunk_append(struct tcb *tcb, struct chunk *chunk)
+static int rx_commit(struct tcb *tcb, int size, pid_t pid, int fd)
 {
+	struct segment *seg;
 	char event_ch = EVENT_READY;
 	int ret;
 
-	CRITICAL_SECTION_BEGIN(&tcb->chunk_lock);
+	CRITICAL_SECTION_BEGIN(&tcb->rx_lock);
 
-	tcb->chunk_list = dlist_append(tcb->chunk_list, chunk);
+	seg = tcb->rx.segment + ((tcb->rx.seg_head + tcb->rx.seg_count) % RX_SEG_MAX);
+	seg->size = size;
+	seg->offset = 0;
+	seg->pid = pid;
+	seg->fd = fd;
+	tcb->rx.seg_count++;
+	tcb->rx.used += size;
 
-	CRITICAL_SECTION_END(&tcb->chunk_lock);
+	CRITICAL_SECTION_END(&tcb->rx_lock);
 
 	ret = write_safe(tcb->evt_pipe[PIPE_WRITE], &event_ch, sizeof(event_ch));
 	if (ret < 0) {
-		CRITICAL_SECTION_BEGIN(&tcb->chunk_lock);
+		CRITICAL_SECTION_BEGIN(&tcb->rx_lock);
 
-		dlist_remove_data(tcb->chunk_list, chunk);
+		tcb->rx.seg_count--;
+		tcb->rx.used -= size;
 
-		CRITICAL_SECTION_END(&tcb->chunk_lock);
+		CRITICAL_SECTION_END(&tcb->rx_lock);
 		return ret;
 	}
 
@@ -254,8 +380,10 @@ static inline int chunk_append(struct tcb *tcb, struct chunk *chunk)
 		ErrPrint("Failed to trigger reader\n");
 	}
 
-	/* Take a breathe */
-	pthread_yield();
+	/* Take a breathe, but a reactor has other connections to serve */
+	if (!tcb->reactor) {
+		pthread_yield();
+	}
 	return 0;
 }
 
@@ -307,30 +435,114 @@ static inline int wait_event(struct tcb *tcb, double timeout)
 
 /*!
  * \NOTE
- * Running thread: Main
+ * Running thread: Other
+ *
+ * Read data from the socket into the free space of the ring, as much as it can do at once.
+ * Returns negative value if the connection should be terminated,
+ * 1 if the ring is full, the reader should wait until the main thread consumes it.
  */
-static inline struct chunk *create_chunk(int size)
+static int read_ring(struct tcb *tcb)
 {
-	struct chunk *chunk;
+	char *ptr;
+	int readsize;
+	int space;
+	int tail;
+	pid_t pid = (pid_t)-1;
+	int fd = -1;
+	int ret;
 
-	chunk = malloc(sizeof(*chunk));
-	if (!chunk) {
-		ErrPrint("Heap: %s\n", strerror(errno));
-		return NULL;
+	readsize = 0;
+	ret = ioctl(tcb->handle, FIONREAD, &readsize);
+	if (ret < 0) {
+		ret = -errno;
+		ErrPrint("ioctl: %s\n", strerror(errno));
+		return ret;
 	}
 
-	chunk->data = malloc(size);
-	if (!chunk->data) {
-		ErrPrint("Heap: %s\n", strerror(errno));
-		free(chunk);
-		return NULL;
+	if (readsize <= 0) {
+		ErrPrint("Available data: %d\n", readsize);
+		return -ECONNRESET;
+	}
+
+	CRITICAL_SECTION_BEGIN(&tcb->rx_lock);
+
+	if (tcb->rx.used == 0) {
+		/* Nothing is referenced, start from the beginning to get the largest contiguous space */
+		tcb->rx.head = 0;
+	}
+
+	tail = (tcb->rx.head + tcb->rx.used) % RX_RING_SIZE;
+	if (tcb->rx.used == RX_RING_SIZE || tcb->rx.seg_count == RX_SEG_MAX) {
+		space = 0;
+	} else if (tail < tcb->rx.head) {
+		space = tcb->rx.head - tail;
+	} else {
+		space = RX_RING_SIZE - tail;
 	}
 
-	chunk->pid = (pid_t)-1;
-	chunk->size = size;
-	chunk->offset = 0;
-	chunk->fd = -1;
-	return chunk;
+	if (space == 0) {
+		/*!
+		 * \note
+		 * The ring is full, a reactor stops polling until the main thread consumes it.
+		 * It is removed instead of being masked, because HUP cannot be masked.
+		 */
+		if (tcb->reactor && epoll_ctl(tcb->reactor->epoll_fd, EPOLL_CTL_DEL, tcb->handle, NULL) < 0) {
+			ErrPrint("epoll_ctl: %s\n", strerror(errno));
+		}
+
+		tcb->rx.stalled = 1;
+	}
+
+	CRITICAL_SECTION_END(&tcb->rx_lock);
+
+	if (space == 0) {
+		return 1;
+	}
+
+	/*!
+	 * \note
+	 * The main thread never touches the free region, so it is safe to fill it without the lock.
+	 * The rest of data will be read when the reader is woken up again.
+	 */
+	ptr = tcb->rx.data + tail;
+	ret = secure_socket_recv_with_fd(tcb->handle, ptr, readsize > space ? space : readsize, &pid, &fd);
+	if (ret <= 0) {
+		if (ret == -EAGAIN) {
+			DbgPrint("Retry to get data\n");
+			return 0;
+		}
+
+		DbgPrint("Recv returns: %d\n", ret);
+		return ret == 0 ? -ECONNRESET : ret;
+	}
+
+	/*!
+	 * Count of segments are same with PIPE'd data
+	 */
+	ret = rx_commit(tcb, ret, pid, fd);
+	if (ret < 0) {
+		if (fd >= 0 && close(fd) < 0) {
+			ErrPrint("close: %s\n", strerror(errno));
+		}
+		return ret;
+	}
+
+	return 0;
+}
+
+/*!
+ * \NOTE
+ * Running thread: Other
+ */
+static inline void notify_term(struct tcb *tcb)
+{
+	char event_ch = EVENT_TERM;
+
+	DbgPrint("Client CB is terminated (%d)\n", tcb->handle);
+	/* Wake up main thread to get disconnected event */
+	if (write_safe(tcb->evt_pipe[PIPE_WRITE], &event_ch, sizeof(event_ch)) != sizeof(event_ch)) {
+		ErrPrint("%d byte is not written\n", sizeof(event_ch));
+	}
 }
 
 /*!
@@ -340,18 +552,11 @@ static inline struct chunk *create_chunk(int size)
 static void *client_cb(void *data)
 {
 	struct tcb *tcb = data;
-	struct chunk *chunk;
 	int ret = 0;
 	fd_set set;
-	int readsize;
-	char event_ch;
 	int fd;
 
 	DbgPrint("Thread is created for %d (server: %d)\n", tcb->handle, tcb->server_handle);
-	/*!
-	 * \NOTE
-	 * Read all data from the socket as possible as it can do
-	 */
 	while (1) {
 		FD_ZERO(&set);
 		FD_SET(tcb->handle, &set);
@@ -386,66 +591,372 @@ static void *client_cb(void *data)
 			break;
 		}
 
-		readsize = 0;
-		ret = ioctl(tcb->handle, FIONREAD, &readsize);
+		ret = read_ring(tcb);
 		if (ret < 0) {
-			ErrPrint("ioctl: %s\n", strerror(errno));
 			break;
+		} else if (ret > 0) {
+			CRITICAL_SECTION_BEGIN(&tcb->rx_lock);
+			while (tcb->rx.stalled && !tcb->rx.closing) {
+				pthread_cond_wait(&tcb->rx_cond, &tcb->rx_lock);
+			}
+			CRITICAL_SECTION_END(&tcb->rx_lock);
 		}
+	}
 
-		if (readsize <= 0) {
-			ErrPrint("Available data: %d\n", readsize);
-			ret = -ECONNRESET;
-			break;
-		}
+	notify_term(tcb);
+	return (void *)(unsigned long)ret;
+}
+
+/*!
+ * \NOTE
+ * Running thread: Reactor
+ *
+ * Every attached TCB gets the TERM event, so its owner can close the connection.
+ */
+static void reactor_abort(struct reactor *reactor)
+{
+	struct dlist *l;
+	struct dlist *n;
+	struct tcb *tcb;
+
+	CRITICAL_SECTION_BEGIN(&reactor->lock);
+
+	reactor->broken = 1;
+	dlist_foreach_safe(reactor->tcb_list, l, n, tcb) {
+		reactor->tcb_list = dlist_remove(reactor->tcb_list, l);
+		notify_term(tcb);
+	}
+
+	CRITICAL_SECTION_END(&reactor->lock);
+}
+
+/*!
+ * \NOTE
+ * Running thread: Reactor
+ *
+ * One reactor serves every connection in its epoll set.
+ * Before reading a connection, the epoch is compared with the one taken before epoll_wait().
+ * If a TCB was detached in the meantime, the rest of the batch may refer to a destroyed TCB,
+ * so it is discarded. Descriptors are level triggered, so nothing is lost by this.
+ * The connection is read without the lock, reactor_detach() waits only for the TCB being read.
+ */
+static void *reactor_main(void *data)
+{
+	struct reactor *reactor = data;
+	struct epoll_event events[REACTOR_MAX_EVENTS];
+	struct dlist *l;
+	struct tcb *tcb;
+	unsigned long epoch;
+	int count;
+	int ret;
+	int i;
+
+	while (1) {
+		CRITICAL_SECTION_BEGIN(&reactor->lock);
+		epoch = reactor->epoch;
+		CRITICAL_SECTION_END(&reactor->lock);
+
+		count = epoll_wait(reactor->epoll_fd, events, REACTOR_MAX_EVENTS, -1);
+		if (count < 0) {
+			if (errno == EINTR) {
+				DbgPrint("epoll_wait receives INTR\n");
+				continue;
+			}
 
-		chunk = create_chunk(readsize);
-		if (!chunk) {
-			ErrPrint("Failed to create a new chunk: %d\n", readsize);
-			ret = -ENOMEM;
+			ErrPrint("epoll_wait: %s\n", strerror(errno));
 			break;
 		}
 
-		ret = secure_socket_recv_with_fd(tcb->handle, chunk->data, chunk->size, &chunk->pid, &chunk->fd);
-		if (ret <= 0) {
-			destroy_chunk(chunk);
-			if (ret == -EAGAIN) {
-				DbgPrint("Retry to get data\n");
-				continue;
+		for (i = 0; i < count; i++) {
+			tcb = events[i].data.ptr;
+
+			CRITICAL_SECTION_BEGIN(&reactor->lock);
+			if (reactor->epoch != epoch) {
+				CRITICAL_SECTION_END(&reactor->lock);
+				break;
 			}
+			reactor->current = tcb;
+			CRITICAL_SECTION_END(&reactor->lock);
+
+			ret = read_ring(tcb);
+			if (ret < 0 && epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, tcb->handle, NULL) < 0) {
+				ErrPrint("epoll_ctl: %s\n", strerror(errno));
+			}
+
+			CRITICAL_SECTION_BEGIN(&reactor->lock);
+			if (ret < 0) {
+				l = dlist_find_data(reactor->tcb_list, tcb);
+				if (l) {
+					reactor->tcb_list = dlist_remove(reactor->tcb_list, l);
+					notify_term(tcb);
+				}
+			}
+			reactor->current = NULL;
+			pthread_cond_broadcast(&reactor->idle_cond);
+			CRITICAL_SECTION_END(&reactor->lock);
+		}
+	}
+
+	reactor_abort(reactor);
+	return NULL;
+}
+
+/*!
+ * \NOTE
+ * Running thread: Main
+ */
+static inline int reactor_workers(void)
+{
+	const char *env;
+
+	if (s_info.reactor_workers < 0) {
+		env = getenv(REACTOR_ENV);
+		s_info.reactor_workers = env ? atoi(env) : 0;
+
+		if (s_info.reactor_workers < 0) {
+			s_info.reactor_workers = 0;
+		} else if (s_info.reactor_workers > REACTOR_MAX_WORKERS) {
+			s_info.reactor_workers = REACTOR_MAX_WORKERS;
+		}
+	}
+
+	return s_info.reactor_workers;
+}
+
+/*!
+ * \NOTE
+ * Running thread: Main
+ */
+static int reactor_launch(struct reactor *reactor)
+{
+	int status;
+
+	reactor->epoch = 0lu;
+	reactor->count = 0;
+	reactor->current = NULL;
+	reactor->tcb_list = NULL;
+	reactor->broken = 0;
+
+	reactor->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (reactor->epoll_fd < 0) {
+		status = -errno;
+		ErrPrint("epoll_create1: %s\n", strerror(errno));
+		return status;
+	}
+
+	status = pthread_mutex_init(&reactor->lock, NULL);
+	if (status != 0) {
+		ErrPrint("Error: %s\n", strerror(status));
+		if (close(reactor->epoll_fd) < 0) {
+			ErrPrint("close: %s\n", strerror(errno));
+		}
+		return -status;
+	}
+
+	status = pthread_cond_init(&reactor->idle_cond, NULL);
+	if (status != 0) {
+		ErrPrint("Error: %s\n", strerror(status));
+		status = pthread_mutex_destroy(&reactor->lock);
+		if (status != 0) {
+			ErrPrint("Error: %s\n", strerror(status));
+		}
+		if (close(reactor->epoll_fd) < 0) {
+			ErrPrint("close: %s\n", strerror(errno));
+		}
+		return -EFAULT;
+	}
+
+	status = pthread_create(&reactor->thid, NULL, reactor_main, reactor);
+	if (status != 0) {
+		ErrPrint("Thread creation failed: %s\n", strerror(status));
+		status = pthread_cond_destroy(&reactor->idle_cond);
+		if (status != 0) {
+			ErrPrint("Error: %s\n", strerror(status));
+		}
+		status = pthread_mutex_destroy(&reactor->lock);
+		if (status != 0) {
+			ErrPrint("Error: %s\n", strerror(status));
+		}
+		if (close(reactor->epoll_fd) < 0) {
+			ErrPrint("close: %s\n", strerror(errno));
+		}
+		return -EFAULT;
+	}
+
+	DbgPrint("Reactor is launched (epoll: %d)\n", reactor->epoll_fd);
+	return 0;
+}
+
+/*!
+ * \NOTE
+ * Running thread: Main
+ *
+ * Reactors are launched lazily and kept until the process is terminated.
+ * Returns the least loaded one or NULL if the thread per connection should be used.
+ * A broken reactor is never picked again.
+ */
+static struct reactor *reactor_pick(void)
+{
+	struct reactor *reactor;
+	int broken;
+	int i;
 
-			DbgPrint("Recv returns: %d\n", ret);
+	while (s_info.reactor_count < reactor_workers()) {
+		if (reactor_launch(&s_info.reactor[s_info.reactor_count]) < 0) {
 			break;
 		}
 
-		/* Update chunk size */
-		chunk->size = ret;
-
-		/*!
-		 * Count of chunk elements are same with PIPE'd data
-		 */
-		if (chunk_append(tcb, chunk) < 0) {
-			destroy_chunk(chunk);
-			break;
+		s_info.reactor_count++;
+	}
+
+	reactor = NULL;
+	for (i = 0; i < s_info.reactor_count; i++) {
+		CRITICAL_SECTION_BEGIN(&s_info.reactor[i].lock);
+		broken = s_info.reactor[i].broken;
+		CRITICAL_SECTION_END(&s_info.reactor[i].lock);
+
+		if (broken) {
+			continue;
+		}
+
+		if (!reactor || s_info.reactor[i].count < reactor->count) {
+			reactor = &s_info.reactor[i];
+		}
+	}
+
+	return reactor;
+}
+
+/*!
+ * \NOTE
+ * Running thread: Main
+ */
+static int reactor_attach(struct reactor *reactor, struct tcb *tcb)
+{
+	struct epoll_event ev;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.ptr = tcb;
+
+	CRITICAL_SECTION_BEGIN(&reactor->lock);
+	reactor->tcb_list = dlist_append(reactor->tcb_list, tcb);
+	CRITICAL_SECTION_END(&reactor->lock);
+
+	tcb->reactor = reactor;
+	if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, tcb->handle, &ev) < 0) {
+		struct dlist *l;
+		int ret;
+
+		ret = -errno;
+		ErrPrint("epoll_ctl: %s\n", strerror(errno));
+
+		CRITICAL_SECTION_BEGIN(&reactor->lock);
+		l = dlist_find_data(reactor->tcb_list, tcb);
+		if (l) {
+			reactor->tcb_list = dlist_remove(reactor->tcb_list, l);
+		}
+		CRITICAL_SECTION_END(&reactor->lock);
+
+		tcb->reactor = NULL;
+		return ret;
+	}
+
+	reactor->count++;
+	DbgPrint("[%d] is attached to the reactor (epoll: %d, count: %d)\n", tcb->handle, reactor->epoll_fd, reactor->count);
+	return 0;
+}
+
+/*!
+ * \NOTE
+ * Running thread: Main
+ *
+ * After this returns, the reactor never touches the TCB again.
+ * If the reactor is reading this TCB, waits for it, reading other TCBs doesn't block this.
+ */
+static void reactor_detach(struct tcb *tcb)
+{
+	struct reactor *reactor = tcb->reactor;
+	struct dlist *l;
+
+	CRITICAL_SECTION_BEGIN(&reactor->lock);
+
+	/*!
+	 * \note
+	 * If the reactor already found the connection is lost, it is removed from the epoll set already.
+	 */
+	if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, tcb->handle, NULL) < 0 && errno != ENOENT) {
+		ErrPrint("epoll_ctl: %s\n", strerror(errno));
+	}
+	reactor->epoch++;
+
+	l = dlist_find_data(reactor->tcb_list, tcb);
+	if (l) {
+		reactor->tcb_list = dlist_remove(reactor->tcb_list, l);
+	}
+
+	while (reactor->current == tcb) {
+		pthread_cond_wait(&reactor->idle_cond, &reactor->lock);
+	}
+
+	CRITICAL_SECTION_END(&reactor->lock);
+
+	reactor->count--;
+	tcb->reactor = NULL;
+}
+
+/*!
+ * \NOTE
+ * Running thread: Main
+ *
+ * Start to read data from the connection,
+ * using a shared reactor if it is enabled, or a dedicated thread.
+ */
+static int reader_launch(struct tcb *tcb)
+{
+	struct reactor *reactor;
+	pthread_attr_t attr;
+	pthread_attr_t *pattr = NULL;
+	int ret;
+
+	reactor = reactor_pick();
+	if (reactor) {
+		return reactor_attach(reactor, tcb);
+	}
+
+	ret = pthread_attr_init(&attr);
+	if (ret == 0) {
+		pattr = &attr;
+
+		ret = pthread_attr_setscope(pattr, PTHREAD_SCOPE_SYSTEM);
+		if (ret != 0) {
+			ErrPrint("setscope: %s\n", strerror(ret));
+		}
+
+		ret = pthread_attr_setinheritsched(pattr, PTHREAD_EXPLICIT_SCHED);
+		if (ret != 0) {
+			ErrPrint("setinheritsched: %s\n", strerror(ret));
 		}
+	} else {
+		ErrPrint("attr_init: %s\n", strerror(ret));
 	}
-
-	DbgPrint("Client CB is terminated (%d)\n", tcb->handle);
-	/* Wake up main thread to get disconnected event */
-	event_ch = EVENT_TERM;
-
-	if (write_safe(tcb->evt_pipe[PIPE_WRITE], &event_ch, sizeof(event_ch)) != sizeof(event_ch)) {
-		ErrPrint("%d byte is not written\n", sizeof(event_ch));
+	ret = pthread_create(&tcb->thid, pattr, client_cb, tcb);
+	if (pattr) {
+		pthread_attr_destroy(pattr);
+	}
+	if (ret != 0) {
+		ErrPrint("Thread creation failed: %s\n", strerror(ret));
+		return -EFAULT;
 	}
 
-	return (void *)(unsigned long)ret;
+	return 0;
 }
 
 /*!
  * \NOTE
  * Running thread: Main
  */
-static inline void tcb_destroy(struct tcb *tcb)
+static void tcb_destroy(struct tcb *tcb)
 {
 	int status;
 
@@ -458,11 +969,17 @@ static inline void tcb_destroy(struct tcb *tcb)
 	CLOSE_PIPE(tcb->evt_pipe);
 	CLOSE_PIPE(tcb->ctrl_pipe);
 
-	status = pthread_mutex_destroy(&tcb->chunk_lock);
+	status = pthread_mutex_destroy(&tcb->rx_lock);
 	if (status != 0) {
 		ErrPrint("Failed to destroy mutex: %s\n", strerror(status));
 	}
 
+	status = pthread_cond_destroy(&tcb->rx_cond);
+	if (status != 0) {
+		ErrPrint("Failed to destroy cond: %s\n", strerror(status));
+	}
+
+	free(tcb->rx.data);
 	free(tcb);
 }
 
@@ -513,7 +1030,7 @@ errout:
  * \NOTE
  * Running thread: Main
  */
-static inline struct tcb *tcb_create(int client_fd, int is_sync, int (*service_cb)(int fd, void *data), void *data)
+static struct tcb *tcb_create(int client_fd, int is_sync, int (*service_cb)(int fd, void *data), void *data)
 {
 	struct tcb *tcb;
 	int status;
@@ -525,44 +1042,62 @@ static inline struct tcb *tcb_create(int client_fd, int is_sync, int (*service_c
 	}
 
 	tcb->handle = client_fd;
-	tcb->chunk_list = NULL;
 	tcb->service_cb = service_cb;
 	tcb->data = data;
 	tcb->id = 0;
+	tcb->reactor = NULL;
+
+	memset(&tcb->rx, 0, sizeof(tcb->rx));
+	tcb->rx.data = malloc(RX_RING_SIZE);
+	if (!tcb->rx.data) {
+		ErrPrint("Error: %s\n", strerror(errno));
+		free(tcb);
+		return NULL;
+	}
 
-	status = pthread_mutex_init(&tcb->chunk_lock, NULL);
+	status = pthread_mutex_init(&tcb->rx_lock, NULL);
 	if (status != 0) {
 		ErrPrint("Error: %s\n", strerror(status));
+		free(tcb->rx.data);
 		free(tcb);
 		return NULL;
 	}
 
+	status = pthread_cond_init(&tcb->rx_cond, NULL);
+	if (status != 0) {
+		ErrPrint("Error: %s\n", strerror(status));
+		goto out_mutex;
+	}
+
 	if (pipe2(tcb->evt_pipe, O_CLOEXEC) < 0) {
 		ErrPrint("Error: %s\n", strerror(errno));
-		status = pthread_mutex_destroy(&tcb->chunk_lock);
-		if (status != 0) {
-			ErrPrint("Error: %s\n", strerror(status));
-		}
-		free(tcb);
-		return NULL;
+		goto out_cond;
 	}
 
 	if (pipe2(tcb->ctrl_pipe, O_CLOEXEC) < 0) {
 		ErrPrint("Error: %s\n", strerror(errno));
-
 		CLOSE_PIPE(tcb->evt_pipe);
-
-		status = pthread_mutex_destroy(&tcb->chunk_lock);
-		if (status != 0) {
-			ErrPrint("Error: %s\n", strerror(status));
-		}
-
-		free(tcb);
-		return NULL;
+		goto out_cond;
 	}
 
 	DbgPrint("[%d] New TCB created: R(%d), W(%d)\n", client_fd, tcb->evt_pipe[PIPE_READ], tcb->evt_pipe[PIPE_WRITE]);
 	return tcb;
+
+out_cond:
+	status = pthread_cond_destroy(&tcb->rx_cond);
+	if (status != 0) {
+		ErrPrint("Error: %s\n", strerror(status));
+	}
+
+out_mutex:
+	status = pthread_mutex_destroy(&tcb->rx_lock);
+	if (status != 0) {
+		ErrPrint("Error: %s\n", strerror(status));
+	}
+
+	free(tcb->rx.data);
+	free(tcb);
+	return NULL;
 }
 
 /*!
@@ -577,8 +1112,6 @@ static gboolean accept_cb(GIOChannel *src, GIOCondition cond, gpointer data)
 	struct tcb *tcb;
 	GIOChannel *gio;
 	struct server *server = data;
-	pthread_attr_t attr;
-	pthread_attr_t *pattr = NULL;
 
 	socket_fd = g_io_channel_unix_get_fd(src);
 	if (!(cond & G_IO_IN)) {
@@ -650,28 +1183,8 @@ static gboolean accept_cb(GIOChannel *src, GIOCondition cond, gpointer data)
 
 	invoke_con_cb_list(tcb->handle, tcb->handle, 0, NULL, 0);
 
-	ret = pthread_attr_init(&attr);
-	if (ret == 0) {
-		pattr = &attr;
-
-		ret = pthread_attr_setscope(pattr, PTHREAD_SCOPE_SYSTEM);
-		if (ret != 0) {
-			ErrPrint("setscope: %s\n", strerror(ret));
-		}
-
-		ret = pthread_attr_setinheritsched(pattr, PTHREAD_EXPLICIT_SCHED);
-		if (ret != 0) {
-			ErrPrint("setinheritsched: %s\n", strerror(ret));
-		}
-	} else {
-		ErrPrint("attr_init: %s\n", strerror(ret));
-	}
-	ret = pthread_create(&tcb->thid, pattr, client_cb, tcb);
-	if (pattr) {
-		pthread_attr_destroy(pattr);
-	}
-	if (ret != 0) {
-		ErrPrint("Thread creation failed: %s\n", strerror(ret));
+	ret = reader_launch(tcb);
+	if (ret < 0) {
 		(void)invoke_disconn_cb_list(tcb->handle, 0, 0, 0);
 		secure_socket_destroy_handle(tcb->handle);
 		tcb_destroy(tcb);
@@ -692,8 +1205,6 @@ EAPI int com_core_thread_client_create(const char *addr, int is_sync, int (*serv
 	int client_fd;
 	struct tcb *tcb;
 	int ret;
-	pthread_attr_t attr;
-	pthread_attr_t *pattr = NULL;
 
 	client_fd = secure_socket_create_client(addr);
 	if (client_fd < 0) {
@@ -748,28 +1259,8 @@ EAPI int com_core_thread_client_create(const char *addr, int is_sync, int (*serv
 
 	invoke_con_cb_list(tcb->handle, tcb->handle, 0, NULL, 0);
 
-	ret = pthread_attr_init(&attr);
-	if (ret == 0) {
-		pattr = &attr;
-
-		ret = pthread_attr_setscope(pattr, PTHREAD_SCOPE_SYSTEM);
-		if (ret != 0) {
-			ErrPrint("setscope: %s\n", strerror(ret));
-		}
-
-		ret = pthread_attr_setinheritsched(pattr, PTHREAD_EXPLICIT_SCHED);
-		if (ret != 0) {
-			ErrPrint("setinheritsched: %s\n", strerror(ret));
-		}
-	} else {
-		ErrPrint("attr_init: %s\n", strerror(ret));
-	}
-	ret = pthread_create(&tcb->thid, pattr, client_cb, tcb);
-	if (pattr) {
-		pthread_attr_destroy(pattr);
-	}
-	if (ret != 0) {
-		ErrPrint("Thread creation failed: %s\n", strerror(ret));
+	ret = reader_launch(tcb);
+	if (ret < 0) {
 		(void)invoke_disconn_cb_list(tcb->handle, 0, 0, 0);
 		secure_socket_destroy_handle(tcb->handle);
 		tcb_destroy(tcb);
@@ -798,8 +1289,6 @@ EAPI int com_core_thread_client_create_by_fd(int client_fd, int is_sync, int (*s
 	GIOChannel *gio;
 	struct tcb *tcb;
 	int ret;
-	pthread_attr_t attr;
-	pthread_attr_t *pattr = NULL;
 
 	if (!validate_handle(client_fd)) {
 		ErrPrint("Invalid handle: %d\n", client_fd);
@@ -854,28 +1343,8 @@ EAPI int com_core_thread_client_create_by_fd(int client_fd, int is_sync, int (*s
 
 	invoke_con_cb_list(tcb->handle, tcb->handle, 0, NULL, 0);
 
-	ret = pthread_attr_init(&attr);
-	if (ret == 0) {
-		pattr = &attr;
-
-		ret = pthread_attr_setscope(pattr, PTHREAD_SCOPE_SYSTEM);
-		if (ret != 0) {
-			ErrPrint("setscope: %s\n", strerror(ret));
-		}
-
-		ret = pthread_attr_setinheritsched(pattr, PTHREAD_EXPLICIT_SCHED);
-		if (ret != 0) {
-			ErrPrint("setinheritsched: %s\n", strerror(ret));
-		}
-	} else {
-		ErrPrint("attr_init: %s\n", strerror(ret));
-	}
-	ret = pthread_create(&tcb->thid, pattr, client_cb, tcb);
-	if (pattr) {
-		pthread_attr_destroy(pattr);
-	}
-	if (ret != 0) {
-		ErrPrint("Thread creation failed: %s\n", strerror(ret));
+	ret = reader_launch(tcb);
+	if (ret < 0) {
 		(void)invoke_disconn_cb_list(tcb->handle, 0, 0, 0);
 		secure_socket_destroy_handle(tcb->handle);
 		tcb_destroy(tcb);
@@ -942,6 +1411,26 @@ EAPI int com_core_thread_server_create(const char *addr, int is_sync, const char
 	return server->handle;
 }
 
+/*!
+ * \NOTE
+ * Running thread: Main
+ */
+EAPI int com_core_thread_set_reactor(int workers)
+{
+	if (s_info.tcb_list || s_info.reactor_count) {
+		ErrPrint("com-core thread is in use\n");
+		return -EBUSY;
+	}
+
+	if (workers < 0 || workers > REACTOR_MAX_WORKERS) {
+		ErrPrint("Invalid count of workers: %d\n", workers);
+		return -EINVAL;
+	}
+
+	s_info.reactor_workers = workers;
+	return 0;
+}
+
 /*!
  * \NOTE
  * Running thread: Main
@@ -1033,6 +1522,23 @@ EAPI int com_core_thread_send_with_fd(int handle, const char *buffer, int size,
 	return writesize;
 }
 
+/*!
+ * \NOTE
+ * Running thread: Main
+ */
+EAPI int com_core_thread_sendv_with_fd(int handle, struct iovec *iov, int iovcnt, double timeout, int fd)
+{
+	struct tcb *tcb;
+
+	tcb = find_tcb_by_handle(handle);
+	if (!tcb) {
+		ErrPrint("TCB is not found\n");
+		return -EINVAL;
+	}
+
+	return com_core_sendv_with_fd(tcb->handle, iov, iovcnt, timeout, fd);
+}
+
 /*!
  * \NOTE
  * Running thread: Main
@@ -1042,15 +1548,101 @@ EAPI int com_core_thread_send(int handle, const char *buffer, int size, double t
 	return com_core_thread_send_with_fd(handle, buffer, size, timeout, -1);
 }
 
-EAPI int com_core_thread_recv_with_fd(int handle, char *buffer, int size, int *sender_pid, double timeout, int *fd)
+/*!
+ * \NOTE
+ * Running thread: Main
+ */
+EAPI int com_core_thread_recv_peek(int handle, const char **ptr, int *sender_pid, double timeout, int *fd)
 {
-	int readsize;
+	struct segment *seg;
+	struct tcb *tcb;
+	int seg_count;
 	int ret;
-	struct chunk *chunk;
-	struct dlist *l;
+
+	tcb = find_tcb_by_handle(handle);
+	if (!tcb) {
+		ErrPrint("TCB is not exists\n");
+		return -EINVAL;
+	}
+
+	if (fd) {
+		*fd = -1;
+	}
+
+	while (1) {
+		CRITICAL_SECTION_BEGIN(&tcb->rx_lock);
+		seg_count = tcb->rx.seg_count;
+		CRITICAL_SECTION_END(&tcb->rx_lock);
+
+		if (seg_count > 0) {
+			break;
+		}
+
+		/*!
+		 * \note
+		 * Pumping up the pipe data
+		 */
+		ret = wait_event(tcb, timeout);
+		if (ret == -EAGAIN) {
+			/* Log is printed from wait_event */
+			continue;
+		} else if (ret == -ECONNRESET) {
+			DbgPrint("Connection is lost\n");
+			return 0;
+		} else if (ret < 0) {
+			/* Log is printed from wait_event */
+			return ret;
+		}
+
+		CRITICAL_SECTION_BEGIN(&tcb->rx_lock);
+		seg_count = tcb->rx.seg_count;
+		CRITICAL_SECTION_END(&tcb->rx_lock);
+
+		if (seg_count == 0) {
+			char event_ch;
+
+			/* Consuming the event */
+			if (read(tcb->evt_pipe[PIPE_READ], &event_ch, sizeof(event_ch)) != sizeof(event_ch)) {
+				ErrPrint("Failed to get readsize: %s\n", strerror(errno));
+			} else if (event_ch == EVENT_READY) {
+				ErrPrint("Failed to get a new segment\n");
+			} else if (event_ch == EVENT_TERM) {
+				DbgPrint("Disconnected\n");
+			}
+
+			return 0;
+		}
+	}
+
+	seg = tcb->rx.segment + tcb->rx.seg_head;
+
+	*ptr = tcb->rx.data + tcb->rx.head;
+	if (sender_pid) {
+		*sender_pid = seg->pid;
+	}
+
+	/* Descriptor is delivered only once */
+	if (seg->fd >= 0) {
+		if (fd) {
+			*fd = seg->fd;
+		} else if (close(seg->fd) < 0) {
+			ErrPrint("close: %s\n", strerror(errno));
+		}
+
+		seg->fd = -1;
+	}
+
+	return seg->size - seg->offset;
+}
+
+/*!
+ * \NOTE
+ * Running thread: Main
+ */
+EAPI int com_core_thread_recv_consume(int handle, int size)
+{
+	struct segment *seg;
 	struct tcb *tcb;
-	int _sender_pid;
-	int _fd;
 
 	tcb = find_tcb_by_handle(handle);
 	if (!tcb) {
@@ -1058,10 +1650,31 @@ EAPI int com_core_thread_recv_with_fd(int handle, char *buffer, int size, int *s
 		return -EINVAL;
 	}
 
-	if (!sender_pid) {
-		sender_pid = &_sender_pid;
+	CRITICAL_SECTION_BEGIN(&tcb->rx_lock);
+	seg = tcb->rx.seg_count > 0 ? tcb->rx.segment + tcb->rx.seg_head : NULL;
+	CRITICAL_SECTION_END(&tcb->rx_lock);
+
+	if (!seg || size <= 0 || size > seg->size - seg->offset) {
+		ErrPrint("Invalid size: %d\n", size);
+		return -EINVAL;
 	}
 
+	rx_consume(tcb, size);
+	return 0;
+}
+
+/*!
+ * \NOTE
+ * Running thread: Main
+ */
+EAPI int com_core_thread_recv_with_fd(int handle, char *buffer, int size, int *sender_pid, double timeout, int *fd)
+{
+	const char *ptr;
+	int readsize;
+	int seg_fd;
+	int ret;
+	int _fd;
+
 	if (!fd) {
 		fd = &_fd;
 	}
@@ -1069,57 +1682,24 @@ EAPI int com_core_thread_recv_with_fd(int handle, char *buffer, int size, int *s
 	*fd = -1;
 	readsize = 0;
 	while (readsize < size) {
-		l = dlist_nth(tcb->chunk_list, 0);
-		chunk = dlist_data(l);
-		/*!
-		 * \note
-		 * Pumping up the pipe data
-		 * This is the first time to use a chunk
-		 */
-		if (!chunk) {
-			ret = wait_event(tcb, timeout);
-			if (ret == -EAGAIN) {
-				/* Log is printed from wait_event */
-				continue;
-			} else if (ret == -ECONNRESET) {
-				DbgPrint("Connection is lost\n");
-				break;
-			} else if (ret < 0) {
-				/* Log is printed from wait_event */
-				return ret;
-			}
-
-			l = dlist_nth(tcb->chunk_list, 0);
-			chunk = dlist_data(l);
-			if (!chunk) {
-				char event_ch;
-
-				/* Consuming the event */
-				if (read(tcb->evt_pipe[PIPE_READ], &event_ch, sizeof(event_ch)) != sizeof(event_ch)) {
-					ErrPrint("Failed to get readsize: %s\n", strerror(errno));
-				} else if (event_ch == EVENT_READY) {
-					ErrPrint("Failed to get a new chunk\n");
-				} else if (event_ch == EVENT_TERM) {
-					DbgPrint("Disconnected\n");
-				}
+		ret = com_core_thread_recv_peek(handle, &ptr, sender_pid, timeout, &seg_fd);
+		if (ret < 0) {
+			return ret;
+		} else if (ret == 0) {
+			break;
+		}
 
-				break;
-			}
+		if (seg_fd >= 0) {
+			*fd = seg_fd;
 		}
 
-		ret = chunk->size - chunk->offset;
 		ret = ret > (size - readsize) ? (size - readsize) : ret;
-		memcpy(buffer + readsize, chunk->data + chunk->offset, ret);
+		memcpy(buffer + readsize, ptr, ret);
 		readsize += ret;
-		chunk->offset += ret;
 
-		*sender_pid = chunk->pid;
-		if (chunk->fd >= 0) {
-			*fd = chunk->fd;
-		}
-
-		if (chunk->offset == chunk->size) {
-			chunk_remove(tcb, chunk);
+		ret = com_core_thread_recv_consume(handle, ret);
+		if (ret < 0) {
+			return ret;
 		}
 	}
 
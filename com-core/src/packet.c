@@ -22,6 +22,8 @@
 #include <string.h>
 #include <sys/time.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <sys/uio.h>
 
 #include <dlog.h>
 
@@ -31,6 +33,30 @@
 
 int errno;
 
+/*!
+ * \note
+ * Size classes of data buffers (head + payload), 256 bytes to 16 KBytes.
+ * Most of packets are fit in the first or second class.
+ * Buffers which are larger than the last class are allocated from the heap directly.
+ */
+#define PACKET_POOL_CLASS_COUNT	7
+#define PACKET_POOL_MIN_SHIFT	8
+#define PACKET_POOL_CACHE_MAX	64 /*!< Maximum count of cached buffers of each class, per thread */
+#define PACKET_POOL_CLASS_SIZE(idx)	(1 << (PACKET_POOL_MIN_SHIFT + (idx)))
+
+/*!
+ * \note
+ * Strings which are longer than this are referenced by packet_create_noack_ref()
+ */
+#define PACKET_REF_MIN_SIZE	512
+#define PACKET_MAX_SEGMENT	((PACKET_MAX_IOV - 1) / 2)
+
+/*!
+ * \note
+ * Formats which have more fields than this are not cached, packet_get() scans them every time.
+ */
+#define PACKET_VIEW_MAX_FIELD	32
+
 struct data {
 	struct {
 		int version;
@@ -56,9 +82,390 @@ struct packet {
 	void (*close_fd_cb)(int fd, void *data);
 	void *close_fd_cbdata;
 	int fd;
+	int capacity; /*!< Allocated size of data */
+	struct pool_cache *pool; /*!< Cache which the packet object is returned to */
+	struct pool_cache *data_pool; /*!< Cache which the data buffer is returned to */
+	int inline_size; /*!< Size of bytes in the data buffer, except referenced strings */
+	struct {
+		int offset; /*!< Offset in the data buffer, where this is placed */
+		int size;
+		const char *ptr;
+	} segment[PACKET_MAX_SEGMENT];
+	int segment_count;
+
+	/*!
+	 * \brief
+	 * Offsets of fields which are parsed by the last packet_view() call.
+	 */
+	struct {
+		int count; /*!< Count of valid fields, -1 if there is no view */
+		char fmt[PACKET_VIEW_MAX_FIELD + 1];
+		int offset[PACKET_VIEW_MAX_FIELD];
+	} view;
 	struct data *data;
 };
 
+struct pool_node {
+	struct pool_node *next;
+};
+
+/*!
+ * \brief
+ * Per-thread cache of released buffers.
+ * Only the owner thread pops buffers from its lists,
+ * Other threads return buffers of the owner via the remote lists, those are drained by the owner when its list is empty.
+ */
+struct pool_cache {
+	struct pool_cache *next; /*!< Link of the orphan list */
+
+	struct pool_node *data[PACKET_POOL_CLASS_COUNT];
+	int data_count[PACKET_POOL_CLASS_COUNT];
+	struct pool_node *packet;
+	int packet_count;
+
+	struct pool_node *remote_data[PACKET_POOL_CLASS_COUNT];
+	struct pool_node *remote_packet;
+};
+
+static struct info {
+	pthread_once_t once;
+	pthread_key_t key;
+	int key_created;
+	pthread_mutex_t orphan_lock;
+	struct pool_cache *orphan; /*!< Caches of terminated threads, other threads can still return buffers to them */
+	struct packet_pool_stat stat;
+} s_info = {
+	.once = PTHREAD_ONCE_INIT,
+	.key_created = 0,
+	.orphan_lock = PTHREAD_MUTEX_INITIALIZER,
+	.orphan = NULL,
+	.stat = {
+		.alloc = 0lu,
+		.hit = 0lu,
+		.heap = 0lu,
+		.grow = 0lu,
+		.recycle = 0lu,
+		.release = 0lu,
+	},
+};
+
+#define POOL_STAT_INC(field)	__atomic_add_fetch(&s_info.stat.field, 1lu, __ATOMIC_RELAXED)
+
+static inline void pool_list_free(struct pool_node *node)
+{
+	struct pool_node *next;
+
+	while (node) {
+		next = node->next;
+		free(node);
+		node = next;
+	}
+}
+
+/*!
+ * \NOTE
+ * Running thread: Any thread which is not the owner of the cache
+ */
+static inline void pool_remote_push(struct pool_node **head, struct pool_node *node)
+{
+	node->next = __atomic_load_n(head, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(head, &node->next, node, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/*!
+ * \NOTE
+ * Running thread: Owner of the cache
+ */
+static inline struct pool_node *pool_remote_take(struct pool_node **head, struct pool_node **list, int *count)
+{
+	struct pool_node *node;
+	struct pool_node *next;
+
+	node = __atomic_exchange_n(head, NULL, __ATOMIC_ACQUIRE);
+	while (node) {
+		next = node->next;
+		if (*count < PACKET_POOL_CACHE_MAX) {
+			node->next = *list;
+			*list = node;
+			(*count)++;
+		} else {
+			free(node);
+			POOL_STAT_INC(release);
+		}
+		node = next;
+	}
+
+	return *list;
+}
+
+/*!
+ * \note
+ * The cache is not freed, other threads can still hold buffers of it.
+ * Cached buffers are released, and the cache is adopted by the next new thread.
+ */
+static void pool_cache_destroy(void *data)
+{
+	struct pool_cache *cache = data;
+	int i;
+
+	for (i = 0; i < PACKET_POOL_CLASS_COUNT; i++) {
+		pool_list_free(cache->data[i]);
+		cache->data[i] = NULL;
+		cache->data_count[i] = 0;
+	}
+
+	pool_list_free(cache->packet);
+	cache->packet = NULL;
+	cache->packet_count = 0;
+
+	CRITICAL_SECTION_BEGIN(&s_info.orphan_lock);
+	cache->next = s_info.orphan;
+	s_info.orphan = cache;
+	CRITICAL_SECTION_END(&s_info.orphan_lock);
+}
+
+static void pool_init(void)
+{
+	int ret;
+
+	ret = pthread_key_create(&s_info.key, pool_cache_destroy);
+	if (ret != 0) {
+		ErrPrint("Unable to create a key: %s\n", strerror(ret));
+		return;
+	}
+
+	s_info.key_created = 1;
+}
+
+static struct pool_cache *pool_cache(void)
+{
+	struct pool_cache *cache;
+	int ret;
+
+	pthread_once(&s_info.once, pool_init);
+	if (!s_info.key_created) {
+		return NULL;
+	}
+
+	cache = pthread_getspecific(s_info.key);
+	if (cache) {
+		return cache;
+	}
+
+	CRITICAL_SECTION_BEGIN(&s_info.orphan_lock);
+	cache = s_info.orphan;
+	if (cache) {
+		s_info.orphan = cache->next;
+	}
+	CRITICAL_SECTION_END(&s_info.orphan_lock);
+
+	if (!cache) {
+		cache = calloc(1, sizeof(*cache));
+		if (!cache) {
+			ErrPrint("Heap: %s\n", strerror(errno));
+			return NULL;
+		}
+	}
+
+	ret = pthread_setspecific(s_info.key, cache);
+	if (ret != 0) {
+		ErrPrint("Unable to set a cache: %s\n", strerror(ret));
+		CRITICAL_SECTION_BEGIN(&s_info.orphan_lock);
+		cache->next = s_info.orphan;
+		s_info.orphan = cache;
+		CRITICAL_SECTION_END(&s_info.orphan_lock);
+		return NULL;
+	}
+
+	return cache;
+}
+
+static int pool_class(int size)
+{
+	int idx;
+
+	for (idx = 0; idx < PACKET_POOL_CLASS_COUNT; idx++) {
+		if (size <= PACKET_POOL_CLASS_SIZE(idx)) {
+			return idx;
+		}
+	}
+
+	return -1;
+}
+
+/*!
+ * \brief
+ * owner is the cache which the buffer should be returned to, NULL if it is not pooled.
+ */
+static struct data *pool_data_alloc(int size, int *capacity, struct pool_cache **owner)
+{
+	struct pool_cache *cache;
+	struct pool_node *node;
+	int idx;
+
+	POOL_STAT_INC(alloc);
+
+	*owner = NULL;
+
+	idx = pool_class(size);
+	if (idx < 0) {
+		*capacity = size;
+	} else {
+		*capacity = PACKET_POOL_CLASS_SIZE(idx);
+
+		cache = pool_cache();
+		*owner = cache;
+		if (cache && (cache->data[idx] || pool_remote_take(&cache->remote_data[idx], &cache->data[idx], &cache->data_count[idx]))) {
+			node = cache->data[idx];
+			cache->data[idx] = node->next;
+			cache->data_count[idx]--;
+			POOL_STAT_INC(hit);
+			return (struct data *)node;
+		}
+	}
+
+	node = malloc(*capacity);
+	if (!node) {
+		ErrPrint("Heap: %s\n", strerror(errno));
+		return NULL;
+	}
+
+	POOL_STAT_INC(heap);
+	return (struct data *)node;
+}
+
+static void pool_data_free(struct data *data, int capacity, struct pool_cache *owner)
+{
+	struct pool_cache *cache;
+	struct pool_node *node;
+	int idx;
+
+	if (!data) {
+		return;
+	}
+
+	idx = pool_class(capacity);
+	if (owner && idx >= 0 && PACKET_POOL_CLASS_SIZE(idx) == capacity) {
+		node = (struct pool_node *)data;
+		cache = pool_cache();
+		if (cache != owner) {
+			pool_remote_push(&owner->remote_data[idx], node);
+			POOL_STAT_INC(recycle);
+			return;
+		}
+
+		if (cache->data_count[idx] < PACKET_POOL_CACHE_MAX) {
+			node->next = cache->data[idx];
+			cache->data[idx] = node;
+			cache->data_count[idx]++;
+			POOL_STAT_INC(recycle);
+			return;
+		}
+	}
+
+	free(data);
+	POOL_STAT_INC(release);
+}
+
+static struct packet *pool_packet_alloc(void)
+{
+	struct pool_cache *cache;
+	struct pool_node *node;
+
+	POOL_STAT_INC(alloc);
+
+	cache = pool_cache();
+	if (cache && (cache->packet || pool_remote_take(&cache->remote_packet, &cache->packet, &cache->packet_count))) {
+		node = cache->packet;
+		cache->packet = node->next;
+		cache->packet_count--;
+		POOL_STAT_INC(hit);
+	} else {
+		node = malloc(sizeof(struct packet));
+		if (!node) {
+			ErrPrint("Heap: %s\n", strerror(errno));
+			return NULL;
+		}
+
+		POOL_STAT_INC(heap);
+	}
+
+	((struct packet *)node)->pool = cache;
+	return (struct packet *)node;
+}
+
+static void pool_packet_free(struct packet *packet)
+{
+	struct pool_cache *owner = packet->pool;
+	struct pool_cache *cache;
+	struct pool_node *node;
+
+	if (owner) {
+		node = (struct pool_node *)packet;
+		cache = pool_cache();
+		if (cache != owner) {
+			pool_remote_push(&owner->remote_packet, node);
+			POOL_STAT_INC(recycle);
+			return;
+		}
+
+		if (cache->packet_count < PACKET_POOL_CACHE_MAX) {
+			node->next = cache->packet;
+			cache->packet = node;
+			cache->packet_count++;
+			POOL_STAT_INC(recycle);
+			return;
+		}
+	}
+
+	free(packet);
+	POOL_STAT_INC(release);
+}
+
+/*!
+ * \brief
+ * Allocate a packet which has a data buffer of the given size (at least the head).
+ * The head is cleared, the payload is not.
+ */
+static struct packet *packet_alloc(int size)
+{
+	struct packet *packet;
+
+	packet = pool_packet_alloc();
+	if (!packet) {
+		return NULL;
+	}
+
+	if (size < sizeof(*packet->data)) {
+		size = sizeof(*packet->data);
+	}
+
+	packet->data = pool_data_alloc(size, &packet->capacity, &packet->data_pool);
+	if (!packet->data) {
+		pool_packet_free(packet);
+		return NULL;
+	}
+
+	memset(&packet->data->head, 0, sizeof(packet->data->head));
+	packet->inline_size = sizeof(packet->data->head);
+	packet->segment_count = 0;
+	packet->view.count = -1;
+	packet->state = VALID;
+	packet->refcnt = 0;
+	packet->fd = -1;
+	packet->close_fd_cb = NULL;
+	packet->close_fd_cbdata = NULL;
+	return packet;
+}
+
+static void packet_free(struct packet *packet)
+{
+	packet->state = INVALID;
+	pool_data_free(packet->data, packet->capacity, packet->data_pool);
+	packet->data = NULL;
+	pool_packet_free(packet);
+}
+
 EAPI const enum packet_type const packet_type(const struct packet *packet)
 {
 	if (!packet || packet->state != VALID || !packet->data) {
@@ -232,121 +639,288 @@ EAPI const void * const packet_data(const struct packet *packet)
 		return NULL;
 	}
 
+	if (packet_flatten((struct packet *)packet) < 0) {
+		return NULL;
+	}
+
 	return packet->data;
 }
 
-static inline __attribute__((always_inline)) struct data *check_and_expand_packet(struct data *packet, int *payload_size)
+EAPI int packet_iovec(const struct packet *packet, struct iovec *iov, int count)
 {
-	struct data *new_packet;
+	int i;
+	int iovcnt;
+	int offset;
 
-	if (packet->head.payload_size < *payload_size) {
-		return packet;
+	if (!packet || packet->state != VALID || !iov || count <= packet->segment_count * 2) {
+		return -EINVAL;
 	}
 
-	new_packet = realloc(packet, sizeof(*packet) + *payload_size + BUFSIZ); /*!< Expanding to +BUFSIZ */
-	if (!new_packet) {
-		ErrPrint("Heap: %s\n", strerror(errno));
-		free(packet);
-		return NULL;
+	if (!packet->segment_count) {
+		iov[0].iov_base = packet->data;
+		iov[0].iov_len = packet_size(packet);
+		return 1;
 	}
 
-	*payload_size += BUFSIZ;
-	return new_packet;
+	iovcnt = 0;
+	offset = 0;
+	for (i = 0; i < packet->segment_count; i++) {
+		if (packet->segment[i].offset > offset) {
+			iov[iovcnt].iov_base = (char *)packet->data + offset;
+			iov[iovcnt].iov_len = packet->segment[i].offset - offset;
+			iovcnt++;
+			offset = packet->segment[i].offset;
+		}
+
+		iov[iovcnt].iov_base = (char *)packet->segment[i].ptr;
+		iov[iovcnt].iov_len = packet->segment[i].size;
+		iovcnt++;
+	}
+
+	if (packet->inline_size > offset) {
+		iov[iovcnt].iov_base = (char *)packet->data + offset;
+		iov[iovcnt].iov_len = packet->inline_size - offset;
+		iovcnt++;
+	}
+
+	return iovcnt;
 }
 
-static inline struct packet *packet_body_filler(struct packet *packet, int payload_size, const char *ptr, va_list va)
+EAPI int packet_flatten(struct packet *packet)
+{
+	struct iovec iov[PACKET_MAX_IOV];
+	struct pool_cache *pool;
+	struct data *data;
+	int capacity;
+	int iovcnt;
+	int offset;
+	int i;
+
+	if (!packet || packet->state != VALID) {
+		return -EINVAL;
+	}
+
+	if (!packet->segment_count) {
+		return 0;
+	}
+
+	data = pool_data_alloc(packet_size(packet), &capacity, &pool);
+	if (!data) {
+		return -ENOMEM;
+	}
+
+	iovcnt = packet_iovec(packet, iov, PACKET_MAX_IOV);
+	offset = 0;
+	for (i = 0; i < iovcnt; i++) {
+		memcpy((char *)data + offset, iov[i].iov_base, iov[i].iov_len);
+		offset += iov[i].iov_len;
+	}
+
+	pool_data_free(packet->data, packet->capacity, packet->data_pool);
+	packet->data = data;
+	packet->capacity = capacity;
+	packet->data_pool = pool;
+	packet->inline_size = offset;
+	packet->segment_count = 0;
+	return 0;
+}
+
+/*!
+ * \brief
+ * Make sure that the data buffer can hold "size" more bytes after the first "used" bytes.
+ * If it has to be expanded, only the "used" bytes are preserved.
+ */
+static int packet_reserve(struct packet *packet, int used, int size)
+{
+	struct pool_cache *pool;
+	struct data *data;
+	int capacity;
+
+	if (used + size <= packet->capacity) {
+		return 0;
+	}
+
+	data = pool_data_alloc(used + size, &capacity, &pool);
+	if (!data) {
+		return -ENOMEM;
+	}
+
+	memcpy(data, packet->data, used);
+	pool_data_free(packet->data, packet->capacity, packet->data_pool);
+	packet->data = data;
+	packet->capacity = capacity;
+	packet->data_pool = pool;
+	POOL_STAT_INC(grow);
+	return 0;
+}
+
+static inline int packet_align(int offset, int size)
 {
-	char *payload;
-	char *str;
 	int align;
 
-	while (*ptr) {
-		payload = packet->data->payload + packet->data->head.payload_size;
+	align = (sizeof(struct data) + offset) & (size - 1);
+	if (align) {
+		align = size - align;
+	}
+
+	return align;
+}
+
+/*!
+ * \brief
+ * Strings which are referenced instead of copying, if the packet is built by reference.
+ */
+static inline int packet_str_by_ref(int by_ref, int segment_count, int len)
+{
+	return by_ref && len >= PACKET_REF_MIN_SIZE && segment_count < PACKET_MAX_SEGMENT;
+}
+
+/*!
+ * \brief
+ * The first pass of building a packet.
+ * Compute the exact size of the payload and the size of bytes which are copied into the packet.
+ */
+static int packet_body_size(const char *ptr, va_list va, int by_ref, int *inline_size)
+{
+	const char *str;
+	int segment_count;
+	int offset;
+	int size;
+
+	segment_count = 0;
+	offset = 0;
+	*inline_size = 0;
 
+	while (*ptr) {
 		switch (*ptr) {
 		case 'i':
 		case 'I':
-			align = (unsigned long)payload & (sizeof(int) - 1);
-			if (align) {
-				align = sizeof(int) - align;
+			size = sizeof(int) + packet_align(offset, sizeof(int));
+			(void)va_arg(va, int);
+			break;
+		case 's':
+		case 'S':
+			str = (const char *)va_arg(va, const char *);
+			size = str ? strlen(str) + 1 : 1; /*!< Including NIL */
+			if (packet_str_by_ref(by_ref, segment_count, size)) {
+				segment_count++;
+				offset += size;
+				ptr++;
+				continue;
 			}
+			break;
+		case 'd':
+		case 'D':
+			size = sizeof(double) + packet_align(offset, sizeof(double));
+			(void)va_arg(va, double);
+			break;
+		default:
+			ErrPrint("Invalid type [%c]\n", *ptr);
+			return -EINVAL;
+		}
 
-			packet->data->head.payload_size += sizeof(int) + align;
-			packet->data = check_and_expand_packet(packet->data, &payload_size);
-			if (!packet->data) {
-				packet->state = INVALID;
-				free(packet);
-				packet = NULL;
-				goto out;
-			}
+		offset += size;
+		*inline_size += size;
+		ptr++;
+	}
+
+	return offset;
+}
+
+/*!
+ * \brief
+ * The second pass of building a packet.
+ * The data buffer is already allocated with the exact size, so it never be expanded.
+ */
+static void packet_body_filler(struct packet *packet, const char *ptr, va_list va, int by_ref)
+{
+	char *payload;
+	const char *str;
+	int align;
+	int offset;
+	int size;
+	int ival;
+	double dval;
 
-			*((int *)(payload + align)) = (int)va_arg(va, int);
+	offset = 0;
+	payload = packet->data->payload;
+
+	while (*ptr) {
+		switch (*ptr) {
+		case 'i':
+		case 'I':
+			align = packet_align(offset, sizeof(int));
+			ival = (int)va_arg(va, int);
+			memset(payload, 0, align);
+			memcpy(payload + align, &ival, sizeof(ival));
+			size = sizeof(int) + align;
 			break;
 		case 's':
 		case 'S':
-			str = (char *)va_arg(va, char *);
+			str = (const char *)va_arg(va, const char *);
+			size = str ? strlen(str) + 1 : 1; /*!< Including NIL */
+			if (packet_str_by_ref(by_ref, packet->segment_count, size)) {
+				packet->segment[packet->segment_count].offset = payload - (char *)packet->data;
+				packet->segment[packet->segment_count].ptr = str;
+				packet->segment[packet->segment_count].size = size;
+				packet->segment_count++;
+				offset += size;
+				ptr++;
+				continue;
+			}
 
 			if (str) {
-				packet->data->head.payload_size += strlen(str) + 1; /*!< Including NIL */
-				packet->data = check_and_expand_packet(packet->data, &payload_size);
-				if (!packet->data) {
-					packet->state = INVALID;
-					free(packet);
-					packet = NULL;
-					goto out;
-				}
-
-				strcpy(payload, str); /*!< Including NIL */
+				memcpy(payload, str, size); /*!< Including NIL */
 			} else {
-				packet->data->head.payload_size += 1;
-				packet->data = check_and_expand_packet(packet->data, &payload_size);
-				if (!packet->data) {
-					packet->state = INVALID;
-					free(packet);
-					packet = NULL;
-					goto out;
-				}
-
 				payload[0] = '\0';
 			}
 			break;
 		case 'd':
 		case 'D':
-			align = (unsigned long)payload & (sizeof(double) - 1);
-			if (align) {
-				align = sizeof(double) - align;
-			}
-
-			packet->data->head.payload_size += sizeof(double) + align;
-			packet->data = check_and_expand_packet(packet->data, &payload_size);
-			if (!packet->data) {
-				packet->state = INVALID;
-				free(packet);
-				packet = NULL;
-				goto out;
-			}
-
-			*((double *)(payload + align)) = (double)va_arg(va, double);
+		default: /*!< Format is already verified by packet_body_size */
+			align = packet_align(offset, sizeof(double));
+			dval = (double)va_arg(va, double);
+			memset(payload, 0, align);
+			memcpy(payload + align, &dval, sizeof(dval));
+			size = sizeof(double) + align;
 			break;
-		default:
-			ErrPrint("Invalid type [%c]\n", *ptr);
-			packet->state = INVALID;
-			free(packet->data);
-			free(packet);
-			packet = NULL;
-			goto out;
 		}
 
+		offset += size;
+		payload += size;
 		ptr++;
 	}
 
-out:
+	packet->inline_size = payload - (char *)packet->data;
+	packet->data->head.payload_size = offset;
+}
+
+static struct packet *packet_body_create(const char *fmt, va_list va, int by_ref)
+{
+	struct packet *packet;
+	va_list va_size;
+	int inline_size;
+	int payload_size;
+
+	va_copy(va_size, va);
+	payload_size = packet_body_size(fmt, va_size, by_ref, &inline_size);
+	va_end(va_size);
+
+	if (payload_size < 0) {
+		return NULL;
+	}
+
+	packet = packet_alloc(sizeof(*packet->data) + inline_size);
+	if (!packet) {
+		return NULL;
+	}
+
+	packet_body_filler(packet, fmt, va, by_ref);
 	return packet;
 }
 
 EAPI struct packet *packet_create_reply(const struct packet *packet, const char *fmt, ...)
 {
-	int payload_size;
 	struct packet *result;
 	va_list va;
 
@@ -354,26 +928,14 @@ EAPI struct packet *packet_create_reply(const struct packet *packet, const char
 		return NULL;
 	}
 
-	result = malloc(sizeof(*result));
-	if (!result) {
-		ErrPrint("Heap: %s\n", strerror(errno));
-		return NULL;
-	}
+	va_start(va, fmt);
+	result = packet_body_create(fmt, va, 0);
+	va_end(va);
 
-	payload_size = sizeof(*result->data) + BUFSIZ;
-	result->refcnt = 0;
-	result->fd = -1;
-	result->close_fd_cb = NULL;
-	result->close_fd_cbdata = NULL;
-	result->data = calloc(1, payload_size);
-	if (!result->data) {
-		ErrPrint("Heap: %s\n", strerror(errno));
-		result->state = INVALID;
-		free(result);
+	if (!result) {
 		return NULL;
 	}
 
-	result->state = VALID;
 	result->data->head.source = packet->data->head.destination;
 	result->data->head.destination = packet->data->head.source;
 	result->data->head.mask = 0xFFFFFFFF;
@@ -388,12 +950,6 @@ EAPI struct packet *packet_create_reply(const struct packet *packet, const char
 	} else {
 		strcpy(result->data->head.command, packet->data->head.command); /* we don't need to use strncmp */
 	}
-	result->data->head.payload_size = 0;
-	payload_size -= sizeof(*result->data);
-
-	va_start(va, fmt);
-	result = packet_body_filler(result, payload_size, fmt, va);
-	va_end(va);
 
 	return packet_ref(result);
 }
@@ -416,7 +972,6 @@ EAPI int packet_swap_address(struct packet *packet)
 EAPI struct packet *packet_create(const char *cmd, const char *fmt, ...)
 {
 	struct packet *packet;
-	int payload_size;
 	va_list va;
 
 	if (strlen(cmd) >= PACKET_MAX_CMD) {
@@ -424,26 +979,14 @@ EAPI struct packet *packet_create(const char *cmd, const char *fmt, ...)
 		return NULL;
 	}
 
-	packet = malloc(sizeof(*packet));
-	if (!packet) {
-		ErrPrint("Heap: %s\n", strerror(errno));
-		return NULL;
-	}
+	va_start(va, fmt);
+	packet = packet_body_create(fmt, va, 0);
+	va_end(va);
 
-	payload_size = sizeof(*packet->data) + BUFSIZ;
-	packet->refcnt = 0;
-	packet->fd = -1;
-	packet->close_fd_cb = NULL;
-	packet->close_fd_cbdata = NULL;
-	packet->data = calloc(1, payload_size);
-	if (!packet->data) {
-		ErrPrint("Heap: %s\n", strerror(errno));
-		packet->state = INVALID;
-		free(packet);
+	if (!packet) {
 		return NULL;
 	}
 
-	packet->state = VALID;
 	packet->data->head.source = 0lu;
 	packet->data->head.destination = 0lu;
 	packet->data->head.mask = 0xFFFFFFFF;
@@ -458,47 +1001,24 @@ EAPI struct packet *packet_create(const char *cmd, const char *fmt, ...)
 	} else {
 		strncpy(packet->data->head.command, cmd, sizeof(packet->data->head.command));
 	}
-	packet->data->head.payload_size = 0;
-	payload_size -= sizeof(*packet->data); /*!< Usable payload size (except head size) */
-
-	va_start(va, fmt);
-	packet = packet_body_filler(packet, payload_size, fmt, va);
-	va_end(va);
 
 	return packet_ref(packet);
 }
 
-EAPI struct packet *packet_create_noack(const char *cmd, const char *fmt, ...)
+static struct packet *packet_create_noack_va(const char *cmd, const char *fmt, va_list va, int by_ref)
 {
-	int payload_size;
 	struct packet *result;
-	va_list va;
 
 	if (strlen(cmd) >= PACKET_MAX_CMD) {
 		ErrPrint("Command is too long\n");
 		return NULL;
 	}
 
-	result = malloc(sizeof(*result));
+	result = packet_body_create(fmt, va, by_ref);
 	if (!result) {
-		ErrPrint("Heap: %s\n", strerror(errno));
 		return NULL;
 	}
 
-	payload_size = sizeof(*result->data) + BUFSIZ;
-	result->refcnt = 0;
-	result->fd = -1;
-	result->close_fd_cb = NULL;
-	result->close_fd_cbdata = NULL;
-	result->data = calloc(1, payload_size);
-	if (!result->data) {
-		ErrPrint("Heap: %s\n", strerror(errno));
-		result->state = INVALID;
-		free(result);
-		return NULL;
-	}
-
-	result->state = VALID;
 	result->data->head.source = 0lu;
 	result->data->head.destination = 0lu;
 	result->data->head.mask = 0xFFFFFFFF;
@@ -512,20 +1032,37 @@ EAPI struct packet *packet_create_noack(const char *cmd, const char *fmt, ...)
 	} else {
 		strncpy(result->data->head.command, cmd, sizeof(result->data->head.command));
 	}
-	result->data->head.payload_size = 0;
-	payload_size -= sizeof(*result->data);
+
+	return packet_ref(result);
+}
+
+EAPI struct packet *packet_create_noack(const char *cmd, const char *fmt, ...)
+{
+	struct packet *result;
+	va_list va;
 
 	va_start(va, fmt);
-	result = packet_body_filler(result, payload_size, fmt, va);
+	result = packet_create_noack_va(cmd, fmt, va, 0);
 	va_end(va);
 
-	return packet_ref(result);
+	return result;
 }
 
-EAPI int packet_get(const struct packet *packet, const char *fmt, ...)
+EAPI struct packet *packet_create_noack_ref(const char *cmd, const char *fmt, ...)
 {
-	const char *ptr;
+	struct packet *result;
 	va_list va;
+
+	va_start(va, fmt);
+	result = packet_create_noack_va(cmd, fmt, va, 1);
+	va_end(va);
+
+	return result;
+}
+
+static int packet_get_scan(const struct packet *packet, const char *fmt, va_list va)
+{
+	const char *ptr;
 	int ret = 0;
 	char *payload;
 	int offset = 0;
@@ -534,12 +1071,6 @@ EAPI int packet_get(const struct packet *packet, const char *fmt, ...)
 	char **str_ptr;
 	int align;
 
-	if (!packet || packet->state != VALID) {
-		return -EINVAL;
-	}
-
-	va_start(va, fmt);
-
 	ptr = fmt;
 	while (*ptr && offset < packet->data->head.payload_size) {
 		payload = packet->data->payload + offset;
@@ -582,16 +1113,182 @@ EAPI int packet_get(const struct packet *packet, const char *fmt, ...)
 	}
 
 out:
-	va_end(va);
 	return ret;
 }
 
+EAPI int packet_view(const struct packet *packet, const char *fmt)
+{
+	struct packet *view_packet = (struct packet *)packet;
+	const char *payload;
+	const char *ptr;
+	int offset;
+	int size;
+	int count;
+
+	if (!packet || packet->state != VALID || !fmt) {
+		return -EINVAL;
+	}
+
+	if (packet->view.count >= 0 && !strcmp(packet->view.fmt, fmt)) {
+		return packet->view.count;
+	}
+
+	if (packet_flatten(view_packet) < 0) {
+		return -ENOMEM;
+	}
+
+	if (strlen(fmt) > PACKET_VIEW_MAX_FIELD) {
+		return -E2BIG;
+	}
+
+	payload = packet->data->payload;
+	offset = 0;
+	count = 0;
+
+	for (ptr = fmt; *ptr && offset < packet->data->head.payload_size; ptr++) {
+		switch (*ptr) {
+		case 'i':
+		case 'I':
+			offset += packet_align(offset, sizeof(int));
+			size = sizeof(int);
+			break;
+		case 'd':
+		case 'D':
+			offset += packet_align(offset, sizeof(double));
+			size = sizeof(double);
+			break;
+		case 's':
+		case 'S':
+			if (!memchr(payload + offset, '\0', packet->data->head.payload_size - offset)) {
+				ErrPrint("String is not terminated [%s:%d]\n", fmt, count);
+				size = packet->data->head.payload_size - offset + 1;
+				break;
+			}
+
+			size = strlen(payload + offset) + 1; /*!< Including NIL */
+			break;
+		default:
+			ErrPrint("Invalid type [%c]\n", *ptr);
+			return -EINVAL;
+		}
+
+		if (offset + size > packet->data->head.payload_size) {
+			ErrPrint("Field is out of the payload [%s:%d]\n", fmt, count);
+			break;
+		}
+
+		view_packet->view.offset[count] = offset;
+		offset += size;
+		count++;
+	}
+
+	strcpy(view_packet->view.fmt, fmt);
+	view_packet->view.count = count;
+	return count;
+}
+
+static inline const char *packet_view_field(const struct packet *packet, int idx, char type)
+{
+	if (!packet || packet->state != VALID || packet->view.count < 0) {
+		return NULL;
+	}
+
+	if (idx < 0 || idx >= packet->view.count || (packet->view.fmt[idx] | 0x20) != type) {
+		ErrPrint("Invalid field [%s:%d] (%c)\n", packet->view.fmt, idx, type);
+		return NULL;
+	}
+
+	return packet->data->payload + packet->view.offset[idx];
+}
+
+EAPI const char *packet_view_str(const struct packet *packet, int idx)
+{
+	return packet_view_field(packet, idx, 's');
+}
+
+EAPI int packet_view_int(const struct packet *packet, int idx)
+{
+	const char *field;
+	int value;
+
+	field = packet_view_field(packet, idx, 'i');
+	if (!field) {
+		return 0;
+	}
+
+	memcpy(&value, field, sizeof(value));
+	return value;
+}
+
+EAPI double packet_view_double(const struct packet *packet, int idx)
+{
+	const char *field;
+	double value;
+
+	field = packet_view_field(packet, idx, 'd');
+	if (!field) {
+		return 0.0f;
+	}
+
+	memcpy(&value, field, sizeof(value));
+	return value;
+}
+
+EAPI int packet_get(const struct packet *packet, const char *fmt, ...)
+{
+	va_list va;
+	int count;
+	int i;
+
+	count = packet_view(packet, fmt);
+	if (count == -E2BIG) {
+		va_start(va, fmt);
+		count = packet_get_scan(packet, fmt, va);
+		va_end(va);
+		return count;
+	} else if (count < 0) {
+		return count;
+	}
+
+	va_start(va, fmt);
+	for (i = 0; i < count; i++) {
+		switch (fmt[i]) {
+		case 'i':
+		case 'I':
+			*((int *)va_arg(va, int *)) = packet_view_int(packet, i);
+			break;
+		case 'd':
+		case 'D':
+			*((double *)va_arg(va, double *)) = packet_view_double(packet, i);
+			break;
+		case 's':
+		case 'S':
+		default:
+			*((const char **)va_arg(va, const char **)) = packet_view_str(packet, i);
+			break;
+		}
+	}
+	va_end(va);
+
+	return count;
+}
+
 EAPI struct packet *packet_ref(struct packet *packet)
 {
 	if (!packet || packet->state != VALID) {
 		return NULL;
 	}
 
+	/*!
+	 * \note
+	 * Another owner can keep the packet after the creator returns, such as a queued, batched or parked packet,
+	 * so the referenced strings are copied before they are gone.
+	 */
+	if (packet->refcnt > 0 && packet_flatten(packet) < 0) {
+		ErrPrint("Failed to copy referenced strings\n");
+		return NULL;
+	}
+
 	packet->refcnt++;
 	return packet;
 }
@@ -613,9 +1310,7 @@ EAPI struct packet *packet_unref(struct packet *packet)
 			packet->close_fd_cb(packet->fd, packet->close_fd_cbdata);
 		}
 
-		packet->state = INVALID;
-		free(packet->data);
-		free(packet);
+		packet_free(packet);
 		return NULL;
 	}
 
@@ -630,51 +1325,57 @@ EAPI int packet_destroy(struct packet *packet)
 
 EAPI struct packet *packet_build(struct packet *packet, int offset, void *data, int size)
 {
-	char *ptr;
-
 	if (packet == NULL) {
 		if (offset) {
 			ErrPrint("Invalid argument\n");
 			return NULL;
 		}
 
-		packet = malloc(sizeof(*packet));
+		packet = packet_alloc(size);
 		if (!packet) {
-			ErrPrint("Heap: %s\n", strerror(errno));
 			return NULL;
 		}
 
 		packet->refcnt = 1;
-		packet->fd = -1;
-		packet->close_fd_cb = NULL;
-		packet->close_fd_cbdata = NULL;
-		packet->data = calloc(1, size);
-		if (!packet->data) {
-			ErrPrint("Heap: %s\n", strerror(errno));
-			packet->state = INVALID;
-			free(packet);
-			return NULL;
-		}
-
-		packet->state = VALID;
 		memcpy(packet->data, data, size);
 		packet->data->head.mask = 0xFFFFFFFF;
 		return packet;
 	}
 
-	ptr = realloc(packet->data, offset + size);
-	if (!ptr) {
-		ErrPrint("Heap: %s\n", strerror(errno));
-		packet->state = INVALID;
-		free(packet->data);
-		free(packet);
+	if (packet_reserve(packet, offset, size) < 0) {
+		packet_free(packet);
 		return NULL;
 	}
 
-	packet->data = (struct data *)ptr;
-	memcpy(ptr + offset, data, size);
+	memcpy((char *)packet->data + offset, data, size);
+	packet->view.count = -1;
 
 	return packet;
 }
 
+EAPI int packet_pool_get_stat(struct packet_pool_stat *stat)
+{
+	if (!stat) {
+		return -EINVAL;
+	}
+
+	stat->alloc = __atomic_load_n(&s_info.stat.alloc, __ATOMIC_RELAXED);
+	stat->hit = __atomic_load_n(&s_info.stat.hit, __ATOMIC_RELAXED);
+	stat->heap = __atomic_load_n(&s_info.stat.heap, __ATOMIC_RELAXED);
+	stat->grow = __atomic_load_n(&s_info.stat.grow, __ATOMIC_RELAXED);
+	stat->recycle = __atomic_load_n(&s_info.stat.recycle, __ATOMIC_RELAXED);
+	stat->release = __atomic_load_n(&s_info.stat.release, __ATOMIC_RELAXED);
+	return 0;
+}
+
+EAPI void packet_pool_reset_stat(void)
+{
+	__atomic_store_n(&s_info.stat.alloc, 0lu, __ATOMIC_RELAXED);
+	__atomic_store_n(&s_info.stat.hit, 0lu, __ATOMIC_RELAXED);
+	__atomic_store_n(&s_info.stat.heap, 0lu, __ATOMIC_RELAXED);
+	__atomic_store_n(&s_info.stat.grow, 0lu, __ATOMIC_RELAXED);
+	__atomic_store_n(&s_info.stat.recycle, 0lu, __ATOMIC_RELAXED);
+	__atomic_store_n(&s_info.stat.release, 0lu, __ATOMIC_RELAXED);
+}
+
 /* End of a file */
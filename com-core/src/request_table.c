@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2000 - 2013 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <glib.h>
+#include <dlog.h>
+
+#include "debug.h"
+#include "dlist.h"
+#include "request_table.h"
+
+/*!
+ * \brief
+ * handle -> (sequence -> node)
+ * Finding a request is two hash lookups,
+ * and clearing the requests of a handle touches only its own requests.
+ */
+struct request_table {
+	GHashTable *handle_table;
+};
+
+static inline unsigned long long seq_key(double seq)
+{
+	unsigned long long key;
+
+	memcpy(&key, &seq, sizeof(key));
+	return key;
+}
+
+static void seq_table_destroy(gpointer data)
+{
+	g_hash_table_destroy(data);
+}
+
+HAPI struct request_table *request_table_create(void)
+{
+	struct request_table *table;
+
+	table = malloc(sizeof(*table));
+	if (!table) {
+		ErrPrint("Heap: %s\n", strerror(errno));
+		return NULL;
+	}
+
+	table->handle_table = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, seq_table_destroy);
+	if (!table->handle_table) {
+		ErrPrint("Failed to create a hash table\n");
+		free(table);
+		return NULL;
+	}
+
+	return table;
+}
+
+HAPI void request_table_destroy(struct request_table *table)
+{
+	g_hash_table_destroy(table->handle_table);
+	free(table);
+}
+
+HAPI int request_table_add(struct request_table *table, struct request_node *node, int handle, double seq)
+{
+	GHashTable *seq_table;
+	struct request_node *head;
+
+	node->handle = handle;
+	node->seq = seq_key(seq);
+	node->next = NULL;
+
+	seq_table = g_hash_table_lookup(table->handle_table, GINT_TO_POINTER(handle));
+	if (!seq_table) {
+		seq_table = g_hash_table_new(g_int64_hash, g_int64_equal);
+		if (!seq_table) {
+			ErrPrint("Failed to create a hash table\n");
+			return -ENOMEM;
+		}
+
+		g_hash_table_insert(table->handle_table, GINT_TO_POINTER(handle), seq_table);
+	}
+
+	head = g_hash_table_lookup(seq_table, &node->seq);
+	if (!head) {
+		g_hash_table_insert(seq_table, &node->seq, node);
+		return 0;
+	}
+
+	/*!
+	 * \note
+	 * Keep the order of requests, the older one will get the ACK first.
+	 */
+	while (head->next) {
+		head = head->next;
+	}
+
+	head->next = node;
+	return 0;
+}
+
+HAPI void request_table_del(struct request_table *table, struct request_node *node)
+{
+	GHashTable *seq_table;
+	struct request_node *head;
+
+	seq_table = g_hash_table_lookup(table->handle_table, GINT_TO_POINTER(node->handle));
+	if (!seq_table) {
+		return;
+	}
+
+	head = g_hash_table_lookup(seq_table, &node->seq);
+	if (!head) {
+		return;
+	}
+
+	if (head == node) {
+		if (node->next) {
+			/*!
+			 * \note
+			 * The key is stored in the node, so it should be replaced with the key of the next one.
+			 */
+			g_hash_table_replace(seq_table, &node->next->seq, node->next);
+		} else {
+			g_hash_table_remove(seq_table, &node->seq);
+			if (g_hash_table_size(seq_table) == 0) {
+				g_hash_table_remove(table->handle_table, GINT_TO_POINTER(node->handle));
+			}
+		}
+	} else {
+		while (head->next && head->next != node) {
+			head = head->next;
+		}
+
+		if (head->next == node) {
+			head->next = node->next;
+		}
+	}
+
+	node->next = NULL;
+}
+
+HAPI struct request_node *request_table_find(struct request_table *table, int handle, double seq)
+{
+	GHashTable *seq_table;
+	unsigned long long key;
+
+	seq_table = g_hash_table_lookup(table->handle_table, GINT_TO_POINTER(handle));
+	if (!seq_table) {
+		return NULL;
+	}
+
+	key = seq_key(seq);
+	return g_hash_table_lookup(seq_table, &key);
+}
+
+HAPI struct dlist *request_table_list(struct request_table *table, int handle)
+{
+	GHashTable *seq_table;
+	GHashTableIter iter;
+	gpointer value;
+	struct request_node *node;
+	struct dlist *list = NULL;
+
+	seq_table = g_hash_table_lookup(table->handle_table, GINT_TO_POINTER(handle));
+	if (!seq_table) {
+		return NULL;
+	}
+
+	g_hash_table_iter_init(&iter, seq_table);
+	while (g_hash_table_iter_next(&iter, NULL, &value)) {
+		for (node = value; node; node = node->next) {
+			list = dlist_append(list, node);
+		}
+	}
+
+	return list;
+}
+
+/* End of a file */
@@ -22,6 +22,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netdb.h>
 #include <arpa/inet.h>
 #include <sys/un.h>
@@ -466,28 +467,25 @@ EAPI int secure_socket_get_connection_handle(int server_handle)
 	return handle;
 }
 
-EAPI int secure_socket_send_with_fd(int handle, const char *buffer, int size, int fd)
+EAPI int secure_socket_sendv_with_fd(int handle, const struct iovec *iov, int iovcnt, int fd)
 {
 	struct msghdr msg;
-	struct iovec iov;
 	union {
 		struct cmsghdr hdr;
 		char control[CMSG_SPACE(sizeof(int))];
 	} cmsgu;
 	int ret;
 
-	if (!buffer || size <= 0) {
+	if (!iov || iovcnt <= 0) {
 		ErrPrint("Reject: 0 byte data sending\n");
 		return -EINVAL;
 	}
 
 	memset(&msg, 0, sizeof(msg));
-	iov.iov_base = (char *)buffer;
-	iov.iov_len = size;
 	msg.msg_name = NULL;
 	msg.msg_namelen = 0;
-	msg.msg_iov = &iov;
-	msg.msg_iovlen = 1;
+	msg.msg_iov = (struct iovec *)iov;
+	msg.msg_iovlen = iovcnt;
 
 	if (fd >= 0) {
 		struct cmsghdr *cmsg;
@@ -508,14 +506,28 @@ EAPI int secure_socket_send_with_fd(int handle, const char *buffer, int size, in
 	if (ret < 0) {
 		ret = -errno;
 		if (errno == EAGAIN || errno == EWOULDBLOCK) {
-			ErrPrint("handle[%d] size[%d] Try again [%s]\n", handle, size, strerror(errno));
+			ErrPrint("handle[%d] iovcnt[%d] Try again [%s]\n", handle, iovcnt, strerror(errno));
 			return -EAGAIN;
 		}
 		ErrPrint("Failed to send message [%s], handle(%d)\n", strerror(errno), handle);
 		return ret;
 	}
 
-	return iov.iov_len;
+	return ret;
+}
+
+EAPI int secure_socket_send_with_fd(int handle, const char *buffer, int size, int fd)
+{
+	struct iovec iov;
+
+	if (!buffer || size <= 0) {
+		ErrPrint("Reject: 0 byte data sending\n");
+		return -EINVAL;
+	}
+
+	iov.iov_base = (char *)buffer;
+	iov.iov_len = size;
+	return secure_socket_sendv_with_fd(handle, &iov, 1, fd);
 }
 
 EAPI int secure_socket_send(int handle, const char *buffer, int size)
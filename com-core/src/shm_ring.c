@@ -0,0 +1,500 @@
+/*
+ * Copyright (c) 2000 - 2013 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+
+#include <dlog.h>
+
+#include "debug.h"
+#include "shm_ring.h"
+
+#define SHM_RING_MAGIC	0x52494e47 /*!< "RING" */
+#define SHM_RING_ALIGN	8
+#define SHM_RING_ALIGNED(size)	(((size) + SHM_RING_ALIGN - 1) & ~(SHM_RING_ALIGN - 1))
+
+#if !defined(MFD_CLOEXEC)
+#define MFD_CLOEXEC	0x0001u
+#endif
+
+#if !defined(MFD_ALLOW_SEALING)
+#define MFD_ALLOW_SEALING	0x0002u
+#endif
+
+#if !defined(F_ADD_SEALS)
+#define F_ADD_SEALS	(1024 + 9)
+#define F_GET_SEALS	(1024 + 10)
+#define F_SEAL_SEAL	0x0001
+#define F_SEAL_SHRINK	0x0002
+#define F_SEAL_GROW	0x0004
+#endif
+
+/*!
+ * \note
+ * The size of a ring cannot be changed by anyone once it is sealed,
+ * so the mapping of the peer's memfd never gets SIGBUS.
+ */
+#define SHM_RING_SEALS	(F_SEAL_SHRINK | F_SEAL_GROW)
+
+/*!
+ * \brief
+ * Shared head of the ring, positions are increased monotonically.
+ * Producer and consumer positions are placed on different cache lines.
+ */
+struct shm_ring_head {
+	unsigned int magic;
+	unsigned int size; /*!< Size of the data area, power of 2 */
+	char pad0[56];
+	unsigned long long head; /*!< Written by the producer */
+	char pad1[56];
+	unsigned long long tail; /*!< Written by the consumer */
+	int signalled; /*!< Producer doesn't need to write the eventfd again while this is set */
+	int waiting; /*!< Producer is waiting for a room, consumer writes the space eventfd */
+	char pad2[48];
+	char data[];
+};
+
+struct shm_ring_record {
+	unsigned int type;
+	unsigned int size; /*!< Size of data, or count of packets for a barrier */
+};
+
+struct shm_ring {
+	struct shm_ring_head *head;
+	unsigned int size;
+	unsigned int map_size;
+	unsigned int peeked; /*!< Validated size of the record which is returned by the last peek */
+	int mem_fd;
+	int evt_fd;
+	int space_fd;
+};
+
+static int memfd_open(const char *name)
+{
+#if defined(SYS_memfd_create)
+	int fd;
+
+	fd = syscall(SYS_memfd_create, name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (fd < 0) {
+		return -errno;
+	}
+
+	return fd;
+#else
+	return -ENOSYS;
+#endif
+}
+
+static struct shm_ring *shm_ring_map(int mem_fd, int evt_fd, int space_fd, unsigned int map_size)
+{
+	struct shm_ring *ring;
+	void *addr;
+
+	ring = calloc(1, sizeof(*ring));
+	if (!ring) {
+		ErrPrint("Heap: %s\n", strerror(errno));
+		return NULL;
+	}
+
+	addr = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, mem_fd, 0);
+	if (addr == MAP_FAILED) {
+		ErrPrint("mmap: %s\n", strerror(errno));
+		free(ring);
+		return NULL;
+	}
+
+	ring->head = addr;
+	ring->map_size = map_size;
+	ring->size = map_size - sizeof(*ring->head);
+	ring->mem_fd = mem_fd;
+	ring->evt_fd = evt_fd;
+	ring->space_fd = space_fd;
+	return ring;
+}
+
+HAPI struct shm_ring *shm_ring_create(unsigned int size)
+{
+	struct shm_ring *ring;
+	unsigned int map_size;
+	int mem_fd;
+	int evt_fd;
+	int space_fd;
+
+	if (!size || (size & (size - 1)) || size < sysconf(_SC_PAGESIZE)) {
+		ErrPrint("Invalid size: %u\n", size);
+		return NULL;
+	}
+
+	mem_fd = memfd_open("com-core.ring");
+	if (mem_fd < 0) {
+		ErrPrint("memfd: %s\n", strerror(-mem_fd));
+		return NULL;
+	}
+
+	map_size = sizeof(struct shm_ring_head) + size;
+	if (ftruncate(mem_fd, map_size) < 0) {
+		ErrPrint("ftruncate: %s\n", strerror(errno));
+		close(mem_fd);
+		return NULL;
+	}
+
+	if (fcntl(mem_fd, F_ADD_SEALS, SHM_RING_SEALS | F_SEAL_SEAL) < 0) {
+		ErrPrint("fcntl: %s\n", strerror(errno));
+		close(mem_fd);
+		return NULL;
+	}
+
+	evt_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (evt_fd < 0) {
+		ErrPrint("eventfd: %s\n", strerror(errno));
+		close(mem_fd);
+		return NULL;
+	}
+
+	space_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (space_fd < 0) {
+		ErrPrint("eventfd: %s\n", strerror(errno));
+		close(evt_fd);
+		close(mem_fd);
+		return NULL;
+	}
+
+	ring = shm_ring_map(mem_fd, evt_fd, space_fd, map_size);
+	if (!ring) {
+		close(space_fd);
+		close(evt_fd);
+		close(mem_fd);
+		return NULL;
+	}
+
+	ring->head->size = size;
+	ring->head->head = 0llu;
+	ring->head->tail = 0llu;
+	ring->head->signalled = 0;
+	ring->head->waiting = 0;
+	__atomic_store_n(&ring->head->magic, SHM_RING_MAGIC, __ATOMIC_RELEASE);
+	return ring;
+}
+
+HAPI struct shm_ring *shm_ring_attach(int mem_fd, int evt_fd, int space_fd)
+{
+	struct shm_ring *ring;
+	struct stat st;
+	unsigned int size;
+	int seals;
+
+	/*!
+	 * \note
+	 * Only the sealed memfd is accepted, otherwise the peer can shrink it under the mapping.
+	 */
+	seals = fcntl(mem_fd, F_GET_SEALS);
+	if (seals < 0) {
+		ErrPrint("fcntl: %s\n", strerror(errno));
+		return NULL;
+	}
+
+	if ((seals & SHM_RING_SEALS) != SHM_RING_SEALS) {
+		ErrPrint("Ring is not sealed: 0x%X\n", seals);
+		return NULL;
+	}
+
+	if (fstat(mem_fd, &st) < 0) {
+		ErrPrint("fstat: %s\n", strerror(errno));
+		return NULL;
+	}
+
+	/*!
+	 * \note
+	 * The size of the mapping is decided by the file, not by the head which can be changed by the peer.
+	 */
+	if (st.st_size <= sizeof(struct shm_ring_head)) {
+		ErrPrint("Invalid ring size: %ld\n", (long)st.st_size);
+		return NULL;
+	}
+
+	size = st.st_size - sizeof(struct shm_ring_head);
+	if (size & (size - 1)) {
+		ErrPrint("Invalid ring size: %u\n", size);
+		return NULL;
+	}
+
+	ring = shm_ring_map(mem_fd, evt_fd, space_fd, st.st_size);
+	if (!ring) {
+		return NULL;
+	}
+
+	if (__atomic_load_n(&ring->head->magic, __ATOMIC_ACQUIRE) != SHM_RING_MAGIC || ring->head->size != size) {
+		ErrPrint("Invalid ring\n");
+		munmap(ring->head, ring->map_size);
+		free(ring);
+		return NULL;
+	}
+
+	return ring;
+}
+
+HAPI void shm_ring_destroy(struct shm_ring *ring)
+{
+	munmap(ring->head, ring->map_size);
+
+	if (ring->evt_fd >= 0 && close(ring->evt_fd) < 0) {
+		ErrPrint("close: %s\n", strerror(errno));
+	}
+
+	if (ring->space_fd >= 0 && close(ring->space_fd) < 0) {
+		ErrPrint("close: %s\n", strerror(errno));
+	}
+
+	if (ring->mem_fd >= 0 && close(ring->mem_fd) < 0) {
+		ErrPrint("close: %s\n", strerror(errno));
+	}
+
+	free(ring);
+}
+
+HAPI int shm_ring_mem_fd(struct shm_ring *ring)
+{
+	return ring->mem_fd;
+}
+
+HAPI int shm_ring_evt_fd(struct shm_ring *ring)
+{
+	return ring->evt_fd;
+}
+
+HAPI int shm_ring_space_fd(struct shm_ring *ring)
+{
+	return ring->space_fd;
+}
+
+static void shm_ring_signal(struct shm_ring *ring)
+{
+	eventfd_t value = 1;
+
+	if (__atomic_exchange_n(&ring->head->signalled, 1, __ATOMIC_SEQ_CST)) {
+		return;
+	}
+
+	if (write(ring->evt_fd, &value, sizeof(value)) != sizeof(value)) {
+		ErrPrint("write: %s\n", strerror(errno));
+	}
+}
+
+/*!
+ * \brief
+ * Release the consumed records, and wake up the producer if it is waiting for a room.
+ */
+static void shm_ring_advance(struct shm_ring *ring, unsigned long long tail)
+{
+	eventfd_t value = 1;
+
+	__atomic_store_n(&ring->head->tail, tail, __ATOMIC_RELEASE);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	if (!__atomic_load_n(&ring->head->waiting, __ATOMIC_RELAXED) || !__atomic_exchange_n(&ring->head->waiting, 0, __ATOMIC_SEQ_CST)) {
+		return;
+	}
+
+	if (write(ring->space_fd, &value, sizeof(value)) != sizeof(value)) {
+		ErrPrint("write: %s\n", strerror(errno));
+	}
+}
+
+/*!
+ * \brief
+ * Reserve a record, a PAD record is put first if the record cannot be placed before the end of the ring.
+ * "reserve" is the room which should be left after this record.
+ */
+static struct shm_ring_record *shm_ring_reserve(struct shm_ring *ring, unsigned int size, unsigned int reserve)
+{
+	struct shm_ring_record *record;
+	unsigned long long head;
+	unsigned long long tail;
+	unsigned int offset;
+	unsigned int room;
+	unsigned int pad;
+
+	head = ring->head->head;
+	tail = __atomic_load_n(&ring->head->tail, __ATOMIC_ACQUIRE);
+	offset = head & (ring->size - 1);
+	room = ring->size - (unsigned int)(head - tail);
+
+	size = SHM_RING_ALIGNED(sizeof(*record) + size);
+	pad = (offset + size > ring->size) ? ring->size - offset : 0;
+
+	if ((unsigned long long)pad + size + reserve > room) {
+		return NULL;
+	}
+
+	if (pad) {
+		record = (struct shm_ring_record *)(ring->head->data + offset);
+		record->type = SHM_RING_PAD;
+		record->size = pad - sizeof(*record);
+		head += pad;
+		__atomic_store_n(&ring->head->head, head, __ATOMIC_RELEASE);
+		offset = 0;
+	}
+
+	return (struct shm_ring_record *)(ring->head->data + offset);
+}
+
+static void shm_ring_commit(struct shm_ring *ring, unsigned int size)
+{
+	__atomic_store_n(&ring->head->head, ring->head->head + SHM_RING_ALIGNED(sizeof(struct shm_ring_record) + size), __ATOMIC_RELEASE);
+	shm_ring_signal(ring);
+}
+
+HAPI int shm_ring_put(struct shm_ring *ring, const struct iovec *iov, int iovcnt, int size)
+{
+	struct shm_ring_record *record;
+	char *ptr;
+	int i;
+
+	/*!
+	 * \note
+	 * Keep a room for a barrier, it never needs padding.
+	 */
+	record = shm_ring_reserve(ring, size, sizeof(*record));
+	if (!record) {
+		return -ENOSPC;
+	}
+
+	ptr = (char *)(record + 1);
+	for (i = 0; i < iovcnt; i++) {
+		memcpy(ptr, iov[i].iov_base, iov[i].iov_len);
+		ptr += iov[i].iov_len;
+	}
+
+	record->type = SHM_RING_DATA;
+	record->size = size;
+	shm_ring_commit(ring, size);
+	return 0;
+}
+
+HAPI int shm_ring_put_barrier(struct shm_ring *ring, int count)
+{
+	struct shm_ring_record *record;
+
+	record = shm_ring_reserve(ring, 0, 0);
+	if (!record) {
+		ErrPrint("No room for a barrier\n");
+		return -ENOSPC;
+	}
+
+	record->type = SHM_RING_BARRIER;
+	record->size = count;
+	shm_ring_commit(ring, 0);
+	return 0;
+}
+
+HAPI int shm_ring_peek(struct shm_ring *ring, const void **data, int *size)
+{
+	struct shm_ring_record *record;
+	unsigned long long head;
+	unsigned long long tail;
+	unsigned int offset;
+	unsigned int used;
+
+	while (1) {
+		head = __atomic_load_n(&ring->head->head, __ATOMIC_ACQUIRE);
+		tail = ring->head->tail;
+		if (head == tail) {
+			return -ENOENT;
+		}
+
+		used = (unsigned int)(head - tail);
+		offset = tail & (ring->size - 1);
+		if (used > ring->size || used < sizeof(*record)) {
+			ErrPrint("Ring is broken: %llu, %llu\n", head, tail);
+			return -EFAULT;
+		}
+
+		record = (struct shm_ring_record *)(ring->head->data + offset);
+
+		/*!
+		 * \note
+		 * The peer can change the record at any time, validate the copied values only.
+		 */
+		*size = record->size;
+		switch (record->type) {
+		case SHM_RING_PAD:
+			if (*size < 0 || offset + sizeof(*record) + *size != ring->size || sizeof(*record) + *size > used) {
+				ErrPrint("Invalid padding: %d\n", *size);
+				return -EFAULT;
+			}
+
+			shm_ring_advance(ring, tail + sizeof(*record) + *size);
+			continue;
+		case SHM_RING_BARRIER:
+			*data = NULL;
+			ring->peeked = sizeof(*record);
+			return SHM_RING_BARRIER;
+		case SHM_RING_DATA:
+			if (*size < 0 || offset + sizeof(*record) + *size > ring->size || SHM_RING_ALIGNED(sizeof(*record) + *size) > used) {
+				ErrPrint("Invalid record: %d\n", *size);
+				return -EFAULT;
+			}
+
+			*data = record + 1;
+			ring->peeked = SHM_RING_ALIGNED(sizeof(*record) + *size);
+			return SHM_RING_DATA;
+		default:
+			ErrPrint("Invalid record type: %u\n", record->type);
+			return -EFAULT;
+		}
+	}
+}
+
+HAPI void shm_ring_consume(struct shm_ring *ring)
+{
+	shm_ring_advance(ring, ring->head->tail + ring->peeked);
+	ring->peeked = 0;
+}
+
+HAPI void shm_ring_rearm(struct shm_ring *ring)
+{
+	eventfd_t value;
+
+	if (read(ring->evt_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+		ErrPrint("read: %s\n", strerror(errno));
+	}
+
+	__atomic_store_n(&ring->head->signalled, 0, __ATOMIC_SEQ_CST);
+}
+
+HAPI void shm_ring_wait_space(struct shm_ring *ring)
+{
+	eventfd_t value;
+
+	if (read(ring->space_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+		ErrPrint("read: %s\n", strerror(errno));
+	}
+
+	__atomic_store_n(&ring->head->waiting, 1, __ATOMIC_SEQ_CST);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+/* End of a file */
@@ -0,0 +1,420 @@
+/*
+ * Copyright (c) 2000 - 2013 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/*!
+ * \brief
+ * Converts the text desc file to the binary one, or dumps the binary one as a text.
+ *
+ * com-core-desc-conv INPUT OUTPUT
+ * com-core-desc-conv -d INPUT OUTPUT
+ * com-core-desc-conv -t INPUT
+ *
+ * With -t, the text desc is converted in memory, then sizes and parse times of both are printed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <time.h>
+
+#include "com-core_desc.h"
+
+static char *load_file(const char *filename, int *size)
+{
+	FILE *fp;
+	char *buffer;
+	long filesize;
+
+	fp = fopen(filename, "rb");
+	if (!fp) {
+		fprintf(stderr, "fopen: %s (%s)\n", filename, strerror(errno));
+		return NULL;
+	}
+
+	if (fseek(fp, 0L, SEEK_END) < 0 || (filesize = ftell(fp)) < 0) {
+		fprintf(stderr, "fseek: %s\n", strerror(errno));
+		fclose(fp);
+		return NULL;
+	}
+	rewind(fp);
+
+	buffer = malloc(filesize + 1);
+	if (!buffer) {
+		fprintf(stderr, "malloc: %s\n", strerror(errno));
+		fclose(fp);
+		return NULL;
+	}
+
+	if (fread(buffer, 1, filesize, fp) != (size_t)filesize) {
+		fprintf(stderr, "fread: %s\n", strerror(errno));
+		free(buffer);
+		fclose(fp);
+		return NULL;
+	}
+
+	buffer[filesize] = '\0';
+	*size = (int)filesize;
+	fclose(fp);
+	return buffer;
+}
+
+static int write_block(FILE *fp, const struct com_core_desc_block *block)
+{
+	char *buffer;
+	int size;
+	int ret;
+
+	size = com_core_desc_write_block(NULL, 0, block);
+	if (size < 0) {
+		return size;
+	}
+
+	buffer = malloc(size);
+	if (!buffer) {
+		return -ENOMEM;
+	}
+
+	ret = com_core_desc_write_block(buffer, size, block);
+	if (ret > 0 && fwrite(buffer, 1, ret, fp) != (size_t)ret) {
+		ret = -EIO;
+	}
+
+	free(buffer);
+	return ret;
+}
+
+static inline char *strip(char *str)
+{
+	char *end;
+
+	while (isspace(*str)) {
+		str++;
+	}
+
+	end = str + strlen(str);
+	while (end > str && isspace(end[-1])) {
+		end--;
+	}
+	*end = '\0';
+
+	return str;
+}
+
+/*!
+ * \note
+ * Fields of blocks are pointing the text, it is modified.
+ */
+static int parse_text(char *text, int (*block_cb)(const struct com_core_desc_block *block, int blockno, void *data), void *data)
+{
+	struct com_core_desc_block block;
+	char *line;
+	char *next;
+	char *value;
+	int in_block = 0;
+	int blockno = 0;
+	int lineno = 0;
+	int ret;
+
+	for (line = text; line; line = next) {
+		lineno++;
+
+		next = strchr(line, '\n');
+		if (next) {
+			*next++ = '\0';
+		}
+
+		if (!in_block) {
+			if (!strcmp(strip(line), "{")) {
+				memset(&block, 0, sizeof(block));
+				in_block = 1;
+			}
+			continue;
+		}
+
+		if (!strcmp(strip(line), "}")) {
+			blockno++;
+			ret = block_cb(&block, blockno, data);
+			if (ret < 0) {
+				fprintf(stderr, "%d: Invalid block\n", lineno);
+				return ret;
+			}
+			in_block = 0;
+			continue;
+		}
+
+		value = strchr(line, '=');
+		if (!value) {
+			continue;
+		}
+
+		*value++ = '\0';
+		value[strcspn(value, "\r\f")] = '\0';
+		line = strip(line);
+
+		if (!strcmp(line, "type")) {
+			block.type = strip(value);
+		} else if (!strcmp(line, "part")) {
+			block.part = value;
+		} else if (!strcmp(line, "data")) {
+			block.data = value;
+		} else if (!strcmp(line, "option")) {
+			block.option = value;
+		} else if (!strcmp(line, "id")) {
+			block.id = value;
+		} else if (!strcmp(line, "target")) {
+			block.target = value;
+		} else if (!strcmp(line, "file")) {
+			block.file = value;
+		} else {
+			fprintf(stderr, "%d: Unknown field: %s\n", lineno, line);
+			return -EINVAL;
+		}
+	}
+
+	if (in_block) {
+		fprintf(stderr, "%d: Block is not closed\n", lineno);
+		return -EINVAL;
+	}
+
+	return blockno;
+}
+
+static int write_block_cb(const struct com_core_desc_block *block, int blockno, void *data)
+{
+	return write_block(data, block);
+}
+
+static int text_to_binary(char *text, FILE *fp)
+{
+	char header[COM_CORE_DESC_HEADER_SIZE];
+	int ret;
+
+	com_core_desc_write_header(header, sizeof(header));
+	if (fwrite(header, 1, sizeof(header), fp) != sizeof(header)) {
+		return -EIO;
+	}
+
+	ret = parse_text(text, write_block_cb, fp);
+	return ret < 0 ? ret : 0;
+}
+
+static int binary_to_text(const char *buffer, int size, FILE *fp)
+{
+	struct com_core_desc_reader reader;
+	struct com_core_desc_block block;
+	int ret;
+
+	ret = com_core_desc_reader_init(&reader, buffer, size);
+	if (ret < 0) {
+		return ret;
+	}
+
+	while ((ret = com_core_desc_reader_next(&reader, &block)) > 0) {
+		fprintf(fp, "{\n");
+		if (block.type) {
+			fprintf(fp, "type=%s\n", block.type);
+		}
+		if (block.part) {
+			fprintf(fp, "part=%s\n", block.part);
+		}
+		if (block.data) {
+			fprintf(fp, "data=%s\n", block.data);
+		}
+		if (block.option) {
+			fprintf(fp, "option=%s\n", block.option);
+		}
+		if (block.id) {
+			fprintf(fp, "id=%s\n", block.id);
+		}
+		if (block.target) {
+			fprintf(fp, "target=%s\n", block.target);
+		}
+		if (block.file) {
+			fprintf(fp, "file=%s\n", block.file);
+		}
+		fprintf(fp, "}\n");
+	}
+
+	return ret;
+}
+
+static double timestamp(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1000000000.0f;
+}
+
+static int count_block_cb(const struct com_core_desc_block *block, int blockno, void *data)
+{
+	(*(int *)data)++;
+	return 0;
+}
+
+/*!
+ * \note
+ * The text parser modifies its buffer, so the text is copied before each parse.
+ * Time of copying is measured separately and subtracted.
+ */
+static int measure(char *text, int size)
+{
+	char *scratch;
+	char *binary;
+	size_t binary_size;
+	double copy_time;
+	double text_time;
+	double binary_time;
+	double elapsed;
+	int count = 0;
+	int loop;
+	int ret;
+	int i;
+	FILE *fp;
+
+	scratch = malloc(size + 1);
+	if (!scratch) {
+		return -ENOMEM;
+	}
+
+	memcpy(scratch, text, size + 1);
+	fp = open_memstream(&binary, &binary_size);
+	if (!fp) {
+		free(scratch);
+		return -errno;
+	}
+
+	ret = text_to_binary(scratch, fp);
+	if (fclose(fp) != 0 && ret == 0) {
+		ret = -EIO;
+	}
+
+	if (ret < 0) {
+		free(binary);
+		free(scratch);
+		return ret;
+	}
+
+	loop = 10000;
+
+	elapsed = timestamp();
+	for (i = 0; i < loop; i++) {
+		memcpy(scratch, text, size + 1);
+	}
+	copy_time = timestamp() - elapsed;
+
+	elapsed = timestamp();
+	for (i = 0; i < loop; i++) {
+		memcpy(scratch, text, size + 1);
+		ret = parse_text(scratch, count_block_cb, &count);
+	}
+	text_time = timestamp() - elapsed - copy_time;
+
+	elapsed = timestamp();
+	for (i = 0; i < loop; i++) {
+		ret = com_core_desc_foreach_block(binary, binary_size, count_block_cb, &count);
+	}
+	binary_time = timestamp() - elapsed;
+
+	printf("%d blocks\n", ret);
+	printf("text:   %d bytes, %.2f usec/parse\n", size, text_time * 1000000.0f / loop);
+	printf("binary: %d bytes, %.2f usec/parse\n", (int)binary_size, binary_time * 1000000.0f / loop);
+
+	free(binary);
+	free(scratch);
+	return ret < 0 ? ret : 0;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *input;
+	const char *output;
+	char *buffer;
+	int decode = 0;
+	int size;
+	int ret;
+	FILE *fp;
+
+	if (argc == 3 && !strcmp(argv[1], "-t")) {
+		buffer = load_file(argv[2], &size);
+		if (!buffer) {
+			return 1;
+		}
+
+		if (com_core_desc_is_binary(buffer, size)) {
+			fprintf(stderr, "%s is already converted\n", argv[2]);
+			free(buffer);
+			return 1;
+		}
+
+		ret = measure(buffer, size);
+		free(buffer);
+		if (ret < 0) {
+			fprintf(stderr, "Failed to measure %s (%d)\n", argv[2], ret);
+			return 1;
+		}
+
+		return 0;
+	}
+
+	if (argc == 4 && !strcmp(argv[1], "-d")) {
+		decode = 1;
+	} else if (argc != 3) {
+		fprintf(stderr, "Usage: %s [-d] INPUT OUTPUT\n       %s -t INPUT\n", argv[0], argv[0]);
+		return 1;
+	}
+
+	input = argv[argc - 2];
+	output = argv[argc - 1];
+
+	buffer = load_file(input, &size);
+	if (!buffer) {
+		return 1;
+	}
+
+	if (!decode && com_core_desc_is_binary(buffer, size)) {
+		fprintf(stderr, "%s is already converted\n", input);
+		free(buffer);
+		return 1;
+	}
+
+	fp = fopen(output, decode ? "w" : "wb");
+	if (!fp) {
+		fprintf(stderr, "fopen: %s (%s)\n", output, strerror(errno));
+		free(buffer);
+		return 1;
+	}
+
+	ret = decode ? binary_to_text(buffer, size, fp) : text_to_binary(buffer, fp);
+	if (fclose(fp) != 0 && ret == 0) {
+		ret = -EIO;
+	}
+
+	free(buffer);
+
+	if (ret < 0) {
+		fprintf(stderr, "Failed to convert %s (%d)\n", input, ret);
+		remove(output);
+		return 1;
+	}
+
+	return 0;
+}
+
+/* End of a file */
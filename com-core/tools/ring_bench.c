@@ -0,0 +1,339 @@
+/*
+ * Copyright (c) 2000 - 2013 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/*!
+ * \brief
+ * Compares the shared memory ring with the socket, between two processes.
+ * A producer sends COUNT messages of SIZE bytes, and puts a barrier every BARRIER messages,
+ * a consumer receives them and checks the order.
+ *
+ * com-core-ring-bench [-n COUNT] [-s SIZE] [-b BARRIER]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+
+#include "shm_ring.h"
+
+#define RING_SIZE (64 * 1024)
+
+static double timestamp(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1000000000.0f;
+}
+
+static void wait_fd(int fd)
+{
+	struct pollfd pfd = {
+		.fd = fd,
+		.events = POLLIN,
+	};
+	eventfd_t value;
+
+	if (poll(&pfd, 1, -1) < 0 && errno != EINTR) {
+		perror("poll");
+		exit(1);
+	}
+
+	if (read(fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+		perror("read");
+		exit(1);
+	}
+}
+
+static inline int ring_try_put(struct shm_ring *ring, const struct iovec *iov, int size)
+{
+	return iov ? shm_ring_put(ring, iov, 1, size) : shm_ring_put_barrier(ring, 0);
+}
+
+/*!
+ * \note
+ * Same as the com-core packet, the producer sleeps on the space eventfd while the ring is full.
+ */
+static void ring_wait_put(struct shm_ring *ring, const struct iovec *iov, int size)
+{
+	while (ring_try_put(ring, iov, size) == -ENOSPC) {
+		shm_ring_wait_space(ring);
+		if (ring_try_put(ring, iov, size) == 0) {
+			break;
+		}
+
+		wait_fd(shm_ring_space_fd(ring));
+	}
+}
+
+static void ring_producer(struct shm_ring *ring, int count, int size, int barrier)
+{
+	struct iovec iov;
+	char *buffer;
+	int i;
+
+	buffer = calloc(1, size);
+	if (!buffer) {
+		perror("calloc");
+		exit(1);
+	}
+
+	iov.iov_base = buffer;
+	iov.iov_len = size;
+
+	for (i = 0; i < count; i++) {
+		if (barrier && i % barrier == 0) {
+			ring_wait_put(ring, NULL, 0);
+		}
+
+		memcpy(buffer, &i, sizeof(i));
+		ring_wait_put(ring, &iov, size);
+	}
+
+	free(buffer);
+}
+
+static int ring_consumer(struct shm_ring *ring, int count)
+{
+	const void *data;
+	int expected = 0;
+	int size;
+	int type;
+
+	while (expected < count) {
+		type = shm_ring_peek(ring, &data, &size);
+		if (type == -ENOENT) {
+			shm_ring_rearm(ring);
+			if (shm_ring_peek(ring, &data, &size) == -ENOENT) {
+				wait_fd(shm_ring_evt_fd(ring));
+			}
+			continue;
+		} else if (type < 0) {
+			fprintf(stderr, "Ring is broken\n");
+			return -EFAULT;
+		} else if (type == SHM_RING_DATA) {
+			if (memcmp(data, &expected, sizeof(expected))) {
+				fprintf(stderr, "Out of order: %d\n", expected);
+				return -EFAULT;
+			}
+			expected++;
+		}
+
+		shm_ring_consume(ring);
+	}
+
+	return 0;
+}
+
+static void socket_producer(int fd, int count, int size)
+{
+	char *buffer;
+	int i;
+
+	buffer = calloc(1, size);
+	if (!buffer) {
+		perror("calloc");
+		exit(1);
+	}
+
+	for (i = 0; i < count; i++) {
+		memcpy(buffer, &i, sizeof(i));
+		if (send(fd, buffer, size, 0) != size) {
+			perror("send");
+			exit(1);
+		}
+	}
+
+	free(buffer);
+}
+
+static int socket_consumer(int fd, int count, int size)
+{
+	char *buffer;
+	int expected;
+	int offset;
+	int ret;
+
+	buffer = malloc(size);
+	if (!buffer) {
+		perror("malloc");
+		return -ENOMEM;
+	}
+
+	for (expected = 0; expected < count; expected++) {
+		for (offset = 0; offset < size; offset += ret) {
+			ret = recv(fd, buffer + offset, size - offset, 0);
+			if (ret <= 0) {
+				perror("recv");
+				free(buffer);
+				return -EIO;
+			}
+		}
+
+		if (memcmp(buffer, &expected, sizeof(expected))) {
+			fprintf(stderr, "Out of order: %d\n", expected);
+			free(buffer);
+			return -EFAULT;
+		}
+	}
+
+	free(buffer);
+	return 0;
+}
+
+static int wait_child(pid_t pid)
+{
+	int status;
+
+	if (waitpid(pid, &status, 0) != pid) {
+		perror("waitpid");
+		return -1;
+	}
+
+	return (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? 0 : -1;
+}
+
+static double bench_ring(int count, int size, int barrier)
+{
+	struct shm_ring *ring;
+	struct shm_ring *peer;
+	double elapsed;
+	pid_t pid;
+
+	ring = shm_ring_create(RING_SIZE);
+	if (!ring) {
+		return -1.0f;
+	}
+
+	elapsed = timestamp();
+	pid = fork();
+	if (pid < 0) {
+		perror("fork");
+		shm_ring_destroy(ring);
+		return -1.0f;
+	} else if (pid == 0) {
+		peer = shm_ring_attach(dup(shm_ring_mem_fd(ring)), dup(shm_ring_evt_fd(ring)), dup(shm_ring_space_fd(ring)));
+		if (!peer) {
+			_exit(1);
+		}
+
+		_exit(ring_consumer(peer, count) < 0);
+	}
+
+	ring_producer(ring, count, size, barrier);
+	if (wait_child(pid) < 0) {
+		shm_ring_destroy(ring);
+		return -1.0f;
+	}
+
+	elapsed = timestamp() - elapsed;
+	shm_ring_destroy(ring);
+	return elapsed;
+}
+
+static double bench_socket(int count, int size)
+{
+	double elapsed;
+	int fd[2];
+	pid_t pid;
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fd) < 0) {
+		perror("socketpair");
+		return -1.0f;
+	}
+
+	elapsed = timestamp();
+	pid = fork();
+	if (pid < 0) {
+		perror("fork");
+		close(fd[0]);
+		close(fd[1]);
+		return -1.0f;
+	} else if (pid == 0) {
+		close(fd[0]);
+		_exit(socket_consumer(fd[1], count, size) < 0);
+	}
+
+	close(fd[1]);
+	socket_producer(fd[0], count, size);
+	close(fd[0]);
+
+	if (wait_child(pid) < 0) {
+		return -1.0f;
+	}
+
+	return timestamp() - elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+	double elapsed;
+	int count = 1000000;
+	int size = 120;
+	int barrier = 1000;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:s:b:")) != -1) {
+		switch (opt) {
+		case 'n':
+			count = atoi(optarg);
+			break;
+		case 's':
+			size = atoi(optarg);
+			break;
+		case 'b':
+			barrier = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-n COUNT] [-s SIZE] [-b BARRIER]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (count <= 0 || size < (int)sizeof(int) || size > RING_SIZE / 4 || barrier < 0) {
+		fprintf(stderr, "Invalid arguments\n");
+		return 1;
+	}
+
+	printf("%d messages, %d bytes, a barrier every %d messages\n", count, size, barrier);
+
+	elapsed = bench_ring(count, size, barrier);
+	if (elapsed < 0.0f) {
+		fprintf(stderr, "Ring failed\n");
+		return 1;
+	}
+	printf("ring:   %.3f sec, %.2f M msg/s\n", elapsed, count / elapsed / 1000000.0f);
+
+	elapsed = bench_socket(count, size);
+	if (elapsed < 0.0f) {
+		fprintf(stderr, "Socket failed\n");
+		return 1;
+	}
+	printf("socket: %.3f sec, %.2f M msg/s\n", elapsed, count / elapsed / 1000000.0f);
+
+	return 0;
+}
+
+/* End of a file */
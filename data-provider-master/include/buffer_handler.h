@@ -106,11 +106,38 @@ extern void *buffer_handler_fb(struct buffer_info *info);
 extern int buffer_handler_get_size(struct buffer_info *info, int *w, int *h);
 
 /*!
- * \brief This API only can be used for file type buffer
+ * \brief Flush the region of a buffer, only rows in the region are written for the file type buffer
  * \param[in] info
+ * \param[in] x
+ * \param[in] y
+ * \param[in] w if it is 0, whole buffer is flushed
+ * \param[in] h if it is 0, whole buffer is flushed
  * \return void
  */
-extern void buffer_handler_flush(struct buffer_info *info);
+extern void buffer_handler_flush(struct buffer_info *info, int x, int y, int w, int h);
+
+/*!
+ * \brief Accumulate the damaged region of a buffer, used by script ports
+ * \param[in] info
+ * \param[in] x
+ * \param[in] y
+ * \param[in] w
+ * \param[in] h
+ * \return void
+ */
+extern void buffer_handler_damage(struct buffer_info *info, int x, int y, int w, int h);
+
+/*!
+ * \brief Get the accumulated damaged region and reset it
+ * \remarks If there is no reported damage, the whole buffer is given
+ * \param[in] info
+ * \param[out] x
+ * \param[out] y
+ * \param[out] w
+ * \param[out] h
+ * \return void
+ */
+extern void buffer_handler_damaged_region(struct buffer_info *info, int *x, int *y, int *w, int *h);
 
 /*!
  * \brief
@@ -345,4 +372,49 @@ extern int buffer_handler_set_data(struct buffer_info *buffer, void *data);
  * \sa
  */
 extern void *buffer_handler_data(struct buffer_info *buffer);
+
+/*!
+ * \brief Make the SHM buffer N-buffered, the provider publishes its frames to slots and viewers read them without the lock.
+ * \details
+ * \remarks Must be called before loading the buffer, the other types of buffers ignore this.
+ * \param[in] info Buffer handler
+ * \param[in] slots Count of slots, 0 or 1 for the single frame, up to SHM_RING_MAX_SLOTS
+ * \return int
+ * \retval WIDGET_ERROR_NONE if succeed
+ * \retval WIDGET_ERROR_INVALID_PARAMETER invalid count of slots
+ * \retval WIDGET_ERROR_RESOURCE_BUSY the buffer is loaded already
+ * \pre
+ * \post
+ * \sa buffer_handler_load
+ */
+extern int buffer_handler_set_slots(struct buffer_info *info, int slots);
+
+/*!
+ * \brief Find a loaded MEMFD buffer using its id.
+ * \details
+ * \remarks Only the MEMFD buffers are indexed.
+ * \param[in] id Id of the buffer, "memfd://..."
+ * \return struct buffer_info *
+ * \retval NULL if there is no such buffer
+ * \retval address Buffer handler
+ * \pre
+ * \post
+ * \sa buffer_handler_fd
+ */
+extern struct buffer_info *buffer_handler_find_memfd(const char *id);
+
+/*!
+ * \brief Get the memfd of a MEMFD buffer, to send it to the provider or viewers.
+ * \details
+ * \remarks The fd is owned by the buffer handler, do not close it.
+ * \param[in] info Buffer handler
+ * \return int
+ * \retval >=0 memfd
+ * \retval WIDGET_ERROR_INVALID_PARAMETER if the buffer is not a loaded MEMFD buffer
+ * \pre
+ * \post
+ * \sa buffer_handler_find_memfd
+ */
+extern int buffer_handler_fd(struct buffer_info *info);
+
 /* End of a file */
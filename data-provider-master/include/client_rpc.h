@@ -18,6 +18,7 @@
  */
 extern int client_rpc_async_request(struct client_node *client, struct packet *packet);
 extern int client_rpc_handle(struct client_node *client);
+extern struct client_node *client_rpc_find_by_handle(int handle);
 
 /*!
  */
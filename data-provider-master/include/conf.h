@@ -17,11 +17,20 @@
 struct conf {
 	int debug_mode;
 	int slave_max_load;
+	int slave_max_inflight; /*!< Count of requests waiting for the reply, per slave. 0 for no limit */
+	int shm_pool_max_size; /*!< Bytes of released SHM segments kept for reusing. 0 for no pooling */
+	int shm_slots; /*!< Count of published frames of the SHM buffers of providers. 0 for the single frame */
 };
 
 extern struct conf g_conf;
 
 #define DELAY_TIME 0.0000001f
+#define DEFAULT_SLAVE_MAX_INFLIGHT 4
+#define SLAVE_MAX_INFLIGHT_ENV "PROVIDER_MAX_INFLIGHT"
+#define DEFAULT_SHM_POOL_MAX_SIZE (16 << 20)
+#define SHM_POOL_MAX_SIZE_ENV "PROVIDER_SHM_POOL_SIZE"
+#define DEFAULT_SHM_SLOTS 0
+#define SHM_SLOTS_ENV "PROVIDER_SHM_SLOTS"
 #define HAPI __attribute__((visibility("hidden")))
 
 #if !defined(VCONFKEY_MASTER_STARTED)
@@ -14,13 +14,26 @@
  * limitations under the License.
  */
 
-extern int slave_rpc_async_request(struct slave_node *slave, const char *pkgname, struct packet *packet, void (*ret_cb)(struct slave_node *slave, const struct packet *packet, void *data), void *data, int urgent);
-extern int slave_rpc_request_only(struct slave_node *slave, const char *pkgname, struct packet *packet, int urgent);
+/*!
+ * \brief
+ * Each slave has its own queue for each lane, lanes are drained in the order of priority.
+ * Values of BACKGROUND and URGENT are same with the old "urgent" flag.
+ */
+enum slave_rpc_lane {
+	SLAVE_RPC_LANE_BACKGROUND = 0x00, /*!< Updates, lifecycle requests which can wait */
+	SLAVE_RPC_LANE_URGENT = 0x01, /*!< Creating or recovering instances */
+	SLAVE_RPC_LANE_INTERACTIVE = 0x02, /*!< Input events, resize, pause and resume */
+	SLAVE_RPC_LANE_MAX = 0x03
+};
+
+extern int slave_rpc_async_request(struct slave_node *slave, const char *pkgname, struct packet *packet, void (*ret_cb)(struct slave_node *slave, const struct packet *packet, void *data), void *data, enum slave_rpc_lane lane);
+extern int slave_rpc_request_only(struct slave_node *slave, const char *pkgname, struct packet *packet, enum slave_rpc_lane lane);
 
 extern int slave_rpc_update_handle(struct slave_node *slave, int handle, int delete_pended_created_packet);
 extern int slave_rpc_ping(struct slave_node *slave);
 extern void slave_rpc_request_update(const char *pkgname, const char *id, const char *cluster, const char *category, const char *content, int force);
 extern int slave_rpc_handle(struct slave_node *slave);
+extern struct slave_node *slave_rpc_find_by_handle(int handle);
 extern int slave_rpc_ping_freeze(struct slave_node *slave);
 extern int slave_rpc_ping_thaw(struct slave_node *slave);
 
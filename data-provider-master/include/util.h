@@ -36,6 +36,22 @@ extern int util_screen_fini(void);
 #define SCHEMA_PIXMAP	"pixmap://"
 #define SCHEMA_SHM	"shm://"
 
+#include <com-core_buffer.h>
+
+#if !defined(MFD_CLOEXEC)
+#include <sys/syscall.h>
+#define MFD_CLOEXEC		0x0001U
+#define MFD_ALLOW_SEALING	0x0002U
+#define memfd_create(name, flags)	syscall(__NR_memfd_create, (name), (flags))
+#endif
+
+#if !defined(F_ADD_SEALS)
+#define F_ADD_SEALS	(1024 + 9)
+#define F_SEAL_SEAL	0x0001
+#define F_SEAL_SHRINK	0x0002
+#define F_SEAL_GROW	0x0004
+#endif
+
 #define CRITICAL_SECTION_BEGIN(handle) \
 do { \
 	int ret; \
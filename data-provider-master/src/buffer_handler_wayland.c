@@ -48,6 +48,7 @@
 #include "client_life.h"
 #include "client_rpc.h"
 #include "buffer_handler.h"
+#include "setting.h"
 #include "script_handler.h" // Reverse dependency. must has to be broken
 
 struct gem_data {
@@ -62,6 +63,22 @@ struct gem_data {
 	int pixmap; /* FD in case of wayland */
 };
 
+/*!
+ * \brief
+ * SHM segment which is released by a buffer, kept to be reused by the next SHM buffer of the same size class.
+ */
+struct shm_segment {
+	int id;
+	int size;
+	widget_fb_t buffer; /*!< Attached address of the segment */
+};
+
+/*!
+ * \brief
+ * Count of pooled SHM segments, the total size of them is limited by g_conf.shm_pool_max_size.
+ */
+#define SHM_POOL_MAX_COUNT	8
+
 struct buffer_info
 {
 	void *buffer;
@@ -77,16 +94,40 @@ struct buffer_info
 
 	struct inst_info *inst;
 	void *data;
+
+	int fd; /*!< File of the FILE type buffer, kept opened while the buffer is loaded, or the memfd of the MEMFD type buffer */
+	struct _damage {
+		int x;
+		int y;
+		int w;
+		int h;
+	} damage; /*!< Damaged region which is not flushed yet, w == 0 if there is nothing */
+
+	int slots; /*!< Count of the published frames of the N-buffered SHM, 0 if it has a single frame */
 };
 
 static struct {
 	tbm_bufmgr slp_bufmgr;
 	int fd;
 	Eina_List *pixmap_list;
+	Eina_List *shm_pool; /*!< The most recently released one is the first */
+	int shm_pool_size;
+	int shm_pool_disabled; /*!< Do not keep segments while the memory is low */
+	unsigned int shm_serial;
+	Eina_Hash *memfd_table; /*!< Loaded MEMFD buffers, indexed by their id */
+	unsigned int memfd_serial;
+	Eina_List *ring_list; /*!< Loaded N-buffered SHM buffers */
 } s_info = {
 	.slp_bufmgr = NULL,
 	.fd = -1,
 	.pixmap_list = NULL,
+	.shm_pool = NULL,
+	.shm_pool_size = 0,
+	.shm_pool_disabled = 0,
+	.shm_serial = 0,
+	.memfd_table = NULL,
+	.memfd_serial = 0,
+	.ring_list = NULL,
 };
 
 
@@ -298,10 +339,241 @@ static inline int load_file_buffer(struct buffer_info *info)
 	return WIDGET_ERROR_NONE;
 }
 
+/*!
+ * \brief
+ * Round up the size of a segment to its size class.
+ * Each power of two is divided into 8 classes, so a segment wastes 12.5% of its size at most.
+ */
+static inline int shm_class_size(int size)
+{
+	int step;
+
+	step = getpagesize();
+	while ((step << 3) < size) {
+		step <<= 1;
+	}
+
+	return (size + step - 1) & ~(step - 1);
+}
+
+static void destroy_shm_segment(int id, widget_fb_t buffer)
+{
+	if (shmdt(buffer) < 0) {
+		ErrPrint("shmdt: %d\n", errno);
+	}
+
+	if (shmctl(id, IPC_RMID, 0) < 0) {
+		ErrPrint("shmctl: %d\n", errno);
+	}
+}
+
+/*!
+ * \brief
+ * Destroy pooled segments from the least recently released one, until the pool fits in the limits.
+ */
+static void flush_shm_pool(int max_count, int max_size)
+{
+	struct shm_segment *segment;
+
+	while (s_info.shm_pool && ((int)eina_list_count(s_info.shm_pool) > max_count || s_info.shm_pool_size > max_size)) {
+		segment = eina_list_data_get(eina_list_last(s_info.shm_pool));
+		s_info.shm_pool = eina_list_remove(s_info.shm_pool, segment);
+		s_info.shm_pool_size -= segment->size;
+
+		destroy_shm_segment(segment->id, segment->buffer);
+		DbgFree(segment);
+	}
+}
+
+/*!
+ * \brief
+ * Take a segment of the given size class from the pool, or create a new one.
+ * A pooled segment which is still attached by a viewer is not reused,
+ * the viewer could see the contents of other instance from it.
+ */
+static widget_fb_t acquire_shm_segment(int size, int *id)
+{
+	struct shm_segment *segment;
+	struct shmid_ds ds;
+	widget_fb_t buffer;
+	Eina_List *l;
+
+	EINA_LIST_FOREACH(s_info.shm_pool, l, segment) {
+		if (segment->size != size) {
+			continue;
+		}
+
+		if (shmctl(segment->id, IPC_STAT, &ds) < 0) {
+			ErrPrint("shmctl: %d\n", errno);
+			continue;
+		}
+
+		if (ds.shm_nattch > 1) {
+			continue;
+		}
+
+		s_info.shm_pool = eina_list_remove_list(s_info.shm_pool, l);
+		s_info.shm_pool_size -= segment->size;
+
+		*id = segment->id;
+		buffer = segment->buffer;
+		DbgFree(segment);
+
+		/*!
+		 * \note
+		 * Clear the previous contents, the new segment is also filled with zero.
+		 */
+		memset(buffer, 0, size);
+		return buffer;
+	}
+
+	*id = shmget(IPC_PRIVATE, size, IPC_CREAT | 0666);
+	if (*id < 0) {
+		ErrPrint("shmget: %d\n", errno);
+		return NULL;
+	}
+
+	buffer = shmat(*id, NULL, 0);
+	if (buffer == (void *)-1) {
+		ErrPrint("shmat: %d\n", errno);
+
+		if (shmctl(*id, IPC_RMID, 0) < 0) {
+			ErrPrint("shmctl: %d\n", errno);
+		}
+
+		return NULL;
+	}
+
+	return buffer;
+}
+
+/*!
+ * \brief
+ * Keep the segment in the pool, or destroy it if the pool cannot take it.
+ */
+static void release_shm_segment(int id, widget_fb_t buffer, int size)
+{
+	struct shm_segment *segment;
+
+	if (s_info.shm_pool_disabled || size > g_conf.shm_pool_max_size) {
+		destroy_shm_segment(id, buffer);
+		return;
+	}
+
+	segment = malloc(sizeof(*segment));
+	if (!segment) {
+		ErrPrint("malloc: %d\n", errno);
+		destroy_shm_segment(id, buffer);
+		return;
+	}
+
+	segment->id = id;
+	segment->size = size;
+	segment->buffer = buffer;
+
+	s_info.shm_pool = eina_list_prepend(s_info.shm_pool, segment);
+	s_info.shm_pool_size += size;
+
+	flush_shm_pool(SHM_POOL_MAX_COUNT, g_conf.shm_pool_max_size);
+}
+
+static int shm_oom_cb(enum oom_event_type type, void *data)
+{
+	if (type == OOM_TYPE_LOW) {
+		DbgPrint("Flush %d SHM segments (%d bytes)\n", eina_list_count(s_info.shm_pool), s_info.shm_pool_size);
+		s_info.shm_pool_disabled = 1;
+		flush_shm_pool(0, 0);
+	} else {
+		s_info.shm_pool_disabled = 0;
+	}
+
+	return WIDGET_ERROR_NONE;
+}
+
+/*!
+ * \brief
+ * Size of the data of a SHM buffer, the N-buffered one has its ring and slots after the draw frame.
+ */
+static inline int shm_data_size(struct buffer_info *info, int size)
+{
+	return info->slots > 1 ? SHM_RING_SIZE(size, info->slots) : size;
+}
+
+/*!
+ * \brief
+ * Give back the slots which are pinned by viewers which are gone.
+ * A viewer crashed or leaked while reading a slot, its pins would block the provider forever.
+ */
+static void release_shm_ring_pins(struct shm_ring *ring, struct client_node *client)
+{
+	struct client_node *owner;
+	struct shm_ring_pin *pin;
+	unsigned int count;
+	int pid;
+	int i;
+	int idx;
+
+	for (i = 0; i < SHM_RING_MAX_PINS; i++) {
+		pin = ring->pins + i;
+
+		pid = __atomic_load_n(&pin->pid, __ATOMIC_SEQ_CST);
+		if (!pid) {
+			continue;
+		}
+
+		owner = client_find_by_pid(pid);
+		if (owner && owner != client) {
+			continue;
+		}
+
+		for (idx = 0; idx < SHM_RING_MAX_SLOTS; idx++) {
+			count = __atomic_exchange_n(&pin->count[idx], 0, __ATOMIC_SEQ_CST);
+			if (count) {
+				DbgPrint("Slot %d is released from %d (%u)\n", idx, pid, count);
+				__atomic_sub_fetch(&ring->readers[idx], count, __ATOMIC_SEQ_CST);
+			}
+		}
+
+		__atomic_store_n(&pin->pid, 0, __ATOMIC_SEQ_CST);
+	}
+}
+
+static int shm_ring_client_destroyed_cb(struct client_node *client, void *data)
+{
+	struct buffer_info *info;
+	Eina_List *l;
+
+	EINA_LIST_FOREACH(s_info.ring_list, l, info) {
+		release_shm_ring_pins(SHM_RING((widget_fb_t)info->buffer), client);
+	}
+
+	return WIDGET_ERROR_NONE;
+}
+
+static inline void init_shm_ring(struct buffer_info *info, widget_fb_t buffer, int size)
+{
+	struct shm_ring *ring;
+	widget_fb_t slot;
+	int idx;
+
+	ring = SHM_RING(buffer);
+	ring->count = info->slots;
+	ring->frame_size = size;
+
+	for (idx = 0; idx < info->slots; idx++) {
+		slot = SHM_RING_SLOT(ring, idx);
+		slot->type = WIDGET_FB_TYPE_SHM;
+		slot->state = WIDGET_FB_STATE_CREATED;
+		slot->refcnt = idx;
+		slot->info = (void *)((long)buffer - (long)slot);
+	}
+}
+
 static inline int load_shm_buffer(struct buffer_info *info)
 {
 	int id;
 	int size;
+	int class_size;
 	widget_fb_t buffer; /* Just for getting a size */
 	char *new_id;
 	int len;
@@ -312,20 +584,11 @@ static inline int load_shm_buffer(struct buffer_info *info)
 		return WIDGET_ERROR_INVALID_PARAMETER;
 	}
 
-	id = shmget(IPC_PRIVATE, size + sizeof(*buffer), IPC_CREAT | 0666);
-	if (id < 0) {
-		ErrPrint("shmget: %d\n", errno);
-		return WIDGET_ERROR_FAULT;
-	}
-
-	buffer = shmat(id, NULL, 0);
-	if (buffer == (void *)-1) {
-		ErrPrint("%s shmat: %d\n", info->id, errno);
-
-		if (shmctl(id, IPC_RMID, 0) < 0) {
-			ErrPrint("%s shmctl: %d\n", info->id, errno);
-		}
+	class_size = shm_class_size(shm_data_size(info, size) + sizeof(*buffer));
 
+	buffer = acquire_shm_segment(class_size, &id);
+	if (!buffer) {
+		ErrPrint("%s Failed to get a segment\n", info->id);
 		return WIDGET_ERROR_FAULT;
 	}
 
@@ -334,27 +597,122 @@ static inline int load_shm_buffer(struct buffer_info *info)
 	buffer->state = WIDGET_FB_STATE_CREATED; /*!< Needless */
 	buffer->info = (void *)((long)size); /*!< Use this field to indicates the size of SHM */
 
+	if (info->slots > 1) {
+		init_shm_ring(info, buffer, size);
+	}
+
 	len = strlen(SCHEMA_SHM) + 30; /* strlen("shm://") + 30 */
 
 	new_id = malloc(len);
 	if (!new_id) {
 		ErrPrint("malloc: %d\n", errno);
-		if (shmdt(buffer) < 0) {
-			ErrPrint("shmdt: %d\n", errno);
+		release_shm_segment(id, buffer, class_size);
+		return WIDGET_ERROR_OUT_OF_MEMORY;
+	}
+
+	/*!
+	 * \note
+	 * A recycled segment has the same SHM id, the serial makes the buffer id different from the previous one,
+	 * so the viewers re-attach it. they get the SHM id using sscanf(SCHEMA_SHM "%d"), the serial is ignored.
+	 */
+	if (info->slots > 1) {
+		snprintf(new_id, len, SCHEMA_SHM "%d#%u%c%d", id, ++s_info.shm_serial, SHM_RING_DELIM, info->slots);
+	} else {
+		snprintf(new_id, len, SCHEMA_SHM "%d#%u", id, ++s_info.shm_serial);
+	}
+
+	DbgFree(info->id);
+	info->id = new_id;
+	info->buffer = buffer;
+	info->is_loaded = 1;
+
+	if (info->slots > 1) {
+		s_info.ring_list = eina_list_append(s_info.ring_list, info);
+	}
+
+	return WIDGET_ERROR_NONE;
+}
+
+static inline int load_memfd_buffer(struct buffer_info *info)
+{
+	widget_fb_t buffer;
+	char *new_id;
+	int size;
+	int len;
+	int fd;
+
+	size = info->w * info->h * info->pixel_size;
+	if (!size) {
+		ErrPrint("Invalid buffer size\n");
+		return WIDGET_ERROR_INVALID_PARAMETER;
+	}
+
+	len = strlen(SCHEMA_MEMFD) + 30; /* strlen("memfd://") + 30 */
+
+	new_id = malloc(len);
+	if (!new_id) {
+		ErrPrint("malloc: %d\n", errno);
+		return WIDGET_ERROR_OUT_OF_MEMORY;
+	}
+
+	/*!
+	 * \note
+	 * The id is used for finding the buffer when a provider or a viewer requests its fd.
+	 */
+	snprintf(new_id, len, SCHEMA_MEMFD "%u", ++s_info.memfd_serial);
+
+	fd = memfd_create("widget-buffer", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (fd < 0) {
+		ErrPrint("memfd_create: %d\n", errno);
+		DbgFree(new_id);
+		return WIDGET_ERROR_FAULT;
+	}
+
+	if (ftruncate(fd, size + sizeof(*buffer)) < 0) {
+		ErrPrint("ftruncate: %d\n", errno);
+		if (close(fd) < 0) {
+			ErrPrint("close: %d\n", errno);
 		}
+		DbgFree(new_id);
+		return WIDGET_ERROR_FAULT;
+	}
 
-		if (shmctl(id, IPC_RMID, 0) < 0) {
-			ErrPrint("shmctl: %d\n", errno);
+	/*!
+	 * \note
+	 * Nobody can change the size of it anymore,
+	 * so the provider and viewers do not need to care of the SIGBUS from their mapping.
+	 */
+	if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0) {
+		ErrPrint("fcntl: %d\n", errno);
+	}
+
+	buffer = mmap(NULL, size + sizeof(*buffer), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (buffer == MAP_FAILED) {
+		ErrPrint("mmap: %d\n", errno);
+		if (close(fd) < 0) {
+			ErrPrint("close: %d\n", errno);
 		}
+		DbgFree(new_id);
+		return WIDGET_ERROR_FAULT;
+	}
 
-		return WIDGET_ERROR_OUT_OF_MEMORY;
+	buffer->type = WIDGET_FB_TYPE_MEMFD;
+	buffer->refcnt = 0; /*!< WIDGET_FB_MEMFD_SEQ(), nothing is published yet */
+	buffer->state = WIDGET_FB_STATE_CREATED;
+	buffer->info = (void *)((long)size); /*!< Size of the pixels, same as the SHM */
+
+	if (!s_info.memfd_table) {
+		s_info.memfd_table = eina_hash_string_superfast_new(NULL);
 	}
 
-	snprintf(new_id, len, SCHEMA_SHM "%d", id);
+	if (s_info.memfd_table) {
+		eina_hash_add(s_info.memfd_table, new_id, info);
+	}
 
 	DbgFree(info->id);
 	info->id = new_id;
 	info->buffer = buffer;
+	info->fd = fd;
 	info->is_loaded = 1;
 	return WIDGET_ERROR_NONE;
 }
@@ -419,7 +777,7 @@ EAPI int buffer_handler_load(struct buffer_info *info)
 		return WIDGET_ERROR_NONE;
 	}
 
-	switch (info->type) {
+	switch ((int)info->type) {
 	case WIDGET_FB_TYPE_FILE:
 		ret = load_file_buffer(info);
 		if (script_handler_buffer_info(instance_gbar_script(info->inst)) != info && instance_gbar_buffer(info->inst) != info) {
@@ -434,6 +792,13 @@ EAPI int buffer_handler_load(struct buffer_info *info)
 		}
 		info->lock_info = widget_service_create_lock(instance_id(info->inst), type, WIDGET_LOCK_WRITE);
 		break;
+	case WIDGET_FB_TYPE_MEMFD:
+		ret = load_memfd_buffer(info);
+		if (script_handler_buffer_info(instance_gbar_script(info->inst)) != info && instance_gbar_buffer(info->inst) != info) {
+			type = WIDGET_TYPE_WIDGET;
+		}
+		info->lock_info = widget_service_create_lock(instance_id(info->inst), type, WIDGET_LOCK_WRITE);
+		break;
 	case WIDGET_FB_TYPE_PIXMAP:
 		ret = load_pixmap_buffer(info);
 		break;
@@ -460,6 +825,13 @@ static inline int unload_file_buffer(struct buffer_info *info)
 	DbgFree(info->buffer);
 	info->buffer = NULL;
 
+	if (info->fd >= 0) {
+		if (close(info->fd) < 0) {
+			ErrPrint("close: %d\n", errno);
+		}
+		info->fd = -1;
+	}
+
 	path = widget_util_uri_to_path(info->id);
 	if (path && unlink(path) < 0) {
 		ErrPrint("unlink: %s\n", errno);
@@ -472,6 +844,7 @@ static inline int unload_file_buffer(struct buffer_info *info)
 
 static inline int unload_shm_buffer(struct buffer_info *info)
 {
+	widget_fb_t buffer;
 	int id;
 	char *new_id;
 
@@ -493,14 +866,53 @@ static inline int unload_shm_buffer(struct buffer_info *info)
 		return WIDGET_ERROR_INVALID_PARAMETER;
 	}
 
-	if (shmdt(info->buffer) < 0) {
-		ErrPrint("shmdt: %d\n", errno);
+	buffer = info->buffer;
+	if (info->slots > 1) {
+		struct shm_ring *ring;
+
+		ring = SHM_RING(buffer);
+		DbgPrint("%s frames: %u, dropped: %u, skipped: %u\n", info->id, SHM_RING_LATEST_SEQ(ring->latest), ring->dropped, ring->skipped);
+		s_info.ring_list = eina_list_remove(s_info.ring_list, info);
 	}
+	release_shm_segment(id, buffer, shm_class_size(shm_data_size(info, (int)((long)buffer->info)) + sizeof(*buffer)));
 
-	if (shmctl(id, IPC_RMID, 0) < 0) {
-		ErrPrint("shmctl: %d\n", errno);
+	info->buffer = NULL;
+
+	DbgFree(info->id);
+	info->id = new_id;
+	return WIDGET_ERROR_NONE;
+}
+
+static inline int unload_memfd_buffer(struct buffer_info *info)
+{
+	widget_fb_t buffer;
+	char *new_id;
+
+	new_id = strdup(SCHEMA_MEMFD "-1");
+	if (!new_id) {
+		ErrPrint("strdup: %d\n", errno);
+		return WIDGET_ERROR_OUT_OF_MEMORY;
 	}
 
+	if (s_info.memfd_table) {
+		eina_hash_del_by_key(s_info.memfd_table, info->id);
+	}
+
+	/*!
+	 * \note
+	 * The provider and viewers keep their mapping until they destroy their FB,
+	 * the memory is released after all of them are unmapped.
+	 */
+	buffer = info->buffer;
+	if (munmap(buffer, WIDGET_FB_MEMFD_SIZE(buffer) + sizeof(*buffer)) < 0) {
+		ErrPrint("munmap: %d\n", errno);
+	}
+
+	if (close(info->fd) < 0) {
+		ErrPrint("close: %d\n", errno);
+	}
+
+	info->fd = -1;
 	info->buffer = NULL;
 
 	DbgFree(info->id);
@@ -563,7 +975,7 @@ EAPI int buffer_handler_unload(struct buffer_info *info)
 		return WIDGET_ERROR_INVALID_PARAMETER;
 	}
 
-	switch (info->type) {
+	switch ((int)info->type) {
 	case WIDGET_FB_TYPE_FILE:
 		widget_service_destroy_lock(info->lock_info, 1);
 		info->lock_info = NULL;
@@ -574,6 +986,11 @@ EAPI int buffer_handler_unload(struct buffer_info *info)
 		info->lock_info = NULL;
 		ret = unload_shm_buffer(info);
 		break;
+	case WIDGET_FB_TYPE_MEMFD:
+		widget_service_destroy_lock(info->lock_info, 1);
+		info->lock_info = NULL;
+		ret = unload_memfd_buffer(info);
+		break;
 	case WIDGET_FB_TYPE_PIXMAP:
 		ret = unload_pixmap_buffer(info);
 		break;
@@ -947,16 +1364,144 @@ EAPI struct inst_info *buffer_handler_instance(struct buffer_info *info)
 	return info->inst;
 }
 
-EAPI void buffer_handler_flush(struct buffer_info *info)
+/*!
+ * \brief
+ * Clip the region by the size of a buffer.
+ * If the width or height is not positive, whole buffer is selected.
+ * \return 0 if there is nothing to flush
+ */
+static int clip_region(struct buffer_info *info, int *x, int *y, int *w, int *h)
 {
-	int fd;
+	int ex;
+	int ey;
+
+	if (*w <= 0 || *h <= 0) {
+		*x = 0;
+		*y = 0;
+		*w = info->w;
+		*h = info->h;
+		return *w > 0 && *h > 0;
+	}
+
+	ex = *x + *w;
+	ey = *y + *h;
+
+	*x = *x < 0 ? 0 : *x;
+	*y = *y < 0 ? 0 : *y;
+	ex = ex > info->w ? info->w : ex;
+	ey = ey > info->h ? info->h : ey;
+
+	if (ex <= *x || ey <= *y) {
+		return 0;
+	}
+
+	*w = ex - *x;
+	*h = ey - *y;
+	return 1;
+}
+
+EAPI void buffer_handler_damage(struct buffer_info *info, int x, int y, int w, int h)
+{
+	int ex;
+	int ey;
+
+	if (!info || w <= 0 || h <= 0) {
+		return;
+	}
+
+	if (info->damage.w <= 0 || info->damage.h <= 0) {
+		info->damage.x = x;
+		info->damage.y = y;
+		info->damage.w = w;
+		info->damage.h = h;
+		return;
+	}
+
+	ex = info->damage.x + info->damage.w;
+	ey = info->damage.y + info->damage.h;
+	ex = ex > x + w ? ex : x + w;
+	ey = ey > y + h ? ey : y + h;
+
+	info->damage.x = info->damage.x < x ? info->damage.x : x;
+	info->damage.y = info->damage.y < y ? info->damage.y : y;
+	info->damage.w = ex - info->damage.x;
+	info->damage.h = ey - info->damage.y;
+}
+
+HAPI void buffer_handler_damaged_region(struct buffer_info *info, int *x, int *y, int *w, int *h)
+{
+	*x = info->damage.x;
+	*y = info->damage.y;
+	*w = info->damage.w;
+	*h = info->damage.h;
+
+	if (!clip_region(info, x, y, w, h)) {
+		/* Damage is not reported, assume that the whole buffer is updated */
+		*x = 0;
+		*y = 0;
+		*w = info->w;
+		*h = info->h;
+	}
+
+	info->damage.x = 0;
+	info->damage.y = 0;
+	info->damage.w = 0;
+	info->damage.h = 0;
+}
+
+/*!
+ * \note
+ * Only rows in the region are written, the file is kept opened until the buffer is unloaded.
+ */
+static void flush_file(struct buffer_info *info, widget_fb_t buffer, int y, int h)
+{
+	const char *path;
+	off_t offset;
+	int stride;
 	int size;
+
+	if (info->fd < 0) {
+		path = widget_util_uri_to_path(info->id);
+		if (!path) {
+			ErrPrint("Invalid id: [%s]\n", info->id);
+			return;
+		}
+
+		info->fd = open(path, O_WRONLY | O_CREAT, 0644);
+		if (info->fd < 0) {
+			ErrPrint("%s open: %d\n", path, errno);
+			return;
+		}
+
+		/* Newly opened file should have the whole frame */
+		y = 0;
+		h = info->h;
+	}
+
+	stride = info->w * info->pixel_size;
+	offset = (off_t)y * stride;
+	size = h * stride;
+
+	widget_service_acquire_lock(info->lock_info);
+	if (pwrite(info->fd, (char *)buffer->data + offset, size, offset) != size) {
+		ErrPrint("pwrite: %d\n", errno);
+	}
+	widget_service_release_lock(info->lock_info);
+}
+
+EAPI void buffer_handler_flush(struct buffer_info *info, int x, int y, int w, int h)
+{
 	widget_fb_t buffer;
 
 	if (!info || !info->buffer) {
 		return;
 	}
 
+	if (!clip_region(info, &x, &y, &w, &h)) {
+		DbgPrint("Flush nothing\n");
+		return;
+	}
+
 	buffer = info->buffer;
 
 	if (buffer->type == WIDGET_FB_TYPE_PIXMAP) {
@@ -966,31 +1511,70 @@ EAPI void buffer_handler_flush(struct buffer_info *info)
 		 * Not supported for wayland or this should be ported correctly
 		 */
 	} else if (buffer->type == WIDGET_FB_TYPE_FILE) {
-		fd = open(widget_util_uri_to_path(info->id), O_WRONLY | O_CREAT, 0644);
-		if (fd < 0) {
-			ErrPrint("%s open falied: %d\n", widget_util_uri_to_path(info->id), errno);
-			return;
-		}
-
-		size = info->w * info->h * info->pixel_size;
-		widget_service_acquire_lock(info->lock_info);
-		if (write(fd, info->buffer, size) != size) {
-			ErrPrint("write: %d\n", errno);
-		}
-		widget_service_release_lock(info->lock_info);
-
-		if (close(fd) < 0) {
-			ErrPrint("close: %d\n", errno);
-		}
+		flush_file(info, buffer, y, h);
+	} else if (buffer->type == WIDGET_FB_TYPE_MEMFD) {
+		/*!
+		 * \note
+		 * Viewers are reading the same pages, publish the frame only.
+		 */
+		WIDGET_FB_MEMFD_PUBLISH(buffer);
 	} else {
 		DbgPrint("Flush nothing\n");
 	}
 }
 
+HAPI int buffer_handler_set_slots(struct buffer_info *info, int slots)
+{
+	if (!info || slots < 0 || slots > SHM_RING_MAX_SLOTS) {
+		return WIDGET_ERROR_INVALID_PARAMETER;
+	}
+
+	if (info->is_loaded) {
+		ErrPrint("%s is loaded already\n", info->id);
+		return WIDGET_ERROR_RESOURCE_BUSY;
+	}
+
+	/*!
+	 * \note
+	 * Only the SHM can be N-buffered, the others ignore this.
+	 * The provider cannot publish a frame while the viewer is reading the only slot, so 1 slot is not used.
+	 */
+	info->slots = slots > 1 ? slots : 0;
+	return WIDGET_ERROR_NONE;
+}
+
+HAPI struct buffer_info *buffer_handler_find_memfd(const char *id)
+{
+	if (!id || !s_info.memfd_table) {
+		return NULL;
+	}
+
+	return eina_hash_find(s_info.memfd_table, id);
+}
+
+HAPI int buffer_handler_fd(struct buffer_info *info)
+{
+	if (!info || !info->is_loaded || info->type != WIDGET_FB_TYPE_MEMFD) {
+		return WIDGET_ERROR_INVALID_PARAMETER;
+	}
+
+	return info->fd;
+}
+
 HAPI int buffer_handler_init(void)
 {
 	int ret;
 
+	if (setting_add_oom_event_callback(shm_oom_cb, NULL) != WIDGET_ERROR_NONE) {
+		ErrPrint("Failed to add the OOM callback, SHM segments are kept even if the memory is low\n");
+	}
+
+	s_info.shm_pool_disabled = (setting_oom_level() == OOM_TYPE_LOW);
+
+	if (client_global_event_handler_add(CLIENT_GLOBAL_EVENT_DESTROY, shm_ring_client_destroyed_cb, NULL) != WIDGET_ERROR_NONE) {
+		ErrPrint("Failed to add the client callback, pins of the N-buffered SHM are not given back\n");
+	}
+
 	if (WIDGET_CONF_USE_SW_BACKEND) {
 		DbgPrint("Fallback to the S/W Backend\n");
 		return WIDGET_ERROR_NONE;
@@ -1014,6 +1598,15 @@ HAPI int buffer_handler_init(void)
 
 HAPI int buffer_handler_fini(void)
 {
+	client_global_event_handler_del(CLIENT_GLOBAL_EVENT_DESTROY, shm_ring_client_destroyed_cb, NULL);
+	setting_del_oom_event_callback(shm_oom_cb, NULL);
+	flush_shm_pool(0, 0);
+
+	if (s_info.memfd_table) {
+		eina_hash_free(s_info.memfd_table);
+		s_info.memfd_table = NULL;
+	}
+
 	if (s_info.slp_bufmgr) {
 		tbm_bufmgr_deinit(s_info.slp_bufmgr);
 		s_info.slp_bufmgr = NULL;
@@ -1262,9 +1855,10 @@ EAPI int buffer_handler_stride(struct buffer_info *info)
 		return WIDGET_ERROR_INVALID_PARAMETER;
 	}
 
-	switch (info->type) {
+	switch ((int)info->type) {
 	case WIDGET_FB_TYPE_FILE:
 	case WIDGET_FB_TYPE_SHM:
+	case WIDGET_FB_TYPE_MEMFD:
 	case WIDGET_FB_TYPE_PIXMAP:
 		stride = info->w * info->pixel_size;
 		break;
@@ -1335,7 +1929,20 @@ HAPI struct buffer_info *buffer_handler_create(struct inst_info *inst, enum widg
 		return NULL;
 	}
 
-	switch (type) {
+	switch ((int)type) {
+	case WIDGET_FB_TYPE_MEMFD:
+		if (pixel_size != WIDGET_CONF_DEFAULT_PIXELS) {
+			DbgPrint("MEMFD only supportes %d bytes pixels (requested: %d)\n", WIDGET_CONF_DEFAULT_PIXELS, pixel_size);
+			pixel_size = WIDGET_CONF_DEFAULT_PIXELS;
+		}
+
+		info->id = strdup(SCHEMA_MEMFD "-1");
+		if (!info->id) {
+			ErrPrint("strdup: %d\n", errno);
+			DbgFree(info);
+			return NULL;
+		}
+		break;
 	case WIDGET_FB_TYPE_SHM:
 		if (pixel_size != WIDGET_CONF_DEFAULT_PIXELS) {
 			DbgPrint("SHM only supportes %d bytes pixels (requested: %d)\n", WIDGET_CONF_DEFAULT_PIXELS, pixel_size);
@@ -1385,6 +1992,11 @@ HAPI struct buffer_info *buffer_handler_create(struct inst_info *inst, enum widg
 	info->inst = inst;
 	info->buffer = NULL;
 	info->data = NULL;
+	info->fd = -1;
+	info->damage.x = 0;
+	info->damage.y = 0;
+	info->damage.w = 0;
+	info->damage.h = 0;
 
 	return info;
 }
@@ -16,6 +16,8 @@
 
 #include <stdio.h>
 #include <errno.h>
+#include <string.h>
+#include <ctype.h> /* tolower */
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -58,12 +60,22 @@ static struct {
 	Eina_List *create_event_list;
 	Eina_List *destroy_event_list;
 
+	Eina_Hash *pid_table; /*!< pid -> client_node */
+	Eina_Hash *direct_addr_table; /*!< direct_addr -> client_node */
+	Eina_Hash *group_table; /*!< "cluster/category" -> list of subscribers, a client is listed once per subscription */
+	Eina_Hash *category_table; /*!< category -> list of subscribers */
+	unsigned int browse_seq; /*!< To visit each subscriber only once in a browsing */
 } s_info = {
 	.client_list = NULL,
 	.nr_of_paused_clients = 0,
 	.in_event_process = GLOBAL_EVENT_PROCESS_IDLE,
 	.create_event_list = NULL,
 	.destroy_event_list = NULL,
+	.pid_table = NULL,
+	.direct_addr_table = NULL,
+	.group_table = NULL,
+	.category_table = NULL,
+	.browse_seq = 0,
 };
 
 struct subscribe_item {	/* Cluster & Sub-cluster. related with Context-aware service */
@@ -118,8 +130,213 @@ struct client_node {
 		char *addr;
 		int fd;
 	} direct;
+
+	unsigned int browse_seq; /*!< Sequence of the last browsing which visits this client */
 };
 
+/*!
+ * \brief
+ * Subscriptions are compared case-insensitively, so the keys of the subscription tables are lowercased.
+ * A subscription of the "*" cluster matches every group, regardless of its category.
+ */
+static char *make_subscribe_key(const char *cluster, const char *category)
+{
+	char *key;
+	char *ptr;
+	int len;
+
+	if (cluster && !strcmp(cluster, "*")) {
+		category = "*";
+	}
+
+	len = (cluster ? strlen(cluster) : 0) + strlen(category) + 2;
+	key = malloc(len);
+	if (!key) {
+		ErrPrint("malloc: %d\n", errno);
+		return NULL;
+	}
+
+	if (cluster) {
+		snprintf(key, len, "%s/%s", cluster, category);
+	} else {
+		snprintf(key, len, "%s", category);
+	}
+
+	for (ptr = key; *ptr; ptr++) {
+		*ptr = tolower(*ptr);
+	}
+
+	return key;
+}
+
+static void subscriber_add(Eina_Hash **table, const char *cluster, const char *category, struct client_node *client)
+{
+	Eina_List *list;
+	char *key;
+
+	if (!*table) {
+		*table = eina_hash_string_superfast_new(NULL);
+		if (!*table) {
+			ErrPrint("Failed to create a table of subscribers\n");
+			return;
+		}
+	}
+
+	key = make_subscribe_key(cluster, category);
+	if (!key) {
+		return;
+	}
+
+	list = eina_hash_find(*table, key);
+	list = eina_list_append(list, client);
+	eina_hash_set(*table, key, list);
+	DbgFree(key);
+}
+
+static void subscriber_del(Eina_Hash *table, const char *cluster, const char *category, struct client_node *client)
+{
+	Eina_List *list;
+	char *key;
+
+	if (!table) {
+		return;
+	}
+
+	key = make_subscribe_key(cluster, category);
+	if (!key) {
+		return;
+	}
+
+	list = eina_hash_find(table, key);
+	list = eina_list_remove(list, client);
+	if (list) {
+		eina_hash_set(table, key, list);
+	} else {
+		eina_hash_del_by_key(table, key);
+	}
+	DbgFree(key);
+}
+
+/*!
+ * \brief
+ * Append subscribers of the key which are not visited yet in this browsing.
+ * Collected clients are referenced, callbacks of the browsing can destroy any clients.
+ */
+static Eina_List *collect_subscribers(Eina_List *result, Eina_Hash *table, const char *cluster, const char *category, unsigned int seq, int *count)
+{
+	struct client_node *client;
+	Eina_List *list;
+	Eina_List *l;
+	char *key;
+
+	if (!table) {
+		return result;
+	}
+
+	key = make_subscribe_key(cluster, category);
+	if (!key) {
+		return result;
+	}
+
+	list = eina_hash_find(table, key);
+	DbgFree(key);
+
+	EINA_LIST_FOREACH(list, l, client) {
+		if (client->browse_seq == seq) {
+			continue;
+		}
+
+		client->browse_seq = seq;
+		if (count) {
+			(*count)++;
+		} else {
+			result = eina_list_append(result, client_ref(client));
+		}
+	}
+
+	return result;
+}
+
+static int invoke_subscribers(Eina_List *subscribers, int (*cb)(struct client_node *client, void *data), void *data)
+{
+	struct client_node *client;
+	int canceled = 0;
+	int cnt = 0;
+
+	EINA_LIST_FREE(subscribers, client) {
+		if (!canceled) {
+			if (cb(client, data) < 0) {
+				canceled = 1;
+			} else {
+				cnt++;
+			}
+		}
+
+		(void)client_unref(client);
+	}
+
+	return canceled ? WIDGET_ERROR_CANCELED : cnt;
+}
+
+static void client_table_del(Eina_Hash *table, const void *key, struct client_node *client)
+{
+	struct client_node *item;
+	Eina_List *l;
+
+	if (!table || eina_hash_find(table, key) != client) {
+		return;
+	}
+
+	eina_hash_del_by_key(table, key);
+
+	/* Another one which has the same key is indexed instead */
+	EINA_LIST_FOREACH(s_info.client_list, l, item) {
+		if (item == client) {
+			continue;
+		}
+
+		if (table == s_info.pid_table && item->pid == client->pid) {
+			eina_hash_add(table, &item->pid, item);
+			break;
+		}
+
+		if (table == s_info.direct_addr_table && item->direct.addr && !strcmp(item->direct.addr, client->direct.addr)) {
+			eina_hash_add(table, item->direct.addr, item);
+			break;
+		}
+	}
+}
+
+/*!
+ * \note
+ * Every change of the pid has to be done via this,
+ * The pid_table should not keep the stale key of a client.
+ */
+static void set_pid(struct client_node *client, pid_t pid)
+{
+	if (client->pid > 0) {
+		client_table_del(s_info.pid_table, &client->pid, client);
+	}
+
+	client->pid = pid;
+
+	if (pid <= 0) {
+		return;
+	}
+
+	if (!s_info.pid_table) {
+		s_info.pid_table = eina_hash_int32_new(NULL);
+		if (!s_info.pid_table) {
+			ErrPrint("Failed to create a table of pids\n");
+			return;
+		}
+	}
+
+	if (!eina_hash_find(s_info.pid_table, &client->pid)) {
+		eina_hash_add(s_info.pid_table, &client->pid, client);
+	}
+}
+
 static inline void invoke_global_destroyed_cb(struct client_node *client)
 {
 	Eina_List *l;
@@ -248,12 +465,14 @@ static inline void destroy_client_data(struct client_node *client)
 	}
 
 	EINA_LIST_FREE(client->subscribe_list, item) {
+		subscriber_del(s_info.group_table, item->cluster, item->category, client);
 		DbgFree(item->cluster);
 		DbgFree(item->category);
 		DbgFree(item);
 	}
 
 	EINA_LIST_FREE(client->category_subscribe_list, category_item) {
+		subscriber_del(s_info.category_table, NULL, category_item->category, client);
 		DbgFree(category_item->category);
 		DbgFree(category_item);
 	}
@@ -262,7 +481,10 @@ static inline void destroy_client_data(struct client_node *client)
 		s_info.nr_of_paused_clients--;
 	}
 
+	set_pid(client, (pid_t)-1);
+
 	if (client->direct.addr) {
+		client_table_del(s_info.direct_addr_table, client->direct.addr, client);
 		(void)unlink(client->direct.addr);
 		DbgFree(client->direct.addr);
 	}
@@ -297,7 +519,7 @@ static struct client_node *create_client_data(pid_t pid, const char *direct_addr
 		return NULL;
 	}
 
-	client->pid = pid;
+	client->pid = (pid_t)-1;
 	client->refcnt = 1;
 	client->direct.fd = -1;
 
@@ -321,6 +543,18 @@ static struct client_node *create_client_data(pid_t pid, const char *direct_addr
 
 	s_info.client_list = eina_list_append(s_info.client_list, client);
 
+	set_pid(client, pid);
+
+	if (client->direct.addr) {
+		if (!s_info.direct_addr_table) {
+			s_info.direct_addr_table = eina_hash_string_superfast_new(NULL);
+		}
+
+		if (s_info.direct_addr_table && !eina_hash_find(s_info.direct_addr_table, client->direct.addr)) {
+			eina_hash_add(s_info.direct_addr_table, client->direct.addr, client);
+		}
+	}
+
 	/*!
 	 * \note
 	 * Right after create a client ADT,
@@ -438,35 +672,21 @@ HAPI const pid_t const client_pid(const struct client_node *client)
 
 HAPI struct client_node *client_find_by_pid(pid_t pid)
 {
-	Eina_List *l;
-	struct client_node *client;
-
-	EINA_LIST_FOREACH(s_info.client_list, l, client) {
-		if (client->pid == pid) {
-			return client;
-		}
+	if (!s_info.pid_table) {
+		return NULL;
 	}
 
-	return NULL;
+	return eina_hash_find(s_info.pid_table, &pid);
 }
 
 HAPI struct client_node *client_find_by_rpc_handle(int handle)
 {
-	Eina_List *l;
-	struct client_node *client;
-
 	if (handle <= 0) {
 		ErrPrint("Invalid handle %d\n", handle);
 		return NULL;
 	}
 
-	EINA_LIST_FOREACH(s_info.client_list, l, client) {
-		if (client_rpc_handle(client) == handle) {
-			return client;
-		}
-	}
-
-	return NULL;
+	return client_rpc_find_by_handle(handle);
 }
 
 HAPI const int const client_count_paused(void)
@@ -493,7 +713,7 @@ HAPI struct client_node *client_deactivated_by_fault(struct client_node *client)
 
 	ErrPrint("Client[%p] is faulted(%d), pid(%d)\n", client, client->refcnt, client->pid);
 	client->faulted = 1;
-	client->pid = (pid_t)-1;
+	set_pid(client, (pid_t)-1);
 
 	invoke_deactivated_cb(client);
 	client = client_destroy(client);
@@ -827,6 +1047,7 @@ HAPI int client_subscribe_category(struct client_node *client, const char *categ
 
 	DbgPrint("Subscribe category[%s]\n", item->category);
 	client->category_subscribe_list = eina_list_append(client->category_subscribe_list, item);
+	subscriber_add(&s_info.category_table, NULL, item->category, client);
 	return WIDGET_ERROR_NONE;
 }
 
@@ -844,6 +1065,7 @@ HAPI int client_unsubscribe_category(struct client_node *client, const char *cat
 	EINA_LIST_FOREACH_SAFE(client->category_subscribe_list, l, n, item) {
 		if (!strcasecmp(category, item->category)) {
 			client->category_subscribe_list = eina_list_remove(client->category_subscribe_list, item);
+			subscriber_del(s_info.category_table, NULL, item->category, client);
 			DbgFree(item->category);
 			DbgFree(item);
 			return WIDGET_ERROR_NONE;
@@ -904,6 +1126,7 @@ HAPI int client_subscribe_group(struct client_node *client, const char *cluster,
 	}
 
 	client->subscribe_list = eina_list_append(client->subscribe_list, item);
+	subscriber_add(&s_info.group_table, item->cluster, item->category, client);
 	return WIDGET_ERROR_NONE;
 }
 
@@ -921,6 +1144,7 @@ HAPI int client_unsubscribe_group(struct client_node *client, const char *cluste
 	EINA_LIST_FOREACH_SAFE(client->subscribe_list, l, n, item) {
 		if (!strcasecmp(cluster, item->cluster) && !strcasecmp(category, item->category)) {
 			client->subscribe_list = eina_list_remove(client->subscribe_list, item);
+			subscriber_del(s_info.group_table, item->cluster, item->category, client);
 			DbgFree(item->cluster);
 			DbgFree(item->category);
 			DbgFree(item);
@@ -964,67 +1188,49 @@ HAPI int client_is_subscribed_group(struct client_node *client, const char *clus
 
 HAPI int client_browse_group_list(const char *cluster, const char *category, int (*cb)(struct client_node *client, void *data), void *data)
 {
-	Eina_List *l;
-	struct client_node *client;
-	int cnt;
+	Eina_List *subscribers;
+	unsigned int seq;
 
 	if (!cb || !cluster || !category) {
 		return WIDGET_ERROR_INVALID_PARAMETER;
 	}
 
-	cnt = 0;
-	EINA_LIST_FOREACH(s_info.client_list, l, client) {
-		if (!client_is_subscribed_group(client, cluster, category)) {
-			continue;
-		}
+	seq = ++s_info.browse_seq;
+	subscribers = collect_subscribers(NULL, s_info.group_table, "*", "*", seq, NULL);
+	subscribers = collect_subscribers(subscribers, s_info.group_table, cluster, "*", seq, NULL);
+	subscribers = collect_subscribers(subscribers, s_info.group_table, cluster, category, seq, NULL);
 
-		if (cb(client, data) < 0) {
-			return WIDGET_ERROR_CANCELED;
-		}
-
-		cnt++;
-	}
-
-	return cnt;
+	return invoke_subscribers(subscribers, cb, data);
 }
 
 HAPI int client_browse_category_list(const char *category, int (*cb)(struct client_node *client, void *data), void *data)
 {
-	Eina_List *l;
-	struct client_node *client;
-	int cnt;
+	Eina_List *subscribers;
 
 	if (!cb || !category) {
 		return WIDGET_ERROR_INVALID_PARAMETER;
 	}
 
-	cnt = 0;
-	EINA_LIST_FOREACH(s_info.client_list, l, client) {
-		if (!client_is_subscribed_by_category(client, category)) {
-			continue;
-		}
-
-		if (cb(client, data) < 0) {
-			return WIDGET_ERROR_CANCELED;
-		}
-
-		cnt++;
-	}
+	subscribers = collect_subscribers(NULL, s_info.category_table, NULL, category, ++s_info.browse_seq, NULL);
 
-	return cnt;
+	return invoke_subscribers(subscribers, cb, data);
 }
 
 HAPI int client_count_of_group_subscriber(const char *cluster, const char *category)
 {
-	Eina_List *l;
-	struct client_node *client;
+	unsigned int seq;
 	int cnt;
 
-	cnt = 0;
-	EINA_LIST_FOREACH(s_info.client_list, l, client) {
-		cnt += !!client_is_subscribed_group(client, cluster, category);
+	if (!cluster || !category) {
+		return 0;
 	}
 
+	cnt = 0;
+	seq = ++s_info.browse_seq;
+	(void)collect_subscribers(NULL, s_info.group_table, "*", "*", seq, &cnt);
+	(void)collect_subscribers(NULL, s_info.group_table, cluster, "*", seq, &cnt);
+	(void)collect_subscribers(NULL, s_info.group_table, cluster, category, seq, &cnt);
+
 	return cnt;
 }
 
@@ -1075,20 +1281,11 @@ HAPI int client_is_sdk_viewer(const struct client_node *client)
 
 HAPI struct client_node *client_find_by_direct_addr(const char *direct_addr)
 {
-	Eina_List *l;
-	struct client_node *client;
-
-	if (!direct_addr) {
+	if (!direct_addr || !s_info.direct_addr_table) {
 		return NULL;
 	}
 
-	EINA_LIST_FOREACH(s_info.client_list, l, client) {
-		if (client->direct.addr && !strcmp(client->direct.addr, direct_addr)) {
-			return client;
-		}
-	}
-
-	return NULL;
+	return eina_hash_find(s_info.direct_addr_table, direct_addr);
 }
 
 HAPI void client_set_direct_fd(struct client_node *client, int fd)
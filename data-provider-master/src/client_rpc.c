@@ -15,6 +15,7 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include <errno.h>
 
 #include <Eina.h>
@@ -27,6 +28,7 @@
 #include <widget_conf.h>
 #include <widget_service.h>
 #include <widget_service_internal.h>
+#include <widget_cmd_list.h>
 
 #include "client_life.h"
 #include "instance.h"
@@ -38,19 +40,25 @@
 #define RPC_TAG "rpc"
 
 /*!
- * \note
- * Static component information structure.
+ * \brief
+ * Maximum count of packets sent at once, whenever the socket of a client becomes writable.
+ * Every client gets the same quantum in a main loop iteration, so a busy client cannot starve others.
  */
-static struct info {
-	Eina_List *command_list; /*!< Packet Q: Before sending the request, all request commands will stay here */
-	Ecore_Timer *command_consumer; /*!< This timer will consuming the command Q. sending them to the specified client */
-} s_info = {
-	.command_list = NULL,
-	.command_consumer = NULL,
-};
+#define COMMAND_BATCH_MAX	32
+
+/*!
+ * \brief
+ * If a client does not drain its queue until this, it is regarded as hanged, new commands are dropped.
+ */
+#define COMMAND_QUEUE_MAX	1024
 
 struct client_rpc {
 	int handle; /*!< Handler for communication with client */
+
+	Eina_List *command_list; /*!< Packet Q: Before sending the request, all request commands will stay here */
+	int count; /*!< Count of commands in the Q */
+	Ecore_Fd_Handler *writable; /*!< Consuming the command Q, exists only if the Q is not empty */
+	int dropped; /*!< Count of dropped commands, for logging */
 };
 
 struct command {
@@ -58,6 +66,39 @@ struct command {
 	struct client_node *client; /*!< Target client. who should receive this command */
 };
 
+static struct {
+	Eina_Hash *handle_table; /*!< rpc handle -> client_node, only for connected clients */
+} s_info = {
+	.handle_table = NULL,
+};
+
+/*!
+ * \brief
+ * Every update of the rpc->handle should be done via this, to keep the handle table
+ */
+static void set_handle(struct client_node *client, struct client_rpc *rpc, int handle)
+{
+	if (rpc->handle > 0 && s_info.handle_table && eina_hash_find(s_info.handle_table, &rpc->handle) == client) {
+		eina_hash_del_by_key(s_info.handle_table, &rpc->handle);
+	}
+
+	rpc->handle = handle;
+
+	if (handle <= 0) {
+		return;
+	}
+
+	if (!s_info.handle_table) {
+		s_info.handle_table = eina_hash_int32_new(NULL);
+		if (!s_info.handle_table) {
+			ErrPrint("Failed to create a table of handles\n");
+			return;
+		}
+	}
+
+	eina_hash_set(s_info.handle_table, &handle, client);
+}
+
 /*!
  * \brief
  * Creating or Destroying command object
@@ -85,87 +126,198 @@ static inline void destroy_command(struct command *command)
 	DbgFree(command);
 }
 
-static inline int count_command(void)
-{
-	return eina_list_count(s_info.command_list);
-}
-
-static inline struct command *pop_command(void)
+static inline struct command *pop_command(struct client_rpc *rpc)
 {
 	struct command *command;
 
-	command = eina_list_nth(s_info.command_list, 0);
+	command = eina_list_data_get(rpc->command_list);
 	if (!command) {
 		return NULL;
 	}
 
-	s_info.command_list = eina_list_remove(s_info.command_list, command);
+	rpc->command_list = eina_list_remove_list(rpc->command_list, rpc->command_list);
+	rpc->count--;
 	return command;
 }
 
-static Eina_Bool command_consumer_cb(void *data)
+static void clear_command(struct client_rpc *rpc)
 {
 	struct command *command;
-	struct client_rpc *rpc;
-	int ret;
 
-	command = pop_command();
-	if (!command) {
-		s_info.command_consumer = NULL;
-		return ECORE_CALLBACK_CANCEL;
+	DbgPrint("Begin: Destroying command\n");
+	while ((command = pop_command(rpc))) {
+		destroy_command(command);
 	}
+	DbgPrint("End: Destroying command\n");
 
-	if (!command->client) {
-		DbgPrint("Has no client\n");
-		goto out;
+	if (rpc->writable) {
+		ecore_main_fd_handler_del(rpc->writable);
+		rpc->writable = NULL;
 	}
+}
 
-	if (client_is_faulted(command->client)) {
-		ErrPrint("Client[%p] is faulted, discard command\n", command->client);
-		goto out;
+static inline int is_update_command(struct packet *packet)
+{
+	static const unsigned int update_cmd[] = { CMD_WIDGET_UPDATED, CMD_GBAR_UPDATED };
+	int i;
+
+	for (i = 0; i < sizeof(update_cmd) / sizeof(update_cmd[0]); i++) {
+		if (!memcmp(packet_command(packet), &update_cmd[i], sizeof(update_cmd[i]))) {
+			return 1;
+		}
 	}
 
-	rpc = client_data(command->client, RPC_TAG);
-	if (!rpc) {
-		ErrPrint("Client is not activated\n");
-		goto out;
+	return 0;
+}
+
+/*!
+ * \brief
+ * Update events only tell the damaged region of a buffer,
+ * so a pending one can absorb a newer one of the same instance, by taking the union of regions.
+ * Searching is stopped by any other kind of command, to keep the order of events.
+ * \return 1 if the packet is merged
+ */
+static int merge_command(struct client_rpc *rpc, struct packet *packet)
+{
+	const char *pkgname;
+	const char *id;
+	const char *buffer_id;
+	const char *file;
+	const char *_pkgname;
+	const char *_id;
+	const char *_buffer_id;
+	const char *_file;
+	int x, y, w, h;
+	int _x, _y, _w, _h;
+	struct command *command;
+	struct packet *merged;
+	Eina_List *l;
+
+	if (!is_update_command(packet)) {
+		return 0;
 	}
 
-	if (rpc->handle < 0) {
-		DbgPrint("RPC is not initialized\n");
-		goto out;
+	if (packet_get(packet, "ssssiiii", &pkgname, &id, &buffer_id, &file, &x, &y, &w, &h) != 8) {
+		return 0;
 	}
 
-	ret = com_core_packet_send_only(rpc->handle, command->packet);
-	if (ret < 0) {
-		ErrPrint("Failed to send packet %d\n", ret);
+	EINA_LIST_REVERSE_FOREACH(rpc->command_list, l, command) {
+		if (!is_update_command(command->packet)) {
+			break;
+		}
+
+		if (memcmp(packet_command(command->packet), packet_command(packet), sizeof(unsigned int))) {
+			continue;
+		}
+
+		if (packet_get(command->packet, "ssssiiii", &_pkgname, &_id, &_buffer_id, &_file, &_x, &_y, &_w, &_h) != 8) {
+			continue;
+		}
+
+		if (strcmp(id, _id) || strcmp(pkgname, _pkgname) || strcmp(buffer_id, _buffer_id) || strcmp(file, _file)) {
+			continue;
+		}
+
+		_w = (_x + _w > x + w ? _x + _w : x + w);
+		_h = (_y + _h > y + h ? _y + _h : y + h);
+		_x = (_x < x ? _x : x);
+		_y = (_y < y ? _y : y);
+		_w -= _x;
+		_h -= _y;
+
+		merged = packet_create_noack(packet_command(packet), "ssssiiii", pkgname, id, buffer_id, file, _x, _y, _w, _h);
+		if (!merged) {
+			return 0;
+		}
+
+		packet_unref(command->packet);
+		command->packet = merged;
+		return 1;
 	}
 
-out:
-	destroy_command(command);
-	return ECORE_CALLBACK_RENEW;
+	return 0;
 }
 
-static inline void push_command(struct command *command)
+static void command_result_cb(int handle, const struct packet *packet, int status, void *data)
 {
-	s_info.command_list = eina_list_append(s_info.command_list, command);
+	if (status < 0) {
+		ErrPrint("Failed to send %s to client(%d): %d\n", packet_command(packet), handle, status);
+	}
+}
+
+static void send_command(struct client_rpc *rpc, struct command *command)
+{
+	int ret;
 
-	if (s_info.command_consumer) {
+	if (client_is_faulted(command->client)) {
+		ErrPrint("Client[%p] is faulted, discard command\n", command->client);
 		return;
 	}
 
-	s_info.command_consumer = ecore_timer_add(WIDGET_CONF_PACKET_TIME, command_consumer_cb, NULL);
-	if (!s_info.command_consumer) {
-		ErrPrint("Failed to add command consumer\n");
-		s_info.command_list = eina_list_remove(s_info.command_list, command);
+	/*!
+	 * \note
+	 * Packets are gathered and sent via one sendmsg by com_core_packet_batch_flush().
+	 */
+	ret = com_core_packet_batch_send(rpc->handle, command->packet, command_result_cb, NULL);
+	if (ret < 0) {
+		ErrPrint("Failed to send packet %d\n", ret);
+	}
+}
+
+static Eina_Bool command_consumer_cb(void *data, Ecore_Fd_Handler *handler)
+{
+	struct client_rpc *rpc = data;
+	struct command *command;
+	int count;
+
+	for (count = 0; count < COMMAND_BATCH_MAX && (command = pop_command(rpc)); count++) {
+		send_command(rpc, command);
 		destroy_command(command);
 	}
+
+	(void)com_core_packet_batch_flush(rpc->handle);
+
+	if (rpc->command_list) {
+		/* Wait for the next turn, other clients should be served first */
+		return ECORE_CALLBACK_RENEW;
+	}
+
+	rpc->writable = NULL;
+	return ECORE_CALLBACK_CANCEL;
+}
+
+static inline int push_command(struct client_rpc *rpc, struct command *command)
+{
+	if (rpc->count >= COMMAND_QUEUE_MAX) {
+		if (!(rpc->dropped++ % COMMAND_QUEUE_MAX)) {
+			ErrPrint("Client[%p] does not consume commands, drop (%d)\n", command->client, rpc->dropped);
+		}
+		return WIDGET_ERROR_RESOURCE_BUSY;
+	}
+
+	/*!
+	 * \note
+	 * Sending is started as soon as the socket becomes writable,
+	 * commands pushed in the same main loop iteration are sent together.
+	 */
+	if (!rpc->writable) {
+		rpc->writable = ecore_main_fd_handler_add(rpc->handle, ECORE_FD_WRITE, command_consumer_cb, rpc, NULL, NULL);
+		if (!rpc->writable) {
+			ErrPrint("Failed to add command consumer\n");
+			return WIDGET_ERROR_FAULT;
+		}
+	}
+
+	rpc->command_list = eina_list_append(rpc->command_list, command);
+	rpc->count++;
+	return WIDGET_ERROR_NONE;
 }
 
 HAPI int client_rpc_async_request(struct client_node *client, struct packet *packet)
 {
 	struct command *command;
 	struct client_rpc *rpc;
+	int ret;
 
 	if (!client || !packet) {
 		return WIDGET_ERROR_INVALID_PARAMETER;
@@ -180,6 +332,19 @@ HAPI int client_rpc_async_request(struct client_node *client, struct packet *pac
 	rpc = client_data(client, RPC_TAG);
 	if (!rpc) {
 		ErrPrint("Client[%p] is not ready for communication (%s)\n", client, packet_command(packet));
+		packet_unref(packet);
+		return WIDGET_ERROR_FAULT;
+	}
+
+	if (rpc->handle < 0) {
+		DbgPrint("RPC is not initialized\n");
+		packet_unref(packet);
+		return WIDGET_ERROR_FAULT;
+	}
+
+	if (merge_command(rpc, packet)) {
+		packet_unref(packet);
+		return WIDGET_ERROR_NONE;
 	}
 
 	command = create_command(client, packet);
@@ -188,17 +353,18 @@ HAPI int client_rpc_async_request(struct client_node *client, struct packet *pac
 		return WIDGET_ERROR_OUT_OF_MEMORY;
 	}
 
-	push_command(command);
+	ret = push_command(rpc, command);
+	if (ret < 0) {
+		destroy_command(command);
+	}
+
 	packet_unref(packet);
-	return WIDGET_ERROR_NONE;
+	return ret;
 }
 
 static int deactivated_cb(struct client_node *client, void *data)
 {
 	struct client_rpc *rpc;
-	struct command *command;
-	Eina_List *l;
-	Eina_List *n;
 
 	rpc = client_data(client, RPC_TAG);
 	if (!rpc) {
@@ -207,16 +373,9 @@ static int deactivated_cb(struct client_node *client, void *data)
 	}
 
 	DbgPrint("Reset handle for %d\n", client_pid(client));
-	rpc->handle = -1;
+	set_handle(client, rpc, -1);
 
-	DbgPrint("Begin: Destroying command\n");
-	EINA_LIST_FOREACH_SAFE(s_info.command_list, l, n, command) {
-		if (command->client == client) {
-			s_info.command_list = eina_list_remove(s_info.command_list, command);
-			destroy_command(command);
-		}
-	}
-	DbgPrint("End: Destroying command\n");
+	clear_command(rpc);
 
 	return WIDGET_ERROR_NONE;
 }
@@ -240,7 +399,6 @@ HAPI int client_rpc_init(struct client_node *client, int handle)
 	}
 
 	DbgPrint("CLIENT: New handle assigned for %d, %d (old: %d)\n", client_pid(client), handle, rpc->handle);
-	rpc->handle = handle;
 
 	ret = client_event_callback_add(client, CLIENT_EVENT_DEACTIVATE, deactivated_cb, NULL);
 	if (ret < 0) {
@@ -251,6 +409,8 @@ HAPI int client_rpc_init(struct client_node *client, int handle)
 			ErrPrint("What happens? (%p <> %p)\n", weird, rpc);
 		}
 		DbgFree(rpc);
+	} else {
+		set_handle(client, rpc, handle);
 	}
 
 	return ret;
@@ -266,6 +426,8 @@ HAPI int client_rpc_fini(struct client_node *client)
 	}
 
 	client_event_callback_del(client, CLIENT_EVENT_DEACTIVATE, deactivated_cb, NULL);
+	clear_command(rpc);
+	set_handle(client, rpc, -1);
 	DbgFree(rpc);
 	return WIDGET_ERROR_NONE;
 }
@@ -283,4 +445,13 @@ HAPI int client_rpc_handle(struct client_node *client)
 	return rpc->handle;
 }
 
+HAPI struct client_node *client_rpc_find_by_handle(int handle)
+{
+	if (handle <= 0 || !s_info.handle_table) {
+		return NULL;
+	}
+
+	return eina_hash_find(s_info.handle_table, &handle);
+}
+
 /* End of a file */
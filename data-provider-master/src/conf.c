@@ -3,6 +3,9 @@
 struct conf g_conf = {
 	.debug_mode = 0,
 	.slave_max_load = -1,
+	.slave_max_inflight = DEFAULT_SLAVE_MAX_INFLIGHT,
+	.shm_pool_max_size = DEFAULT_SHM_POOL_MAX_SIZE,
+	.shm_slots = DEFAULT_SHM_SLOTS,
 };
 
 /* End of a file */
@@ -272,7 +272,7 @@ static int viewer_deactivated_cb(struct client_node *client, void *data)
 
 	packet = packet_create_noack((const char *)&cmd, "sss", package_name(inst->info), inst->id, client_direct_addr(inst->client));
 	if (packet) {
-		if (slave_rpc_request_only(package_slave(inst->info), package_name(inst->info), packet, 0) < 0) {
+		if (slave_rpc_request_only(package_slave(inst->info), package_name(inst->info), packet, SLAVE_RPC_LANE_BACKGROUND) < 0) {
 			ErrPrint("Failed to send request to slave: %s\n", package_name(inst->info));
 			/*!
 			 * \note
@@ -304,7 +304,7 @@ static int pause_widget(struct inst_info *inst)
 		return WIDGET_ERROR_FAULT;
 	}
 
-	return slave_rpc_request_only(package_slave(inst->info), package_name(inst->info), packet, 0);
+	return slave_rpc_request_only(package_slave(inst->info), package_name(inst->info), packet, SLAVE_RPC_LANE_INTERACTIVE);
 }
 
 /*! \TODO Wake up the freeze'd timer */
@@ -319,7 +319,7 @@ static int resume_widget(struct inst_info *inst)
 		return WIDGET_ERROR_FAULT;
 	}
 
-	return slave_rpc_request_only(package_slave(inst->info), package_name(inst->info), packet, 0);
+	return slave_rpc_request_only(package_slave(inst->info), package_name(inst->info), packet, SLAVE_RPC_LANE_INTERACTIVE);
 }
 
 static inline int instance_recover_visible_state(struct inst_info *inst)
@@ -874,9 +874,9 @@ static inline void destroy_instance(struct inst_info *inst)
 	DbgFree(inst->cluster);
 	DbgFree(inst->content);
 	DbgFree(inst->title);
+	package_del_instance(inst->info, inst);
 	util_unlink(widget_util_uri_to_path(inst->id));
 	DbgFree(inst->id);
-	package_del_instance(inst->info, inst);
 	DbgFree(inst);
 
 	slave = slave_unload_instance(slave);
@@ -1616,6 +1616,8 @@ HAPI int instance_create_gbar_buffer(struct inst_info *inst, int pixels)
 		inst->gbar.canvas.buffer = buffer_handler_create(inst, s_info.env_buf_type, inst->gbar.width, inst->gbar.height, pixels);
 		if (!inst->gbar.canvas.buffer) {
 			ErrPrint("Failed to create GBAR Buffer\n");
+		} else {
+			(void)buffer_handler_set_slots(inst->gbar.canvas.buffer, g_conf.shm_slots);
 		}
 	}
 
@@ -1657,6 +1659,8 @@ HAPI int instance_create_widget_buffer(struct inst_info *inst, int pixels)
 		inst->widget.canvas.buffer = buffer_handler_create(inst, s_info.env_buf_type, inst->widget.width, inst->widget.height, pixels);
 		if (!inst->widget.canvas.buffer) {
 			ErrPrint("Failed to create WIDGET\n");
+		} else {
+			(void)buffer_handler_set_slots(inst->widget.canvas.buffer, g_conf.shm_slots);
 		}
 	}
 
@@ -1763,7 +1767,7 @@ HAPI int instance_destroy(struct inst_info *inst, widget_destroy_type_e type)
 	inst->requested_state = INST_DESTROYED;
 	inst->state = INST_REQUEST_TO_DESTROY;
 	inst->changing_state++;
-	return slave_rpc_async_request(package_slave(inst->info), package_name(inst->info), packet, deactivate_cb, instance_ref(inst), 0);
+	return slave_rpc_async_request(package_slave(inst->info), package_name(inst->info), packet, deactivate_cb, instance_ref(inst), SLAVE_RPC_LANE_BACKGROUND);
 }
 
 HAPI int instance_reload(struct inst_info *inst, widget_destroy_type_e type)
@@ -1834,7 +1838,7 @@ HAPI int instance_reload(struct inst_info *inst, widget_destroy_type_e type)
 	inst->requested_state = INST_ACTIVATED;
 	inst->state = INST_REQUEST_TO_DESTROY;
 	inst->changing_state++;
-	return slave_rpc_async_request(package_slave(inst->info), package_name(inst->info), packet, deactivate_cb, instance_ref(inst), 0);
+	return slave_rpc_async_request(package_slave(inst->info), package_name(inst->info), packet, deactivate_cb, instance_ref(inst), SLAVE_RPC_LANE_BACKGROUND);
 }
 
 /* Client Deactivated Callback */
@@ -2014,7 +2018,7 @@ HAPI int instance_reactivate(struct inst_info *inst)
 	inst->state = INST_REQUEST_TO_REACTIVATE;
 	inst->changing_state++;
 
-	return slave_rpc_async_request(package_slave(inst->info), package_name(inst->info), packet, reactivate_cb, instance_ref(inst), 1);
+	return slave_rpc_async_request(package_slave(inst->info), package_name(inst->info), packet, reactivate_cb, instance_ref(inst), SLAVE_RPC_LANE_URGENT);
 }
 
 HAPI int instance_activate(struct inst_info *inst)
@@ -2087,7 +2091,7 @@ HAPI int instance_activate(struct inst_info *inst)
 	 * \note
 	 * Try to activate a slave if it is not activated
 	 */
-	return slave_rpc_async_request(package_slave(inst->info), package_name(inst->info), packet, activate_cb, instance_ref(inst), 1);
+	return slave_rpc_async_request(package_slave(inst->info), package_name(inst->info), packet, activate_cb, instance_ref(inst), SLAVE_RPC_LANE_URGENT);
 }
 
 HAPI int instance_widget_update_begin(struct inst_info *inst, double priority, const char *content, const char *title)
@@ -2458,7 +2462,7 @@ HAPI int instance_set_update_mode(struct inst_info *inst, int active_update)
 		return WIDGET_ERROR_FAULT;
 	}
 
-	return slave_rpc_async_request(package_slave(inst->info), package_name(inst->info), packet, update_mode_cb, cbdata, 0);
+	return slave_rpc_async_request(package_slave(inst->info), package_name(inst->info), packet, update_mode_cb, cbdata, SLAVE_RPC_LANE_BACKGROUND);
 }
 
 HAPI int instance_active_update(struct inst_info *inst)
@@ -2654,7 +2658,7 @@ HAPI int instance_set_pinup(struct inst_info *inst, int pinup)
 		return WIDGET_ERROR_FAULT;
 	}
 
-	return slave_rpc_async_request(package_slave(inst->info), package_name(inst->info), packet, pinup_cb, cbdata, 0);
+	return slave_rpc_async_request(package_slave(inst->info), package_name(inst->info), packet, pinup_cb, cbdata, SLAVE_RPC_LANE_BACKGROUND);
 }
 
 HAPI int instance_freeze_updator(struct inst_info *inst)
@@ -2863,7 +2867,7 @@ HAPI int instance_resize(struct inst_info *inst, int w, int h)
 	}
 
 	DbgPrint("RESIZE: [%s] resize[%dx%d]\n", instance_id(inst), w, h);
-	ret = slave_rpc_async_request(package_slave(inst->info), package_name(inst->info), packet, resize_cb, cbdata, 0);
+	ret = slave_rpc_async_request(package_slave(inst->info), package_name(inst->info), packet, resize_cb, cbdata, SLAVE_RPC_LANE_INTERACTIVE);
 	return ret;
 }
 
@@ -2997,7 +3001,7 @@ HAPI int instance_set_period(struct inst_info *inst, double period)
 		return WIDGET_ERROR_FAULT;
 	}
 
-	return slave_rpc_async_request(package_slave(inst->info), package_name(inst->info), packet, set_period_cb, cbdata, 0);
+	return slave_rpc_async_request(package_slave(inst->info), package_name(inst->info), packet, set_period_cb, cbdata, SLAVE_RPC_LANE_BACKGROUND);
 }
 
 HAPI int instance_clicked(struct inst_info *inst, const char *event, double timestamp, double x, double y)
@@ -3022,7 +3026,7 @@ HAPI int instance_clicked(struct inst_info *inst, const char *event, double time
 		return WIDGET_ERROR_FAULT;
 	}
 
-	return slave_rpc_request_only(package_slave(inst->info), package_name(inst->info), packet, 0);
+	return slave_rpc_request_only(package_slave(inst->info), package_name(inst->info), packet, SLAVE_RPC_LANE_INTERACTIVE);
 }
 
 HAPI int instance_signal_emit(struct inst_info *inst, const char *signal, const char *part, double sx, double sy, double ex, double ey, double x, double y, int down)
@@ -3055,7 +3059,7 @@ HAPI int instance_signal_emit(struct inst_info *inst, const char *signal, const
 		return WIDGET_ERROR_FAULT;
 	}
 
-	return slave_rpc_request_only(slave, pkgname, packet, 0); 
+	return slave_rpc_request_only(slave, pkgname, packet, SLAVE_RPC_LANE_INTERACTIVE); 
 }
 
 HAPI int instance_text_signal_emit(struct inst_info *inst, const char *signal_name, const char *source, double sx, double sy, double ex, double ey)
@@ -3079,7 +3083,7 @@ HAPI int instance_text_signal_emit(struct inst_info *inst, const char *signal_na
 		return WIDGET_ERROR_FAULT;
 	}
 
-	return slave_rpc_request_only(package_slave(inst->info), package_name(inst->info), packet, 0);
+	return slave_rpc_request_only(package_slave(inst->info), package_name(inst->info), packet, SLAVE_RPC_LANE_INTERACTIVE);
 }
 
 static void change_group_cb(struct slave_node *slave, const struct packet *packet, void *data)
@@ -3178,7 +3182,7 @@ HAPI int instance_change_group(struct inst_info *inst, const char *cluster, cons
 		return WIDGET_ERROR_FAULT;
 	}
 
-	return slave_rpc_async_request(package_slave(inst->info), package_name(inst->info), packet, change_group_cb, cbdata, 0);
+	return slave_rpc_async_request(package_slave(inst->info), package_name(inst->info), packet, change_group_cb, cbdata, SLAVE_RPC_LANE_BACKGROUND);
 }
 
 HAPI const char * const instance_auto_launch(const struct inst_info *inst)
@@ -3587,7 +3591,7 @@ HAPI int instance_slave_open_gbar(struct inst_info *inst, struct client_node *cl
 	(void)slave_freeze_ttl(slave);
 
 	DbgPrint("PERF_WIDGET\n");
-	ret = slave_rpc_request_only(slave, pkgname, packet, 0);
+	ret = slave_rpc_request_only(slave, pkgname, packet, SLAVE_RPC_LANE_INTERACTIVE);
 	if (ret < 0) {
 		ErrPrint("Unable to send request to slave\n");
 		/*!
@@ -3663,7 +3667,7 @@ HAPI int instance_slave_close_gbar(struct inst_info *inst, struct client_node *c
 
 	slave_thaw_ttl(slave);
 
-	ret = slave_rpc_request_only(slave, pkgname, packet, 0);
+	ret = slave_rpc_request_only(slave, pkgname, packet, SLAVE_RPC_LANE_INTERACTIVE);
 	release_resource_for_closing_gbar(pkg, inst, client);
 	inst->gbar.owner = NULL;
 	DbgPrint("PERF_WIDGET\n");
@@ -3838,7 +3842,7 @@ HAPI int instance_add_client(struct inst_info *inst, struct client_node *client)
 	instance_ref(inst);
 	inst->client_list = eina_list_append(inst->client_list, client);
 
-	return slave_rpc_request_only(package_slave(inst->info), package_name(inst->info), packet, 0);
+	return slave_rpc_request_only(package_slave(inst->info), package_name(inst->info), packet, SLAVE_RPC_LANE_BACKGROUND);
 }
 
 HAPI int instance_del_client(struct inst_info *inst, struct client_node *client)
@@ -3869,6 +3873,8 @@ HAPI int instance_init(void)
 		s_info.env_buf_type = WIDGET_FB_TYPE_SHM;
 	} else if (!strcasecmp(WIDGET_CONF_PROVIDER_METHOD, "pixmap")) {
 		s_info.env_buf_type = WIDGET_FB_TYPE_PIXMAP;
+	} else if (!strcasecmp(WIDGET_CONF_PROVIDER_METHOD, "memfd")) {
+		s_info.env_buf_type = WIDGET_FB_TYPE_MEMFD;
 	}
 	/* Default method is WIDGET_FB_TYPE_FILE */
 
@@ -3979,7 +3985,7 @@ HAPI void instance_set_orientation(struct inst_info *inst, int degree)
 		return;
 	}
 
-	if (slave_rpc_request_only(package_slave(inst->info), package_name(inst->info), packet, 0) != WIDGET_ERROR_NONE) {
+	if (slave_rpc_request_only(package_slave(inst->info), package_name(inst->info), packet, SLAVE_RPC_LANE_BACKGROUND) != WIDGET_ERROR_NONE) {
 		/* packet will be destroyed by slave_rpc_request_only if it fails */
 		ErrPrint("Failed to send a request\n");
 	}
@@ -391,6 +391,27 @@ int main(int argc, char *argv[])
 	widget_conf_load();
 	widget_abi_init();
 
+	if (getenv(SLAVE_MAX_INFLIGHT_ENV)) {
+		g_conf.slave_max_inflight = atoi(getenv(SLAVE_MAX_INFLIGHT_ENV));
+		if (g_conf.slave_max_inflight < 0) {
+			g_conf.slave_max_inflight = DEFAULT_SLAVE_MAX_INFLIGHT;
+		}
+	}
+
+	if (getenv(SHM_POOL_MAX_SIZE_ENV)) {
+		g_conf.shm_pool_max_size = atoi(getenv(SHM_POOL_MAX_SIZE_ENV));
+		if (g_conf.shm_pool_max_size < 0) {
+			g_conf.shm_pool_max_size = DEFAULT_SHM_POOL_MAX_SIZE;
+		}
+	}
+
+	if (getenv(SHM_SLOTS_ENV)) {
+		g_conf.shm_slots = atoi(getenv(SHM_SLOTS_ENV));
+		if (g_conf.shm_slots < 0 || g_conf.shm_slots > SHM_RING_MAX_SLOTS) {
+			g_conf.shm_slots = DEFAULT_SHM_SLOTS;
+		}
+	}
+
 	if (vconf_get_int(VCONFKEY_MASTER_RESTART_COUNT, &restart_count) < 0 || restart_count == 0) {
 		/*!
 		 * \note
@@ -174,7 +174,7 @@ HAPI int monitor_multicast_state_change_event(const char *widget_id, enum monito
 
 	cmd = (unsigned int)event;
 
-	packet = packet_create_noack((const char *)&cmd, "dsss", util_timestamp(), widget_id, instance_id, content_info);
+	packet = packet_create_noack_ref((const char *)&cmd, "dsss", util_timestamp(), widget_id, instance_id, content_info);
 	if (!packet) {
 		ErrPrint("Failed to create a packet\n");
 		return WIDGET_ERROR_FAULT;
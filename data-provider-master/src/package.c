@@ -127,6 +127,8 @@ struct pkg_info {
 	int refcnt;
 
 	Eina_List *inst_list;
+	Eina_Hash *inst_id_table; /*!< instance id -> inst_info, same with the inst_list */
+	Eina_Hash *inst_timestamp_table; /*!< timestamp -> inst_info, same with the inst_list */
 	Eina_List *ctx_list;
 
 	union _pkg_flags {
@@ -145,10 +147,119 @@ struct pkg_info {
 
 static struct {
 	Eina_List *pkg_list;
+	Eina_Hash *pkg_table; /*!< widget_id -> pkg_info, same with the pkg_list */
 } s_info = {
 	.pkg_list = NULL,
+	.pkg_table = NULL,
 };
 
+/*!
+ * \brief
+ * Keys of the timestamp table, timestamps are compared as it is.
+ */
+static unsigned int timestamp_key_length(const void *key)
+{
+	return sizeof(double);
+}
+
+static int timestamp_key_cmp(const void *key1, int key1_length, const void *key2, int key2_length)
+{
+	double a = *(const double *)key1;
+	double b = *(const double *)key2;
+
+	return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+static int timestamp_key_hash(const void *key, int key_length)
+{
+	unsigned long long int bits;
+
+	memcpy(&bits, key, sizeof(bits));
+	return eina_hash_int64(&bits, sizeof(bits));
+}
+
+/*!
+ * \brief
+ * Lookup tables are not sure that the key is unique,
+ * If the removed one was indexed, another one which has the same key is indexed instead.
+ */
+static void pkg_table_del(struct pkg_info *info)
+{
+	struct pkg_info *item;
+	Eina_List *l;
+
+	if (eina_hash_find(s_info.pkg_table, info->widget_id) != info) {
+		return;
+	}
+
+	eina_hash_del_by_key(s_info.pkg_table, info->widget_id);
+
+	EINA_LIST_FOREACH(s_info.pkg_list, l, item) {
+		if (item != info && !strcmp(item->widget_id, info->widget_id)) {
+			eina_hash_add(s_info.pkg_table, item->widget_id, item);
+			break;
+		}
+	}
+}
+
+static void inst_table_add(struct pkg_info *info, struct inst_info *inst)
+{
+	double timestamp;
+
+	if (!info->inst_id_table) {
+		info->inst_id_table = eina_hash_string_superfast_new(NULL);
+		if (!info->inst_id_table) {
+			ErrPrint("Failed to create a table of instances\n");
+		}
+	}
+
+	if (!info->inst_timestamp_table) {
+		info->inst_timestamp_table = eina_hash_new(timestamp_key_length, timestamp_key_cmp, timestamp_key_hash, NULL, 6);
+		if (!info->inst_timestamp_table) {
+			ErrPrint("Failed to create a table of instances\n");
+		}
+	}
+
+	if (info->inst_id_table && !eina_hash_find(info->inst_id_table, instance_id(inst))) {
+		eina_hash_add(info->inst_id_table, instance_id(inst), inst);
+	}
+
+	timestamp = instance_timestamp(inst);
+	if (info->inst_timestamp_table && !eina_hash_find(info->inst_timestamp_table, &timestamp)) {
+		eina_hash_add(info->inst_timestamp_table, &timestamp, inst);
+	}
+}
+
+static void inst_table_del(struct pkg_info *info, struct inst_info *inst)
+{
+	struct inst_info *item;
+	double timestamp;
+	Eina_List *l;
+
+	if (info->inst_id_table && eina_hash_find(info->inst_id_table, instance_id(inst)) == inst) {
+		eina_hash_del_by_key(info->inst_id_table, instance_id(inst));
+
+		EINA_LIST_FOREACH(info->inst_list, l, item) {
+			if (item != inst && !strcmp(instance_id(item), instance_id(inst))) {
+				eina_hash_add(info->inst_id_table, instance_id(item), item);
+				break;
+			}
+		}
+	}
+
+	timestamp = instance_timestamp(inst);
+	if (info->inst_timestamp_table && eina_hash_find(info->inst_timestamp_table, &timestamp) == inst) {
+		eina_hash_del_by_key(info->inst_timestamp_table, &timestamp);
+
+		EINA_LIST_FOREACH(info->inst_list, l, item) {
+			if (item != inst && instance_timestamp(item) == timestamp) {
+				eina_hash_add(info->inst_timestamp_table, &timestamp, item);
+				break;
+			}
+		}
+	}
+}
+
 static int slave_activated_cb(struct slave_node *slave, void *data)
 {
 	struct pkg_info *info = data;
@@ -315,6 +426,15 @@ static inline void destroy_package(struct pkg_info *info)
 	package_clear_fault(info);
 
 	s_info.pkg_list = eina_list_remove(s_info.pkg_list, info);
+	pkg_table_del(info);
+
+	if (info->inst_id_table) {
+		eina_hash_free(info->inst_id_table);
+	}
+
+	if (info->inst_timestamp_table) {
+		eina_hash_free(info->inst_timestamp_table);
+	}
 
 	if (info->widget.type == WIDGET_TYPE_SCRIPT) {
 		DbgFree(info->widget.info.script.path);
@@ -559,6 +679,17 @@ HAPI struct pkg_info *package_create(const char *pkgid, const char *widget_id)
 
 	s_info.pkg_list = eina_list_append(s_info.pkg_list, pkginfo);
 
+	if (!s_info.pkg_table) {
+		s_info.pkg_table = eina_hash_string_superfast_new(NULL);
+		if (!s_info.pkg_table) {
+			ErrPrint("Failed to create a table of packages\n");
+		}
+	}
+
+	if (s_info.pkg_table && !eina_hash_find(s_info.pkg_table, pkginfo->widget_id)) {
+		eina_hash_add(s_info.pkg_table, pkginfo->widget_id, pkginfo);
+	}
+
 	return pkginfo;
 }
 
@@ -613,26 +744,15 @@ HAPI int package_is_widget_pkgname(const char *pkgname)
 
 HAPI struct pkg_info *package_find(const char *widget_id)
 {
-	Eina_List *l;
-	struct pkg_info *info;
-
-	if (!widget_id) {
+	if (!widget_id || !s_info.pkg_table) {
 		return NULL;
 	}
 
-	EINA_LIST_FOREACH(s_info.pkg_list, l, info) {
-		if (!strcmp(info->widget_id, widget_id)) {
-			return info;
-		}
-	}
-
-	return NULL;
+	return eina_hash_find(s_info.pkg_table, widget_id);
 }
 
 HAPI struct inst_info *package_find_instance_by_id(const char *widget_id, const char *id)
 {
-	Eina_List *l;
-	struct inst_info *inst;
 	struct pkg_info *info;
 
 	info = package_find(widget_id);
@@ -641,19 +761,15 @@ HAPI struct inst_info *package_find_instance_by_id(const char *widget_id, const
 		return NULL;
 	}
 
-	EINA_LIST_FOREACH(info->inst_list, l, inst) {
-		if (!strcmp(instance_id(inst), id)) {
-			return inst;
-		}
+	if (!id || !info->inst_id_table) {
+		return NULL;
 	}
 
-	return NULL;
+	return eina_hash_find(info->inst_id_table, id);
 }
 
 HAPI struct inst_info *package_find_instance_by_timestamp(const char *widget_id, double timestamp)
 {
-	Eina_List *l;
-	struct inst_info *inst;
 	struct pkg_info *info;
 
 	info = package_find(widget_id);
@@ -662,13 +778,11 @@ HAPI struct inst_info *package_find_instance_by_timestamp(const char *widget_id,
 		return NULL;
 	}
 
-	EINA_LIST_FOREACH(info->inst_list, l, inst) {
-		if (instance_timestamp(inst) == timestamp) {
-			return inst;
-		}
+	if (!info->inst_timestamp_table) {
+		return NULL;
 	}
 
-	return NULL;
+	return eina_hash_find(info->inst_timestamp_table, &timestamp);
 }
 
 HAPI int package_dump_fault_info(struct pkg_info *info)
@@ -1265,12 +1379,14 @@ HAPI int package_add_instance(struct pkg_info *info, struct inst_info *inst)
 	}
 
 	info->inst_list = eina_list_append(info->inst_list, inst);
+	inst_table_add(info, inst);
 	return WIDGET_ERROR_NONE;
 }
 
 HAPI int package_del_instance(struct pkg_info *info, struct inst_info *inst)
 {
 	info->inst_list = eina_list_remove(info->inst_list, inst);
+	inst_table_del(info, inst);
 
 	if (info->inst_list) {
 		return WIDGET_ERROR_NONE;
@@ -1605,6 +1721,11 @@ HAPI int package_fini(void)
 		package_destroy(info);
 	}
 
+	if (s_info.pkg_table) {
+		eina_hash_free(s_info.pkg_table);
+		s_info.pkg_table = NULL;
+	}
+
 	return 0;
 }
 
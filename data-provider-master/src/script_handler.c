@@ -32,6 +32,7 @@
 
 #include <dlog.h>
 #include <packet.h>
+#include <com-core_desc.h>
 #include <widget_errno.h>
 #include <widget_service.h>
 #include <widget_service_internal.h>
@@ -166,6 +167,9 @@ struct script_info {
 	void *port_data;
 
 	Eina_List *cached_blocks;
+
+	Eina_Hash *applied_blocks; /*!< State of the block which is applied lastly, for each type, id and part */
+	unsigned int skipped_updates; /*!< Count of port calls which are skipped, because nothing is changed */
 };
 
 static inline void consuming_parsed_block(struct inst_info *inst, int is_pd, struct block *block);
@@ -370,6 +374,175 @@ static inline void delete_block(struct block *block)
 	DbgFree(block);
 }
 
+#define BLOCK_FIELD(field)	((field) ? '+' : '-'), ((field) ? (field) : "")
+
+/*!
+ * \note
+ * Fields of a block cannot have the new line, it is used as a delimiter of the key and the state.
+ * "type\nid\npart"
+ */
+static char *applied_block_key(const struct block *block)
+{
+	char *key;
+	int len;
+
+	len = strlen(block->id ? block->id : "") + strlen(block->part) + 16;
+	key = malloc(len);
+	if (!key) {
+		ErrPrint("malloc: %d\n", errno);
+		return NULL;
+	}
+
+	snprintf(key, len, "%d\n%s\n%s", block->type, block->id ? block->id : "", block->part);
+	return key;
+}
+
+static char *applied_block_state(const struct block *block)
+{
+	char stamp[64];
+	struct stat st;
+	char *state;
+	int len;
+
+	/*!
+	 * \note
+	 * Image and script files can be rewritten using the same name.
+	 */
+	if ((block->type == TYPE_IMAGE || block->type == TYPE_SCRIPT) && block->data && stat(block->data, &st) == 0) {
+		snprintf(stamp, sizeof(stamp), "%ld.%09ld:%lld", (long)st.st_mtim.tv_sec, (long)st.st_mtim.tv_nsec, (long long)st.st_size);
+	} else {
+		stamp[0] = '\0';
+	}
+
+	len = strlen(block->data ? block->data : "") + strlen(block->option ? block->option : "") + strlen(block->target ? block->target : "") + strlen(stamp) + 16;
+	state = malloc(len);
+	if (!state) {
+		ErrPrint("malloc: %d\n", errno);
+		return NULL;
+	}
+
+	snprintf(state, len, "%c%s\n%c%s\n%c%s\n%s", BLOCK_FIELD(block->data), BLOCK_FIELD(block->option), BLOCK_FIELD(block->target), stamp);
+	return state;
+}
+
+/*!
+ * \brief
+ * Compare a block with the one which is applied lastly to the same part.
+ * Signals and access operations are events, they are always applied.
+ * \return 1 if nothing is changed, or 0 with its key and state to record it after applying.
+ */
+static int is_applied_block(struct script_info *info, const struct block *block, char **key, char **state)
+{
+	const char *applied;
+
+	*key = NULL;
+	*state = NULL;
+
+	if (block->type == TYPE_SIGNAL || block->type == TYPE_ACCESS_OP || !block->part) {
+		return 0;
+	}
+
+	if (!info->applied_blocks) {
+		info->applied_blocks = eina_hash_string_superfast_new(free);
+		if (!info->applied_blocks) {
+			ErrPrint("Failed to create a table\n");
+			return 0;
+		}
+	}
+
+	*key = applied_block_key(block);
+	if (!*key) {
+		return 0;
+	}
+
+	*state = applied_block_state(block);
+	if (!*state) {
+		DbgFree(*key);
+		*key = NULL;
+		return 0;
+	}
+
+	applied = eina_hash_find(info->applied_blocks, *key);
+	if (applied && !strcmp(applied, *state)) {
+		DbgFree(*key);
+		DbgFree(*state);
+		*key = NULL;
+		*state = NULL;
+		return 1;
+	}
+
+	return 0;
+}
+
+static void record_applied_block(struct script_info *info, char *key, char *state, int ret)
+{
+	if (!key) {
+		return;
+	}
+
+	if (ret < 0) {
+		/*!
+		 * \note
+		 * The state of the part is not able to be known.
+		 */
+		eina_hash_del_by_key(info->applied_blocks, key);
+		DbgFree(state);
+	} else {
+		DbgFree(eina_hash_set(info->applied_blocks, key, state));
+	}
+
+	DbgFree(key);
+}
+
+static Eina_Bool collect_applied_block_cb(const Eina_Hash *hash, const void *key, void *data, void *fdata)
+{
+	void **param = fdata;
+	const char *id = param[0];
+	const char *ptr;
+	int len;
+
+	ptr = strchr(key, '\n');
+	if (ptr) {
+		ptr++;
+		len = strlen(id);
+		if (!strncmp(ptr, id, len) && ptr[len] == '\n') {
+			char *dup;
+
+			dup = strdup(key);
+			if (dup) {
+				param[1] = eina_list_append(param[1], dup);
+			} else {
+				ErrPrint("strdup: %d\n", errno);
+			}
+		}
+	}
+
+	return EINA_TRUE;
+}
+
+/*!
+ * \brief
+ * Parts of an object which is replaced by a script block are not same with the applied ones anymore.
+ */
+static void forget_applied_blocks(struct script_info *info, const char *id)
+{
+	void *param[2];
+	char *key;
+
+	if (!info->applied_blocks || !id) {
+		return;
+	}
+
+	param[0] = (void *)id;
+	param[1] = NULL;
+	eina_hash_foreach(info->applied_blocks, collect_applied_block_cb, param);
+
+	EINA_LIST_FREE(param[1], key) {
+		eina_hash_del_by_key(info->applied_blocks, key);
+		DbgFree(key);
+	}
+}
+
 static int render_post_cb(void *_buffer_handle, void *data)
 {
 	PERF_INIT();
@@ -377,6 +550,10 @@ static int render_post_cb(void *_buffer_handle, void *data)
 	struct inst_info *inst;
 	struct buffer_info *buffer_handle = _buffer_handle;
 	struct script_info *info;
+	int x;
+	int y;
+	int w;
+	int h;
 
 	inst = buffer_handler_instance(buffer_handle);
 	if (!inst) {
@@ -389,18 +566,25 @@ static int render_post_cb(void *_buffer_handle, void *data)
 		return WIDGET_ERROR_INVALID_PARAMETER;
 	}
 
+	/*!
+	 * \note
+	 * The damaged region is reported by the script port,
+	 * Viewers get the same region with the flushed one.
+	 */
+	buffer_handler_damaged_region(buffer_handle, &x, &y, &w, &h);
+
 	info = instance_widget_script(inst);
 	if (info && info == data) {
-		buffer_handler_flush(buffer_handle);
-		instance_widget_updated_by_instance(inst, NULL, info->x, info->y, info->w, info->h);
+		buffer_handler_flush(buffer_handle, x, y, w, h);
+		instance_widget_updated_by_instance(inst, NULL, x, y, w, h);
 		PERF_MARK("lb,update");
 		return WIDGET_ERROR_NONE;
 	}
 
 	info = instance_gbar_script(inst);
 	if (info && info == data) {
-		buffer_handler_flush(buffer_handle);
-		instance_gbar_updated_by_instance(inst, NULL, info->x, info->y, info->w, info->h);
+		buffer_handler_flush(buffer_handle, x, y, w, h);
+		instance_gbar_updated_by_instance(inst, NULL, x, y, w, h);
 		PERF_MARK("pd,update");
 		return WIDGET_ERROR_NONE;
 	}
@@ -505,7 +689,7 @@ HAPI int script_handler_load(struct script_info *info, int is_pd)
 		script_signal_emit(info->buffer_handle, instance_id(inst),
 				is_pd ? "gbar,show" : "widget,show", 0.0f, 0.0f, 0.0f, 0.0f);
 	}
-	buffer_handler_flush(info->buffer_handle);
+	buffer_handler_flush(info->buffer_handle, 0, 0, 0, 0);
 	return WIDGET_ERROR_NONE;
 }
 
@@ -537,6 +721,14 @@ HAPI int script_handler_unload(struct script_info *info, int is_pd)
 		ErrPrint("Failed to unload script object. but go ahead\n");
 	}
 
+	/*!
+	 * \note
+	 * Objects are re-created by the next load, every block should be applied again.
+	 */
+	if (info->applied_blocks) {
+		eina_hash_free_buckets(info->applied_blocks);
+	}
+
 	return WIDGET_ERROR_NONE;
 }
 
@@ -611,6 +803,11 @@ HAPI int script_handler_destroy(struct script_info *info)
 		delete_block(block);
 	}
 
+	if (info->applied_blocks) {
+		eina_hash_free(info->applied_blocks);
+	}
+
+	DbgPrint("%u updates were skipped\n", info->skipped_updates);
 	DbgFree(info);
 	return WIDGET_ERROR_NONE;
 }
@@ -1017,7 +1214,21 @@ static inline void consuming_parsed_block(struct inst_info *inst, int is_pd, str
 
 	if (script_handler_is_loaded(info)) {
 		if (block->type >= 0 || block->type < TYPE_MAX) {
-			(void)updators[block->type](inst, block, is_pd);
+			char *key;
+			char *state;
+			int ret;
+
+			if (is_applied_block(info, block, &key, &state)) {
+				info->skipped_updates++;
+				goto free_out;
+			}
+
+			ret = updators[block->type](inst, block, is_pd);
+			record_applied_block(info, key, state, ret);
+
+			if (block->type == TYPE_SCRIPT && ret >= 0) {
+				forget_applied_blocks(info, block->target);
+			}
 		} else {
 			ErrPrint("Block type[%d] is not valid\n", block->type);
 		}
@@ -1037,6 +1248,8 @@ HAPI int script_init(void)
 		s_info.env_buf_type = WIDGET_FB_TYPE_SHM;
 	} else if (!strcasecmp(WIDGET_CONF_PROVIDER_METHOD, "pixmap")) {
 		s_info.env_buf_type = WIDGET_FB_TYPE_PIXMAP;
+	} else if (!strcasecmp(WIDGET_CONF_PROVIDER_METHOD, "memfd")) {
+		s_info.env_buf_type = WIDGET_FB_TYPE_MEMFD;
 	}
 
 	return WIDGET_ERROR_NONE;
@@ -1106,7 +1319,7 @@ HAPI int script_handler_feed_event(struct script_info *info, int event, double t
 	return ret;
 }
 
-static inline char *load_file(const char *filename)
+static inline char *load_file(const char *filename, int *size)
 {
 	char *filebuf = NULL;
 	int fd;
@@ -1156,6 +1369,7 @@ static inline char *load_file(const char *filename)
 
 	if (filebuf) {
 		filebuf[readsize] = '\0';
+		*size = (int)readsize;
 	}
 
 	/*!
@@ -1171,6 +1385,55 @@ errout:
 	return filebuf;
 }
 
+struct binary_desc {
+	const char *filename;
+	Eina_List *block_list;
+};
+
+/*!
+ * \note
+ * Binary desc is read by the com-core, this maps its blocks to the blocks of the text parser.
+ */
+static int binary_block_cb(const struct com_core_desc_block *desc, int blockno, void *data)
+{
+	struct binary_desc *binary = data;
+	struct block *block;
+	int type_idx;
+
+	if (!desc->type) {
+		ErrPrint("%d: Type is not exists\n", blockno);
+		return WIDGET_ERROR_FAULT;
+	}
+
+	for (type_idx = 0; type_list[type_idx]; type_idx++) {
+		if (!strcmp(type_list[type_idx], desc->type)) {
+			break;
+		}
+	}
+
+	if (!type_list[type_idx]) {
+		ErrPrint("%d: type is not valid (%s)\n", blockno, desc->type);
+		return WIDGET_ERROR_FAULT;
+	}
+
+	block = calloc(1, sizeof(*block));
+	if (!block) {
+		ErrPrint("calloc: %d\n", errno);
+		return WIDGET_ERROR_OUT_OF_MEMORY;
+	}
+
+	block->type = type_idx;
+	block->part = (char *)desc->part;
+	block->data = (char *)desc->data;
+	block->option = (char *)desc->option;
+	block->id = (char *)desc->id;
+	block->target = (char *)desc->target;
+	block->file = (char *)desc->file;
+	block->filename = binary->filename;
+	binary->block_list = eina_list_append(binary->block_list, block);
+	return WIDGET_ERROR_NONE;
+}
+
 #if defined(_APPLY_SCRIPT_ASYNC_UPDATE)
 struct apply_data {
 	struct inst_info *inst;
@@ -1206,6 +1469,7 @@ HAPI int script_handler_parse_desc(struct inst_info *inst, const char *filename,
 	int field_len = 0;
 	char *filebuf;
 	char *fileptr;
+	int filesize = 0;
 	char *ptr = NULL;
 	struct block *block = NULL;
 	Eina_List *block_list = NULL;
@@ -1218,14 +1482,35 @@ HAPI int script_handler_parse_desc(struct inst_info *inst, const char *filename,
 		ERROR,
 	} state;
 
-	filebuf = load_file(filename);
+	filebuf = load_file(filename, &filesize);
 	if (!filebuf) {
 		return WIDGET_ERROR_IO_ERROR;
 	}
 
-	fileptr = filebuf;
-
 	state = BEGIN;
+	if (com_core_desc_is_binary(filebuf, filesize)) {
+		struct binary_desc binary = {
+			.filename = filename,
+			.block_list = NULL,
+		};
+		int ret;
+
+		ret = com_core_desc_foreach_block(filebuf, filesize, binary_block_cb, &binary);
+		if (ret < 0) {
+			ErrPrint("Unable to read %s (%d)\n", filename, ret);
+			state = ERROR;
+		}
+		block_list = binary.block_list;
+
+		/*!
+		 * \note
+		 * Binary desc doesn't need to be tokenized, make the text parser stop at the terminator.
+		 */
+		fileptr = filebuf + filesize;
+	} else {
+		fileptr = filebuf;
+	}
+
 	while (*fileptr && state != ERROR) {
 		switch (state) {
 		case BEGIN:
@@ -1497,12 +1782,24 @@ HAPI int script_handler_parse_desc(struct inst_info *inst, const char *filename,
 		}
 	}
 #else
+	struct script_info *info;
+	unsigned int skipped;
+	int count;
+
+	info = is_pd ? instance_gbar_script(inst) : instance_widget_script(inst);
+	skipped = info ? info->skipped_updates : 0;
+	count = eina_list_count(block_list);
+
 	ErrPrint("Begin: Set content for EDJE object\n");
 	EINA_LIST_FREE(block_list, block) {
 		consuming_parsed_block(inst, is_pd, block);
 	}
 	ErrPrint("End: Set content for EDJE object\n");
 
+	if (info) {
+		DbgPrint("%s: %u of %d blocks are not changed\n", instance_id(inst), info->skipped_updates - skipped, count);
+	}
+
 	/*!
 	 * Doesn't need to force to render the contents.
 	 struct script_info *info;
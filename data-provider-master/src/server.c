@@ -122,6 +122,33 @@ struct deleted_item {
 	struct inst_info *inst;
 };
 
+/*!
+ * \note
+ * Fields of the mouse event packet, "ssdiiiddi"
+ * Buffer type forwards the packet as is, so only the pkgname and the id are read.
+ */
+enum mouse_event_field {
+	MOUSE_EVENT_PKGNAME,
+	MOUSE_EVENT_ID,
+	MOUSE_EVENT_TIMESTAMP,
+	MOUSE_EVENT_X,
+	MOUSE_EVENT_Y,
+	MOUSE_EVENT_SOURCE,
+	MOUSE_EVENT_RATIO_W,
+	MOUSE_EVENT_RATIO_H,
+	MOUSE_EVENT_DEVICE
+};
+
+static inline void update_pointer_by_packet(struct script_info *script, const struct packet *packet)
+{
+	int x;
+	int y;
+
+	x = packet_view_int(packet, MOUSE_EVENT_X) * packet_view_double(packet, MOUSE_EVENT_RATIO_W);
+	y = packet_view_int(packet, MOUSE_EVENT_Y) * packet_view_double(packet, MOUSE_EVENT_RATIO_H);
+	script_handler_update_pointer(script, packet_view_int(packet, MOUSE_EVENT_DEVICE), x, y, -1);
+}
+
 static int is_valid_service_requestor(pid_t pid, const char *pkgname)
 {
 	char pid_pkgname[pathconf("/", _PC_PATH_MAX)];
@@ -363,7 +390,7 @@ static int forward_widget_event_packet(const struct pkg_info *pkg, struct inst_i
 	}
 
 	packet_ref((struct packet *)packet);
-	ret = slave_rpc_request_only(slave, package_name(pkg), (struct packet *)packet, 0);
+	ret = slave_rpc_request_only(slave, package_name(pkg), (struct packet *)packet, SLAVE_RPC_LANE_INTERACTIVE);
 
 out:
 	return ret;
@@ -390,7 +417,7 @@ static int forward_gbar_event_packet(const struct pkg_info *pkg, struct inst_inf
 	}
 
 	packet_ref((struct packet *)packet);
-	ret = slave_rpc_request_only(slave, package_name(pkg), (struct packet *)packet, 0);
+	ret = slave_rpc_request_only(slave, package_name(pkg), (struct packet *)packet, SLAVE_RPC_LANE_INTERACTIVE);
 
 out:
 	return ret;
@@ -418,7 +445,7 @@ static int forward_gbar_access_packet(const struct pkg_info *pkg, struct inst_in
 	}
 
 	p = packet_create_noack(command, "ssdiii", package_name(pkg), instance_id(inst), timestamp, event->x, event->y, event->type);
-	ret = slave_rpc_request_only(slave, package_name(pkg), p, 0);
+	ret = slave_rpc_request_only(slave, package_name(pkg), p, SLAVE_RPC_LANE_INTERACTIVE);
 
 out:
 	return ret;
@@ -446,7 +473,7 @@ static int forward_widget_access_packet(const struct pkg_info *pkg, struct inst_
 	}
 
 	p = packet_create_noack(command, "ssdiii", package_name(pkg), instance_id(inst), timestamp, event->x, event->y, event->type);
-	ret = slave_rpc_request_only(slave, package_name(pkg), p, 0);
+	ret = slave_rpc_request_only(slave, package_name(pkg), p, SLAVE_RPC_LANE_INTERACTIVE);
 
 out:
 	return ret;
@@ -474,7 +501,7 @@ static int forward_gbar_key_packet(const struct pkg_info *pkg, struct inst_info
 	}
 
 	p = packet_create_noack(command, "ssdi", package_name(pkg), instance_id(inst), timestamp, keycode);
-	ret = slave_rpc_request_only(slave, package_name(pkg), p, 0);
+	ret = slave_rpc_request_only(slave, package_name(pkg), p, SLAVE_RPC_LANE_INTERACTIVE);
 
 out:
 	return ret;
@@ -502,7 +529,7 @@ static int forward_widget_key_packet(const struct pkg_info *pkg, struct inst_inf
 	}
 
 	p = packet_create_noack(command, "ssdi", package_name(pkg), instance_id(inst), timestamp, keycode);
-	ret = slave_rpc_request_only(slave, package_name(pkg), p, 0);
+	ret = slave_rpc_request_only(slave, package_name(pkg), p, SLAVE_RPC_LANE_INTERACTIVE);
 
 out:
 	return ret;
@@ -638,7 +665,7 @@ static int key_event_widget_route_cb(enum event_state state, struct event_data *
 		return WIDGET_ERROR_FAULT;
 	}
 
-	return slave_rpc_request_only(slave, package_name(pkg), packet, 0);
+	return slave_rpc_request_only(slave, package_name(pkg), packet, SLAVE_RPC_LANE_INTERACTIVE);
 }
 
 static int mouse_event_widget_route_cb(enum event_state state, struct event_data *event_info, void *data)
@@ -683,7 +710,7 @@ static int mouse_event_widget_route_cb(enum event_state state, struct event_data
 		return WIDGET_ERROR_FAULT;
 	}
 
-	return slave_rpc_request_only(slave, package_name(pkg), packet, 0);
+	return slave_rpc_request_only(slave, package_name(pkg), packet, SLAVE_RPC_LANE_INTERACTIVE);
 }
 
 static int key_event_widget_consume_cb(enum event_state state, struct event_data *event_info, void *data)
@@ -812,7 +839,7 @@ static int key_event_gbar_route_cb(enum event_state state, struct event_data *ev
 		return WIDGET_ERROR_FAULT;
 	}
 
-	return slave_rpc_request_only(slave, package_name(pkg), packet, 0);
+	return slave_rpc_request_only(slave, package_name(pkg), packet, SLAVE_RPC_LANE_INTERACTIVE);
 }
 
 static int mouse_event_gbar_route_cb(enum event_state state, struct event_data *event_info, void *data)
@@ -857,7 +884,7 @@ static int mouse_event_gbar_route_cb(enum event_state state, struct event_data *
 		return WIDGET_ERROR_FAULT;
 	}
 
-	return slave_rpc_request_only(slave, package_name(pkg), packet, 0);
+	return slave_rpc_request_only(slave, package_name(pkg), packet, SLAVE_RPC_LANE_INTERACTIVE);
 }
 
 static int key_event_gbar_consume_cb(enum event_state state, struct event_data *event_info, void *data)
@@ -1640,15 +1667,8 @@ static struct packet *client_gbar_mouse_enter(pid_t pid, int handle, const struc
 	const char *pkgname;
 	const char *id;
 	int ret;
-	double timestamp;
-	int x;
-	int y;
 	struct inst_info *inst;
 	const struct pkg_info *pkg;
-	int source;
-	double ratio_w;
-	double ratio_h;
-	int device;
 
 	client = client_find_by_rpc_handle(handle);
 	if (!client) {
@@ -1657,13 +1677,16 @@ static struct packet *client_gbar_mouse_enter(pid_t pid, int handle, const struc
 		goto out;
 	}
 
-	ret = packet_get(packet, "ssdiiiddi", &pkgname, &id, &timestamp, &x, &y, &source, &ratio_w, &ratio_h, &device);
+	ret = packet_view(packet, "ssdiiiddi");
 	if (ret != 9) {
 		ErrPrint("Invalid parameter\n");
 		ret = WIDGET_ERROR_INVALID_PARAMETER;
 		goto out;
 	}
 
+	pkgname = packet_view_str(packet, MOUSE_EVENT_PKGNAME);
+	id = packet_view_str(packet, MOUSE_EVENT_ID);
+
 	ret = validate_request(pid, NULL, pkgname, id, &inst, &pkg);
 	if (ret != WIDGET_ERROR_NONE) {
 		goto out;
@@ -1680,8 +1703,8 @@ static struct packet *client_gbar_mouse_enter(pid_t pid, int handle, const struc
 			goto out;
 		}
 
-		script_handler_update_pointer(script, device, x * ratio_w, y * ratio_h, -1);
-		script_handler_feed_event(script, WIDGET_SCRIPT_MOUSE_IN, timestamp);
+		update_pointer_by_packet(script, packet);
+		script_handler_feed_event(script, WIDGET_SCRIPT_MOUSE_IN, packet_view_double(packet, MOUSE_EVENT_TIMESTAMP));
 		ret = 0;
 	} else {
 		ErrPrint("Unsupported package\n");
@@ -1699,15 +1722,8 @@ static struct packet *client_gbar_mouse_leave(pid_t pid, int handle, const struc
 	const char *pkgname;
 	const char *id;
 	int ret;
-	double timestamp;
-	int x;
-	int y;
 	struct inst_info *inst;
 	const struct pkg_info *pkg;
-	int source;
-	double ratio_w;
-	double ratio_h;
-	int device;
 
 	client = client_find_by_rpc_handle(handle);
 	if (!client) {
@@ -1716,13 +1732,16 @@ static struct packet *client_gbar_mouse_leave(pid_t pid, int handle, const struc
 		goto out;
 	}
 
-	ret = packet_get(packet, "ssdiiiddi", &pkgname, &id, &timestamp, &x, &y, &source, &ratio_w, &ratio_h, &device);
+	ret = packet_view(packet, "ssdiiiddi");
 	if (ret != 9) {
 		ErrPrint("Parameter is not matched\n");
 		ret = WIDGET_ERROR_INVALID_PARAMETER;
 		goto out;
 	}
 
+	pkgname = packet_view_str(packet, MOUSE_EVENT_PKGNAME);
+	id = packet_view_str(packet, MOUSE_EVENT_ID);
+
 	ret = validate_request(pid, NULL, pkgname, id, &inst, &pkg);
 	if (ret != WIDGET_ERROR_NONE) {
 		goto out;
@@ -1739,8 +1758,8 @@ static struct packet *client_gbar_mouse_leave(pid_t pid, int handle, const struc
 			goto out;
 		}
 
-		script_handler_update_pointer(script, device, x * ratio_w, y * ratio_h, -1);
-		script_handler_feed_event(script, WIDGET_SCRIPT_MOUSE_OUT, timestamp);
+		update_pointer_by_packet(script, packet);
+		script_handler_feed_event(script, WIDGET_SCRIPT_MOUSE_OUT, packet_view_double(packet, MOUSE_EVENT_TIMESTAMP));
 		ret = 0;
 	} else {
 		ErrPrint("Unsupported package\n");
@@ -1876,15 +1895,8 @@ static struct packet *client_gbar_mouse_move(pid_t pid, int handle, const struct
 	const char *pkgname;
 	const char *id;
 	int ret;
-	double timestamp;
-	int x;
-	int y;
 	struct inst_info *inst;
 	const struct pkg_info *pkg;
-	int source;
-	double ratio_w;
-	double ratio_h;
-	int device;
 
 	client = client_find_by_rpc_handle(handle);
 	if (!client) {
@@ -1893,13 +1905,16 @@ static struct packet *client_gbar_mouse_move(pid_t pid, int handle, const struct
 		goto out;
 	}
 
-	ret = packet_get(packet, "ssdiiiddi", &pkgname, &id, &timestamp, &x, &y, &source, &ratio_w, &ratio_h, &device);
+	ret = packet_view(packet, "ssdiiiddi");
 	if (ret != 9) {
 		ErrPrint("Parameter is not matched\n");
 		ret = WIDGET_ERROR_INVALID_PARAMETER;
 		goto out;
 	}
 
+	pkgname = packet_view_str(packet, MOUSE_EVENT_PKGNAME);
+	id = packet_view_str(packet, MOUSE_EVENT_ID);
+
 	ret = validate_request(pid, NULL, pkgname, id, &inst, &pkg);
 	if (ret != WIDGET_ERROR_NONE) {
 		goto out;
@@ -1916,8 +1931,8 @@ static struct packet *client_gbar_mouse_move(pid_t pid, int handle, const struct
 			goto out;
 		}
 
-		script_handler_update_pointer(script, device, x * ratio_w, y * ratio_h, -1);
-		script_handler_feed_event(script, WIDGET_SCRIPT_MOUSE_MOVE, timestamp);
+		update_pointer_by_packet(script, packet);
+		script_handler_feed_event(script, WIDGET_SCRIPT_MOUSE_MOVE, packet_view_double(packet, MOUSE_EVENT_TIMESTAMP));
 		ret = 0;
 	} else {
 		ErrPrint("Unsupported package\n");
@@ -1935,15 +1950,8 @@ static struct packet *client_widget_mouse_move(pid_t pid, int handle, const stru
 	const char *pkgname;
 	const char *id;
 	int ret;
-	double timestamp;
-	int x;
-	int y;
 	struct inst_info *inst;
 	const struct pkg_info *pkg;
-	int source;
-	double ratio_w;
-	double ratio_h;
-	int device;
 
 	client = client_find_by_rpc_handle(handle);
 	if (!client) {
@@ -1952,13 +1960,16 @@ static struct packet *client_widget_mouse_move(pid_t pid, int handle, const stru
 		goto out;
 	}
 
-	ret = packet_get(packet, "ssdiiiddi", &pkgname, &id, &timestamp, &x, &y, &source, &ratio_w, &ratio_h, &device);
+	ret = packet_view(packet, "ssdiiiddi");
 	if (ret != 9) {
 		ErrPrint("Parameter is not matched\n");
 		ret = WIDGET_ERROR_INVALID_PARAMETER;
 		goto out;
 	}
 
+	pkgname = packet_view_str(packet, MOUSE_EVENT_PKGNAME);
+	id = packet_view_str(packet, MOUSE_EVENT_ID);
+
 	ret = validate_request(pid, NULL, pkgname, id, &inst, &pkg);
 	if (ret != WIDGET_ERROR_NONE) {
 		goto out;
@@ -1975,8 +1986,8 @@ static struct packet *client_widget_mouse_move(pid_t pid, int handle, const stru
 			goto out;
 		}
 
-		script_handler_update_pointer(script, device, x * ratio_w, y * ratio_h, -1);
-		script_handler_feed_event(script, WIDGET_SCRIPT_MOUSE_MOVE, timestamp);
+		update_pointer_by_packet(script, packet);
+		script_handler_feed_event(script, WIDGET_SCRIPT_MOUSE_MOVE, packet_view_double(packet, MOUSE_EVENT_TIMESTAMP));
 		ret = 0;
 	} else {
 		ErrPrint("Unsupported package\n");
@@ -2331,7 +2342,7 @@ static struct packet *client_widget_mouse_set(pid_t pid, int handle, const struc
 			slave = package_slave(pkg);
 			if (slave) {
 				packet_ref((struct packet *)packet);
-				ret = slave_rpc_request_only(slave, pkgname, (struct packet *)packet, 0);
+				ret = slave_rpc_request_only(slave, pkgname, (struct packet *)packet, SLAVE_RPC_LANE_INTERACTIVE);
 			} else {
 				ErrPrint("Unable to find a slave for %s\n", pkgname);
 				ret = WIDGET_ERROR_FAULT;
@@ -2412,7 +2423,7 @@ static struct packet *client_widget_mouse_unset(pid_t pid, int handle, const str
 			slave = package_slave(pkg);
 			if (slave) {
 				packet_ref((struct packet *)packet);
-				ret = slave_rpc_request_only(slave, pkgname, (struct packet *)packet, 0);
+				ret = slave_rpc_request_only(slave, pkgname, (struct packet *)packet, SLAVE_RPC_LANE_INTERACTIVE);
 			} else {
 				ErrPrint("Unable to find a slave for %s\n", pkgname);
 				ret = WIDGET_ERROR_FAULT;
@@ -2493,7 +2504,7 @@ static struct packet *client_gbar_mouse_set(pid_t pid, int handle, const struct
 			slave = package_slave(pkg);
 			if (slave) {
 				packet_ref((struct packet *)packet);
-				ret = slave_rpc_request_only(slave, pkgname, (struct packet *)packet, 0);
+				ret = slave_rpc_request_only(slave, pkgname, (struct packet *)packet, SLAVE_RPC_LANE_INTERACTIVE);
 			} else {
 				ErrPrint("Unable to find a slave for %s\n", pkgname);
 				ret = WIDGET_ERROR_FAULT;
@@ -2642,15 +2653,8 @@ static struct packet *client_widget_mouse_on_hold(pid_t pid, int handle, const s
 	const char *pkgname;
 	const char *id;
 	int ret;
-	double timestamp;
-	int x;
-	int y;
 	struct inst_info *inst;
 	const struct pkg_info *pkg;
-	int source;
-	double ratio_w;
-	double ratio_h;
-	int device;
 
 	client = client_find_by_rpc_handle(handle);
 	if (!client) {
@@ -2659,13 +2663,16 @@ static struct packet *client_widget_mouse_on_hold(pid_t pid, int handle, const s
 		goto out;
 	}
 
-	ret = packet_get(packet, "ssdiiiddi", &pkgname, &id, &timestamp, &x, &y, &source, &ratio_w, &ratio_h, &device);
+	ret = packet_view(packet, "ssdiiiddi");
 	if (ret != 9) {
 		ErrPrint("Parameter is not matched\n");
 		ret = WIDGET_ERROR_INVALID_PARAMETER;
 		goto out;
 	}
 
+	pkgname = packet_view_str(packet, MOUSE_EVENT_PKGNAME);
+	id = packet_view_str(packet, MOUSE_EVENT_ID);
+
 	ret = validate_request(pid, NULL, pkgname, id, &inst, &pkg);
 	if (ret != WIDGET_ERROR_NONE) {
 		goto out;
@@ -2682,8 +2689,8 @@ static struct packet *client_widget_mouse_on_hold(pid_t pid, int handle, const s
 			goto out;
 		}
 
-		script_handler_update_pointer(script, device, x * ratio_w, y * ratio_h, -1);
-		script_handler_feed_event(script, WIDGET_SCRIPT_MOUSE_ON_HOLD, timestamp);
+		update_pointer_by_packet(script, packet);
+		script_handler_feed_event(script, WIDGET_SCRIPT_MOUSE_ON_HOLD, packet_view_double(packet, MOUSE_EVENT_TIMESTAMP));
 		ret = 0;
 	} else {
 		ErrPrint("Unsupported package\n");
@@ -2701,15 +2708,8 @@ static struct packet *client_widget_mouse_off_hold(pid_t pid, int handle, const
 	const char *pkgname;
 	const char *id;
 	int ret;
-	double timestamp;
-	int x;
-	int y;
 	struct inst_info *inst;
 	const struct pkg_info *pkg;
-	int source;
-	double ratio_w;
-	double ratio_h;
-	int device;
 
 	client = client_find_by_rpc_handle(handle);
 	if (!client) {
@@ -2718,13 +2718,16 @@ static struct packet *client_widget_mouse_off_hold(pid_t pid, int handle, const
 		goto out;
 	}
 
-	ret = packet_get(packet, "ssdiiiddi", &pkgname, &id, &timestamp, &x, &y, &source, &ratio_w, &ratio_h, &device);
+	ret = packet_view(packet, "ssdiiiddi");
 	if (ret != 9) {
 		ErrPrint("Parameter is not matched\n");
 		ret = WIDGET_ERROR_INVALID_PARAMETER;
 		goto out;
 	}
 
+	pkgname = packet_view_str(packet, MOUSE_EVENT_PKGNAME);
+	id = packet_view_str(packet, MOUSE_EVENT_ID);
+
 	ret = validate_request(pid, NULL, pkgname, id, &inst, &pkg);
 	if (ret != WIDGET_ERROR_NONE) {
 		goto out;
@@ -2741,8 +2744,8 @@ static struct packet *client_widget_mouse_off_hold(pid_t pid, int handle, const
 			goto out;
 		}
 
-		script_handler_update_pointer(script, device, x * ratio_w, y * ratio_h, -1);
-		script_handler_feed_event(script, WIDGET_SCRIPT_MOUSE_OFF_HOLD, timestamp);
+		update_pointer_by_packet(script, packet);
+		script_handler_feed_event(script, WIDGET_SCRIPT_MOUSE_OFF_HOLD, packet_view_double(packet, MOUSE_EVENT_TIMESTAMP));
 		ret = 0;
 	} else {
 		ErrPrint("Unsupported package\n");
@@ -2760,15 +2763,8 @@ static struct packet *client_gbar_mouse_on_scroll(pid_t pid, int handle, const s
 	const char *pkgname;
 	const char *id;
 	int ret;
-	double timestamp;
-	int x;
-	int y;
 	struct inst_info *inst;
 	const struct pkg_info *pkg;
-	int source;
-	double ratio_w;
-	double ratio_h;
-	int device;
 
 	client = client_find_by_rpc_handle(handle);
 	if (!client) {
@@ -2777,13 +2773,16 @@ static struct packet *client_gbar_mouse_on_scroll(pid_t pid, int handle, const s
 		goto out;
 	}
 
-	ret = packet_get(packet, "ssdiiiddi", &pkgname, &id, &timestamp, &x, &y, &source, &ratio_w, &ratio_h, &device);
+	ret = packet_view(packet, "ssdiiiddi");
 	if (ret != 9) {
 		ErrPrint("Parameter is not matched\n");
 		ret = WIDGET_ERROR_INVALID_PARAMETER;
 		goto out;
 	}
 
+	pkgname = packet_view_str(packet, MOUSE_EVENT_PKGNAME);
+	id = packet_view_str(packet, MOUSE_EVENT_ID);
+
 	ret = validate_request(pid, NULL, pkgname, id, &inst, &pkg);
 	if (ret != WIDGET_ERROR_NONE) {
 		goto out;
@@ -2800,8 +2799,8 @@ static struct packet *client_gbar_mouse_on_scroll(pid_t pid, int handle, const s
 			goto out;
 		}
 
-		script_handler_update_pointer(script, device, x * ratio_w, y * ratio_h, -1);
-		script_handler_feed_event(script, WIDGET_SCRIPT_MOUSE_ON_SCROLL, timestamp);
+		update_pointer_by_packet(script, packet);
+		script_handler_feed_event(script, WIDGET_SCRIPT_MOUSE_ON_SCROLL, packet_view_double(packet, MOUSE_EVENT_TIMESTAMP));
 		ret = 0;
 	} else {
 		ErrPrint("Unsupported package\n");
@@ -2819,15 +2818,8 @@ static struct packet *client_gbar_mouse_off_scroll(pid_t pid, int handle, const
 	const char *pkgname;
 	const char *id;
 	int ret;
-	double timestamp;
-	int x;
-	int y;
 	struct inst_info *inst;
 	const struct pkg_info *pkg;
-	int source;
-	double ratio_w;
-	double ratio_h;
-	int device;
 
 	client = client_find_by_rpc_handle(handle);
 	if (!client) {
@@ -2836,13 +2828,16 @@ static struct packet *client_gbar_mouse_off_scroll(pid_t pid, int handle, const
 		goto out;
 	}
 
-	ret = packet_get(packet, "ssdiiiddi", &pkgname, &id, &timestamp, &x, &y, &source, &ratio_w, &ratio_h, &device);
+	ret = packet_view(packet, "ssdiiiddi");
 	if (ret != 9) {
 		ErrPrint("Parameter is not matched\n");
 		ret = WIDGET_ERROR_INVALID_PARAMETER;
 		goto out;
 	}
 
+	pkgname = packet_view_str(packet, MOUSE_EVENT_PKGNAME);
+	id = packet_view_str(packet, MOUSE_EVENT_ID);
+
 	ret = validate_request(pid, NULL, pkgname, id, &inst, &pkg);
 	if (ret != WIDGET_ERROR_NONE) {
 		goto out;
@@ -2859,8 +2854,8 @@ static struct packet *client_gbar_mouse_off_scroll(pid_t pid, int handle, const
 			goto out;
 		}
 
-		script_handler_update_pointer(script, device, x * ratio_w, y * ratio_h, -1);
-		script_handler_feed_event(script, WIDGET_SCRIPT_MOUSE_OFF_SCROLL, timestamp);
+		update_pointer_by_packet(script, packet);
+		script_handler_feed_event(script, WIDGET_SCRIPT_MOUSE_OFF_SCROLL, packet_view_double(packet, MOUSE_EVENT_TIMESTAMP));
 		ret = 0;
 	} else {
 		ErrPrint("Unsupported package\n");
@@ -2878,15 +2873,8 @@ static struct packet *client_gbar_mouse_on_hold(pid_t pid, int handle, const str
 	const char *pkgname;
 	const char *id;
 	int ret;
-	double timestamp;
-	int x;
-	int y;
 	struct inst_info *inst;
 	const struct pkg_info *pkg;
-	int source;
-	double ratio_w;
-	double ratio_h;
-	int device;
 
 	client = client_find_by_rpc_handle(handle);
 	if (!client) {
@@ -2895,13 +2883,16 @@ static struct packet *client_gbar_mouse_on_hold(pid_t pid, int handle, const str
 		goto out;
 	}
 
-	ret = packet_get(packet, "ssdiiiddi", &pkgname, &id, &timestamp, &x, &y, &source, &ratio_w, &ratio_h, &device);
+	ret = packet_view(packet, "ssdiiiddi");
 	if (ret != 9) {
 		ErrPrint("Parameter is not matched\n");
 		ret = WIDGET_ERROR_INVALID_PARAMETER;
 		goto out;
 	}
 
+	pkgname = packet_view_str(packet, MOUSE_EVENT_PKGNAME);
+	id = packet_view_str(packet, MOUSE_EVENT_ID);
+
 	ret = validate_request(pid, NULL, pkgname, id, &inst, &pkg);
 	if (ret != WIDGET_ERROR_NONE) {
 		goto out;
@@ -2918,8 +2909,8 @@ static struct packet *client_gbar_mouse_on_hold(pid_t pid, int handle, const str
 			goto out;
 		}
 
-		script_handler_update_pointer(script, device, x * ratio_w, y * ratio_h, -1);
-		script_handler_feed_event(script, WIDGET_SCRIPT_MOUSE_ON_HOLD, timestamp);
+		update_pointer_by_packet(script, packet);
+		script_handler_feed_event(script, WIDGET_SCRIPT_MOUSE_ON_HOLD, packet_view_double(packet, MOUSE_EVENT_TIMESTAMP));
 		ret = 0;
 	} else {
 		ErrPrint("Unsupported package\n");
@@ -2937,15 +2928,8 @@ static struct packet *client_gbar_mouse_off_hold(pid_t pid, int handle, const st
 	const char *pkgname;
 	const char *id;
 	int ret;
-	double timestamp;
-	int x;
-	int y;
 	struct inst_info *inst;
 	const struct pkg_info *pkg;
-	int source;
-	double ratio_w;
-	double ratio_h;
-	int device;
 
 	client = client_find_by_rpc_handle(handle);
 	if (!client) {
@@ -2954,13 +2938,16 @@ static struct packet *client_gbar_mouse_off_hold(pid_t pid, int handle, const st
 		goto out;
 	}
 
-	ret = packet_get(packet, "ssdiiiddi", &pkgname, &id, &timestamp, &x, &y, &source, &ratio_w, &ratio_h, &device);
+	ret = packet_view(packet, "ssdiiiddi");
 	if (ret != 9) {
 		ErrPrint("Parameter is not matched\n");
 		ret = WIDGET_ERROR_INVALID_PARAMETER;
 		goto out;
 	}
 
+	pkgname = packet_view_str(packet, MOUSE_EVENT_PKGNAME);
+	id = packet_view_str(packet, MOUSE_EVENT_ID);
+
 	ret = validate_request(pid, NULL, pkgname, id, &inst, &pkg);
 	if (ret != WIDGET_ERROR_NONE) {
 		goto out;
@@ -2977,8 +2964,8 @@ static struct packet *client_gbar_mouse_off_hold(pid_t pid, int handle, const st
 			goto out;
 		}
 
-		script_handler_update_pointer(script, device, x * ratio_w, y * ratio_h, -1);
-		script_handler_feed_event(script, WIDGET_SCRIPT_MOUSE_OFF_HOLD, timestamp);
+		update_pointer_by_packet(script, packet);
+		script_handler_feed_event(script, WIDGET_SCRIPT_MOUSE_OFF_HOLD, packet_view_double(packet, MOUSE_EVENT_TIMESTAMP));
 		ret = 0;
 	} else {
 		ErrPrint("Unsupported package\n");
@@ -3047,7 +3034,7 @@ static struct packet *client_gbar_mouse_unset(pid_t pid, int handle, const struc
 			slave = package_slave(pkg);
 			if (slave) {
 				packet_ref((struct packet *)packet);
-				ret = slave_rpc_request_only(slave, pkgname, (struct packet *)packet, 0);
+				ret = slave_rpc_request_only(slave, pkgname, (struct packet *)packet, SLAVE_RPC_LANE_INTERACTIVE);
 			} else {
 				ErrPrint("Unable to find a slave for %s\n", pkgname);
 				ret = WIDGET_ERROR_FAULT;
@@ -3081,15 +3068,8 @@ static struct packet *client_widget_mouse_enter(pid_t pid, int handle, const str
 	const char *pkgname;
 	const char *id;
 	int ret;
-	double timestamp;
-	int x;
-	int y;
 	struct inst_info *inst;
 	const struct pkg_info *pkg;
-	int source;
-	double ratio_w;
-	double ratio_h;
-	int device;
 
 	client = client_find_by_rpc_handle(handle);
 	if (!client) {
@@ -3098,13 +3078,16 @@ static struct packet *client_widget_mouse_enter(pid_t pid, int handle, const str
 		goto out;
 	}
 
-	ret = packet_get(packet, "ssdiiiddi", &pkgname, &id, &timestamp, &x, &y, &source, &ratio_w, &ratio_h, &device);
+	ret = packet_view(packet, "ssdiiiddi");
 	if (ret != 9) {
 		ErrPrint("Parameter is not matched\n");
 		ret = WIDGET_ERROR_INVALID_PARAMETER;
 		goto out;
 	}
 
+	pkgname = packet_view_str(packet, MOUSE_EVENT_PKGNAME);
+	id = packet_view_str(packet, MOUSE_EVENT_ID);
+
 	ret = validate_request(pid, NULL, pkgname, id, &inst, &pkg);
 	if (ret != WIDGET_ERROR_NONE) {
 		goto out;
@@ -3121,8 +3104,8 @@ static struct packet *client_widget_mouse_enter(pid_t pid, int handle, const str
 			goto out;
 		}
 
-		script_handler_update_pointer(script, device, x * ratio_w, y * ratio_h, -1);
-		script_handler_feed_event(script, WIDGET_SCRIPT_MOUSE_IN, timestamp);
+		update_pointer_by_packet(script, packet);
+		script_handler_feed_event(script, WIDGET_SCRIPT_MOUSE_IN, packet_view_double(packet, MOUSE_EVENT_TIMESTAMP));
 		ret = 0;
 	} else {
 		ErrPrint("Unsupported package\n");
@@ -3140,15 +3123,8 @@ static struct packet *client_widget_mouse_leave(pid_t pid, int handle, const str
 	const char *pkgname;
 	const char *id;
 	int ret;
-	double timestamp;
-	int x;
-	int y;
 	struct inst_info *inst;
 	const struct pkg_info *pkg;
-	int source;
-	double ratio_w;
-	double ratio_h;
-	int device;
 
 	client = client_find_by_rpc_handle(handle);
 	if (!client) {
@@ -3157,13 +3133,16 @@ static struct packet *client_widget_mouse_leave(pid_t pid, int handle, const str
 		goto out;
 	}
 
-	ret = packet_get(packet, "ssdiiiddi", &pkgname, &id, &timestamp, &x, &y, &source, &ratio_w, &ratio_h, &device);
+	ret = packet_view(packet, "ssdiiiddi");
 	if (ret != 9) {
 		ErrPrint("Parameter is not matched\n");
 		ret = WIDGET_ERROR_INVALID_PARAMETER;
 		goto out;
 	}
 
+	pkgname = packet_view_str(packet, MOUSE_EVENT_PKGNAME);
+	id = packet_view_str(packet, MOUSE_EVENT_ID);
+
 	ret = validate_request(pid, NULL, pkgname, id, &inst, &pkg);
 	if (ret != WIDGET_ERROR_NONE) {
 		goto out;
@@ -3180,8 +3159,8 @@ static struct packet *client_widget_mouse_leave(pid_t pid, int handle, const str
 			goto out;
 		}
 
-		script_handler_update_pointer(script, device, x * ratio_w, y * ratio_h, -1);
-		script_handler_feed_event(script, WIDGET_SCRIPT_MOUSE_OUT, timestamp);
+		update_pointer_by_packet(script, packet);
+		script_handler_feed_event(script, WIDGET_SCRIPT_MOUSE_OUT, packet_view_double(packet, MOUSE_EVENT_TIMESTAMP));
 		ret = 0;
 	} else {
 		ErrPrint("Unsupported package\n");
@@ -5409,6 +5388,62 @@ out:
 	return NULL;
 }
 
+static struct packet *client_buffer_fd(pid_t pid, int handle, const struct packet *packet) /* id, - out - ret, fd */
+{
+	struct packet *result;
+	struct client_node *client;
+	struct buffer_info *info;
+	struct inst_info *inst;
+	const char *id;
+	int ret;
+	int fd = -1;
+
+	/*!
+	 * \note
+	 * Viewers send this using a oneshot connection, the handle is not the one of their RPC.
+	 */
+	client = client_find_by_pid(pid);
+	if (!client) {
+		ErrPrint("Client %d is not exists\n", pid);
+		ret = WIDGET_ERROR_NOT_EXIST;
+		goto out;
+	}
+
+	ret = packet_get(packet, "s", &id);
+	if (ret != 1) {
+		ErrPrint("Parameter is not matched\n");
+		ret = WIDGET_ERROR_INVALID_PARAMETER;
+		goto out;
+	}
+
+	info = buffer_handler_find_memfd(id);
+	if (!info) {
+		ErrPrint("Buffer is not exists: %s\n", id);
+		ret = WIDGET_ERROR_NOT_EXIST;
+		goto out;
+	}
+
+	inst = buffer_handler_instance(info);
+	if (!inst || (instance_client(inst) != client && !instance_has_client(inst, client))) {
+		ErrPrint("%d is not a viewer of %s\n", pid, id);
+		ret = WIDGET_ERROR_PERMISSION_DENIED;
+		goto out;
+	}
+
+	fd = buffer_handler_fd(info);
+	ret = fd < 0 ? fd : WIDGET_ERROR_NONE;
+
+out:
+	result = packet_create_reply(packet, "i", ret);
+	if (!result) {
+		ErrPrint("Failed to create a reply packet\n");
+	} else if (fd >= 0) {
+		packet_set_fd(result, fd);
+	}
+
+	return result;
+}
+
 static struct packet *client_gbar_acquire_xpixmap(pid_t pid, int handle, const struct packet *packet) /* pid, pkgname, filename, width, height, timestamp, x, y, ret */
 {
 	struct packet *result;
@@ -7685,6 +7720,58 @@ out:
 	return result;
 }
 
+static struct packet *slave_buffer_fd(pid_t pid, int handle, const struct packet *packet) /* id, - out - ret, fd */
+{
+	struct packet *result;
+	struct slave_node *slave;
+	struct buffer_info *info;
+	struct inst_info *inst;
+	const char *id;
+	int ret;
+	int fd = -1;
+
+	slave = slave_find_by_pid(pid);
+	if (!slave) {
+		ErrPrint("Slave %d is not exists\n", pid);
+		ret = WIDGET_ERROR_NOT_EXIST;
+		goto out;
+	}
+
+	ret = packet_get(packet, "s", &id);
+	if (ret != 1) {
+		ErrPrint("Parameter is not matched\n");
+		ret = WIDGET_ERROR_INVALID_PARAMETER;
+		goto out;
+	}
+
+	info = buffer_handler_find_memfd(id);
+	if (!info) {
+		ErrPrint("Buffer is not exists: %s\n", id);
+		ret = WIDGET_ERROR_NOT_EXIST;
+		goto out;
+	}
+
+	inst = buffer_handler_instance(info);
+	if (!inst || package_slave(instance_package(inst)) != slave) {
+		ErrPrint("%d is not the provider of %s\n", pid, id);
+		ret = WIDGET_ERROR_PERMISSION_DENIED;
+		goto out;
+	}
+
+	fd = buffer_handler_fd(info);
+	ret = fd < 0 ? fd : WIDGET_ERROR_NONE;
+
+out:
+	result = packet_create_reply(packet, "i", ret);
+	if (!result) {
+		ErrPrint("Failed to create a reply packet\n");
+	} else if (fd >= 0) {
+		packet_set_fd(result, fd);
+	}
+
+	return result;
+}
+
 static struct packet *slave_acquire_extra_buffer(pid_t pid, int handle, const struct packet *packet)
 {
 	struct slave_node *slave;
@@ -9210,7 +9297,7 @@ static struct packet *widget_mgr_slave_ctrl(pid_t pid, int handle, const struct
 		packet_cmd = CMD_CTRL_MODE;
 		ctrl_packet = packet_create_noack((const char *)&packet_cmd, "ssii", pkgname, id, cmd, value);
 		if (ctrl_packet) {
-			if (slave_rpc_request_only(package_slave(info), package_name(info), ctrl_packet, 0) < 0) {
+			if (slave_rpc_request_only(package_slave(info), package_name(info), ctrl_packet, SLAVE_RPC_LANE_BACKGROUND) < 0) {
 				ErrPrint("Failed to send request\n");
 			}
 		}
@@ -9786,6 +9873,11 @@ static struct method s_client_table[] = {
         .cmd = CMD_STR_HELLO_SYNC_PREPARE,
         .handler = slave_hello_sync_prepare, /* timestamp */
     },
+	{
+		/* String command only, int tagged commands of peers are the positions of the entries above */
+		.cmd = CMD_STR_BUFFER_FD,
+		.handler = client_buffer_fd, /* id, - out - ret, fd */
+	},
 
 	{
 		.cmd = NULL,
@@ -9938,6 +10030,11 @@ static struct method s_slave_table[] = {
         .cmd = CMD_STR_HELLO_SYNC_PREPARE,
         .handler = slave_hello_sync_prepare, /* timestamp */
     },
+	{
+		/* String command only, int tagged commands of peers are the positions of the entries above */
+		.cmd = CMD_STR_BUFFER_FD,
+		.handler = slave_buffer_fd, /* id, - out - ret, fd */
+	},
 
 	{
 		.cmd = NULL,
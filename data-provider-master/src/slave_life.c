@@ -19,6 +19,7 @@
 #include <errno.h> /* errno */
 #include <unistd.h> /* pid_t */
 #include <stdlib.h> /* free */
+#include <ctype.h> /* tolower */
 #include <pthread.h>
 #include <malloc.h>
 #include <sys/time.h>
@@ -128,6 +129,7 @@ struct slave_node {
 
 	char *hw_acceleration;
 	char *extra_bundle_data;
+	char *pool_key; /*!< Key of the candidate pool which has this slave */
 
 	struct _resource {
 		struct _memory {
@@ -152,12 +154,132 @@ struct priv_data {
 
 static struct {
 	Eina_List *slave_list;
+	Eina_Hash *name_table; /*!< name -> slave_node */
+	Eina_Hash *pid_table; /*!< pid -> slave_node, only for launched slaves */
+	Eina_Hash *pool_table; /*!< pool key -> list of slave_nodes, sorted by the count of loaded packages */
 	int deactivate_all_refcnt;
 } s_info = {
 	.slave_list = NULL,
+	.name_table = NULL,
+	.pid_table = NULL,
+	.pool_table = NULL,
 	.deactivate_all_refcnt = 0,
 };
 
+/*!
+ * \brief
+ * Slaves which are able to be shared with each other have the same pool key.
+ * abi, pkgname and hw_acceleration are compared case-insensitively, and the network is not cared for secured slaves.
+ */
+static char *make_pool_key(const char *abi, const char *pkgname, int secured, int network, const char *hw_acceleration, int auto_align)
+{
+	char *key;
+	char *ptr;
+	int len;
+
+	len = strlen(abi) + strlen(pkgname) + (hw_acceleration ? strlen(hw_acceleration) : 0) + 16;
+	key = malloc(len);
+	if (!key) {
+		ErrPrint("malloc: %d\n", errno);
+		return NULL;
+	}
+
+	snprintf(key, len, "%s|%s|%d%d%d|%c%s", abi, pkgname, !!secured, secured ? 0 : !!network, !!auto_align, hw_acceleration ? '+' : '-', hw_acceleration ? hw_acceleration : "");
+
+	for (ptr = key; *ptr; ptr++) {
+		*ptr = tolower(*ptr);
+	}
+
+	return key;
+}
+
+static int pool_load_cmp(const void *a, const void *b)
+{
+	const struct slave_node *slave_a = a;
+	const struct slave_node *slave_b = b;
+
+	return slave_a->loaded_package - slave_b->loaded_package;
+}
+
+static void pool_del(struct slave_node *slave)
+{
+	Eina_List *list;
+
+	if (!slave->pool_key) {
+		return;
+	}
+
+	list = eina_hash_find(s_info.pool_table, slave->pool_key);
+	list = eina_list_remove(list, slave);
+	if (list) {
+		eina_hash_set(s_info.pool_table, slave->pool_key, list);
+	} else {
+		eina_hash_del_by_key(s_info.pool_table, slave->pool_key);
+	}
+
+	DbgFree(slave->pool_key);
+	slave->pool_key = NULL;
+}
+
+static void pool_add(struct slave_node *slave)
+{
+	Eina_List *list;
+
+	if (!s_info.pool_table) {
+		s_info.pool_table = eina_hash_string_superfast_new(NULL);
+		if (!s_info.pool_table) {
+			ErrPrint("Failed to create a pool of slaves\n");
+			return;
+		}
+	}
+
+	slave->pool_key = make_pool_key(slave->abi, slave->pkgname, slave->flags.field.secured, slave->flags.field.network, slave->hw_acceleration, slave->flags.field.auto_align);
+	if (!slave->pool_key) {
+		return;
+	}
+
+	list = eina_hash_find(s_info.pool_table, slave->pool_key);
+	list = eina_list_sorted_insert(list, pool_load_cmp, slave);
+	eina_hash_set(s_info.pool_table, slave->pool_key, list);
+}
+
+/*!
+ * \brief
+ * Should be called whenever the load or the attributes of the key is changed.
+ */
+static inline void pool_update(struct slave_node *slave)
+{
+	pool_del(slave);
+	pool_add(slave);
+}
+
+/*!
+ * \brief
+ * Every update of the slave->pid should be done via this, to keep the pid table
+ */
+static void set_pid(struct slave_node *slave, pid_t pid)
+{
+	if (slave->pid > 0 && s_info.pid_table && eina_hash_find(s_info.pid_table, &slave->pid) == slave) {
+		eina_hash_del_by_key(s_info.pid_table, &slave->pid);
+	}
+
+	slave->pid = pid;
+
+	if (pid <= 0) {
+		return;
+	}
+
+	if (!s_info.pid_table) {
+		s_info.pid_table = eina_hash_int32_new(NULL);
+		if (!s_info.pid_table) {
+			ErrPrint("Failed to create a table of pids\n");
+			return;
+		}
+	}
+
+	eina_hash_set(s_info.pid_table, &slave->pid, slave);
+}
+
 static inline int apply_resource_limit(struct slave_node *slave)
 {
 	struct rlimit limit;
@@ -411,6 +533,19 @@ static inline struct slave_node *create_slave_node(const char *name, int is_secu
 	xmonitor_add_event_callback(XMONITOR_RESUMED, xmonitor_resume_cb, slave);
 
 	s_info.slave_list = eina_list_append(s_info.slave_list, slave);
+
+	if (!s_info.name_table) {
+		s_info.name_table = eina_hash_string_superfast_new(NULL);
+		if (!s_info.name_table) {
+			ErrPrint("Failed to create a table of slaves\n");
+		}
+	}
+
+	if (s_info.name_table) {
+		eina_hash_add(s_info.name_table, slave->name, slave);
+	}
+
+	pool_add(slave);
 	return slave;
 }
 
@@ -468,6 +603,10 @@ static inline void destroy_slave_node(struct slave_node *slave)
 	}
 
 	s_info.slave_list = eina_list_remove(s_info.slave_list, slave);
+	if (s_info.name_table && eina_hash_find(s_info.name_table, slave->name) == slave) {
+		eina_hash_del_by_key(s_info.name_table, slave->name);
+	}
+	pool_del(slave);
 
 	if (slave->ttl_timer) {
 		ecore_timer_del(slave->ttl_timer);
@@ -492,16 +631,11 @@ static inline void destroy_slave_node(struct slave_node *slave)
 
 static inline struct slave_node *find_slave(const char *name)
 {
-	struct slave_node *slave;
-	Eina_List *l;
-
-	EINA_LIST_FOREACH(s_info.slave_list, l, slave) {
-		if (!strcmp(slave->name, name)) {
-			return slave;
-		}
+	if (!name || !s_info.name_table) {
+		return NULL;
 	}
 
-	return NULL;
+	return eina_hash_find(s_info.name_table, name);
 }
 
 HAPI int slave_expired_ttl(struct slave_node *slave)
@@ -794,7 +928,7 @@ static Eina_Bool relaunch_timer_cb(void *data)
 			invoke_slave_fault_handler(slave);
 		} else {
 			ErrPrint("Launch App [%s]\n", slave_pkgname(slave));
-			slave->pid = (pid_t)aul_launch_app(slave_pkgname(slave), param);
+			set_pid(slave, (pid_t)aul_launch_app(slave_pkgname(slave), param));
 			bundle_free(param);
 
 			switch (slave->pid) {
@@ -805,7 +939,7 @@ static Eina_Bool relaunch_timer_cb(void *data)
 			case AUL_R_ENOINIT:		/**< AUL handler NOT initialized */
 			case AUL_R_ERROR:		/**< General error */
 				CRITICAL_LOG("Failed to launch a new slave %s (%d)\n", slave_name(slave), slave->pid);
-				slave->pid = (pid_t)-1;
+				set_pid(slave, (pid_t)-1);
 				ecore_timer_del(slave->activate_timer);
 				slave->activate_timer = NULL;
 
@@ -822,7 +956,7 @@ static Eina_Bool relaunch_timer_cb(void *data)
 				slave->relaunch_count--;
 
 				CRITICAL_LOG("Try relaunch again %s (%d), %d\n", slave_name(slave), slave->pid, slave->relaunch_count);
-				slave->pid = (pid_t)-1;
+				set_pid(slave, (pid_t)-1);
 				ret = ECORE_CALLBACK_RENEW;
 				ecore_timer_reset(slave->activate_timer);
 				/* Try again after a few secs later */
@@ -902,7 +1036,7 @@ HAPI int slave_activate(struct slave_node *slave)
 		slave->relaunch_count = WIDGET_CONF_SLAVE_RELAUNCH_COUNT;
 
 		ErrPrint("Launch App [%s]\n", slave_pkgname(slave));
-		slave->pid = (pid_t)aul_launch_app(slave_pkgname(slave), param);
+		set_pid(slave, (pid_t)aul_launch_app(slave_pkgname(slave), param));
 
 		bundle_free(param);
 
@@ -914,7 +1048,7 @@ HAPI int slave_activate(struct slave_node *slave)
 		case AUL_R_ENOINIT:		/**< AUL handler NOT initialized */
 		case AUL_R_ERROR:		/**< General error */
 			CRITICAL_LOG("Failed to launch a new slave %s (%d)\n", slave_name(slave), slave->pid);
-			slave->pid = (pid_t)-1;
+			set_pid(slave, (pid_t)-1);
 			/* Waiting app-launch result */
 			break;
 		case AUL_R_ECOMM:		/**< Comunication Error */
@@ -926,7 +1060,7 @@ HAPI int slave_activate(struct slave_node *slave)
 			slave->relaunch_timer = ecore_timer_add(WIDGET_CONF_SLAVE_RELAUNCH_TIME, relaunch_timer_cb, slave);
 			if (!slave->relaunch_timer) {
 				CRITICAL_LOG("Failed to register a relaunch timer (%s)\n", slave_name(slave));
-				slave->pid = (pid_t)-1;
+				set_pid(slave, (pid_t)-1);
 				return WIDGET_ERROR_FAULT;
 			}
 			/* Try again after a few secs later */
@@ -1107,7 +1241,7 @@ HAPI struct slave_node *slave_deactivated(struct slave_node *slave)
 {
 	int reactivate;
 
-	slave->pid = (pid_t)-1;
+	set_pid(slave, (pid_t)-1);
 	slave->state = SLAVE_TERMINATED;
 
 	if (slave->ttl_timer) {
@@ -1516,6 +1650,11 @@ HAPI struct slave_node *slave_find_by_pid(pid_t pid)
 	Eina_List *l;
 	struct slave_node *slave;
 
+	if (pid > 0) {
+		return s_info.pid_table ? eina_hash_find(s_info.pid_table, &pid) : NULL;
+	}
+
+	/* Not launched slaves are not indexed */
 	EINA_LIST_FOREACH(s_info.slave_list, l, slave) {
 		if (slave_pid(slave) == pid) {
 			return slave;
@@ -1527,28 +1666,34 @@ HAPI struct slave_node *slave_find_by_pid(pid_t pid)
 
 HAPI struct slave_node *slave_find_by_name(const char *name)
 {
-	Eina_List *l;
-	struct slave_node *slave;
-
-	EINA_LIST_FOREACH(s_info.slave_list, l, slave) {
-		if (!strcmp(slave_name(slave), name)) {
-			return slave;
-		}
-	}
-
-	return NULL;
+	return find_slave(name);
 }
 
 HAPI struct slave_node *slave_find_available(const char *slave_pkgname, const char *abi, int secured, int network, const char *hw_acceleration, int auto_align)
 {
 	Eina_List *l;
+	Eina_List *list;
 	struct slave_node *slave;
+	char *key;
 
-	EINA_LIST_FOREACH(s_info.slave_list, l, slave) {
-		if (slave->flags.field.secured != secured) {
-			continue;
-		}
+	if (!s_info.pool_table || !slave_pkgname || !abi) {
+		return NULL;
+	}
 
+	key = make_pool_key(abi, slave_pkgname, secured, network, hw_acceleration, auto_align);
+	if (!key) {
+		return NULL;
+	}
+
+	list = eina_hash_find(s_info.pool_table, key);
+	DbgFree(key);
+
+	/*!
+	 * \note
+	 * Slaves in the pool are sorted by their load,
+	 * so the first usable one is the least loaded one.
+	 */
+	EINA_LIST_FOREACH(list, l, slave) {
 		if ((slave->state == SLAVE_REQUEST_TO_TERMINATE || slave->state == SLAVE_REQUEST_TO_DISCONNECT) && slave->loaded_instance == 0) {
 			/*!
 			 * \note
@@ -1562,46 +1707,32 @@ HAPI struct slave_node *slave_find_available(const char *slave_pkgname, const ch
 			continue;
 		}
 
-		if (strcasecmp(slave->abi, abi)) {
-			continue;
-		}
-
-		if (strcasecmp(slave->pkgname, slave_pkgname)) {
-			continue;
-		}
-
-		if (slave->hw_acceleration != hw_acceleration) {
-			if (!slave->hw_acceleration || !hw_acceleration || strcasecmp(slave->hw_acceleration, hw_acceleration)) {
-				continue;
-			}
-		}
-
-		if (slave->flags.field.auto_align != auto_align) {
-			continue;
-		}
-
 		if (slave->flags.field.secured) {
 			if (slave->loaded_package == 0) {
 				DbgPrint("Found secured slave - has no instances (%s)\n", slave_name(slave));
 				return slave;
 			}
-		} else if (slave->flags.field.network == network) {
-			DbgPrint("slave[%s] loaded_package[%d] net: [%d]\n", slave_name(slave), slave->loaded_package, slave->flags.field.network);
-			if (!strcasecmp(abi, WIDGET_CONF_DEFAULT_ABI)) {
-				int max_load;
-				if (g_conf.slave_max_load < 0) {
-					max_load = WIDGET_CONF_SLAVE_MAX_LOAD;
-				} else {
-					max_load = g_conf.slave_max_load;
-				}
 
-				if (slave->loaded_package < max_load) {
-					return slave;
-				}
+			break;
+		}
+
+		DbgPrint("slave[%s] loaded_package[%d] net: [%d]\n", slave_name(slave), slave->loaded_package, slave->flags.field.network);
+		if (!strcasecmp(abi, WIDGET_CONF_DEFAULT_ABI)) {
+			int max_load;
+			if (g_conf.slave_max_load < 0) {
+				max_load = WIDGET_CONF_SLAVE_MAX_LOAD;
 			} else {
+				max_load = g_conf.slave_max_load;
+			}
+
+			if (slave->loaded_package < max_load) {
 				return slave;
 			}
+
+			break;
 		}
+
+		return slave;
 	}
 
 	return NULL;
@@ -1629,22 +1760,12 @@ HAPI struct slave_node *slave_find_by_pkgname(const char *pkgname)
 
 HAPI struct slave_node *slave_find_by_rpc_handle(int handle)
 {
-	Eina_List *l;
-	struct slave_node *slave;
-
 	if (handle <= 0) {
 		ErrPrint("Invalid RPC handle: %d\n", handle);
 		return NULL;
 	}
 
-	EINA_LIST_FOREACH(s_info.slave_list, l, slave) {
-		if (slave_rpc_handle(slave) == handle) {
-			return slave;
-		}
-	}
-
-	/* Not found */
-	return NULL;
+	return slave_rpc_find_by_handle(handle);
 }
 
 HAPI char *slave_package_name(const char *abi, const char *lbid)
@@ -1682,6 +1803,7 @@ HAPI char *slave_package_name(const char *abi, const char *lbid)
 HAPI void slave_load_package(struct slave_node *slave)
 {
 	slave->loaded_package++;
+	pool_update(slave);
 }
 
 HAPI void slave_unload_package(struct slave_node *slave)
@@ -1692,6 +1814,7 @@ HAPI void slave_unload_package(struct slave_node *slave)
 	}
 
 	slave->loaded_package--;
+	pool_update(slave);
 }
 
 HAPI void slave_load_instance(struct slave_node *slave)
@@ -1762,7 +1885,7 @@ HAPI int slave_set_pid(struct slave_node *slave, pid_t pid)
 
 	DbgPrint("Slave PID is updated to %d from %d\n", pid, slave_pid(slave));
 
-	slave->pid = pid;
+	set_pid(slave, pid);
 	return WIDGET_ERROR_NONE;
 }
 
@@ -1881,7 +2004,7 @@ HAPI int slave_resume(struct slave_node *slave)
 	}
 
 	slave->state = SLAVE_REQUEST_TO_RESUME;
-	return slave_rpc_async_request(slave, NULL, packet, resume_cb, NULL, 0);
+	return slave_rpc_async_request(slave, NULL, packet, resume_cb, NULL, SLAVE_RPC_LANE_INTERACTIVE);
 }
 
 HAPI int slave_pause(struct slave_node *slave)
@@ -1913,7 +2036,7 @@ HAPI int slave_pause(struct slave_node *slave)
 	}
 
 	slave->state = SLAVE_REQUEST_TO_PAUSE;
-	return slave_rpc_async_request(slave, NULL, packet, pause_cb, NULL, 0);
+	return slave_rpc_async_request(slave, NULL, packet, pause_cb, NULL, SLAVE_RPC_LANE_INTERACTIVE);
 }
 
 HAPI const char *slave_pkgname(const struct slave_node *slave)
@@ -2050,6 +2173,7 @@ HAPI int slave_network(const struct slave_node *slave)
 HAPI void slave_set_network(struct slave_node *slave, int network)
 {
 	slave->flags.field.network = network;
+	pool_update(slave);
 }
 
 HAPI int slave_deactivate_all(int reactivate, int reactivate_instances, int no_timer)
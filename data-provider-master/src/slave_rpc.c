@@ -44,6 +44,12 @@
 #include "conf.h"
 #include "instance.h"
 
+/*!
+ * \brief
+ * Maximum count of commands sent at once, whenever the socket of a slave becomes writable.
+ */
+#define SLAVE_RPC_BATCH_MAX 16
+
 struct slave_rpc {
 	Ecore_Timer *pong_timer;
 	int handle;
@@ -51,6 +57,12 @@ struct slave_rpc {
 	unsigned long ping_count;
 	unsigned long next_ping_count;
 	Eina_List *pending_list;
+
+	Eina_List *lane[SLAVE_RPC_LANE_MAX]; /*!< Commands which are waiting to be sent */
+	Ecore_Fd_Handler *writable; /*!< Consuming lanes, exists only if there is a command to send */
+	Ecore_Timer *retry_timer; /*!< Sending is paused until this expires, if a command is failed to be sent */
+	int inflight; /*!< Count of PACKET_REQ waiting for the reply */
+	unsigned long epoch; /*!< Increased whenever the connection is lost, to ignore replies of old requests */
 };
 
 struct command {
@@ -59,28 +71,43 @@ struct command {
 	struct packet *packet;
 	struct slave_node *slave;
 	int ttl; /* If it fails to handle this, destroy this */
+	enum slave_rpc_lane lane;
+	unsigned long epoch; /*!< epoch of the rpc when this request is sent */
 
 	/* Don't need to care these data */
 	void (*ret_cb)(struct slave_node *slave, const struct packet *packet, void *cbdata);
 	void *cbdata;
 };
 
-static struct info {
-	Eina_List *command_list;
-	Ecore_Timer *command_consuming_timer;
-} s_info = {
-	.command_list = NULL,
-	.command_consuming_timer = NULL,
+/*!
+ * \brief
+ * Lanes in the order of priority
+ */
+static const enum slave_rpc_lane s_lane_order[SLAVE_RPC_LANE_MAX] = {
+	SLAVE_RPC_LANE_URGENT,
+	SLAVE_RPC_LANE_INTERACTIVE,
+	SLAVE_RPC_LANE_BACKGROUND,
 };
 
 #define DEFAULT_CMD_TTL 3
 
-static void prepend_command(struct command *command);
+static struct {
+	Eina_Hash *handle_table; /*!< rpc handle -> slave_node, only for connected slaves */
+} s_info = {
+	.handle_table = NULL,
+};
 
-static inline struct command *create_command(struct slave_node *slave, const char *pkgname, struct packet *packet)
+static void kick_consumer(struct slave_node *slave, struct slave_rpc *rpc);
+
+static inline struct command *create_command(struct slave_node *slave, const char *pkgname, struct packet *packet, enum slave_rpc_lane lane)
 {
 	struct command *command;
 
+	if (lane < 0 || lane >= SLAVE_RPC_LANE_MAX) {
+		ErrPrint("Invalid lane: %d\n", lane);
+		lane = SLAVE_RPC_LANE_BACKGROUND;
+	}
+
 	command = calloc(1, sizeof(*command));
 	if (!command) {
 		ErrPrint("calloc: %d\n", errno);
@@ -99,6 +126,7 @@ static inline struct command *create_command(struct slave_node *slave, const cha
 	command->slave = slave_ref(slave); /*!< To prevent from destroying of the slave while communicating with the slave */
 	command->packet = packet_ref(packet);
 	command->ttl = DEFAULT_CMD_TTL;
+	command->lane = lane;
 
 	return command;
 }
@@ -111,28 +139,94 @@ static inline void destroy_command(struct command *command)
 	DbgFree(command);
 }
 
-static inline struct command *pop_command(void)
+/*!
+ * \brief
+ * Every update of the rpc->handle should be done via this, to keep the handle table
+ */
+static void set_handle(struct slave_node *slave, struct slave_rpc *rpc, int handle)
+{
+	if (rpc->handle > 0 && s_info.handle_table && eina_hash_find(s_info.handle_table, &rpc->handle) == slave) {
+		eina_hash_del_by_key(s_info.handle_table, &rpc->handle);
+	}
+
+	rpc->handle = handle;
+
+	if (handle <= 0) {
+		return;
+	}
+
+	if (!s_info.handle_table) {
+		s_info.handle_table = eina_hash_int32_new(NULL);
+		if (!s_info.handle_table) {
+			ErrPrint("Failed to create a table of handles\n");
+			return;
+		}
+	}
+
+	if (!eina_hash_modify(s_info.handle_table, &handle, slave)) {
+		eina_hash_add(s_info.handle_table, &handle, slave);
+	}
+}
+
+/*!
+ * \brief
+ * Find the lane which has a command can be sent now.
+ * A request is held while the slave has too many requests waiting for the reply,
+ * but it does not block other lanes.
+ * \return lane or -ENOENT
+ */
+static int sendable_lane(struct slave_rpc *rpc)
 {
 	struct command *command;
+	int i;
 
-	command = eina_list_nth(s_info.command_list, 0);
-	if (!command) {
+	for (i = 0; i < SLAVE_RPC_LANE_MAX; i++) {
+		command = eina_list_data_get(rpc->lane[s_lane_order[i]]);
+		if (!command) {
+			continue;
+		}
+
+		if (packet_type(command->packet) == PACKET_REQ && g_conf.slave_max_inflight > 0 && rpc->inflight >= g_conf.slave_max_inflight) {
+			continue;
+		}
+
+		return s_lane_order[i];
+	}
+
+	return -ENOENT;
+}
+
+static inline struct command *pop_command(struct slave_rpc *rpc)
+{
+	struct command *command;
+	int lane;
+
+	lane = sendable_lane(rpc);
+	if (lane < 0) {
 		return NULL;
 	}
 
-	s_info.command_list = eina_list_remove(s_info.command_list, command);
+	command = eina_list_data_get(rpc->lane[lane]);
+	rpc->lane[lane] = eina_list_remove_list(rpc->lane[lane], rpc->lane[lane]);
 	return command;
 }
 
 static int slave_async_cb(pid_t pid, int handle, const struct packet *packet, void *data)
 {
 	struct command *command = data;
+	struct slave_rpc *rpc;
 
 	if (!command) {
 		ErrPrint("Command is NIL\n");
 		return WIDGET_ERROR_NONE;
 	}
 
+	rpc = slave_data(command->slave, "rpc");
+	if (rpc && rpc->epoch == command->epoch && rpc->inflight > 0) {
+		rpc->inflight--;
+		kick_consumer(command->slave, rpc);
+	}
+
 	/*!
 	 * \note
 	 * command->packet is not valid from here.
@@ -171,17 +265,24 @@ out:
 	return WIDGET_ERROR_NONE;
 }
 
-static Eina_Bool command_consumer_cb(void *data)
+/*!
+ * \note
+ * The command is destroyed already, the slave could be gone as well, so only the handle is used.
+ */
+static void batch_result_cb(int handle, const struct packet *packet, int status, void *data)
 {
-	struct command *command;
-	struct slave_rpc *rpc;
-
-	command = pop_command();
-	if (!command) {
-		s_info.command_consuming_timer = NULL;
-		return ECORE_CALLBACK_CANCEL;
+	if (status < 0) {
+		ErrPrint("Failed to send %s to slave(%d): %d\n", packet_command(packet), handle, status);
 	}
+}
 
+/*!
+ * \brief
+ * Send a command, the command is consumed if this returns 0.
+ * If it returns negative value, the command is put back to the head of its lane to try again later.
+ */
+static int send_command(struct slave_rpc *rpc, struct command *command)
+{
 	if (!slave_is_activated(command->slave)) {
 		ErrPrint("Slave is not activated: %s(%d)\n",
 				slave_name(command->slave), slave_pid(command->slave));
@@ -198,24 +299,27 @@ static Eina_Bool command_consumer_cb(void *data)
 		}
 	}
 
-	rpc = slave_data(command->slave, "rpc");
-	if (!rpc || rpc->handle < 0) {
-		ErrPrint("Slave has no rpc info\n");
-		goto errout;
-	}
-
 	if (packet_type(command->packet) == PACKET_REQ_NOACK) {
-		if (com_core_packet_send_only(rpc->handle, command->packet) == 0) {
+		/*!
+		 * \note
+		 * Gathered packets are sent via one sendmsg by com_core_packet_batch_flush().
+		 */
+		if (com_core_packet_batch_send(rpc->handle, command->packet, batch_result_cb, NULL) == 0) {
 			/* Keep a slave alive, while processing events */
 			slave_give_more_ttl(command->slave);
 			destroy_command(command);
-			return ECORE_CALLBACK_RENEW;
+			return 0;
 		}
 	} else if (packet_type(command->packet) == PACKET_REQ) {
+		/* Gathered packets should be sent before this, to keep the order */
+		(void)com_core_packet_batch_flush(rpc->handle);
+
+		command->epoch = rpc->epoch;
 		if (com_core_packet_async_send(rpc->handle, command->packet, 0.0f, slave_async_cb, command) == 0) {
+			rpc->inflight++;
 			/* Keep a slave alive, while processing events */
 			slave_give_more_ttl(command->slave);
-			return ECORE_CALLBACK_RENEW;
+			return 0;
 		}
 	}
 
@@ -241,11 +345,12 @@ static Eina_Bool command_consumer_cb(void *data)
 	if (command->ttl == 0) {
 		DbgPrint("Discard packet (%d)\n", command->ttl);
 		destroy_command(command);
-	} else {
-		DbgPrint("Send again (%d)\n", command->ttl);
-		prepend_command(command);
+		return 0;
 	}
-	return ECORE_CALLBACK_RENEW;
+
+	DbgPrint("Send again (%d)\n", command->ttl);
+	rpc->lane[command->lane] = eina_list_prepend(rpc->lane[command->lane], command);
+	return WIDGET_ERROR_IO_ERROR;
 
 errout:
 	if (command->ret_cb) {
@@ -253,38 +358,121 @@ errout:
 	}
 
 	destroy_command(command);
-	return ECORE_CALLBACK_RENEW;
+	return 0;
 }
 
-static void prepend_command(struct command *command)
+static Eina_Bool retry_timer_cb(void *data)
 {
-	s_info.command_list = eina_list_prepend(s_info.command_list, command);
+	struct slave_node *slave = data;
+	struct slave_rpc *rpc;
 
-	if (s_info.command_consuming_timer) {
-		return;
+	rpc = slave_data(slave, "rpc");
+	if (!rpc) {
+		ErrPrint("Slave RPC is not valid (%s)\n", slave_name(slave));
+		return ECORE_CALLBACK_CANCEL;
 	}
 
-	s_info.command_consuming_timer = ecore_timer_add(WIDGET_CONF_PACKET_TIME, command_consumer_cb, NULL);
-	if (!s_info.command_consuming_timer) {
-		ErrPrint("Failed to add command consumer\n");
-		s_info.command_list = eina_list_remove(s_info.command_list, command);
-		destroy_command(command);
+	rpc->retry_timer = NULL;
+	kick_consumer(slave, rpc);
+	return ECORE_CALLBACK_CANCEL;
+}
+
+static Eina_Bool command_consumer_cb(void *data, Ecore_Fd_Handler *handler)
+{
+	struct slave_node *slave = data;
+	struct slave_rpc *rpc;
+	struct command *command;
+	Eina_Bool ret = ECORE_CALLBACK_RENEW;
+	int count;
+
+	rpc = slave_data(slave, "rpc");
+	if (!rpc) {
+		ErrPrint("Slave RPC is not valid (%s)\n", slave_name(slave));
+		return ECORE_CALLBACK_CANCEL;
+	}
+
+	/*!
+	 * \note
+	 * Callbacks of failed commands can release the last reference of the slave.
+	 */
+	slave_ref(slave);
+
+	for (count = 0; count < SLAVE_RPC_BATCH_MAX && rpc->handle >= 0 && (command = pop_command(rpc)); count++) {
+		if (send_command(rpc, command) < 0) {
+			/*!
+			 * \note
+			 * Only this slave waits for the retry, others are not blocked by this.
+			 */
+			rpc->retry_timer = ecore_timer_add(WIDGET_CONF_PACKET_TIME, retry_timer_cb, slave);
+			if (!rpc->retry_timer) {
+				ErrPrint("Failed to add retry timer\n");
+			}
+			break;
+		}
 	}
+
+	if (rpc->handle >= 0) {
+		(void)com_core_packet_batch_flush(rpc->handle);
+	}
+
+	/* The handler can be replaced by callbacks of commands */
+	if (rpc->writable == handler && (rpc->retry_timer || rpc->handle < 0 || sendable_lane(rpc) < 0)) {
+		rpc->writable = NULL;
+		ret = ECORE_CALLBACK_CANCEL;
+	}
+
+	slave_unref(slave);
+	return ret;
 }
 
-static void push_command(struct command *command)
+/*!
+ * \brief
+ * Sending is started as soon as the socket of the slave becomes writable.
+ */
+static void kick_consumer(struct slave_node *slave, struct slave_rpc *rpc)
 {
-	s_info.command_list = eina_list_append(s_info.command_list, command);
+	if (rpc->writable || rpc->retry_timer || rpc->handle < 0) {
+		return;
+	}
 
-	if (s_info.command_consuming_timer) {
+	if (sendable_lane(rpc) < 0) {
 		return;
 	}
 
-	s_info.command_consuming_timer = ecore_timer_add(WIDGET_CONF_PACKET_TIME, command_consumer_cb, NULL);
-	if (!s_info.command_consuming_timer) {
+	rpc->writable = ecore_main_fd_handler_add(rpc->handle, ECORE_FD_WRITE, command_consumer_cb, slave, NULL, NULL);
+	if (!rpc->writable) {
 		ErrPrint("Failed to add command consumer\n");
-		s_info.command_list = eina_list_remove(s_info.command_list, command);
-		destroy_command(command);
+	}
+}
+
+static void push_command(struct slave_rpc *rpc, struct command *command)
+{
+	rpc->lane[command->lane] = eina_list_append(rpc->lane[command->lane], command);
+	kick_consumer(command->slave, rpc);
+}
+
+static void clear_command(struct slave_rpc *rpc)
+{
+	struct command *command;
+	int i;
+
+	if (rpc->writable) {
+		ecore_main_fd_handler_del(rpc->writable);
+		rpc->writable = NULL;
+	}
+
+	if (rpc->retry_timer) {
+		ecore_timer_del(rpc->retry_timer);
+		rpc->retry_timer = NULL;
+	}
+
+	for (i = 0; i < SLAVE_RPC_LANE_MAX; i++) {
+		EINA_LIST_FREE(rpc->lane[i], command) {
+			if (command->ret_cb) {
+				command->ret_cb(command->slave, NULL, command->cbdata);
+			}
+			destroy_command(command);
+		}
 	}
 }
 
@@ -292,8 +480,6 @@ static int slave_deactivate_cb(struct slave_node *slave, void *data)
 {
 	struct slave_rpc *rpc;
 	struct command *command;
-	Eina_List *l;
-	Eina_List *n;
 
 	rpc = slave_data(slave, "rpc");
 	if (!rpc) {
@@ -320,15 +506,7 @@ static int slave_deactivate_cb(struct slave_node *slave, void *data)
 			destroy_command(command);
 		}
 	} else {
-		EINA_LIST_FOREACH_SAFE(s_info.command_list, l, n, command) {
-			if (command->slave == slave) {
-				s_info.command_list = eina_list_remove(s_info.command_list, command);
-				if (command->ret_cb) {
-					command->ret_cb(command->slave, NULL, command->cbdata);
-				}
-				destroy_command(command);
-			}
-		}
+		clear_command(rpc);
 	}
 
 	/*!
@@ -336,7 +514,7 @@ static int slave_deactivate_cb(struct slave_node *slave, void *data)
 	 * Reset handle
 	 */
 	DbgPrint("Reset handle for %d (%d)\n", slave_pid(slave), rpc->handle);
-	rpc->handle = -1;
+	set_handle(slave, rpc, -1);
 
 	/*!
 	 * \todo
@@ -344,6 +522,10 @@ static int slave_deactivate_cb(struct slave_node *slave, void *data)
 	 */
 	rpc->ping_count = 0;
 	rpc->next_ping_count = 1;
+
+	/* Replies of requests sent via the lost connection are not counted anymore */
+	rpc->inflight = 0;
+	rpc->epoch++;
 	return WIDGET_ERROR_NONE;
 }
 
@@ -381,12 +563,12 @@ static Eina_Bool ping_timeout_cb(void *data)
 	return ECORE_CALLBACK_CANCEL;
 }
 
-HAPI int slave_rpc_async_request(struct slave_node *slave, const char *pkgname, struct packet *packet, void (*ret_cb)(struct slave_node *slave, const struct packet *packet, void *data), void *data, int urgent)
+HAPI int slave_rpc_async_request(struct slave_node *slave, const char *pkgname, struct packet *packet, void (*ret_cb)(struct slave_node *slave, const struct packet *packet, void *data), void *data, enum slave_rpc_lane lane)
 {
 	struct command *command;
 	struct slave_rpc *rpc;
 
-	command = create_command(slave, pkgname, packet);
+	command = create_command(slave, pkgname, packet, lane);
 	if (!command) {
 		ErrPrint("Failed to create command\n");
 
@@ -431,7 +613,7 @@ HAPI int slave_rpc_async_request(struct slave_node *slave, const char *pkgname,
 			}
 		}
 
-		if (urgent) {
+		if (lane == SLAVE_RPC_LANE_URGENT) {
 			rpc->pending_list = eina_list_prepend(rpc->pending_list, command);
 		} else {
 			rpc->pending_list = eina_list_append(rpc->pending_list, command);
@@ -440,21 +622,16 @@ HAPI int slave_rpc_async_request(struct slave_node *slave, const char *pkgname,
 		return WIDGET_ERROR_NONE;
 	}
 
-	if (urgent) {
-		prepend_command(command);
-	} else {
-		push_command(command);
-	}
-
+	push_command(rpc, command);
 	return WIDGET_ERROR_NONE;
 }
 
-HAPI int slave_rpc_request_only(struct slave_node *slave, const char *pkgname, struct packet *packet, int urgent)
+HAPI int slave_rpc_request_only(struct slave_node *slave, const char *pkgname, struct packet *packet, enum slave_rpc_lane lane)
 {
 	struct command *command;
 	struct slave_rpc *rpc;
 
-	command = create_command(slave, pkgname, packet);
+	command = create_command(slave, pkgname, packet, lane);
 	if (!command) {
 		ErrPrint("Failed to create a command\n");
 		packet_unref(packet);
@@ -487,7 +664,7 @@ HAPI int slave_rpc_request_only(struct slave_node *slave, const char *pkgname, s
 			}
 		}
 
-		if (urgent) {
+		if (lane == SLAVE_RPC_LANE_URGENT) {
 			rpc->pending_list = eina_list_prepend(rpc->pending_list, command);
 		} else {
 			rpc->pending_list = eina_list_append(rpc->pending_list, command);
@@ -496,12 +673,7 @@ HAPI int slave_rpc_request_only(struct slave_node *slave, const char *pkgname, s
 		return WIDGET_ERROR_NONE;
 	}
 
-	if (urgent) {
-		prepend_command(command);
-	} else {
-		push_command(command);
-	}
-
+	push_command(rpc, command);
 	return WIDGET_ERROR_NONE;
 }
 
@@ -516,7 +688,7 @@ HAPI int slave_rpc_update_handle(struct slave_node *slave, int handle, int delet
 	}
 
 	DbgPrint("SLAVE: New handle assigned for %d, %d\n", slave_pid(slave), handle);
-	rpc->handle = handle;
+	set_handle(slave, rpc, handle);
 	if (rpc->pong_timer) {
 		ecore_timer_del(rpc->pong_timer);
 	}
@@ -562,7 +734,7 @@ HAPI int slave_rpc_update_handle(struct slave_node *slave, int handle, int delet
 						}
 						destroy_command(command);
 					} else {
-						push_command(command);
+						push_command(rpc, command);
 					}
 				} else if (!strcmp(cmd, CMD_STR_NEW)) {
 					if (command->cbdata) {
@@ -571,13 +743,13 @@ HAPI int slave_rpc_update_handle(struct slave_node *slave, int handle, int delet
 					}
 					destroy_command(command);
 				} else {
-					push_command(command);
+					push_command(rpc, command);
 				}
 			} else {
 				ErrPrint("Invalid package: cmd is nil\n");
 			}
 		} else {
-			push_command(command);
+			push_command(rpc, command);
 		}
 	}
 
@@ -625,6 +797,9 @@ HAPI int slave_rpc_fini(struct slave_node *slave)
 		ecore_timer_del(rpc->pong_timer);
 	}
 
+	clear_command(rpc);
+	set_handle(slave, rpc, -1);
+
 	DbgFree(rpc);
 	return WIDGET_ERROR_NONE;
 }
@@ -749,6 +924,15 @@ HAPI int slave_rpc_handle(struct slave_node *slave)
 	return rpc->handle;
 }
 
+HAPI struct slave_node *slave_rpc_find_by_handle(int handle)
+{
+	if (handle <= 0 || !s_info.handle_table) {
+		return NULL;
+	}
+
+	return eina_hash_find(s_info.handle_table, &handle);
+}
+
 HAPI int slave_rpc_disconnect(struct slave_node *slave)
 {
 	struct packet *packet;
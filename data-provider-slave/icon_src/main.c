@@ -66,6 +66,7 @@
 #define DEFAULT_FONT_SIZE	-100
 
 int script_handler_parse_desc(Evas_Object *edje, const char *descfile);
+void script_handler_fini(void);
 
 static struct info {
 	int client_fd;
@@ -505,6 +506,7 @@ static void app_terminate(void *data)
 	}
 
 	client_fini();
+	script_handler_fini();
 
 	free(s_info.font_name);
 	s_info.font_name = NULL;
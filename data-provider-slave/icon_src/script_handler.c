@@ -3,6 +3,7 @@
 #include <errno.h>
 #include<stdlib.h>
 #include <ctype.h>
+#include <sys/stat.h>
 
 #include <Elementary.h>
 #include <Evas.h>
@@ -16,6 +17,9 @@
 #include <dlog.h>
 #include <widget_errno.h>
 #include <widget_util.h>
+#include <com-core_desc.h>
+#include <com-core_cache.h>
+#include <vconf.h>
 
 #include "debug.h"
 #include "util.h"
@@ -38,6 +42,7 @@
 #define INFO_SIZE "size"
 #define INFO_CATEGORY "category"
 #define ADDEND 256
+#define IMAGE_CACHE_SIZE (4 * 1024 * 1024) /* Cropped images, in bytes */
 
 struct block {
 	char *type;
@@ -95,8 +100,10 @@ struct obj_info {
 
 static struct info {
 	Eina_List *obj_list;
+	struct com_core_cache *image_cache;
 } s_info = {
 	.obj_list = NULL,
+	.image_cache = NULL,
 };
 
 static inline Evas_Object *find_edje(const char *id)
@@ -409,6 +416,69 @@ static inline void parse_image_option(const char *option, struct image_option *i
 	}
 }
 
+static void low_mem_cb(keynode_t *node, void *user_data)
+{
+	if (vconf_keynode_get_int(node) >= VCONFKEY_SYSMAN_LOW_MEMORY_SOFT_WARNING) {
+		DbgPrint("Low memory: %lu bytes of cropped images are released\n", com_core_cache_trim(s_info.image_cache, 0));
+	}
+}
+
+/*!
+ * \note
+ * Cropped pixels are decided by the file (path, inode, mtime in nsec, size), the part size, the scaled size and the orientation.
+ * Same as the widget-edje does.
+ */
+static inline int image_cache_key(char *key, int len, const char *path, int part_w, int part_h, int w, int h, struct image_option *img_opt)
+{
+	struct stat st;
+
+	if (!s_info.image_cache) {
+		s_info.image_cache = com_core_cache_create(IMAGE_CACHE_SIZE);
+		if (!s_info.image_cache) {
+			return WIDGET_ERROR_OUT_OF_MEMORY;
+		}
+
+		if (vconf_notify_key_changed(VCONFKEY_SYSMAN_LOW_MEMORY, low_mem_cb, NULL) < 0) {
+			ErrPrint("Failed to add vconf for low mem monitor\n");
+		}
+	}
+
+	if (stat(path, &st) < 0) {
+		ErrPrint("stat: %d\n", errno);
+		return WIDGET_ERROR_IO_ERROR;
+	}
+
+	if (snprintf(key, len, "%s:%llu:%ld.%09ld:%lld:%dx%d:%dx%d:%d", path, (unsigned long long)st.st_ino, (long)st.st_mtim.tv_sec, (long)st.st_mtim.tv_nsec, (long long)st.st_size, part_w, part_h, w, h, img_opt->orient) >= len) {
+		return WIDGET_ERROR_INVALID_PARAMETER;
+	}
+
+	return WIDGET_ERROR_NONE;
+}
+
+static Evas_Object *cropped_image_add(Evas_Object *img, const void *data, int part_w, int part_h)
+{
+	Evas *e;
+
+	e = evas_object_evas_get(img);
+	evas_object_del(img);
+	img = evas_object_image_filled_add(e);
+	if (!img) {
+		return NULL;
+	}
+
+	evas_object_image_colorspace_set(img, EVAS_COLORSPACE_ARGB8888);
+	evas_object_image_smooth_scale_set(img, EINA_TRUE);
+	evas_object_image_alpha_set(img, EINA_TRUE);
+	evas_object_image_data_set(img, NULL);
+	evas_object_image_size_set(img, part_w, part_h);
+	evas_object_resize(img, part_w, part_h);
+	evas_object_image_data_copy_set(img, (void *)data);
+	evas_object_image_fill_set(img, 0, 0, part_w, part_h);
+	evas_object_image_data_update_add(img, 0, 0, part_w, part_h);
+
+	return img;
+}
+
 static int update_script_image(Evas_Object *edje, struct block *block)
 {
 	Evas_Load_Error err;
@@ -506,6 +576,10 @@ static int update_script_image(Evas_Object *edje, struct block *block)
 		if (img_opt.fill == FILL_OVER_SIZE) {
 			Evas_Coord part_w;
 			Evas_Coord part_h;
+			char key[PATH_MAX + 128];
+			const void *cached = NULL;
+			int cacheable = 0;
+			int size = 0;
 
 			if (img_opt.width >= 0 && img_opt.height >= 0) {
 				part_w = img_opt.width * elm_config_scale_get();
@@ -545,6 +619,15 @@ static int update_script_image(Evas_Object *edje, struct block *block)
 				evas_object_image_load_size_set(img, part_w, part_h);
 				evas_object_image_filled_set(img, EINA_TRUE);
 				DbgPrint("Size: %dx%d (region: %dx%d - %dx%d)\n", w, h, (w - part_w) / 2, (h - part_h) / 2, part_w, part_h);
+			} else if ((cacheable = image_cache_key(key, sizeof(key), block->data, part_w, part_h, w, h, &img_opt) == WIDGET_ERROR_NONE)
+					&& (cached = com_core_cache_get(s_info.image_cache, key, &size)) && size == part_w * part_h * sizeof(int)) {
+				DbgPrint("Cropped image is cached: %s\n", key);
+				img = cropped_image_add(img, cached, part_w, part_h);
+				if (!img) {
+					free(child->part);
+					free(child);
+					return WIDGET_ERROR_OUT_OF_MEMORY;
+				}
 			} else {
 				Ecore_Evas *ee;
 				Evas *e;
@@ -620,9 +703,11 @@ static int update_script_image(Evas_Object *edje, struct block *block)
 					return WIDGET_ERROR_IO_ERROR;
 				}
 
-				e = evas_object_evas_get(img);
-				evas_object_del(img);
-				img = evas_object_image_filled_add(e);
+				if (cacheable && com_core_cache_put(s_info.image_cache, key, data, part_w * part_h * sizeof(int)) < 0) {
+					DbgPrint("Cropped image is not cached: %s\n", key);
+				}
+
+				img = cropped_image_add(img, data, part_w, part_h);
 				if (!img) {
 					evas_object_del(src_img);
 					ecore_evas_free(ee);
@@ -632,16 +717,6 @@ static int update_script_image(Evas_Object *edje, struct block *block)
 					return WIDGET_ERROR_OUT_OF_MEMORY;
 				}
 
-				evas_object_image_colorspace_set(img, EVAS_COLORSPACE_ARGB8888);
-				evas_object_image_smooth_scale_set(img, EINA_TRUE);
-				evas_object_image_alpha_set(img, EINA_TRUE);
-				evas_object_image_data_set(img, NULL);
-				evas_object_image_size_set(img, part_w, part_h);
-				evas_object_resize(img, part_w, part_h);
-				evas_object_image_data_copy_set(img, (void *)data);
-				evas_object_image_fill_set(img, 0, 0, part_w, part_h);
-				evas_object_image_data_update_add(img, 0, 0, part_w, part_h);
-
 				evas_object_del(src_img);
 				ecore_evas_free(ee);
 			}
@@ -931,7 +1006,7 @@ static int update_access(Evas_Object *edje, struct block *block)
 	return WIDGET_ERROR_INVALID_PARAMETER;
 }
 
-static inline void consuming_parsed_block(Evas_Object *edje, int lineno, struct block *block)
+static inline void apply_parsed_block(Evas_Object *edje, int lineno, struct block *block)
 {
 	/*!
 	 * To speed up, use the static.
@@ -993,10 +1068,110 @@ static inline void consuming_parsed_block(Evas_Object *edje, int lineno, struct
 	if (!handlers[i].type) {
 		ErrPrint("%d: Unknown block type: %s\n", lineno, block->type);
 	}
+}
 
+static inline void consuming_parsed_block(Evas_Object *edje, int lineno, struct block *block)
+{
+	apply_parsed_block(edje, lineno, block);
 	delete_block(block);
+}
+
+static inline int is_binary_desc(FILE *fp)
+{
+	char header[COM_CORE_DESC_HEADER_SIZE];
+	int ret;
+
+	ret = fread(header, 1, sizeof(header), fp) == sizeof(header) && com_core_desc_is_binary(header, sizeof(header));
+	rewind(fp);
+	return ret;
+}
+
+struct binary_desc {
+	Evas_Object *edje;
+	const char *descfile;
+};
+
+/*!
+ * \note
+ * Blocks are pointing the loaded file directly, they are applied without copying fields.
+ */
+static int binary_block_cb(const struct com_core_desc_block *desc, int blockno, void *data)
+{
+	struct binary_desc *binary = data;
+	struct block block;
+
+	if (!desc->type) {
+		ErrPrint("%d: Type is not exists\n", blockno);
+		return WIDGET_ERROR_NONE;
+	}
+
+	memset(&block, 0, sizeof(block));
+	block.type = (char *)desc->type;
+	block.part = (char *)desc->part;
+	block.data = (char *)desc->data;
+	block.file = (char *)(desc->file ? desc->file : binary->descfile);
+	block.option = (char *)desc->option;
+	block.id = (char *)desc->id;
+	block.target_id = (char *)desc->target;
 
-	return;
+	apply_parsed_block(binary->edje, blockno, &block);
+	return WIDGET_ERROR_NONE;
+}
+
+static int parse_binary_desc(Evas_Object *edje, FILE *fp, const char *descfile)
+{
+	struct binary_desc binary = {
+		.edje = edje,
+		.descfile = descfile,
+	};
+	char *filebuf;
+	long filesize;
+	int ret;
+
+	if (fseek(fp, 0L, SEEK_END) < 0 || (filesize = ftell(fp)) < 0) {
+		ErrPrint("fseek: %d\n", errno);
+		return WIDGET_ERROR_IO_ERROR;
+	}
+	rewind(fp);
+
+	filebuf = malloc(filesize);
+	if (!filebuf) {
+		ErrPrint("malloc: %d\n", errno);
+		return WIDGET_ERROR_OUT_OF_MEMORY;
+	}
+
+	if (fread(filebuf, 1, filesize, fp) != (size_t)filesize) {
+		ErrPrint("fread: %d\n", errno);
+		DbgFree(filebuf);
+		return WIDGET_ERROR_IO_ERROR;
+	}
+
+	ret = com_core_desc_foreach_block(filebuf, filesize, binary_block_cb, &binary);
+	DbgFree(filebuf);
+
+	if (ret == -EINVAL || ret == -ENOTSUP) {
+		ErrPrint("Unable to read %s (%d)\n", widget_util_basename(descfile), ret);
+		return WIDGET_ERROR_NOT_SUPPORTED;
+	} else if (ret < 0) {
+		ErrPrint("Parse error in %s (%d)\n", widget_util_basename(descfile), ret);
+		return WIDGET_ERROR_INVALID_PARAMETER;
+	}
+
+	return WIDGET_ERROR_NONE;
+}
+
+HAPI void script_handler_fini(void)
+{
+	if (!s_info.image_cache) {
+		return;
+	}
+
+	if (vconf_ignore_key_changed(VCONFKEY_SYSMAN_LOW_MEMORY, low_mem_cb) < 0) {
+		ErrPrint("Failed to ignore vconf key\n");
+	}
+
+	com_core_cache_destroy(s_info.image_cache);
+	s_info.image_cache = NULL;
 }
 
 HAPI int script_handler_parse_desc(Evas_Object *edje, const char *descfile)
@@ -1067,6 +1242,16 @@ HAPI int script_handler_parse_desc(Evas_Object *edje, const char *descfile)
 	evas_object_data_set(edje, "obj_info", info);
 	evas_object_event_callback_add(edje, EVAS_CALLBACK_DEL, edje_del_cb, NULL);
 
+	if (is_binary_desc(fp)) {
+		int ret;
+
+		ret = parse_binary_desc(edje, fp, descfile);
+		if (fclose(fp) != 0) {
+			ErrPrint("fclose: %d\n", errno);
+		}
+		return ret;
+	}
+
 	state = UNKNOWN;
 	field_idx = 0;
 	lineno = 1;
@@ -2,7 +2,8 @@ enum buffer_type { /*!< Must have to be sync with libprovider, libwidget-viewer,
 	BUFFER_TYPE_FILE,
 	BUFFER_TYPE_SHM,
 	BUFFER_TYPE_PIXMAP,
-	BUFFER_TYPE_ERROR
+	BUFFER_TYPE_ERROR,
+	BUFFER_TYPE_MEMFD /*!< Follows the ERROR, same as the WIDGET_FB_TYPE_MEMFD of the com-core_buffer.h */
 };
 
 extern int script_buffer_load(void *handle);
@@ -28,7 +29,8 @@ extern int script_buffer_pixels(void *handle);
 
 extern void *script_buffer_fb(void *handle);
 extern int script_buffer_get_size(void *handle, int *w, int *h);
-extern void script_buffer_flush(void *handle);
+extern void script_buffer_flush(void *handle, int x, int y, int w, int h);
+extern void script_buffer_damage(void *handle, int x, int y, int w, int h);
 extern void *script_buffer_instance(void *handle);
 
 extern void *script_buffer_raw_open(enum buffer_type type, void *resource);
@@ -0,0 +1,31 @@
+/*
+ * Copyright 2013  Samsung Electronics Co., Ltd
+ *
+ * Licensed under the Flora License, Version 1.1 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://floralicense.org/license/
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*!
+ * \note
+ * Same as the evas_data_argb_unpremul, color = color * 255 / alpha,
+ * But color channels are clamped to 255 if the pixel is not a valid premultiplied one.
+ * Every implementation (AVX2, SSE2, NEON, C) gives the same result.
+ */
+extern void unpremul_pixels(unsigned int *data, int len);
+
+/*!
+ * \note
+ * stride is the length of a line of the canvas in bytes.
+ */
+extern void unpremul_rect(void *canvas, int stride, int x, int y, int w, int h);
+
+/* End of a file */
@@ -17,6 +17,7 @@ BuildRequires: pkgconfig(ecore)
 BuildRequires: pkgconfig(elementary)
 BuildRequires: pkgconfig(widget_service)
 BuildRequires: pkgconfig(capi-system-system-settings)
+BuildRequires: pkgconfig(com-core)
 BuildRequires: model-build-features
 
 %description
@@ -248,9 +248,9 @@ int script_buffer_get_size(void *handle, int *w, int *h)
 	return get_size(handle, w, h);
 }
 
-void script_buffer_flush(void *handle)
+void script_buffer_flush(void *handle, int x, int y, int w, int h)
 {
-	static void (*buffer_flush)(void *handle) = NULL;
+	static void (*buffer_flush)(void *handle, int x, int y, int w, int h) = NULL;
 
 	if (!buffer_flush) {
 		buffer_flush = dlsym(RTLD_DEFAULT, "buffer_handler_flush");
@@ -260,7 +260,22 @@ void script_buffer_flush(void *handle)
 		}
 	}
 
-	return buffer_flush(handle);	/* "void" function can be used to return from this function ;) */
+	return buffer_flush(handle, x, y, w, h);	/* "void" function can be used to return from this function ;) */
+}
+
+void script_buffer_damage(void *handle, int x, int y, int w, int h)
+{
+	static void (*buffer_damage)(void *handle, int x, int y, int w, int h) = NULL;
+
+	if (!buffer_damage) {
+		buffer_damage = dlsym(RTLD_DEFAULT, "buffer_handler_damage");
+		if (!buffer_damage) {
+			ErrPrint("broken ABI\n");
+			return;
+		}
+	}
+
+	return buffer_damage(handle, x, y, w, h);
 }
 
 void *script_buffer_instance(void *handle)
@@ -21,6 +21,7 @@
 #include <unistd.h>
 #include <ctype.h>
 #include <dlfcn.h>
+#include <sys/stat.h>
 
 #include <Elementary.h>
 #include <Evas.h>
@@ -42,15 +43,19 @@
 #include <widget_service.h>
 #include <widget_service_internal.h>
 #include <widget_script.h>
+#include <com-core_cache.h>
 
 #include "script_port.h"
 #include "abi.h"
+#include "unpremul.h"
 
 #define TEXT_CLASS	"tizen"
 #define DEFAULT_FONT_SIZE	-100
 
 #define PUBLIC __attribute__((visibility("default")))
 
+#define IMAGE_CACHE_SIZE	(8 * 1024 * 1024) /* Cropped images, in bytes */
+
 #define ACCESS_TYPE_DOWN 0
 #define ACCESS_TYPE_MOVE 1
 #define ACCESS_TYPE_UP 2
@@ -99,6 +104,9 @@ struct info {
 	int (*render_pre)(void *buffer_handle, void *data);
 	int (*render_post)(void *render_handle, void *data);
 	void *render_data;
+
+	int stride; /* Line length of the canvas in bytes, 0 if the canvas has no padding */
+	int updated_area_reported; /* Render post event gives the updated area, only that area needs to be unpremultiplied */
 };
 
 struct child {
@@ -122,6 +130,7 @@ static struct {
 	int premultiplied;
 	Ecore_Evas *(*alloc_canvas)(int w, int h, void *(*a)(void *data, int size), void (*f)(void *data, void *ptr), void *data);
 	Ecore_Evas *(*alloc_canvas_with_stride)(int w, int h, void *(*a)(void *data, int size, int *stride, int *bpp), void (*f)(void *data, void *ptr), void *data);
+	struct com_core_cache *image_cache;
 } s_info = {
 	.font_name = NULL,
 	.font_size = -100,
@@ -131,6 +140,7 @@ static struct {
 	.premultiplied = 1,
 	.alloc_canvas = NULL,
 	.alloc_canvas_with_stride = NULL,
+	.image_cache = NULL,
 };
 
 static inline Evas_Object *find_edje(struct info *handle, const char *id)
@@ -708,6 +718,53 @@ static inline void apply_shadow_effect(struct image_option *img_opt, Evas_Object
 #endif
 }
 
+/*!
+ * \note
+ * Cropped pixels are decided by the file (path, inode, mtime in nsec, size), the part size, the scaled size and the orientation.
+ */
+static inline int image_cache_key(char *key, int len, const char *path, int part_w, int part_h, int w, int h, struct image_option *img_opt)
+{
+	struct stat st;
+
+	if (!s_info.image_cache) {
+		return WIDGET_ERROR_NOT_SUPPORTED;
+	}
+
+	if (stat(path, &st) < 0) {
+		ErrPrint("stat: %d\n", errno);
+		return WIDGET_ERROR_IO_ERROR;
+	}
+
+	if (snprintf(key, len, "%s:%llu:%ld.%09ld:%lld:%dx%d:%dx%d:%d", path, (unsigned long long)st.st_ino, (long)st.st_mtim.tv_sec, (long)st.st_mtim.tv_nsec, (long long)st.st_size, part_w, part_h, w, h, img_opt->orient) >= len) {
+		return WIDGET_ERROR_INVALID_PARAMETER;
+	}
+
+	return WIDGET_ERROR_NONE;
+}
+
+static Evas_Object *cropped_image_add(Evas_Object *img, const void *data, int part_w, int part_h)
+{
+	Evas_Object *_img;
+
+	_img = evas_object_image_filled_add(evas_object_evas_get(img));
+	if (!_img) {
+		return img;
+	}
+
+	evas_object_image_colorspace_set(_img, EVAS_COLORSPACE_ARGB8888);
+	evas_object_image_smooth_scale_set(_img, EINA_TRUE);
+	evas_object_image_alpha_set(_img, EINA_TRUE);
+	evas_object_image_data_set(_img, NULL);
+	evas_object_image_size_set(_img, part_w, part_h);
+	evas_object_resize(_img, part_w, part_h);
+	evas_object_image_data_copy_set(_img, (void *)data);
+	evas_object_image_fill_set(_img, 0, 0, part_w, part_h);
+	evas_object_image_data_update_add(_img, 0, 0, part_w, part_h);
+
+	evas_object_del(img);
+	return _img;
+}
+
 static Evas_Object *crop_image(Evas_Object *img, const char *path, int part_w, int part_h, int w, int h, struct image_option *img_opt)
 {
 	Ecore_Evas *ee;
@@ -717,6 +774,18 @@ static Evas_Object *crop_image(Evas_Object *img, const char *path, int part_w, i
 	const void *data;
 	Evas_Load_Error err;
 	Evas_Object *_img;
+	char key[PATH_MAX + 128];
+	int cacheable;
+	int size;
+
+	cacheable = image_cache_key(key, sizeof(key), path, part_w, part_h, w, h, img_opt) == WIDGET_ERROR_NONE;
+	if (cacheable) {
+		data = com_core_cache_get(s_info.image_cache, key, &size);
+		if (data && size == part_w * part_h * sizeof(int)) {
+			DbgPrint("Cropped image is cached: %s\n", key);
+			return cropped_image_add(img, data, part_w, part_h);
+		}
+	}
 
 	ee = ecore_evas_buffer_new(part_w, part_h);
 	if (!ee) {
@@ -766,28 +835,14 @@ static Evas_Object *crop_image(Evas_Object *img, const char *path, int part_w, i
 		return img;
 	}
 
-	e = evas_object_evas_get(img);
-	_img = evas_object_image_filled_add(e);
-	if (!_img) {
-		evas_object_del(src_img);
-		ecore_evas_free(ee);
-		return img;
+	if (cacheable && com_core_cache_put(s_info.image_cache, key, data, part_w * part_h * sizeof(int)) < 0) {
+		DbgPrint("Cropped image is not cached: %s\n", key);
 	}
 
-	evas_object_image_colorspace_set(_img, EVAS_COLORSPACE_ARGB8888);
-	evas_object_image_smooth_scale_set(_img, EINA_TRUE);
-	evas_object_image_alpha_set(_img, EINA_TRUE);
-	evas_object_image_data_set(_img, NULL);
-	evas_object_image_size_set(_img, part_w, part_h);
-	evas_object_resize(_img, part_w, part_h);
-	evas_object_image_data_copy_set(_img, (void *)data);
-	evas_object_image_fill_set(_img, 0, 0, part_w, part_h);
-	evas_object_image_data_update_add(_img, 0, 0, part_w, part_h);
+	_img = cropped_image_add(img, data, part_w, part_h);
 
 	evas_object_del(src_img);
 	ecore_evas_free(ee);
-
-	evas_object_del(img);
 	return _img;
 }
 
@@ -1684,7 +1739,12 @@ static void sw_render_pre_cb(void *data, Evas *e, void *event_info)
 
 	script_buffer_lock(handle->buffer_handle);
 
-	if (s_info.premultiplied) {
+	/*!
+	 * \note
+	 * Without the updated area, the whole canvas is going to be unpremultiplied,
+	 * So every pixels should be rendered again.
+	 */
+	if (s_info.premultiplied && !handle->updated_area_reported) {
 		int w;
 		int h;
 
@@ -1696,11 +1756,12 @@ static void sw_render_pre_cb(void *data, Evas *e, void *event_info)
 static void sw_render_post_cb(void *data, Evas *e, void *event_info)
 {
 	struct info *handle = data;
+	Evas_Event_Render_Post *post = event_info;
+	void *canvas = NULL;
+	int x, y, w, h;
+	int stride = 0;
 
 	if (s_info.premultiplied) {
-		void *canvas;
-		int x, y, w, h;
-
 		// Get a pointer of a buffer of the virtual canvas
 		canvas = (void *)ecore_evas_buffer_pixels_get(handle->ee);
 		if (!canvas) {
@@ -1709,7 +1770,33 @@ static void sw_render_post_cb(void *data, Evas *e, void *event_info)
 		}
 
 		ecore_evas_geometry_get(handle->ee, &x, &y, &w, &h);
-		evas_data_argb_unpremul(canvas, w * h);
+		stride = handle->stride > 0 ? handle->stride : w * sizeof(int);
+	}
+
+	if (post) {
+		Eina_Rectangle *rect;
+		Eina_List *l;
+		Eina_Rectangle area;
+
+		/*!
+		 * \note
+		 * Master flushes only the damaged region of the buffer,
+		 * If there is no reported damage, the whole buffer will be flushed.
+		 */
+		EINA_LIST_FOREACH(post->updated_area, l, rect) {
+			script_buffer_damage(handle->buffer_handle, rect->x, rect->y, rect->w, rect->h);
+
+			if (canvas) {
+				EINA_RECTANGLE_SET(&area, 0, 0, w, h);
+				if (eina_rectangle_intersection(&area, rect)) {
+					unpremul_rect(canvas, stride, area.x, area.y, area.w, area.h);
+				}
+			}
+		}
+
+		handle->updated_area_reported = 1;
+	} else if (canvas) {
+		unpremul_rect(canvas, stride, 0, 0, w, h);
 	}
 
 	script_buffer_unlock(handle->buffer_handle);
@@ -1789,6 +1876,8 @@ static void *alloc_with_stride_fb(void *data, int size, int *stride, int *bpp)
 	*stride = _stride;
 	*bpp = _bpp << 3;
 
+	handle->stride = _stride;
+
 	return canvas;
 }
 
@@ -2108,6 +2197,13 @@ static void font_size_cb(system_settings_key_e key, void *user_data)
 	DbgPrint("Font size is changed to %d, but don't update the font info\n", size);
 }
 
+static void low_mem_cb(keynode_t *node, void *user_data)
+{
+	if (vconf_keynode_get_int(node) >= VCONFKEY_SYSMAN_LOW_MEMORY_SOFT_WARNING) {
+		DbgPrint("Low memory: %lu bytes of cropped images are released\n", com_core_cache_trim(s_info.image_cache, 0));
+	}
+}
+
 PUBLIC int script_init(double scale, int premultiplied)
 {
 	int ret;
@@ -2134,6 +2230,16 @@ PUBLIC int script_init(double scale, int premultiplied)
 	ret = system_settings_set_changed_cb(SYSTEM_SETTINGS_KEY_FONT_SIZE, font_size_cb, NULL);
 	DbgPrint("System font size is changed: %d\n", ret);
 
+	s_info.image_cache = com_core_cache_create(IMAGE_CACHE_SIZE);
+	if (!s_info.image_cache) {
+		ErrPrint("Cropped images will not be cached\n");
+	} else {
+		ret = vconf_notify_key_changed(VCONFKEY_SYSMAN_LOW_MEMORY, low_mem_cb, NULL);
+		if (ret < 0) {
+			DbgPrint("Low memory event: %d\n", ret);
+		}
+	}
+
 	access_cb(NULL, NULL);
 	font_changed_cb(NULL, NULL);
 	font_size_cb(SYSTEM_SETTINGS_KEY_FONT_SIZE, NULL);
@@ -2177,6 +2283,16 @@ PUBLIC int script_fini(void)
 		DbgPrint("Unset tts: %d\n", ret);
 	}
 
+	if (s_info.image_cache) {
+		ret = vconf_ignore_key_changed(VCONFKEY_SYSMAN_LOW_MEMORY, low_mem_cb);
+		if (ret < 0) {
+			DbgPrint("Unset low memory event: %d\n", ret);
+		}
+
+		com_core_cache_destroy(s_info.image_cache);
+		s_info.image_cache = NULL;
+	}
+
 	elm_shutdown();
 
 	free(s_info.font_name);
@@ -0,0 +1,219 @@
+/*
+ * Copyright 2013  Samsung Electronics Co., Ltd
+ *
+ * Licensed under the Flora License, Version 1.1 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://floralicense.org/license/
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "unpremul.h"
+
+/*!
+ * \note
+ * Vector versions get the quotient from the float division (or the reciprocal with correction),
+ * color * 255 is less than 2^16, so the truncated quotient is always same as the integer division.
+ */
+static inline unsigned int unpremul_pixel(unsigned int pixel)
+{
+	unsigned int a = pixel >> 24;
+	unsigned int r;
+	unsigned int g;
+	unsigned int b;
+
+	if (a == 0 || a == 255) {
+		return pixel;
+	}
+
+	r = ((pixel >> 16) & 0xFF) * 255 / a;
+	g = ((pixel >> 8) & 0xFF) * 255 / a;
+	b = (pixel & 0xFF) * 255 / a;
+
+	return (a << 24) | ((r > 255 ? 255 : r) << 16) | ((g > 255 ? 255 : g) << 8) | (b > 255 ? 255 : b);
+}
+
+#if defined(__AVX2__)
+#define LANES 8
+
+static inline __m256i unpremul_channel(__m256i pixel, int shift, __m256 alpha)
+{
+	__m256 color;
+
+	color = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(pixel, shift), _mm256_set1_epi32(0xFF)));
+	color = _mm256_min_ps(_mm256_div_ps(_mm256_mul_ps(color, _mm256_set1_ps(255.0f)), alpha), _mm256_set1_ps(255.0f));
+	return _mm256_slli_epi32(_mm256_cvttps_epi32(color), shift);
+}
+
+static inline void unpremul_lanes(unsigned int *data)
+{
+	__m256i pixel;
+	__m256i a;
+	__m256i mask;
+	__m256i result;
+	__m256 alpha;
+
+	pixel = _mm256_loadu_si256((const __m256i *)data);
+	a = _mm256_srli_epi32(pixel, 24);
+	mask = _mm256_and_si256(_mm256_cmpgt_epi32(a, _mm256_setzero_si256()), _mm256_cmpgt_epi32(_mm256_set1_epi32(255), a));
+	if (_mm256_testz_si256(mask, mask)) {
+		return;
+	}
+
+	alpha = _mm256_cvtepi32_ps(_mm256_max_epi32(a, _mm256_set1_epi32(1)));
+
+	result = _mm256_slli_epi32(a, 24);
+	result = _mm256_or_si256(result, unpremul_channel(pixel, 16, alpha));
+	result = _mm256_or_si256(result, unpremul_channel(pixel, 8, alpha));
+	result = _mm256_or_si256(result, unpremul_channel(pixel, 0, alpha));
+
+	_mm256_storeu_si256((__m256i *)data, _mm256_blendv_epi8(pixel, result, mask));
+}
+#elif defined(__SSE2__)
+#define LANES 4
+
+static inline __m128i unpremul_channel(__m128i pixel, int shift, __m128 alpha)
+{
+	__m128 color;
+
+	color = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixel, shift), _mm_set1_epi32(0xFF)));
+	color = _mm_min_ps(_mm_div_ps(_mm_mul_ps(color, _mm_set1_ps(255.0f)), alpha), _mm_set1_ps(255.0f));
+	return _mm_slli_epi32(_mm_cvttps_epi32(color), shift);
+}
+
+static inline void unpremul_lanes(unsigned int *data)
+{
+	__m128i pixel;
+	__m128i a;
+	__m128i mask;
+	__m128i result;
+	__m128 alpha;
+
+	pixel = _mm_loadu_si128((const __m128i *)data);
+	a = _mm_srli_epi32(pixel, 24);
+	mask = _mm_and_si128(_mm_cmpgt_epi32(a, _mm_setzero_si128()), _mm_cmplt_epi32(a, _mm_set1_epi32(255)));
+	if (_mm_movemask_epi8(mask) == 0) {
+		return;
+	}
+
+	/* Zero alpha lanes are masked out, avoid the division by zero */
+	alpha = _mm_cvtepi32_ps(_mm_or_si128(a, _mm_andnot_si128(mask, _mm_set1_epi32(1))));
+
+	result = _mm_slli_epi32(a, 24);
+	result = _mm_or_si128(result, unpremul_channel(pixel, 16, alpha));
+	result = _mm_or_si128(result, unpremul_channel(pixel, 8, alpha));
+	result = _mm_or_si128(result, unpremul_channel(pixel, 0, alpha));
+
+	_mm_storeu_si128((__m128i *)data, _mm_or_si128(_mm_and_si128(mask, result), _mm_andnot_si128(mask, pixel)));
+}
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define LANES 4
+
+/*!
+ * \note
+ * ARMv7 NEON has no division, the quotient from the reciprocal can be off by one,
+ * Products are less than 2^24, so the correction steps are done exactly in float.
+ */
+static inline uint32x4_t unpremul_channel(uint32x4_t pixel, int shift, float32x4_t alpha, float32x4_t reciprocal)
+{
+	float32x4_t color;
+	float32x4_t quotient;
+	float32x4_t one = vdupq_n_f32(1.0f);
+
+	color = vcvtq_f32_u32(vandq_u32(vshlq_u32(pixel, vdupq_n_s32(-shift)), vdupq_n_u32(0xFF)));
+	color = vmulq_f32(color, vdupq_n_f32(255.0f));
+
+	quotient = vcvtq_f32_u32(vcvtq_u32_f32(vmulq_f32(color, reciprocal)));
+	quotient = vbslq_f32(vcleq_f32(vmulq_f32(vaddq_f32(quotient, one), alpha), color), vaddq_f32(quotient, one), quotient);
+	quotient = vbslq_f32(vcgtq_f32(vmulq_f32(quotient, alpha), color), vsubq_f32(quotient, one), quotient);
+	quotient = vminq_f32(quotient, vdupq_n_f32(255.0f));
+
+	return vshlq_u32(vcvtq_u32_f32(quotient), vdupq_n_s32(shift));
+}
+
+static inline void unpremul_lanes(unsigned int *data)
+{
+	uint32x4_t pixel;
+	uint32x4_t a;
+	uint32x4_t mask;
+	uint32x4_t result;
+	uint32x2_t any;
+	float32x4_t alpha;
+	float32x4_t reciprocal;
+
+	pixel = vld1q_u32(data);
+	a = vshrq_n_u32(pixel, 24);
+	mask = vandq_u32(vcgtq_u32(a, vdupq_n_u32(0)), vcltq_u32(a, vdupq_n_u32(255)));
+	any = vorr_u32(vget_low_u32(mask), vget_high_u32(mask));
+	if ((vget_lane_u32(any, 0) | vget_lane_u32(any, 1)) == 0) {
+		return;
+	}
+
+	alpha = vcvtq_f32_u32(vmaxq_u32(a, vdupq_n_u32(1)));
+	reciprocal = vrecpeq_f32(alpha);
+	reciprocal = vmulq_f32(vrecpsq_f32(alpha, reciprocal), reciprocal);
+	reciprocal = vmulq_f32(vrecpsq_f32(alpha, reciprocal), reciprocal);
+
+	result = vshlq_n_u32(a, 24);
+	result = vorrq_u32(result, unpremul_channel(pixel, 16, alpha, reciprocal));
+	result = vorrq_u32(result, unpremul_channel(pixel, 8, alpha, reciprocal));
+	result = vorrq_u32(result, unpremul_channel(pixel, 0, alpha, reciprocal));
+
+	vst1q_u32(data, vbslq_u32(mask, result, pixel));
+}
+#endif
+
+void unpremul_pixels(unsigned int *data, int len)
+{
+	unsigned int pixel = 0;
+	unsigned int result = 0;
+	int i = 0;
+
+#if defined(LANES)
+	for (; i + LANES <= len; i += LANES) {
+		unpremul_lanes(data + i);
+	}
+#endif
+
+	/*!
+	 * \note
+	 * Same as the evas, the result of the previous pixel is reused for runs of a same color.
+	 */
+	for (; i < len; i++) {
+		if (data[i] != pixel) {
+			pixel = data[i];
+			result = unpremul_pixel(pixel);
+		}
+
+		data[i] = result;
+	}
+}
+
+void unpremul_rect(void *canvas, int stride, int x, int y, int w, int h)
+{
+	unsigned char *line;
+
+	if (!canvas || w <= 0 || h <= 0) {
+		return;
+	}
+
+	line = (unsigned char *)canvas + y * stride + x * sizeof(unsigned int);
+	while (h-- > 0) {
+		unpremul_pixels((unsigned int *)line, w);
+		line += stride;
+	}
+}
+
+/* End of a file */
@@ -0,0 +1,248 @@
+/*
+ * Copyright 2013  Samsung Electronics Co., Ltd
+ *
+ * Licensed under the Flora License, Version 1.1 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://floralicense.org/license/
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*!
+ * \brief
+ * Compares unpremul_pixels with evas_data_argb_unpremul on canvases of common widget sizes.
+ * Each canvas is filled with premultiplied pixels and restored before every run,
+ * only the unpremultiplying call is measured.
+ *
+ * widget_edje-unpremul-bench [-n COUNT] [-s WxH]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <Evas.h>
+
+#include "unpremul.h"
+
+#define DEFAULT_COUNT 200
+
+enum pattern {
+	PATTERN_NOISE, /*!< Every pixel is different, no run can be reused */
+	PATTERN_FLAT, /*!< Runs of same pixels, like a widget which has opaque areas and flat colors */
+	PATTERN_MAX
+};
+
+static const char *pattern_name[PATTERN_MAX] = {
+	"noise",
+	"flat",
+};
+
+static const struct {
+	int w;
+	int h;
+} s_size[] = {
+	{ 175, 175 }, /* 1x1 */
+	{ 354, 175 }, /* 2x1 */
+	{ 354, 354 }, /* 2x2 */
+	{ 360, 360 }, /* Wearable */
+	{ 712, 354 }, /* 4x2 */
+	{ 712, 712 }, /* 4x4 */
+};
+
+static double timestamp(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+static inline unsigned int premul_pixel(unsigned int a, unsigned int r, unsigned int g, unsigned int b)
+{
+	return (a << 24) | ((r * a / 255) << 16) | ((g * a / 255) << 8) | (b * a / 255);
+}
+
+static void fill_canvas(unsigned int *data, int len, enum pattern pattern)
+{
+	unsigned int pixel = 0;
+	unsigned int a;
+	int run = 0;
+	int i;
+
+	srand(len);
+	for (i = 0; i < len; i++) {
+		if (pattern == PATTERN_FLAT && run-- > 0) {
+			data[i] = pixel;
+			continue;
+		}
+
+		/* A quarter of pixels are transparent or opaque, those are not changed */
+		a = rand() & 0x1FF;
+		a = a > 255 ? ((a & 1) ? 255 : 0) : a;
+		pixel = premul_pixel(a, rand() & 0xFF, rand() & 0xFF, rand() & 0xFF);
+		data[i] = pixel;
+		run = rand() % 64;
+	}
+}
+
+/*!
+ * \note
+ * evas_data_argb_unpremul makes transparent pixels zero and doesn't clamp,
+ * but a valid premultiplied canvas gives the same result.
+ */
+static int compare(const unsigned int *src, const unsigned int *a, const unsigned int *b, int len)
+{
+	int mismatch = 0;
+	int i;
+
+	for (i = 0; i < len; i++) {
+		if (src[i] >> 24 == 0) {
+			continue;
+		}
+
+		if (a[i] != b[i]) {
+			if (!mismatch) {
+				fprintf(stderr, "Mismatch at %d: %08X -> %08X / %08X\n", i, src[i], a[i], b[i]);
+			}
+			mismatch++;
+		}
+	}
+
+	return mismatch;
+}
+
+static double run(void (*unpremul)(unsigned int *data, int len), unsigned int *data, const unsigned int *src, int len, int count)
+{
+	double elapsed = 0.0f;
+	double stime;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		memcpy(data, src, len * sizeof(*data));
+
+		stime = timestamp();
+		unpremul(data, len);
+		elapsed += timestamp() - stime;
+	}
+
+	return elapsed;
+}
+
+static void evas_unpremul(unsigned int *data, int len)
+{
+	evas_data_argb_unpremul(data, len);
+}
+
+static int bench(int w, int h, int count)
+{
+	unsigned int *src;
+	unsigned int *ref;
+	unsigned int *data;
+	double evas_time;
+	double kernel_time;
+	int mismatch = 0;
+	int len = w * h;
+	int pattern;
+
+	src = malloc(len * sizeof(*src));
+	ref = malloc(len * sizeof(*ref));
+	data = malloc(len * sizeof(*data));
+	if (!src || !ref || !data) {
+		perror("malloc");
+		free(src);
+		free(ref);
+		free(data);
+		return -1;
+	}
+
+	for (pattern = 0; pattern < PATTERN_MAX; pattern++) {
+		fill_canvas(src, len, pattern);
+
+		evas_time = run(evas_unpremul, ref, src, len, count);
+		kernel_time = run(unpremul_pixels, data, src, len, count);
+		mismatch += compare(src, ref, data, len);
+
+		printf("%4dx%-4d %-5s evas %8.2f us  unpremul %8.2f us  %5.2fx\n",
+				w, h, pattern_name[pattern],
+				evas_time * 1000000.0f / count, kernel_time * 1000000.0f / count,
+				kernel_time > 0.0f ? evas_time / kernel_time : 0.0f);
+	}
+
+	free(src);
+	free(ref);
+	free(data);
+	return mismatch;
+}
+
+int main(int argc, char *argv[])
+{
+	int count = DEFAULT_COUNT;
+	int mismatch = 0;
+	int w = 0;
+	int h = 0;
+	int ret;
+	int c;
+	int i;
+
+	while ((c = getopt(argc, argv, "n:s:")) != -1) {
+		switch (c) {
+		case 'n':
+			count = atoi(optarg);
+			break;
+		case 's':
+			if (sscanf(optarg, "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0) {
+				fprintf(stderr, "Invalid size: %s\n", optarg);
+				return 1;
+			}
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-n COUNT] [-s WxH]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (count <= 0) {
+		fprintf(stderr, "Invalid count: %d\n", count);
+		return 1;
+	}
+
+#if defined(__AVX2__)
+	printf("unpremul: AVX2, %d runs\n", count);
+#elif defined(__SSE2__)
+	printf("unpremul: SSE2, %d runs\n", count);
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+	printf("unpremul: NEON, %d runs\n", count);
+#else
+	printf("unpremul: C, %d runs\n", count);
+#endif
+
+	for (i = 0; i < sizeof(s_size) / sizeof(s_size[0]); i++) {
+		ret = w ? bench(w, h, count) : bench(s_size[i].w, s_size[i].h, count);
+		if (ret < 0) {
+			return 1;
+		}
+
+		mismatch += ret;
+		if (w) {
+			break;
+		}
+	}
+
+	if (mismatch) {
+		fprintf(stderr, "%d pixels are different\n", mismatch);
+		return 1;
+	}
+
+	return 0;
+}
+
+/* End of a file */
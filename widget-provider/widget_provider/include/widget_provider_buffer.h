@@ -517,6 +517,25 @@ extern int widget_provider_buffer_frame_skip(widget_buffer_h info);
  */
 extern int widget_provider_buffer_clear_frame_skip(widget_buffer_h info);
 
+/**
+ * @brief Get the counters of frames of the N-buffered SHM.
+ * @details If the master gives N-buffered SHM, widget_provider_buffer_post_render() publishes the drawn frame to a free slot
+ *          and the viewers read the latest one without the lock.
+ *          A frame is dropped if it is replaced by the next one before any viewer takes it,
+ *          and it is skipped if it is not published, because of the frame-skip or every slot is being read.
+ * @param[in] info Buffer handle
+ * @param[out] published Count of published frames, can be @c NULL
+ * @param[out] dropped Count of dropped frames, can be @c NULL
+ * @param[out] skipped Count of skipped frames, can be @c NULL
+ * @privlevel platform
+ * @privilege %http://developer.samsung.com/privilege/core/widget.provider
+ * @return 0 on success, otherwise a negative error value
+ * @retval #WIDGET_ERROR_NONE Successfully get the counters
+ * @retval #WIDGET_ERROR_INVALID_PARAMETER Invalid argument
+ * @retval #WIDGET_ERROR_NOT_SUPPORTED The buffer has a single frame
+ */
+extern int widget_provider_buffer_frame_stat(widget_buffer_h info, unsigned int *published, unsigned int *dropped, unsigned int *skipped);
+
 /**
  * @brief Dump the buffer to a file
  * @details Used for debugging renderer.
@@ -33,6 +33,15 @@ extern int fb_release_buffer(void *data);
 extern const char *fb_id(struct fb_info *info);
 extern int fb_type(struct fb_info *info);
 
+/*!
+ * \note
+ * For the N-buffered SHM, the frame is drawn on the draw frame and fb_publish() copies it to a free slot.
+ * If skip is not 0, the frame is only counted as a skipped one.
+ */
+extern int fb_slots(struct fb_info *info);
+extern int fb_publish(struct fb_info *info, int skip);
+extern int fb_frame_stat(struct fb_info *info, unsigned int *published, unsigned int *dropped, unsigned int *skipped);
+
 extern int fb_create_gem(struct fb_info *info, int auto_align);
 extern int fb_destroy_gem(struct fb_info *info);
 extern void *fb_acquire_gem(struct fb_info *info);
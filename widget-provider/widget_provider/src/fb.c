@@ -43,6 +43,9 @@
 #include <widget_service.h>
 #include <widget_buffer.h>
 #include <widget_util.h>
+#include <widget_conf.h>
+#include <packet.h>
+#include <com-core_packet.h>
 
 #include "debug.h"
 #include "util.h"
@@ -58,8 +61,20 @@ struct pixmap_info {
 	XShmSegmentInfo si;
 	XImage *xim;
 	GC gc;
+
+	int w;
+	int h;
+	int pixels;
 };
 
+/*!
+ * \brief
+ * Released XShm segments are kept for a while, to reuse them for the next buffer which has the same size.
+ * The least recently released one is destroyed first, if the pool exceeds its limit.
+ */
+#define PIXMAP_POOL_MAX_COUNT	4
+#define PIXMAP_POOL_MAX_SIZE	(8 << 20)
+
 struct gem_data {
 	DRI2Buffer *dri2_buffer;
 	unsigned int attachments[1];
@@ -80,6 +95,8 @@ static struct info {
 	tbm_bufmgr bufmgr;
 	int fd;
 	struct dlist *shm_list;
+	struct dlist *pixmap_pool; /*!< Attached segments which are not used, the most recently released one is the first */
+	int pixmap_pool_size;
 
 	Display *disp;
 	int screen;
@@ -91,6 +108,8 @@ static struct info {
 	.bufmgr = NULL,
 	.fd = -1,
 	.shm_list = NULL,
+	.pixmap_pool = NULL,
+	.pixmap_pool_size = 0,
 
 	.disp = NULL,
 	.screen = 0,
@@ -99,6 +118,8 @@ static struct info {
 	.master_disconnected = 0,
 };
 
+static void flush_pixmap_pool(int max_count, int max_size);
+
 int fb_init(void *disp)
 {
 	Screen *screen;
@@ -139,6 +160,8 @@ int fb_init(void *disp)
 
 int fb_fini(void)
 {
+	flush_pixmap_pool(0, 0);
+
 	if (s_info.bufmgr) {
 		tbm_bufmgr_deinit(s_info.bufmgr);
 		s_info.bufmgr = NULL;
@@ -248,6 +271,73 @@ static inline int sync_for_pixmap(struct fb_info *info)
 	return WIDGET_ERROR_NONE;
 }
 
+/*!
+ * \brief
+ * Get the memfd of the buffer from the master, and map it.
+ * The fd is closed after mapping, the mapping is kept until the FB is destroyed.
+ */
+static widget_fb_t map_memfd(struct fb_info *info)
+{
+	struct packet *packet;
+	struct packet *result;
+	widget_fb_t buffer;
+	struct stat st;
+	int ret;
+	int fd;
+
+	packet = packet_create(CMD_STR_BUFFER_FD, "s", info->id);
+	if (!packet) {
+		ErrPrint("Failed to build a packet\n");
+		return NULL;
+	}
+
+	result = com_core_packet_oneshot_send(SLAVE_SOCKET, packet, 0.0f);
+	packet_destroy(packet);
+	if (!result) {
+		ErrPrint("Failed to send a request\n");
+		return NULL;
+	}
+
+	if (packet_get(result, "i", &ret) != 1) {
+		ErrPrint("Invalid result packet\n");
+		ret = WIDGET_ERROR_INVALID_PARAMETER;
+	}
+
+	fd = packet_fd(result);
+	packet_unref(result);
+
+	if (ret != WIDGET_ERROR_NONE || fd < 0) {
+		ErrPrint("Failed to get the fd of %s: %d\n", info->id, ret);
+		if (fd >= 0 && close(fd) < 0) {
+			ErrPrint("close: %d\n", errno);
+		}
+		return NULL;
+	}
+
+	if (fstat(fd, &st) < 0) {
+		ErrPrint("fstat: %d\n", errno);
+		buffer = MAP_FAILED;
+	} else {
+		buffer = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (buffer == MAP_FAILED) {
+			ErrPrint("mmap: %d\n", errno);
+		}
+	}
+
+	if (close(fd) < 0) {
+		ErrPrint("close: %d\n", errno);
+	}
+
+	return buffer == MAP_FAILED ? NULL : buffer;
+}
+
+static void unmap_memfd(widget_fb_t buffer)
+{
+	if (munmap(buffer, sizeof(*buffer) + WIDGET_FB_MEMFD_SIZE(buffer)) < 0) {
+		ErrPrint("munmap: %d\n", errno);
+	}
+}
+
 int fb_sync(struct fb_info *info)
 {
 	if (!info) {
@@ -266,6 +356,15 @@ int fb_sync(struct fb_info *info)
 		return sync_for_pixmap(info);
 	} else if (!strncasecmp(info->id, SCHEMA_SHM, strlen(SCHEMA_SHM))) {
 		return WIDGET_ERROR_NONE;
+	} else if (!strncasecmp(info->id, SCHEMA_MEMFD, strlen(SCHEMA_MEMFD))) {
+		/*!
+		 * \note
+		 * Viewers are reading the same pages, publish the frame only.
+		 */
+		if (info->buffer) {
+			WIDGET_FB_MEMFD_PUBLISH((widget_fb_t)info->buffer);
+		}
+		return WIDGET_ERROR_NONE;
 	}
 
 	ErrPrint("Invalid URI: [%s]\n", info->id);
@@ -353,6 +452,10 @@ static inline __attribute__((always_inline)) int create_pixmap_info(unsigned int
 		return WIDGET_ERROR_FAULT;
 	}
 
+	pixmap_info->w = w;
+	pixmap_info->h = h;
+	pixmap_info->pixels = pixels;
+
 	DbgPrint("SHMID: %d (Size: %d), %p\n", pixmap_info->si.shmid, bufsz, pixmap_info->si.shmaddr);
 	return WIDGET_ERROR_NONE;
 }
@@ -375,6 +478,80 @@ static inline int destroy_pixmap_info(struct pixmap_info *pixmap_info)
 	return WIDGET_ERROR_NONE;
 }
 
+/*!
+ * \brief
+ * Destroy pooled segments from the least recently released one, until the pool fits in the limits.
+ */
+static void flush_pixmap_pool(int max_count, int max_size)
+{
+	struct pixmap_info *pooled;
+	struct dlist *l;
+
+	while (s_info.pixmap_pool && (dlist_count(s_info.pixmap_pool) > max_count || s_info.pixmap_pool_size > max_size)) {
+		l = dlist_prev(s_info.pixmap_pool);
+		pooled = dlist_data(l);
+		s_info.pixmap_pool = dlist_remove(s_info.pixmap_pool, l);
+
+		s_info.pixmap_pool_size -= pooled->w * pooled->h * pooled->pixels;
+		destroy_pixmap_info(pooled);
+		free(pooled);
+	}
+}
+
+/*!
+ * \brief
+ * Same as the create_pixmap_info, but an attached segment in the pool is used if there is one for the same size.
+ */
+static int acquire_pixmap_info(unsigned int pixmap, struct pixmap_info *pixmap_info, int bufsz, int w, int h, int pixels)
+{
+	struct pixmap_info *pooled;
+	struct dlist *l;
+
+	dlist_foreach(s_info.pixmap_pool, l, pooled) {
+		if (pooled->w == w && pooled->h == h && pooled->pixels == pixels) {
+			s_info.pixmap_pool = dlist_remove(s_info.pixmap_pool, l);
+			s_info.pixmap_pool_size -= w * h * pixels;
+
+			memcpy(pixmap_info, pooled, sizeof(*pixmap_info));
+			free(pooled);
+
+			/* Newly created segment is cleared, keep it same */
+			memset(pixmap_info->si.shmaddr, 0, bufsz);
+			DbgPrint("Reuse SHMID: %d (Size: %d), %p\n", pixmap_info->si.shmid, bufsz, pixmap_info->si.shmaddr);
+			return WIDGET_ERROR_NONE;
+		}
+	}
+
+	return create_pixmap_info(pixmap, pixmap_info, bufsz, w, h, pixels);
+}
+
+static void release_pixmap_info(struct pixmap_info *pixmap_info)
+{
+	struct pixmap_info *pooled;
+	struct dlist *pool;
+
+	pooled = malloc(sizeof(*pooled));
+	if (!pooled) {
+		ErrPrint("malloc: %d\n", errno);
+		destroy_pixmap_info(pixmap_info);
+		return;
+	}
+
+	memcpy(pooled, pixmap_info, sizeof(*pooled));
+
+	pool = dlist_prepend(s_info.pixmap_pool, pooled);
+	if (!pool) {
+		ErrPrint("Failed to pool a segment\n");
+		destroy_pixmap_info(pooled);
+		free(pooled);
+		return;
+	}
+
+	s_info.pixmap_pool = pool;
+	s_info.pixmap_pool_size += pooled->w * pooled->h * pooled->pixels;
+	flush_pixmap_pool(PIXMAP_POOL_MAX_COUNT, PIXMAP_POOL_MAX_SIZE);
+}
+
 static inline struct gem_data *create_gem(Pixmap pixmap, int w, int h, int depth, int auto_align)
 {
 	struct gem_data *gem;
@@ -629,6 +806,8 @@ struct fb_info *fb_create(const char *id, int w, int h)
 		DbgPrint("PIXMAP: %d\n", info->handle);
 	} else if (!strncasecmp(info->id, SCHEMA_FILE, strlen(SCHEMA_FILE))) {
 		info->handle = -1;
+	} else if (!strncasecmp(info->id, SCHEMA_MEMFD, strlen(SCHEMA_MEMFD))) {
+		info->handle = -1; /*!< The fd is requested when the buffer is acquired */
 	} else {
 		ErrPrint("Unsupported schema: %s\n", info->id);
 		free(info->id);
@@ -703,7 +882,10 @@ int fb_destroy(struct fb_info *info)
 		return WIDGET_ERROR_INVALID_PARAMETER;
 	}
 
-	if (info->buffer) {
+	if (info->buffer && !strncasecmp(info->id, SCHEMA_MEMFD, strlen(SCHEMA_MEMFD))) {
+		unmap_memfd(info->buffer);
+		info->buffer = NULL;
+	} else if (info->buffer) {
 		widget_fb_t buffer;
 		buffer = info->buffer;
 		buffer->info = NULL;
@@ -725,6 +907,8 @@ int fb_is_created(struct fb_info *info)
 		return 1;
 	} else if (!strncasecmp(info->id, SCHEMA_SHM, strlen(SCHEMA_SHM)) && info->handle > 0) {
 		return 1;
+	} else if (!strncasecmp(info->id, SCHEMA_MEMFD, strlen(SCHEMA_MEMFD))) {
+		return 1;
 	} else {
 		const char *path;
 		path = widget_util_uri_to_path(info->id);
@@ -768,7 +952,7 @@ void *fb_acquire_buffer(struct fb_info *info)
 			info->buffer = buffer;
 
 			DbgPrint("Create PIXMAP Info\n");
-			if (create_pixmap_info(info->handle, (struct pixmap_info *)buffer->data, info->bufsz, info->w, info->h, info->pixels) != WIDGET_ERROR_NONE) {
+			if (acquire_pixmap_info(info->handle, (struct pixmap_info *)buffer->data, info->bufsz, info->w, info->h, info->pixels) != WIDGET_ERROR_NONE) {
 				free(buffer);
 				info->buffer = NULL;
 				info->bufsz = 0;
@@ -797,6 +981,13 @@ void *fb_acquire_buffer(struct fb_info *info)
 				return NULL;
 			}
 
+			info->buffer = buffer;
+		} else if (!strncasecmp(info->id, SCHEMA_MEMFD, strlen(SCHEMA_MEMFD))) {
+			buffer = map_memfd(info);
+			if (!buffer) {
+				return NULL;
+			}
+
 			info->buffer = buffer;
 		} else {
 			DbgPrint("Buffer is NIL\n");
@@ -805,7 +996,7 @@ void *fb_acquire_buffer(struct fb_info *info)
 	}
 
 	buffer = info->buffer;
-	switch (buffer->type) {
+	switch ((int)buffer->type) {
 	case WIDGET_FB_TYPE_PIXMAP:
 		buffer->refcnt++;
 		pixmap_info = (struct pixmap_info *)buffer->data;
@@ -815,6 +1006,7 @@ void *fb_acquire_buffer(struct fb_info *info)
 		buffer->refcnt++;
 		/* Fall through */
 	case WIDGET_FB_TYPE_SHM:
+	case WIDGET_FB_TYPE_MEMFD:
 		addr = buffer->data;
 		break;
 	default:
@@ -846,7 +1038,13 @@ int fb_release_buffer(void *data)
 		return WIDGET_ERROR_INVALID_PARAMETER;
 	}
 
-	switch (buffer->type) {
+	switch ((int)buffer->type) {
+	case WIDGET_FB_TYPE_MEMFD:
+		/*!
+		 * \note
+		 * It is unmapped when the FB is destroyed.
+		 */
+		break;
 	case WIDGET_FB_TYPE_SHM:
 		/*!
 		 * \note
@@ -865,7 +1063,7 @@ int fb_release_buffer(void *data)
 					info->buffer = NULL;
 				}
 				dlist_remove_data(s_info.shm_list, info);
-				destroy_pixmap_info((struct pixmap_info *)buffer->data);
+				release_pixmap_info((struct pixmap_info *)buffer->data);
 			}
 			buffer->state = WIDGET_FB_STATE_DESTROYED;
 			free(buffer);
@@ -913,6 +1111,8 @@ int fb_type(struct fb_info *info)
 				type = WIDGET_FB_TYPE_PIXMAP;
 			} else if (!strncasecmp(info->id, SCHEMA_SHM, strlen(SCHEMA_SHM))) {
 				type = WIDGET_FB_TYPE_SHM;
+			} else if (!strncasecmp(info->id, SCHEMA_MEMFD, strlen(SCHEMA_MEMFD))) {
+				type = WIDGET_FB_TYPE_MEMFD;
 			}
 		}
 
@@ -939,7 +1139,10 @@ int fb_refcnt(void *data)
 		return WIDGET_ERROR_INVALID_PARAMETER;
 	}
 
-	switch (buffer->type) {
+	switch ((int)buffer->type) {
+	case WIDGET_FB_TYPE_MEMFD:
+		ret = 1; /*!< Mapped until the FB is destroyed */
+		break;
 	case WIDGET_FB_TYPE_SHM:
 		if (shmctl(buffer->refcnt, IPC_STAT, &buf) < 0) {
 			ErrPrint("shmctl: %d\n", errno);
@@ -963,6 +1166,118 @@ int fb_refcnt(void *data)
 	return ret;
 }
 
+int fb_slots(struct fb_info *info)
+{
+	const char *slots;
+
+	if (!info || !info->id || strncasecmp(info->id, SCHEMA_SHM, strlen(SCHEMA_SHM))) {
+		return 0;
+	}
+
+	slots = strrchr(info->id, SHM_RING_DELIM);
+	return slots ? atoi(slots + 1) : 0;
+}
+
+int fb_publish(struct fb_info *info, int skip)
+{
+	struct shm_ring *ring;
+	widget_fb_t buffer;
+	widget_fb_t slot;
+	unsigned int latest;
+	unsigned int seq;
+	unsigned int idx;
+	unsigned int i;
+
+	if (fb_slots(info) <= 1) {
+		return WIDGET_ERROR_NOT_SUPPORTED;
+	}
+
+	buffer = info->buffer;
+	if (!buffer) {
+		/*!
+		 * \note
+		 * Nothing is drawn yet.
+		 */
+		return WIDGET_ERROR_NONE;
+	}
+
+	ring = SHM_RING(buffer);
+	if (skip) {
+		__atomic_add_fetch(&ring->skipped, 1, __ATOMIC_RELAXED);
+		return WIDGET_ERROR_NONE;
+	}
+
+	/*!
+	 * \note
+	 * Only this provider publishes, the latest is not changed by others.
+	 * Viewers increase the readers of a slot then check the latest again,
+	 * the provider checks the readers after it publishes another one,
+	 * so one of them always sees the other's change. (Both are sequentially consistent)
+	 */
+	latest = __atomic_load_n(&ring->latest, __ATOMIC_RELAXED);
+	idx = latest ? SHM_RING_LATEST_IDX(latest) : ring->count;
+
+	for (i = 1; i <= ring->count; i++) {
+		unsigned int candidate = (idx + i) % ring->count;
+
+		if (candidate != idx && __atomic_load_n(&ring->readers[candidate], __ATOMIC_SEQ_CST) == 0) {
+			break;
+		}
+	}
+
+	if (i > ring->count) {
+		/*!
+		 * \note
+		 * Every other slot is being read, this frame is dropped.
+		 * The draw frame keeps its contents, the next one will publish it.
+		 */
+		__atomic_add_fetch(&ring->skipped, 1, __ATOMIC_RELAXED);
+		return WIDGET_ERROR_NONE;
+	}
+
+	idx = (idx + i) % ring->count;
+	slot = SHM_RING_SLOT(ring, idx);
+	memcpy(slot->data, buffer->data, ring->frame_size);
+
+	seq = SHM_RING_LATEST_SEQ(latest);
+	if (latest && __atomic_load_n(&ring->consumed, __ATOMIC_RELAXED) != seq) {
+		__atomic_add_fetch(&ring->dropped, 1, __ATOMIC_RELAXED);
+	}
+
+	seq = (seq + 1) & 0x3FFFFFFF;
+	if (!seq) {
+		seq = 1;
+	}
+
+	__atomic_store_n(&ring->latest, SHM_RING_LATEST(seq, idx), __ATOMIC_SEQ_CST);
+	return WIDGET_ERROR_NONE;
+}
+
+int fb_frame_stat(struct fb_info *info, unsigned int *published, unsigned int *dropped, unsigned int *skipped)
+{
+	struct shm_ring *ring;
+
+	if (fb_slots(info) <= 1 || !info->buffer) {
+		return WIDGET_ERROR_NOT_SUPPORTED;
+	}
+
+	ring = SHM_RING((widget_fb_t)info->buffer);
+
+	if (published) {
+		*published = SHM_RING_LATEST_SEQ(__atomic_load_n(&ring->latest, __ATOMIC_RELAXED));
+	}
+
+	if (dropped) {
+		*dropped = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+	}
+
+	if (skipped) {
+		*skipped = __atomic_load_n(&ring->skipped, __ATOMIC_RELAXED);
+	}
+
+	return WIDGET_ERROR_NONE;
+}
+
 const char *fb_id(struct fb_info *info)
 {
 	return info ? info->id : NULL;
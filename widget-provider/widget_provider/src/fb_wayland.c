@@ -32,6 +32,9 @@
 #include <widget_service.h>
 #include <widget_buffer.h>
 #include <widget_util.h>
+#include <widget_conf.h>
+#include <packet.h>
+#include <com-core_packet.h>
 
 #include <wayland-client.h>
 #include <tbm_bufmgr.h>
@@ -213,6 +216,73 @@ static inline int sync_for_pixmap(struct fb_info *info)
 	return WIDGET_ERROR_NONE;
 }
 
+/*!
+ * \brief
+ * Get the memfd of the buffer from the master, and map it.
+ * The fd is closed after mapping, the mapping is kept until the FB is destroyed.
+ */
+static widget_fb_t map_memfd(struct fb_info *info)
+{
+	struct packet *packet;
+	struct packet *result;
+	widget_fb_t buffer;
+	struct stat st;
+	int ret;
+	int fd;
+
+	packet = packet_create(CMD_STR_BUFFER_FD, "s", info->id);
+	if (!packet) {
+		ErrPrint("Failed to build a packet\n");
+		return NULL;
+	}
+
+	result = com_core_packet_oneshot_send(SLAVE_SOCKET, packet, 0.0f);
+	packet_destroy(packet);
+	if (!result) {
+		ErrPrint("Failed to send a request\n");
+		return NULL;
+	}
+
+	if (packet_get(result, "i", &ret) != 1) {
+		ErrPrint("Invalid result packet\n");
+		ret = WIDGET_ERROR_INVALID_PARAMETER;
+	}
+
+	fd = packet_fd(result);
+	packet_unref(result);
+
+	if (ret != WIDGET_ERROR_NONE || fd < 0) {
+		ErrPrint("Failed to get the fd of %s: %d\n", info->id, ret);
+		if (fd >= 0 && close(fd) < 0) {
+			ErrPrint("close: %d\n", errno);
+		}
+		return NULL;
+	}
+
+	if (fstat(fd, &st) < 0) {
+		ErrPrint("fstat: %d\n", errno);
+		buffer = MAP_FAILED;
+	} else {
+		buffer = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (buffer == MAP_FAILED) {
+			ErrPrint("mmap: %d\n", errno);
+		}
+	}
+
+	if (close(fd) < 0) {
+		ErrPrint("close: %d\n", errno);
+	}
+
+	return buffer == MAP_FAILED ? NULL : buffer;
+}
+
+static void unmap_memfd(widget_fb_t buffer)
+{
+	if (munmap(buffer, sizeof(*buffer) + WIDGET_FB_MEMFD_SIZE(buffer)) < 0) {
+		ErrPrint("munmap: %d\n", errno);
+	}
+}
+
 int fb_sync(struct fb_info *info)
 {
 	if (!info) {
@@ -231,6 +301,15 @@ int fb_sync(struct fb_info *info)
 		return sync_for_pixmap(info);
 	} else if (!strncasecmp(info->id, SCHEMA_SHM, strlen(SCHEMA_SHM))) {
 		return WIDGET_ERROR_NONE;
+	} else if (!strncasecmp(info->id, SCHEMA_MEMFD, strlen(SCHEMA_MEMFD))) {
+		/*!
+		 * \note
+		 * Viewers are reading the same pages, publish the frame only.
+		 */
+		if (info->buffer) {
+			WIDGET_FB_MEMFD_PUBLISH((widget_fb_t)info->buffer);
+		}
+		return WIDGET_ERROR_NONE;
 	}
 
 	ErrPrint("Invalid URI: [%s]\n", info->id);
@@ -267,6 +346,8 @@ struct fb_info *fb_create(const char *id, int w, int h)
 		DbgPrint("PIXMAP: %d\n", info->handle);
 	} else if (!strncasecmp(info->id, SCHEMA_FILE, strlen(SCHEMA_FILE))) {
 		info->handle = -1;
+	} else if (!strncasecmp(info->id, SCHEMA_MEMFD, strlen(SCHEMA_MEMFD))) {
+		info->handle = -1; /*!< The fd is requested when the buffer is acquired */
 	} else {
 		ErrPrint("Unsupported schema: %s\n", info->id);
 		free(info->id);
@@ -449,7 +530,10 @@ int fb_destroy(struct fb_info *info)
 		return WIDGET_ERROR_INVALID_PARAMETER;
 	}
 
-	if (info->buffer) {
+	if (info->buffer && !strncasecmp(info->id, SCHEMA_MEMFD, strlen(SCHEMA_MEMFD))) {
+		unmap_memfd(info->buffer);
+		info->buffer = NULL;
+	} else if (info->buffer) {
 		widget_fb_t buffer;
 		buffer = info->buffer;
 		buffer->info = NULL;
@@ -471,6 +555,8 @@ int fb_is_created(struct fb_info *info)
 		return 1;
 	} else if (!strncasecmp(info->id, SCHEMA_SHM, strlen(SCHEMA_SHM)) && info->handle > 0) {
 		return 1;
+	} else if (!strncasecmp(info->id, SCHEMA_MEMFD, strlen(SCHEMA_MEMFD))) {
+		return 1;
 	} else {
 		const char *path;
 		path = widget_util_uri_to_path(info->id);
@@ -518,6 +604,13 @@ void *fb_acquire_buffer(struct fb_info *info)
 				return NULL;
 			}
 
+			info->buffer = buffer;
+		} else if (!strncasecmp(info->id, SCHEMA_MEMFD, strlen(SCHEMA_MEMFD))) {
+			buffer = map_memfd(info);
+			if (!buffer) {
+				return NULL;
+			}
+
 			info->buffer = buffer;
 		} else {
 			DbgPrint("Buffer is NIL\n");
@@ -526,11 +619,12 @@ void *fb_acquire_buffer(struct fb_info *info)
 	}
 
 	buffer = info->buffer;
-	switch (buffer->type) {
+	switch ((int)buffer->type) {
 	case WIDGET_FB_TYPE_FILE:
 		buffer->refcnt++;
 		/* Fall through */
 	case WIDGET_FB_TYPE_SHM:
+	case WIDGET_FB_TYPE_MEMFD:
 		addr = buffer->data;
 		break;
 	case WIDGET_FB_TYPE_PIXMAP:
@@ -558,7 +652,13 @@ int fb_release_buffer(void *data)
 		return WIDGET_ERROR_INVALID_PARAMETER;
 	}
 
-	switch (buffer->type) {
+	switch ((int)buffer->type) {
+	case WIDGET_FB_TYPE_MEMFD:
+		/*!
+		 * \note
+		 * It is unmapped when the FB is destroyed.
+		 */
+		break;
 	case WIDGET_FB_TYPE_SHM:
 		/*!
 		 * \note
@@ -614,6 +714,8 @@ int fb_type(struct fb_info *info)
 				type = WIDGET_FB_TYPE_PIXMAP;
 			} else if (!strncasecmp(info->id, SCHEMA_SHM, strlen(SCHEMA_SHM))) {
 				type = WIDGET_FB_TYPE_SHM;
+			} else if (!strncasecmp(info->id, SCHEMA_MEMFD, strlen(SCHEMA_MEMFD))) {
+				type = WIDGET_FB_TYPE_MEMFD;
 			}
 		}
 
@@ -640,7 +742,10 @@ int fb_refcnt(void *data)
 		return WIDGET_ERROR_INVALID_PARAMETER;
 	}
 
-	switch (buffer->type) {
+	switch ((int)buffer->type) {
+	case WIDGET_FB_TYPE_MEMFD:
+		ret = 1; /*!< Mapped until the FB is destroyed */
+		break;
 	case WIDGET_FB_TYPE_SHM:
 		if (shmctl(buffer->refcnt, IPC_STAT, &buf) < 0) {
 			ErrPrint("shmctl: %d\n", errno);
@@ -664,6 +769,118 @@ int fb_refcnt(void *data)
 	return ret;
 }
 
+int fb_slots(struct fb_info *info)
+{
+	const char *slots;
+
+	if (!info || !info->id || strncasecmp(info->id, SCHEMA_SHM, strlen(SCHEMA_SHM))) {
+		return 0;
+	}
+
+	slots = strrchr(info->id, SHM_RING_DELIM);
+	return slots ? atoi(slots + 1) : 0;
+}
+
+int fb_publish(struct fb_info *info, int skip)
+{
+	struct shm_ring *ring;
+	widget_fb_t buffer;
+	widget_fb_t slot;
+	unsigned int latest;
+	unsigned int seq;
+	unsigned int idx;
+	unsigned int i;
+
+	if (fb_slots(info) <= 1) {
+		return WIDGET_ERROR_NOT_SUPPORTED;
+	}
+
+	buffer = info->buffer;
+	if (!buffer) {
+		/*!
+		 * \note
+		 * Nothing is drawn yet.
+		 */
+		return WIDGET_ERROR_NONE;
+	}
+
+	ring = SHM_RING(buffer);
+	if (skip) {
+		__atomic_add_fetch(&ring->skipped, 1, __ATOMIC_RELAXED);
+		return WIDGET_ERROR_NONE;
+	}
+
+	/*!
+	 * \note
+	 * Only this provider publishes, the latest is not changed by others.
+	 * Viewers increase the readers of a slot then check the latest again,
+	 * the provider checks the readers after it publishes another one,
+	 * so one of them always sees the other's change. (Both are sequentially consistent)
+	 */
+	latest = __atomic_load_n(&ring->latest, __ATOMIC_RELAXED);
+	idx = latest ? SHM_RING_LATEST_IDX(latest) : ring->count;
+
+	for (i = 1; i <= ring->count; i++) {
+		unsigned int candidate = (idx + i) % ring->count;
+
+		if (candidate != idx && __atomic_load_n(&ring->readers[candidate], __ATOMIC_SEQ_CST) == 0) {
+			break;
+		}
+	}
+
+	if (i > ring->count) {
+		/*!
+		 * \note
+		 * Every other slot is being read, this frame is dropped.
+		 * The draw frame keeps its contents, the next one will publish it.
+		 */
+		__atomic_add_fetch(&ring->skipped, 1, __ATOMIC_RELAXED);
+		return WIDGET_ERROR_NONE;
+	}
+
+	idx = (idx + i) % ring->count;
+	slot = SHM_RING_SLOT(ring, idx);
+	memcpy(slot->data, buffer->data, ring->frame_size);
+
+	seq = SHM_RING_LATEST_SEQ(latest);
+	if (latest && __atomic_load_n(&ring->consumed, __ATOMIC_RELAXED) != seq) {
+		__atomic_add_fetch(&ring->dropped, 1, __ATOMIC_RELAXED);
+	}
+
+	seq = (seq + 1) & 0x3FFFFFFF;
+	if (!seq) {
+		seq = 1;
+	}
+
+	__atomic_store_n(&ring->latest, SHM_RING_LATEST(seq, idx), __ATOMIC_SEQ_CST);
+	return WIDGET_ERROR_NONE;
+}
+
+int fb_frame_stat(struct fb_info *info, unsigned int *published, unsigned int *dropped, unsigned int *skipped)
+{
+	struct shm_ring *ring;
+
+	if (fb_slots(info) <= 1 || !info->buffer) {
+		return WIDGET_ERROR_NOT_SUPPORTED;
+	}
+
+	ring = SHM_RING((widget_fb_t)info->buffer);
+
+	if (published) {
+		*published = SHM_RING_LATEST_SEQ(__atomic_load_n(&ring->latest, __ATOMIC_RELAXED));
+	}
+
+	if (dropped) {
+		*dropped = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+	}
+
+	if (skipped) {
+		*skipped = __atomic_load_n(&ring->skipped, __ATOMIC_RELAXED);
+	}
+
+	return WIDGET_ERROR_NONE;
+}
+
 const char *fb_id(struct fb_info *info)
 {
 	return info ? info->id : NULL;
@@ -1714,7 +1714,7 @@ EAPI int widget_provider_send_widget_update_begin(const char *pkgname, const cha
 		return WIDGET_ERROR_INVALID_PARAMETER;
 	}
 
-	packet = packet_create_noack((const char *)&cmd, "ssdss",
+	packet = packet_create_noack_ref((const char *)&cmd, "ssdss",
 			pkgname, id, priority, content_info, title);
 	if (!packet) {
 		ErrPrint("Failed to build a packet\n");
@@ -1831,7 +1831,7 @@ EAPI int widget_provider_send_extra_info(const char *pkgname, const char *id, do
 		return WIDGET_ERROR_INVALID_PARAMETER;
 	}
 
-	packet = packet_create_noack((const char *)&cmd, "ssssssd", pkgname, id, content_info, title, icon, name, priority);
+	packet = packet_create_noack_ref((const char *)&cmd, "ssssssd", pkgname, id, content_info, title, icon, name, priority);
 	if (!packet) {
 		ErrPrint("failed to build a packet\n");
 		return WIDGET_ERROR_FAULT;
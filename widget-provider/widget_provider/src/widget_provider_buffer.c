@@ -2100,6 +2100,7 @@ EAPI int widget_provider_buffer_acquire(widget_buffer_h info, int width, int hei
 	switch (fb_type(info->fb)) {
 	case WIDGET_FB_TYPE_FILE:
 	case WIDGET_FB_TYPE_SHM:
+	case WIDGET_FB_TYPE_MEMFD:
 		info->lock_info = widget_service_create_lock(info->id, info->type, WIDGET_LOCK_WRITE);
 		break;
 	case WIDGET_FB_TYPE_PIXMAP:
@@ -2469,7 +2470,12 @@ EAPI int widget_provider_buffer_pre_render(widget_buffer_h info)
 
 	if (fb_has_gem(info->fb)) {
 		ret = fb_acquire_gem(info->fb) ? WIDGET_ERROR_NONE : WIDGET_ERROR_FAULT;
-	} else if (fb_type(info->fb) == WIDGET_FB_TYPE_SHM) {
+	} else if (fb_slots(info->fb) > 1) {
+		/*!
+		 * \note
+		 * Viewers do not read the draw frame, the lock is not necessary.
+		 */
+	} else if (fb_type(info->fb) == WIDGET_FB_TYPE_SHM || fb_type(info->fb) == WIDGET_FB_TYPE_MEMFD) {
 		ret = widget_service_acquire_lock(info->lock_info);
 	} else {
 		ErrPrint("Unable to acquire gem (%s)\n", info ? (info->fb ? info->fb->id : "info->fb==null") : "info==null");
@@ -2501,7 +2507,14 @@ EAPI int widget_provider_buffer_post_render(widget_buffer_h info)
 
 	if (fb_has_gem(info->fb)) {
 		ret = fb_release_gem(info->fb);
-	} else if (fb_type(info->fb) == WIDGET_FB_TYPE_SHM) {
+	} else if (fb_slots(info->fb) > 1) {
+		/*!
+		 * \note
+		 * Frames which are in the frame-skip are not published,
+		 * viewers keep showing the previous one until it is cleared.
+		 */
+		ret = fb_publish(info->fb, info->frame_skip > 0);
+	} else if (fb_type(info->fb) == WIDGET_FB_TYPE_SHM || fb_type(info->fb) == WIDGET_FB_TYPE_MEMFD) {
 		ret = widget_service_release_lock(info->lock_info);
 	} else {
 		ErrPrint("Unable to release gem (%s)\n", info ? (info->fb ? info->fb->id : "info->fb==null") : "info==null");
@@ -2535,6 +2548,15 @@ EAPI int widget_provider_buffer_frame_skip(widget_buffer_h info)
 	return info->frame_skip;
 }
 
+EAPI int widget_provider_buffer_frame_stat(widget_buffer_h info, unsigned int *published, unsigned int *dropped, unsigned int *skipped)
+{
+	if (!info || info->state != BUFFER_CREATED) {
+		return WIDGET_ERROR_INVALID_PARAMETER;
+	}
+
+	return fb_frame_stat(info->fb, published, dropped, skipped);
+}
+
 EAPI int widget_provider_buffer_clear_frame_skip(widget_buffer_h info)
 {
 	int old;
@@ -2548,6 +2570,14 @@ EAPI int widget_provider_buffer_clear_frame_skip(widget_buffer_h info)
 	info->frame_skip = 0;
 
 	if (old > 0) {
+		/*!
+		 * \note
+		 * The last drawn frame is not published yet.
+		 */
+		if (info->state == BUFFER_CREATED && fb_slots(info->fb) > 1) {
+			(void)fb_publish(info->fb, 0);
+		}
+
 		feed_frame_skip_cleared_event(info);
 	}
 
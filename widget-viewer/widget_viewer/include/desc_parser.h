@@ -15,5 +15,8 @@
  */
 
 extern int parse_desc(struct widget_common *common, const char *filename, int is_pd);
+extern void desc_parser_cancel(struct widget_common *common);
+extern int desc_parser_init(void);
+extern int desc_parser_fini(void);
 
 /* End of a file */
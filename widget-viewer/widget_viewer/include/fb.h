@@ -25,9 +25,11 @@ extern int fb_size(struct fb_info *info);
 extern int fb_refcnt(void *data);
 extern int fb_is_created(struct fb_info *info);
 extern int fb_type(struct fb_info *info);
+extern int fb_slots(struct fb_info *info); /*!< Count of slots of the N-buffered SHM, 0 for the single frame */
 
 extern struct fb_info *fb_create(const char *filename, int w, int h);
 extern int fb_destroy(struct fb_info *info);
+extern int fb_set_ready_cb(struct fb_info *info, void (*cb)(struct fb_info *info, void *data), void *data); /*!< Invoked when a buffer which was busy is able to be acquired */
 
 extern void *fb_acquire_buffer(struct fb_info *info);
 extern int fb_release_buffer(void *data);
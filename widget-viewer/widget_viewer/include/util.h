@@ -23,6 +23,8 @@ extern int util_unlink(const char *filename);
 #define SCHEMA_PIXMAP "pixmap://"
 #define SCHEMA_SHM    "shm://"
 
+#include <com-core_buffer.h>
+
 #define container_of(ptr, type, member) \
         ({ const typeof( ((type *)0)->member ) *__mptr = (ptr);    \
         (type *)( (char *)__mptr - offsetof(type,member) );})
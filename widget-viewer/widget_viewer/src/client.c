@@ -2277,6 +2277,7 @@ int client_init(int use_thread)
 	}
 
 	(void)file_service_init();
+	(void)desc_parser_init();
 
 	DbgPrint("Server Address: %s\n", s_info.client_addr);
 
@@ -2317,6 +2318,7 @@ int client_fini(void)
 {
 	int ret;
 
+	(void)desc_parser_fini();
 	(void)file_service_fini();
 
 	ret = vconf_ignore_key_changed(VCONFKEY_MASTER_STARTED, master_started_cb);
@@ -23,6 +23,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <pthread.h>
 
 #include <gio/gio.h>
 #include <dlog.h>
@@ -30,6 +31,7 @@
 #include <widget_service.h>
 #include <widget_service_internal.h>
 #include <widget_buffer.h>
+#include <com-core_desc.h>
 
 #include "debug.h"
 #include "widget_viewer.h"
@@ -327,20 +329,13 @@ static inline void consuming_parsed_block(widget_h handle, int is_gbar, struct b
 	}
 }
 
-static inline char *load_file(const char *filename)
+static inline char *load_file(int fd, int *size)
 {
 	char *filebuf = NULL;
-	int fd;
 	off_t filesize;
 	int ret;
 	size_t readsize = 0;
 
-	fd = open(filename, O_RDONLY);
-	if (fd < 0) {
-		ErrPrint("open: %d (%s)\n", errno, filename);
-		return NULL;
-	}
-
 	filesize = lseek(fd, 0L, SEEK_END);
 	if (filesize == (off_t)-1) {
 		ErrPrint("lseek: %d\n", errno);
@@ -377,6 +372,7 @@ static inline char *load_file(const char *filename)
 
 	if (filebuf) {
 		filebuf[readsize] = '\0';
+		*size = (int)readsize;
 	}
 
 	/*!
@@ -385,14 +381,65 @@ static inline char *load_file(const char *filename)
 	 */
 
 errout:
-	if (close(fd) < 0) {
-		ErrPrint("close: %d\n", errno);
+	return filebuf;
+}
+
+struct binary_desc {
+	const char *filename;
+	struct dlist *block_list;
+};
+
+/*!
+ * \note
+ * Desc thread (or the main thread if the desc thread is not running)
+ * Blocks of the binary desc are given by the com-core, only the type should be resolved.
+ */
+static int binary_block_cb(const struct com_core_desc_block *desc, int blockno, void *data)
+{
+	struct binary_desc *binary = data;
+	struct block *block;
+	int type_idx;
+
+	if (!desc->type) {
+		ErrPrint("%d: Type is not exists\n", blockno);
+		return WIDGET_ERROR_FAULT;
 	}
 
-	return filebuf;
+	for (type_idx = 0; type_list[type_idx]; type_idx++) {
+		if (!strcmp(type_list[type_idx], desc->type)) {
+			break;
+		}
+	}
+
+	if (!type_list[type_idx]) {
+		ErrPrint("%d: type is not valid (%s)\n", blockno, desc->type);
+		return WIDGET_ERROR_FAULT;
+	}
+
+	block = calloc(1, sizeof(*block));
+	if (!block) {
+		ErrPrint("calloc: %d\n", errno);
+		return WIDGET_ERROR_OUT_OF_MEMORY;
+	}
+
+	block->type = type_idx;
+	block->part = (char *)desc->part;
+	block->data = (char *)desc->data;
+	block->option = (char *)desc->option;
+	block->id = (char *)desc->id;
+	block->target = (char *)desc->target;
+	block->file = (char *)desc->file;
+	block->filename = binary->filename;
+	binary->block_list = dlist_append(binary->block_list, block);
+	return WIDGET_ERROR_NONE;
 }
 
-int parse_desc(struct widget_common *common, const char *filename, int is_gbar)
+/*!
+ * \note
+ * Desc thread (or the main thread if the desc thread is not running)
+ * Load and tokenize the desc file, the last block of the list owns the filebuf.
+ */
+static int tokenize_desc(int fd, const char *filename, struct dlist **list)
 {
 	int type_idx = 0;
 	int type_len = 0;
@@ -400,13 +447,10 @@ int parse_desc(struct widget_common *common, const char *filename, int is_gbar)
 	int field_len = 0;
 	char *filebuf;
 	char *fileptr;
+	int filesize = 0;
 	char *ptr = NULL;
 	struct block *block = NULL;
 	struct dlist *block_list = NULL;
-	struct dlist *l;
-	struct dlist *n;
-	struct dlist *handle_iterator;
-	widget_h handler;
 	enum state {
 		BEGIN,
 		FIELD,
@@ -416,14 +460,35 @@ int parse_desc(struct widget_common *common, const char *filename, int is_gbar)
 		ERROR,
 	} state;
 
-	filebuf = load_file(filename);
+	filebuf = load_file(fd, &filesize);
 	if (!filebuf) {
 		return WIDGET_ERROR_IO_ERROR;
 	}
 
-	fileptr = filebuf;
-
 	state = BEGIN;
+	if (com_core_desc_is_binary(filebuf, filesize)) {
+		struct binary_desc binary = {
+			.filename = filename,
+			.block_list = NULL,
+		};
+		int ret;
+
+		ret = com_core_desc_foreach_block(filebuf, filesize, binary_block_cb, &binary);
+		if (ret < 0) {
+			ErrPrint("Unable to read %s (%d)\n", filename, ret);
+			state = ERROR;
+		}
+		block_list = binary.block_list;
+
+		/*!
+		 * \note
+		 * Binary desc doesn't need to be tokenized, make the text parser stop at the terminator.
+		 */
+		fileptr = filebuf + filesize;
+	} else {
+		fileptr = filebuf;
+	}
+
 	while (*fileptr && state != ERROR) {
 		switch (state) {
 		case BEGIN:
@@ -676,6 +741,30 @@ int parse_desc(struct widget_common *common, const char *filename, int is_gbar)
 		free(filebuf);
 	}
 
+	*list = block_list;
+	return WIDGET_ERROR_NONE;
+}
+
+static inline void delete_block_list(struct dlist *block_list)
+{
+	struct dlist *l;
+	struct dlist *n;
+	struct block *block;
+
+	dlist_foreach_safe(block_list, l, n, block) {
+		block_list = dlist_remove(block_list, l);
+		delete_block(block);
+	}
+}
+
+static void apply_desc(struct widget_common *common, int is_gbar, struct dlist *block_list)
+{
+	struct dlist *l;
+	struct dlist *n;
+	struct dlist *handle_iterator;
+	struct block *block;
+	widget_h handler;
+
 	ErrPrint("Begin: Set content for object\n");
 	dlist_foreach(common->widget_list, l, handler) {
 		update_begin(handler, is_gbar);
@@ -694,7 +783,421 @@ int parse_desc(struct widget_common *common, const char *filename, int is_gbar)
 		update_end(handler, is_gbar);
 	}
 	ErrPrint("End: Set content for object\n");
+}
+
+/*!
+ * \note
+ * Loading and tokenizing are done by the desc thread,
+ * blocks are applied by the main thread in between update_begin and update_end.
+ */
+#define CRITICAL_SECTION_BEGIN(handle) \
+	do { \
+		int ret; \
+		ret = pthread_mutex_lock(handle); \
+		if (ret != 0) { \
+			ErrPrint("Failed to lock: %s\n", strerror(ret)); \
+		} \
+	} while (0)
+
+#define CRITICAL_SECTION_END(handle) \
+	do { \
+		int ret; \
+		ret = pthread_mutex_unlock(handle); \
+		if (ret != 0) { \
+			ErrPrint("Failed to unlock: %s\n", strerror(ret)); \
+		} \
+	} while (0)
+
+#define CLOSE_PIPE(p)    do { \
+	int status; \
+	status = close(p[PIPE_READ]); \
+	if (status < 0) { \
+		ErrPrint("close: %d\n", errno); \
+	} \
+	status = close(p[PIPE_WRITE]); \
+	if (status < 0) { \
+		ErrPrint("close: %d\n", errno); \
+	} \
+} while (0)
+
+#define PIPE_READ 0
+#define PIPE_WRITE 1
+#define PIPE_MAX 2
+
+#define EVT_END_CH    'c'
+#define EVT_CH        'e'
+
+struct desc_request {
+	struct widget_common *common;
+	int is_gbar;
+	int fd;
+	char *filename;
+
+	int canceled; /* Protected by the desc_lock */
+
+	/* Result of the desc thread */
+	struct dlist *block_list;
+	int ret;
+};
+
+static struct {
+	pthread_t desc_thid;
+	pthread_mutex_t desc_lock;
+	int ctrl_pipe[PIPE_MAX];
+	int evt_pipe[PIPE_MAX];
+	guint evt_id;
+	struct dlist *request_list; /* Protected by the desc_lock, Not yet tokenized */
+	struct dlist *pending_list; /* Main thread only, Not yet applied */
+	int initialized;
+} s_info = {
+	.ctrl_pipe = { -1, -1 },
+	.evt_pipe = { -1, -1 },
+	.evt_id = 0,
+	.request_list = NULL,
+	.pending_list = NULL,
+	.initialized = 0,
+};
+
+static inline void destroy_request(struct desc_request *request)
+{
+	if (request->fd >= 0 && close(request->fd) < 0) {
+		ErrPrint("close: %d\n", errno);
+	}
+
+	delete_block_list(request->block_list);
+	free(request->filename);
+	free(request);
+}
+
+/*!
+ * \note
+ * Desc thread
+ */
+static void *desc_thread_main(void *data)
+{
+	struct desc_request *request;
+	struct dlist *l;
+	int canceled;
+	char ch;
+
+	while (1) {
+		if (read(s_info.ctrl_pipe[PIPE_READ], &ch, sizeof(ch)) != sizeof(ch)) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			ErrPrint("read: %d\n", errno);
+			break;
+		}
+
+		if (ch == EVT_END_CH) {
+			DbgPrint("Desc thread is canceled\n");
+			break;
+		}
+
+		/*!
+		 * \note
+		 * Consumes all queued requests, even if some events were not delivered.
+		 */
+		while (1) {
+			CRITICAL_SECTION_BEGIN(&s_info.desc_lock);
+			l = dlist_nth(s_info.request_list, 0);
+			request = dlist_data(l);
+			s_info.request_list = dlist_remove(s_info.request_list, l);
+			canceled = request ? request->canceled : 0;
+			CRITICAL_SECTION_END(&s_info.desc_lock);
+
+			if (!request) {
+				break;
+			}
+
+			if (!canceled) {
+				request->ret = tokenize_desc(request->fd, request->filename, &request->block_list);
+			}
+
+			if (close(request->fd) < 0) {
+				ErrPrint("close: %d\n", errno);
+			}
+			request->fd = -1;
+
+			if (write(s_info.evt_pipe[PIPE_WRITE], &request, sizeof(request)) != sizeof(request)) {
+				/*!
+				 * \note
+				 * The request is still in the pending_list, it will be released by desc_parser_fini.
+				 */
+				ErrPrint("write: %d\n", errno);
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/*!
+ * \note
+ * Main thread
+ */
+static gboolean evt_cb(GIOChannel *src, GIOCondition cond, gpointer data)
+{
+	struct desc_request *request;
+	struct dlist *l;
+	int fd;
+
+	if ((cond & G_IO_ERR) || (cond & G_IO_HUP) || (cond & G_IO_NVAL)) {
+		ErrPrint("Event pipe is lost\n");
+		s_info.evt_id = 0;
+		return FALSE;
+	}
+
+	fd = g_io_channel_unix_get_fd(src);
+	if (read(fd, &request, sizeof(request)) != sizeof(request)) {
+		ErrPrint("read: %d\n", errno);
+		return TRUE;
+	}
+
+	l = dlist_find_data(s_info.pending_list, request);
+	s_info.pending_list = dlist_remove(s_info.pending_list, l);
+
+	if (request->canceled) {
+		DbgPrint("Stale desc is dropped (%s)\n", request->filename);
+	} else if (request->ret != WIDGET_ERROR_NONE) {
+		ErrPrint("Failed to parse %s (%d)\n", request->filename, request->ret);
+	} else if (request->common->state != WIDGET_STATE_CREATE) {
+		DbgPrint("Instance is not created anymore (%s)\n", request->filename);
+	} else {
+		apply_desc(request->common, request->is_gbar, request->block_list);
+		request->block_list = NULL;
+	}
+
+	destroy_request(request);
+	return TRUE;
+}
+
+static inline void cancel_requests(struct widget_common *common, int is_gbar, int all)
+{
+	struct desc_request *request;
+	struct dlist *l;
+
+	CRITICAL_SECTION_BEGIN(&s_info.desc_lock);
+	dlist_foreach(s_info.pending_list, l, request) {
+		if (request->common == common && (all || request->is_gbar == is_gbar)) {
+			request->canceled = 1;
+		}
+	}
+	CRITICAL_SECTION_END(&s_info.desc_lock);
+}
+
+int parse_desc(struct widget_common *common, const char *filename, int is_gbar)
+{
+	struct desc_request *request;
+	struct dlist *block_list = NULL;
+	char ch = EVT_CH;
+	int fd;
+	int ret;
+
+	/*!
+	 * \note
+	 * Open it from here, the caller is able to unlink the file as soon as this returns.
+	 */
+	fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		ErrPrint("open: %d (%s)\n", errno, filename);
+		return WIDGET_ERROR_IO_ERROR;
+	}
+
+	if (!s_info.initialized) {
+		ret = tokenize_desc(fd, filename, &block_list);
+		if (close(fd) < 0) {
+			ErrPrint("close: %d\n", errno);
+		}
+
+		if (ret == WIDGET_ERROR_NONE) {
+			apply_desc(common, is_gbar, block_list);
+		}
+
+		return ret;
+	}
+
+	request = calloc(1, sizeof(*request));
+	if (!request) {
+		ErrPrint("calloc: %d\n", errno);
+		if (close(fd) < 0) {
+			ErrPrint("close: %d\n", errno);
+		}
+		return WIDGET_ERROR_OUT_OF_MEMORY;
+	}
+
+	request->filename = strdup(filename);
+	if (!request->filename) {
+		ErrPrint("strdup: %d\n", errno);
+		if (close(fd) < 0) {
+			ErrPrint("close: %d\n", errno);
+		}
+		free(request);
+		return WIDGET_ERROR_OUT_OF_MEMORY;
+	}
+
+	request->common = common;
+	request->is_gbar = is_gbar;
+	request->fd = fd;
+	request->ret = WIDGET_ERROR_NONE;
+
+	/*!
+	 * \note
+	 * The newer desc replaces all contents, previous one doesn't need to be applied.
+	 */
+	cancel_requests(common, is_gbar, 0);
+
+	s_info.pending_list = dlist_append(s_info.pending_list, request);
+
+	CRITICAL_SECTION_BEGIN(&s_info.desc_lock);
+	s_info.request_list = dlist_append(s_info.request_list, request);
+	CRITICAL_SECTION_END(&s_info.desc_lock);
+
+	if (write(s_info.ctrl_pipe[PIPE_WRITE], &ch, sizeof(ch)) != sizeof(ch)) {
+		/*!
+		 * \note
+		 * The desc thread will consume this with the next event.
+		 */
+		ErrPrint("write: %d\n", errno);
+	}
+
+	return WIDGET_ERROR_NONE;
+}
+
+void desc_parser_cancel(struct widget_common *common)
+{
+	if (!s_info.initialized) {
+		return;
+	}
+
+	cancel_requests(common, 0, 1);
+}
+
+int desc_parser_init(void)
+{
+	GIOChannel *gio;
+	int status;
+
+	if (s_info.initialized) {
+		return WIDGET_ERROR_ALREADY_EXIST;
+	}
+
+	if (pipe2(s_info.ctrl_pipe, O_CLOEXEC) < 0) {
+		ErrPrint("desc parser: %d\n", errno);
+		return WIDGET_ERROR_FAULT;
+	}
+
+	if (pipe2(s_info.evt_pipe, O_CLOEXEC) < 0) {
+		ErrPrint("desc parser: %d\n", errno);
+		CLOSE_PIPE(s_info.ctrl_pipe);
+		return WIDGET_ERROR_FAULT;
+	}
+
+	status = pthread_mutex_init(&s_info.desc_lock, NULL);
+	if (status != 0) {
+		ErrPrint("Mutex: %s\n", strerror(status));
+		CLOSE_PIPE(s_info.ctrl_pipe);
+		CLOSE_PIPE(s_info.evt_pipe);
+		return WIDGET_ERROR_FAULT;
+	}
+
+	gio = g_io_channel_unix_new(s_info.evt_pipe[PIPE_READ]);
+	if (!gio) {
+		ErrPrint("io channel new\n");
+		status = pthread_mutex_destroy(&s_info.desc_lock);
+		if (status != 0) {
+			ErrPrint("destroy: %s\n", strerror(status));
+		}
+		CLOSE_PIPE(s_info.ctrl_pipe);
+		CLOSE_PIPE(s_info.evt_pipe);
+		return WIDGET_ERROR_FAULT;
+	}
+
+	g_io_channel_set_close_on_unref(gio, FALSE);
+
+	s_info.evt_id = g_io_add_watch(gio, G_IO_IN | G_IO_HUP | G_IO_ERR | G_IO_NVAL, (GIOFunc)evt_cb, NULL);
+	g_io_channel_unref(gio);
+	if (s_info.evt_id <= 0) {
+		ErrPrint("Failed to add IO watch\n");
+		status = pthread_mutex_destroy(&s_info.desc_lock);
+		if (status != 0) {
+			ErrPrint("destroy: %s\n", strerror(status));
+		}
+		CLOSE_PIPE(s_info.ctrl_pipe);
+		CLOSE_PIPE(s_info.evt_pipe);
+		return WIDGET_ERROR_FAULT;
+	}
+
+	status = pthread_create(&s_info.desc_thid, NULL, desc_thread_main, NULL);
+	if (status != 0) {
+		ErrPrint("desc parser: %s\n", strerror(status));
+		g_source_remove(s_info.evt_id);
+		s_info.evt_id = 0;
+		status = pthread_mutex_destroy(&s_info.desc_lock);
+		if (status != 0) {
+			ErrPrint("destroy: %s\n", strerror(status));
+		}
+		CLOSE_PIPE(s_info.ctrl_pipe);
+		CLOSE_PIPE(s_info.evt_pipe);
+		return WIDGET_ERROR_FAULT;
+	}
+
+	s_info.initialized = 1;
+	return WIDGET_ERROR_NONE;
+}
+
+int desc_parser_fini(void)
+{
+	struct desc_request *request;
+	struct dlist *l;
+	struct dlist *n;
+	char ch = EVT_END_CH;
+	int ret;
+
+	if (!s_info.initialized) {
+		return WIDGET_ERROR_INVALID_PARAMETER;
+	}
+
+	if (write(s_info.ctrl_pipe[PIPE_WRITE], &ch, sizeof(ch)) != sizeof(ch)) {
+		ErrPrint("write: %d\n", errno);
+	}
+
+	ret = pthread_join(s_info.desc_thid, NULL);
+	if (ret != 0) {
+		ErrPrint("join: %s\n", strerror(ret));
+	}
+
+	if (s_info.evt_id > 0) {
+		g_source_remove(s_info.evt_id);
+		s_info.evt_id = 0;
+	}
+
+	/*!
+	 * \note
+	 * Every request is in the pending_list until it is applied,
+	 * Pointers which are remained in the event pipe are discarded with the pipe.
+	 */
+	dlist_foreach_safe(s_info.pending_list, l, n, request) {
+		s_info.pending_list = dlist_remove(s_info.pending_list, l);
+		destroy_request(request);
+	}
+
+	l = s_info.request_list;
+	while (l) {
+		s_info.request_list = dlist_remove(s_info.request_list, l);
+		l = s_info.request_list;
+	}
+
+	ret = pthread_mutex_destroy(&s_info.desc_lock);
+	if (ret != 0) {
+		ErrPrint("destroy: %s\n", strerror(ret));
+	}
+
+	CLOSE_PIPE(s_info.evt_pipe);
+	CLOSE_PIPE(s_info.ctrl_pipe);
 
+	s_info.initialized = 0;
 	return WIDGET_ERROR_NONE;
 }
 
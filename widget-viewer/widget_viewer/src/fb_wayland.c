@@ -34,12 +34,15 @@
 #include <widget_errno.h> /* For error code */
 #include <widget_service.h> /* For buffer event data */
 #include <widget_buffer.h>
+#include <packet.h>
 #include <widget_util.h>
 
 #include "debug.h"
 #include "util.h"
 #include "fb.h"
 #include "dlist.h"
+#include "widget_viewer.h"
+#include "master_rpc.h"
 
 int errno;
 
@@ -55,12 +58,14 @@ static struct {
 	int disp_is_opened;
 	int fd;
 	struct dlist *canvas_list;
+	struct dlist *memfd_request_list;
 } s_info = {
 	.disp = NULL,
 	.bufmgr = NULL,
 	.disp_is_opened = 0,
 	.fd = -1,
 	.canvas_list = NULL,
+	.memfd_request_list = NULL,
 };
 
 int fb_init(void *disp)
@@ -231,6 +236,253 @@ static int sync_for_file(struct fb_info *info, int x, int y, int w, int h)
 	return WIDGET_ERROR_NONE;
 }
 
+/*!
+ * \brief
+ * The memfd of a buffer is requested to the master when the FB is created,
+ * not to block the main loop in the fb_acquire_buffer.
+ * It is kept opened until the FB is destroyed, and every acquired buffer is a new mapping of it, like the SHM.
+ */
+struct memfd_request {
+	struct fb_info *info; /*!< NULL if the FB is destroyed while the request is pending */
+	int pending;
+	int missed; /*!< The buffer is acquired before the fd is gotten */
+	void (*ready_cb)(struct fb_info *info, void *data);
+	void *data;
+};
+
+static struct memfd_request *find_memfd_request(struct fb_info *info)
+{
+	struct dlist *l;
+	struct memfd_request *request;
+
+	dlist_foreach(s_info.memfd_request_list, l, request) {
+		if (request->info == info) {
+			return request;
+		}
+	}
+
+	return NULL;
+}
+
+static void memfd_ret_cb(widget_h handler, const struct packet *result, void *data)
+{
+	struct memfd_request *request = data;
+	struct fb_info *info;
+	int ret;
+	int fd = -1;
+
+	request->pending = 0;
+	info = request->info;
+
+	if (!result) {
+		ret = WIDGET_ERROR_FAULT;
+	} else {
+		if (packet_get(result, "i", &ret) != 1) {
+			ErrPrint("Invalid result packet\n");
+			ret = WIDGET_ERROR_INVALID_PARAMETER;
+		}
+
+		fd = packet_fd(result);
+	}
+
+	if (!info) {
+		if (fd >= 0 && close(fd) < 0) {
+			ErrPrint("close: %d\n", errno);
+		}
+
+		dlist_remove_data(s_info.memfd_request_list, request);
+		free(request);
+		return;
+	}
+
+	if (ret != WIDGET_ERROR_NONE || fd < 0) {
+		ErrPrint("Failed to get the fd of %s: %d\n", info->id, ret);
+		if (fd >= 0 && close(fd) < 0) {
+			ErrPrint("close: %d\n", errno);
+		}
+		return;
+	}
+
+	info->handle = fd;
+	if (request->missed && request->ready_cb) {
+		request->missed = 0;
+		request->ready_cb(info, request->data);
+	}
+}
+
+static int request_memfd(struct memfd_request *request)
+{
+	struct packet *packet;
+	int ret;
+
+	packet = packet_create(CMD_STR_BUFFER_FD, "s", request->info->id);
+	if (!packet) {
+		ErrPrint("Failed to build a packet\n");
+		return WIDGET_ERROR_FAULT;
+	}
+
+	ret = master_rpc_async_request(NULL, packet, 1, memfd_ret_cb, request);
+	if (ret < 0) {
+		ErrPrint("Failed to send a request: %d\n", ret);
+		return ret;
+	}
+
+	request->pending = 1;
+	return WIDGET_ERROR_NONE;
+}
+
+static widget_fb_t map_memfd(int fd)
+{
+	widget_fb_t buffer;
+	struct stat st;
+
+	if (fstat(fd, &st) < 0) {
+		ErrPrint("fstat: %d\n", errno);
+		return NULL;
+	}
+
+	buffer = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if (buffer == MAP_FAILED) {
+		ErrPrint("mmap: %d\n", errno);
+		return NULL;
+	}
+
+	return buffer;
+}
+
+static void unmap_memfd(widget_fb_t buffer)
+{
+	if (munmap(buffer, sizeof(*buffer) + WIDGET_FB_MEMFD_SIZE(buffer)) < 0) {
+		ErrPrint("munmap: %d\n", errno);
+	}
+}
+
+/*!
+ * \brief
+ * Find the pin of this process, or take a free one.
+ */
+static struct shm_ring_pin *find_pin(struct shm_ring *ring)
+{
+	pid_t pid;
+	int expected;
+	int i;
+
+	pid = getpid();
+
+	for (i = 0; i < SHM_RING_MAX_PINS; i++) {
+		if (__atomic_load_n(&ring->pins[i].pid, __ATOMIC_SEQ_CST) == pid) {
+			return ring->pins + i;
+		}
+	}
+
+	for (i = 0; i < SHM_RING_MAX_PINS; i++) {
+		expected = 0;
+		if (__atomic_compare_exchange_n(&ring->pins[i].pid, &expected, pid, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+			return ring->pins + i;
+		}
+	}
+
+	return NULL;
+}
+
+/*!
+ * \brief
+ * Take the latest published slot of the N-buffered SHM.
+ * The provider does not write on the slot until it is released.
+ */
+static widget_fb_t pin_latest_slot(widget_fb_t buffer)
+{
+	struct shm_ring_pin *pin;
+	struct shm_ring *ring;
+	unsigned int latest;
+	unsigned int idx;
+	int retry;
+
+	ring = SHM_RING(buffer);
+
+	/*!
+	 * \note
+	 * Without a pin, the master cannot give back the slot if this process is gone.
+	 * Then the draw frame is used instead.
+	 */
+	pin = find_pin(ring);
+	if (!pin) {
+		ErrPrint("No free pin for %d\n", getpid());
+		return NULL;
+	}
+
+	for (retry = 0; retry < SHM_RING_MAX_SLOTS * 2; retry++) {
+		latest = __atomic_load_n(&ring->latest, __ATOMIC_SEQ_CST);
+		if (!latest) {
+			/*!
+			 * \note
+			 * Nothing is published yet.
+			 */
+			return NULL;
+		}
+
+		idx = SHM_RING_LATEST_IDX(latest);
+		__atomic_add_fetch(&ring->readers[idx], 1, __ATOMIC_SEQ_CST);
+
+		/*!
+		 * \note
+		 * If the latest is not changed, the provider will see the readers before it chooses a slot to write.
+		 */
+		if (__atomic_load_n(&ring->latest, __ATOMIC_SEQ_CST) == latest) {
+			__atomic_add_fetch(&pin->count[idx], 1, __ATOMIC_SEQ_CST);
+			__atomic_store_n(&ring->consumed, SHM_RING_LATEST_SEQ(latest), __ATOMIC_RELAXED);
+			return SHM_RING_SLOT(ring, idx);
+		}
+
+		__atomic_sub_fetch(&ring->readers[idx], 1, __ATOMIC_SEQ_CST);
+	}
+
+	ErrPrint("Failed to take the latest slot\n");
+	return NULL;
+}
+
+/*!
+ * \brief
+ * Get the segment of a slot, the "info" of a slot has the negative offset to it.
+ */
+static inline widget_fb_t slot_segment(widget_fb_t slot)
+{
+	return (widget_fb_t)((char *)slot + (long)slot->info);
+}
+
+static inline int is_slot(widget_fb_t buffer)
+{
+	return buffer->type == WIDGET_FB_TYPE_SHM && (long)buffer->info < 0;
+}
+
+static void unpin_slot(widget_fb_t slot)
+{
+	struct shm_ring_pin *pin;
+	struct shm_ring *ring;
+	unsigned int count;
+
+	ring = SHM_RING(slot_segment(slot));
+	pin = find_pin(ring);
+	if (!pin) {
+		ErrPrint("Pin of %d is not found\n", getpid());
+		return;
+	}
+
+	/*!
+	 * \note
+	 * If the master gave back the pin already, the readers are also decreased by it.
+	 */
+	count = __atomic_load_n(&pin->count[slot->refcnt], __ATOMIC_SEQ_CST);
+	do {
+		if (count == 0) {
+			ErrPrint("Slot %d is not pinned\n", slot->refcnt);
+			return;
+		}
+	} while (!__atomic_compare_exchange_n(&pin->count[slot->refcnt], &count, count - 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST));
+
+	__atomic_sub_fetch(&ring->readers[slot->refcnt], 1, __ATOMIC_SEQ_CST);
+}
+
 int fb_sync(struct fb_info *info, int x, int y, int w, int h)
 {
 	if (!info) {
@@ -250,6 +502,9 @@ int fb_sync(struct fb_info *info, int x, int y, int w, int h)
 	} else if (!strncasecmp(info->id, SCHEMA_SHM, strlen(SCHEMA_SHM))) {
 		/* No need to do sync */
 		return WIDGET_ERROR_NONE;
+	} else if (!strncasecmp(info->id, SCHEMA_MEMFD, strlen(SCHEMA_MEMFD))) {
+		/* Same as the SHM, the provider writes on the same pages */
+		return WIDGET_ERROR_NONE;
 	}
 
 	return WIDGET_ERROR_INVALID_PARAMETER;
@@ -283,6 +538,22 @@ struct fb_info *fb_create(const char *id, int w, int h)
 		DbgPrint("SHMID: %d is gotten\n", info->handle);
 	} else if (sscanf(info->id, SCHEMA_PIXMAP "%d:%d", &info->handle, &info->pixels) == 2) {
 		DbgPrint("PIXMAP-SHMID: %d is gotten (%d)\n", info->handle, info->pixels);
+	} else if (!strncasecmp(info->id, SCHEMA_MEMFD, strlen(SCHEMA_MEMFD))) {
+		struct memfd_request *request;
+
+		request = calloc(1, sizeof(*request));
+		if (!request) {
+			ErrPrint("Heap: %d\n", errno);
+			free(info->id);
+			free(info);
+			return NULL;
+		}
+
+		request->info = info;
+		s_info.memfd_request_list = dlist_append(s_info.memfd_request_list, request);
+
+		info->handle = -1; /*!< Updated by the memfd_ret_cb */
+		(void)request_memfd(request);
 	} else {
 		info->handle = WIDGET_ERROR_INVALID_PARAMETER;
 	}
@@ -302,6 +573,24 @@ int fb_destroy(struct fb_info *info)
 		return WIDGET_ERROR_INVALID_PARAMETER;
 	}
 
+	if (!strncasecmp(info->id, SCHEMA_MEMFD, strlen(SCHEMA_MEMFD))) {
+		struct memfd_request *request;
+
+		request = find_memfd_request(info);
+		if (request) {
+			if (request->pending) {
+				request->info = NULL; /*!< Released by the memfd_ret_cb */
+			} else {
+				dlist_remove_data(s_info.memfd_request_list, request);
+				free(request);
+			}
+		}
+
+		if (info->handle >= 0 && close(info->handle) < 0) {
+			ErrPrint("close: %d\n", errno);
+		}
+	}
+
 	if (info->buffer) {
 		widget_fb_t buffer;
 		buffer = info->buffer;
@@ -314,6 +603,25 @@ int fb_destroy(struct fb_info *info)
 	return WIDGET_ERROR_NONE;
 }
 
+int fb_set_ready_cb(struct fb_info *info, void (*cb)(struct fb_info *info, void *data), void *data)
+{
+	struct memfd_request *request;
+
+	if (!info) {
+		ErrPrint("Handle is not valid\n");
+		return WIDGET_ERROR_INVALID_PARAMETER;
+	}
+
+	request = find_memfd_request(info);
+	if (!request) {
+		return WIDGET_ERROR_NOT_EXIST;
+	}
+
+	request->ready_cb = cb;
+	request->data = data;
+	return WIDGET_ERROR_NONE;
+}
+
 int fb_is_created(struct fb_info *info)
 {
 	if (!info) {
@@ -325,6 +633,8 @@ int fb_is_created(struct fb_info *info)
 		return 1;
 	} else if (!strncasecmp(info->id, SCHEMA_SHM, strlen(SCHEMA_SHM)) && info->handle > 0) {
 		return 1;
+	} else if (!strncasecmp(info->id, SCHEMA_MEMFD, strlen(SCHEMA_MEMFD))) {
+		return 1;
 	} else {
 		const char *path;
 		path = util_uri_to_path(info->id);
@@ -413,6 +723,51 @@ void *fb_acquire_buffer(struct fb_info *info)
 				return NULL;
 			}
 
+			if (fb_slots(info) > 1) {
+				widget_fb_t slot;
+
+				/*!
+				 * \note
+				 * Before the first frame is published, give the draw frame as the single frame SHM does.
+				 */
+				slot = pin_latest_slot(buffer);
+				if (slot) {
+					return slot->data;
+				}
+			}
+
+			return buffer->data;
+		} else if (!strncasecmp(info->id, SCHEMA_MEMFD, strlen(SCHEMA_MEMFD))) {
+			if (info->handle < 0) {
+				struct memfd_request *request;
+
+				/*!
+				 * \note
+				 * The fd is not gotten yet, the ready callback will be invoked when it is gotten.
+				 * If the request was failed, try it again.
+				 */
+				request = find_memfd_request(info);
+				if (!request) {
+					set_last_result(WIDGET_ERROR_FAULT);
+					return NULL;
+				}
+
+				if (!request->pending && request_memfd(request) < 0) {
+					set_last_result(WIDGET_ERROR_FAULT);
+					return NULL;
+				}
+
+				request->missed = 1;
+				set_last_result(WIDGET_ERROR_RESOURCE_BUSY);
+				return NULL;
+			}
+
+			buffer = map_memfd(info->handle);
+			if (!buffer) {
+				set_last_result(WIDGET_ERROR_FAULT);
+				return NULL;
+			}
+
 			return buffer->data;
 		} else {
 			ErrPrint("Buffer is not created (%s)\n", info->id);
@@ -483,8 +838,16 @@ int fb_release_buffer(void *data)
 		return WIDGET_ERROR_INVALID_PARAMETER;
 	}
 
-	switch (buffer->type) {
+	switch ((int)buffer->type) {
+	case WIDGET_FB_TYPE_MEMFD:
+		unmap_memfd(buffer);
+		break;
 	case WIDGET_FB_TYPE_SHM:
+		if (is_slot(buffer)) {
+			unpin_slot(buffer);
+			buffer = slot_segment(buffer);
+		}
+
 		if (shmdt(buffer) < 0) {
 			ErrPrint("shmdt: %d\n", errno);
 		}
@@ -551,8 +914,15 @@ int fb_refcnt(void *data)
 		return WIDGET_ERROR_INVALID_PARAMETER;
 	}
 
-	switch (buffer->type) {
+	switch ((int)buffer->type) {
+	case WIDGET_FB_TYPE_MEMFD:
+		ret = 1; /*!< The count of mappings is not able to be known */
+		break;
 	case WIDGET_FB_TYPE_SHM:
+		if (is_slot(buffer)) {
+			buffer = slot_segment(buffer);
+		}
+
 		if (shmctl(buffer->refcnt, IPC_STAT, &buf) < 0) {
 			ErrPrint("Error: %d\n", errno);
 			set_last_result(WIDGET_ERROR_FAULT);
@@ -576,6 +946,18 @@ int fb_refcnt(void *data)
 	return ret;
 }
 
+int fb_slots(struct fb_info *info)
+{
+	const char *slots;
+
+	if (!info || !info->id || strncasecmp(info->id, SCHEMA_SHM, strlen(SCHEMA_SHM))) {
+		return 0;
+	}
+
+	slots = strrchr(info->id, SHM_RING_DELIM);
+	return slots ? atoi(slots + 1) : 0;
+}
+
 const char *fb_id(struct fb_info *info)
 {
 	return info ? info->id : NULL;
@@ -627,6 +1009,8 @@ int fb_type(struct fb_info *info)
 				type = WIDGET_FB_TYPE_PIXMAP;
 			} else if (!strncasecmp(info->id, SCHEMA_SHM, strlen(SCHEMA_SHM))) {
 				type = WIDGET_FB_TYPE_SHM;
+			} else if (!strncasecmp(info->id, SCHEMA_MEMFD, strlen(SCHEMA_MEMFD))) {
+				type = WIDGET_FB_TYPE_MEMFD;
 			}
 		}
 
@@ -4024,6 +4024,14 @@ EAPI int widget_viewer_acquire_buffer_lock(widget_h handle, int is_gbar)
 		return WIDGET_ERROR_INVALID_PARAMETER;
 	}
 
+	if (fb_slots(is_gbar ? handle->common->gbar.fb : handle->common->widget.fb) > 1) {
+		/*!
+		 * \note
+		 * Acquired buffers of the N-buffered SHM are not written by the provider until they are released.
+		 */
+		return WIDGET_ERROR_NONE;
+	}
+
 	if (is_gbar) {
 		ret = widget_service_acquire_lock(handle->common->gbar.lock);
 	} else {
@@ -4052,6 +4060,14 @@ EAPI int widget_viewer_release_buffer_lock(widget_h handle, int is_gbar)
 		return WIDGET_ERROR_INVALID_PARAMETER;
 	}
 
+	if (fb_slots(is_gbar ? handle->common->gbar.fb : handle->common->widget.fb) > 1) {
+		/*!
+		 * \note
+		 * Acquired buffers of the N-buffered SHM are not written by the provider until they are released.
+		 */
+		return WIDGET_ERROR_NONE;
+	}
+
 	if (is_gbar) {
 		ret = widget_service_release_lock(handle->common->gbar.lock);
 	} else {
@@ -22,6 +22,7 @@
 #include "conf.h"
 #include "util.h"
 #include "master_rpc.h"
+#include "desc_parser.h"
 
 int errno;
 
@@ -170,6 +171,8 @@ int _widget_destroy_common_handle(struct widget_common *common)
 
 	common->state = WIDGET_STATE_DESTROYED;
 
+	desc_parser_cancel(common);
+
 	if (common->filename) {
 		(void)util_unlink(common->filename);
 	}
@@ -538,6 +541,30 @@ void _widget_set_alt_name(struct widget_common *common, const char *name)
 	common->alt.name = _name;
 }
 
+static void widget_fb_ready_cb(struct fb_info *info, void *data)
+{
+	struct widget_common *common = data;
+	struct dlist *l;
+	struct dlist *n;
+	widget_h handler;
+
+	dlist_foreach_safe(common->widget_list, l, n, handler) {
+		_widget_invoke_event_handler(handler, WIDGET_EVENT_WIDGET_UPDATED);
+	}
+}
+
+static void gbar_fb_ready_cb(struct fb_info *info, void *data)
+{
+	struct widget_common *common = data;
+	struct dlist *l;
+	struct dlist *n;
+	widget_h handler;
+
+	dlist_foreach_safe(common->widget_list, l, n, handler) {
+		_widget_invoke_event_handler(handler, WIDGET_EVENT_GBAR_UPDATED);
+	}
+}
+
 int _widget_set_widget_fb(struct widget_common *common, const char *filename)
 {
 	struct fb_info *fb;
@@ -569,6 +596,12 @@ int _widget_set_widget_fb(struct widget_common *common, const char *filename)
 		return WIDGET_ERROR_FAULT;
 	}
 
+	/*!
+	 * \note
+	 * Only the MEMFD buffer can be busy, the fd of it is gotten asynchronously.
+	 */
+	(void)fb_set_ready_cb(common->widget.fb, widget_fb_ready_cb, common);
+
 	if (fb) {
 		fb_destroy(fb);
 	}
@@ -607,6 +640,8 @@ int _widget_set_gbar_fb(struct widget_common *common, const char *filename)
 		return WIDGET_ERROR_FAULT;
 	}
 
+	(void)fb_set_ready_cb(common->gbar.fb, gbar_fb_ready_cb, common);
+
 	if (fb) {
 		fb_destroy(fb);
 	}